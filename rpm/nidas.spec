@@ -33,7 +33,7 @@ Url: https://github.com/NCAR/nidas
 Vendor: UCAR
 Source: https://github.com/NCAR/%{name}/archive/master.tar.gz#/%{name}-%{version}.tar.gz
 
-BuildRequires: gcc-c++ xerces-c-devel xmlrpc++ bluez-libs-devel bzip2-devel
+BuildRequires: gcc-c++ xerces-c-devel xmlrpc++ bluez-libs-devel bzip2-devel libzstd-devel
 BuildRequires: flex gsl-devel kernel-devel libcap-devel
 # Allow eol_scons requirement to be met with a local checkout and not only as
 # an installed package.  Building NIDAS does require one or the other.
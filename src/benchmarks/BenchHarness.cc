@@ -0,0 +1,279 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "BenchHarness.h"
+
+#include <nidas/core/Version.h>
+#include <nidas/util/UTime.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <new>
+
+#include <unistd.h>
+
+using namespace std;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+std::atomic<long long> allocations(0);
+
+/**
+ * Print a string as a JSON string, with quotes and escapes.
+ */
+void printJSONString(ostream& out, const string& str)
+{
+    out << '"';
+    for (unsigned char c : str) {
+        switch (c) {
+        case '"':
+            out << "\\\"";
+            break;
+        case '\\':
+            out << "\\\\";
+            break;
+        case '\n':
+            out << "\\n";
+            break;
+        case '\t':
+            out << "\\t";
+            break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                snprintf(buf, sizeof(buf), "\\u%04x", c);
+                out << buf;
+            }
+            else out << c;
+            break;
+        }
+    }
+    out << '"';
+}
+
+/**
+ * JSON has no representation of inf or nan.
+ */
+void printJSONNumber(ostream& out, double val)
+{
+    if (std::isfinite(val)) out << val;
+    else out << "null";
+}
+
+const struct
+{
+    const char* name;
+    double p;
+} percentiles[] = {
+    { "p50", 0.50 }, { "p90", 0.90 }, { "p99", 0.99 }, { "p999", 0.999 },
+    { "max", 1.0 }
+};
+
+}   // namespace
+
+/*
+ * Counting replacements of the global allocation functions.  The
+ * array and nothrow forms in libstdc++ call these.  They are not
+ * inlined, so that the compiler does not pair malloc and free with
+ * its built-in new and delete and warn about a mismatch.
+ */
+__attribute__((noinline))
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = ::malloc(size ? size : 1);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+__attribute__((noinline))
+void operator delete(void* ptr) noexcept
+{
+    ::free(ptr);
+}
+
+namespace bench {
+
+long long getAllocations()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+double BenchResult::percentile(double p) const
+{
+    if (latencies.empty()) return 0.0;
+    size_t rank = (size_t) ceil(p * latencies.size());
+    if (rank > 0) rank--;
+    return latencies[std::min(rank, latencies.size() - 1)];
+}
+
+CaseTimer::CaseTimer(const string& name, const string& input,
+                     const string& latencyKind):
+    _result(), _t0(0), _tbatch(0), _allocs0(0),
+    _tpause(0), _allocsPause(0), _pausedNsecs(0), _pausedAllocs(0)
+{
+    _result.name = name;
+    _result.input = input;
+    _result.latencyKind = latencyKind;
+}
+
+void CaseTimer::start()
+{
+    _result.items = 0;
+    _result.latencies.clear();
+    _pausedNsecs = 0;
+    _pausedAllocs = 0;
+    _allocs0 = getAllocations();
+    _t0 = _tbatch = nanoTime();
+}
+
+void CaseTimer::batch(long long nitems)
+{
+    long long t = nanoTime();
+    if (nitems > 0) {
+        _result.items += nitems;
+        _result.latencies.push_back((double)(t - _tbatch) / nitems);
+    }
+    _tbatch = t;
+}
+
+void CaseTimer::pause()
+{
+    _tpause = nanoTime();
+    _allocsPause = getAllocations();
+}
+
+void CaseTimer::resume()
+{
+    long long t = nanoTime();
+    _pausedAllocs += getAllocations() - _allocsPause;
+    _pausedNsecs += t - _tpause;
+    _tbatch += t - _tpause;
+}
+
+void CaseTimer::stop()
+{
+    long long t = nanoTime();
+    _result.seconds = (t - _t0 - _pausedNsecs) * 1.e-9;
+    _result.allocations = getAllocations() - _allocs0 - _pausedAllocs;
+    std::sort(_result.latencies.begin(), _result.latencies.end());
+}
+
+BenchReport::BenchReport(const string& program):
+    _program(program), _results()
+{
+}
+
+void BenchReport::add(const BenchResult& result)
+{
+    _results.push_back(result);
+}
+
+void BenchReport::printTable(ostream& out) const
+{
+    size_t namew = 8;
+    for (const BenchResult& r : _results)
+        namew = std::max(namew, r.name.length() + 1);
+
+    out << setw(namew) << left << "case" << right
+        << setw(12) << "items"
+        << setw(13) << "items/s"
+        << setw(10) << "ns/item"
+        << setw(11) << "allocs/it"
+        << setw(10) << "p50 ns"
+        << setw(10) << "p99 ns"
+        << setw(11) << "max ns"
+        << "  input" << endl;
+
+    for (const BenchResult& r : _results) {
+        out << setw(namew) << left << r.name << right
+            << setw(12) << r.items
+            << setw(13) << fixed << setprecision(0) << r.itemsPerSec()
+            << setw(10) << setprecision(1) << r.nsPerItem()
+            << setw(11) << setprecision(3) << r.allocationsPerItem()
+            << setw(10) << setprecision(0) << r.percentile(0.5)
+            << setw(10) << r.percentile(0.99)
+            << setw(11) << r.percentile(1.0)
+            << "  " << r.input;
+        if (r.latencyKind != "batch") out << " (" << r.latencyKind << ")";
+        out << endl;
+    }
+    out.unsetf(std::ios::floatfield);
+}
+
+void BenchReport::printJSON(ostream& out) const
+{
+    char host[256];
+    if (gethostname(host, sizeof(host)) < 0) host[0] = 0;
+    host[sizeof(host) - 1] = 0;
+
+    out << setprecision(6) << "{\n";
+    out << "  \"program\": ";
+    printJSONString(out, _program);
+    out << ",\n  \"nidas_version\": ";
+    printJSONString(out, nidas::core::Version::getSoftwareVersion());
+    out << ",\n  \"host\": ";
+    printJSONString(out, host);
+    out << ",\n  \"ncpus\": " << sysconf(_SC_NPROCESSORS_ONLN);
+    out << ",\n  \"time\": ";
+    printJSONString(out, n_u::UTime().format(true, "%Y-%m-%dT%H:%M:%SZ"));
+    out << ",\n  \"cases\": [";
+
+    for (size_t i = 0; i < _results.size(); i++) {
+        const BenchResult& r = _results[i];
+        out << (i ? ",\n" : "\n") << "    {\n      \"name\": ";
+        printJSONString(out, r.name);
+        out << ",\n      \"input\": ";
+        printJSONString(out, r.input);
+        out << ",\n      \"items\": " << r.items;
+        out << ",\n      \"seconds\": ";
+        printJSONNumber(out, r.seconds);
+        out << ",\n      \"items_per_sec\": ";
+        printJSONNumber(out, r.itemsPerSec());
+        out << ",\n      \"ns_per_item\": ";
+        printJSONNumber(out, r.nsPerItem());
+        out << ",\n      \"allocations\": " << r.allocations;
+        out << ",\n      \"allocations_per_item\": ";
+        printJSONNumber(out, r.allocationsPerItem());
+        out << ",\n      \"latency_ns\": {\n        \"kind\": ";
+        printJSONString(out, r.latencyKind);
+        out << ",\n        \"count\": " << r.latencies.size();
+        for (const auto& pc : percentiles) {
+            out << ",\n        \"" << pc.name << "\": ";
+            printJSONNumber(out, r.percentile(pc.p));
+        }
+        out << "\n      }\n    }";
+    }
+    out << "\n  ]\n}" << endl;
+}
+
+}   // namespace bench
@@ -0,0 +1,234 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Timing, allocation counting and reporting shared by the benchmarks.
+ *
+ * A benchmark program runs its cases with a CaseTimer, which counts
+ * the items (samples or messages) a case processes, the calls of the
+ * global operator new while it runs, and per-item latencies.  The
+ * results are collected in a BenchReport, which prints a table or
+ * a JSON document, for comparison between runs.
+ */
+
+#ifndef NIDAS_BENCHMARKS_BENCHHARNESS_H
+#define NIDAS_BENCHMARKS_BENCHHARNESS_H
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+/**
+ * Number of calls of the global operator new since the start of the
+ * program, in all threads.  Linking BenchHarness.cc into a program
+ * replaces operator new and delete with counting versions.
+ */
+long long getAllocations();
+
+/**
+ * Nanoseconds of a monotonic clock.
+ */
+inline long long nanoTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Result of a benchmark case.
+ */
+struct BenchResult
+{
+    BenchResult():
+        name(), input(), latencyKind(), items(0), seconds(0.0),
+        allocations(0), latencies()
+    {}
+
+    /**
+     * Name of the case, such as "sample_sorter".
+     */
+    std::string name;
+
+    /**
+     * The sample stream, "synthetic" or the name of a recorded archive.
+     */
+    std::string input;
+
+    /**
+     * "batch": latencies are the mean time per item of consecutive
+     * batches of items.  "end_to_end": latencies are the times from
+     * when an item was passed to the component to when it came out.
+     */
+    std::string latencyKind;
+
+    long long items;
+
+    double seconds;
+
+    long long allocations;
+
+    /**
+     * Latencies in nanoseconds, sorted.
+     */
+    std::vector<double> latencies;
+
+    double itemsPerSec() const
+    {
+        return seconds > 0.0 ? items / seconds : 0.0;
+    }
+
+    double nsPerItem() const
+    {
+        return items > 0 ? seconds * 1.e9 / items : 0.0;
+    }
+
+    double allocationsPerItem() const
+    {
+        return items > 0 ? (double) allocations / items : 0.0;
+    }
+
+    /**
+     * Latency at fraction p, 0 <= p <= 1, of the sorted latencies,
+     * by the nearest rank.  0 if no latencies were recorded.
+     */
+    double percentile(double p) const;
+};
+
+/**
+ * Measure a benchmark case.  Call start() before the timed section,
+ * batch(n) after each batch of n items if the latencies are per batch,
+ * or latency() for each item if they are end to end, and then stop().
+ * Setup within the timed section, such as between passes, can be
+ * excluded with pause() and resume().
+ */
+class CaseTimer
+{
+public:
+
+    CaseTimer(const std::string& name, const std::string& input,
+              const std::string& latencyKind = "batch");
+
+    void start();
+
+    /**
+     * End of a batch of nitems, started by start() or the previous
+     * batch().  Adds the items to the count, and records the mean
+     * time per item of the batch as a latency.
+     */
+    void batch(long long nitems);
+
+    /**
+     * Add nitems to the count without recording a latency.
+     */
+    void addItems(long long nitems)
+    {
+        _result.items += nitems;
+    }
+
+    /**
+     * Record the latency of one item, in nanoseconds.
+     */
+    void latency(long long nsecs)
+    {
+        _result.latencies.push_back(nsecs);
+    }
+
+    /**
+     * Reserve room for n latencies, so that recording them does
+     * not allocate during the timed section.
+     */
+    void reserve(size_t n)
+    {
+        _result.latencies.reserve(n);
+    }
+
+    /**
+     * Stop counting time and allocations, until resume().
+     */
+    void pause();
+
+    void resume();
+
+    void stop();
+
+    const BenchResult& getResult() const { return _result; }
+
+private:
+
+    BenchResult _result;
+
+    long long _t0;
+
+    long long _tbatch;
+
+    long long _allocs0;
+
+    long long _tpause;
+
+    long long _allocsPause;
+
+    long long _pausedNsecs;
+
+    long long _pausedAllocs;
+};
+
+/**
+ * Results of the cases of a benchmark program.
+ */
+class BenchReport
+{
+public:
+
+    BenchReport(const std::string& program);
+
+    void add(const BenchResult& result);
+
+    const std::vector<BenchResult>& getResults() const { return _results; }
+
+    /**
+     * Print a table of the results, one case per line.
+     */
+    void printTable(std::ostream& out) const;
+
+    /**
+     * Print the results as a JSON object with the name of the program,
+     * the host, the time and a "cases" array, with a member for each
+     * of the quantities in the table.
+     */
+    void printJSON(std::ostream& out) const;
+
+private:
+
+    std::string _program;
+
+    std::vector<BenchResult> _results;
+};
+
+}   // namespace bench
+
+#endif
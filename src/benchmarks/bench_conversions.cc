@@ -0,0 +1,361 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Compare the conversions of the Variables of a SampleTag applied one
+ * value at a time with Variable::convert(), as DSMSensor::applyConversions()
+ * did, with the same conversions applied by the SampleTag's
+ * ConversionPlan, for several layouts of variables and converters.
+ * The results of the two are checked to be identical before timing.
+ */
+
+#include "BenchHarness.h"
+
+#include <nidas/core/ConversionPlan.h>
+#include <nidas/core/SampleTag.h>
+#include <nidas/core/Variable.h>
+#include <nidas/core/VariableConverter.h>
+#include <nidas/util/Logger.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace nidas::core;
+using namespace std;
+
+using bench::BenchReport;
+using bench::CaseTimer;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+std::mt19937 rng(42);
+
+/**
+ * Samples per latency batch.
+ */
+const size_t BATCH = 256;
+
+/**
+ * Number of distinct raw samples of a layout, which are converted
+ * in turn.
+ */
+const size_t NRAW = 1024;
+
+/**
+ * A SampleTag with its Variables and converters, and raw values
+ * for NRAW samples.
+ */
+struct Layout
+{
+    Layout(const string& n): name(n), tag(), nvalues(0), raw()
+    {}
+
+    void addVariable(Variable* var)
+    {
+        tag.addVariable(var);
+        nvalues += var->getLength();
+    }
+
+    /**
+     * Fill the raw samples with random counts, with a few missing
+     * values and values outside the min/max limits.
+     */
+    void fill(float missing)
+    {
+        std::uniform_real_distribution<float> counts(-500.0, 5000.0);
+        std::uniform_int_distribution<int> oneIn(0, 99);
+        raw.resize(NRAW * nvalues);
+        for (float& v : raw)
+            v = oneIn(rng) == 0 ? missing : counts(rng);
+    }
+
+    const float* rawSample(size_t i) const
+    {
+        return raw.data() + (i % NRAW) * nvalues;
+    }
+
+    string name;
+
+    SampleTag tag;
+
+    unsigned int nvalues;
+
+    vector<float> raw;
+};
+
+Variable*
+linearVariable(const string& name, float slope, float intercept)
+{
+    Variable* var = new Variable();
+    var->setName(name);
+    Linear* conv = new Linear();
+    conv->setSlope(slope);
+    conv->setIntercept(intercept);
+    var->setConverter(conv);
+    var->setMissingValue(-9999);
+    var->setMinValue(-50);
+    var->setMaxValue(400);
+    return var;
+}
+
+Variable*
+polyVariable(const string& name, unsigned int length,
+             const vector<float>& coefs)
+{
+    Variable* var = new Variable();
+    var->setName(name);
+    var->setLength(length);
+    Polynomial* conv = new Polynomial();
+    conv->setCoefficients(coefs);
+    var->setConverter(conv);
+    var->setMissingValue(-9999);
+    var->setMaxValue(1.e6);
+    return var;
+}
+
+/**
+ * Sixteen analog channels with linear calibrations, as from an A2D.
+ */
+void
+a2dLayout(Layout& layout)
+{
+    for (int i = 0; i < 16; i++)
+        layout.addVariable(linearVariable("ch" + to_string(i),
+                                          0.1 + i * 0.01, -2.0 + i));
+    layout.fill(-9999);
+}
+
+/**
+ * A 64 bin histogram with a cubic calibration, as from a particle probe,
+ * and a few housekeeping channels.
+ */
+void
+histogramLayout(Layout& layout)
+{
+    layout.addVariable(polyVariable("counts", 64,
+                                    { 0.5, 1.02, -2.e-5, 3.e-9 }));
+    for (int i = 0; i < 4; i++)
+        layout.addVariable(polyVariable("hk" + to_string(i), 1,
+                                        { -10.0, 0.05, 1.e-6 }));
+    layout.fill(-9999);
+}
+
+/**
+ * Scalar variables with linear, polynomial and no conversions, as from
+ * a serial sensor.
+ */
+void
+mixedLayout(Layout& layout)
+{
+    for (int i = 0; i < 4; i++) {
+        layout.addVariable(linearVariable("l" + to_string(i), 0.01, 3.0));
+        layout.addVariable(polyVariable("p" + to_string(i), 1,
+                                        { 1.0, 0.1, 1.e-4 }));
+        Variable* var = new Variable();
+        var->setName("r" + to_string(i));
+        var->setMinValue(0);
+        layout.addVariable(var);
+    }
+    layout.fill(-9999);
+}
+
+/**
+ * Convert one sample one value at a time.
+ */
+inline void
+convertEach(const vector<Variable*>& vars, dsm_time_t tt, float* values)
+{
+    for (auto var : vars)
+        values = var->convert(tt, values);
+}
+
+bool
+sameResults(const vector<float>& a, const vector<float>& b)
+{
+    for (size_t i = 0; i < a.size(); i++) {
+        if (std::isnan(a[i]) != std::isnan(b[i])) return false;
+        if (!std::isnan(a[i]) && a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+/**
+ * Check that the plan gives the same results as Variable::convert()
+ * for every raw sample of the layout.
+ */
+bool
+checkLayout(Layout& layout)
+{
+    const vector<Variable*>& vars = layout.tag.getVariables();
+    ConversionPlan& plan = layout.tag.getConversionPlan();
+    vector<float> each(layout.nvalues);
+    vector<float> planned(layout.nvalues);
+    for (size_t i = 0; i < NRAW; i++) {
+        const float* raw = layout.rawSample(i);
+        std::copy(raw, raw + layout.nvalues, each.begin());
+        std::copy(raw, raw + layout.nvalues, planned.begin());
+        convertEach(vars, i, each.data());
+        plan.apply(vars, i, planned.data(), layout.nvalues);
+        if (!sameResults(each, planned)) {
+            cerr << layout.name << ": conversion_plan results differ from "
+                "variable_convert in sample " << i << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void
+benchLayout(BenchReport& report, Layout& layout, size_t nsamples,
+            int npass, bool usePlan)
+{
+    const vector<Variable*>& vars = layout.tag.getVariables();
+    ConversionPlan& plan = layout.tag.getConversionPlan();
+    vector<float> values(layout.nvalues);
+    float sum = 0.0;
+
+    CaseTimer timer(usePlan ? "conversion_plan" : "variable_convert",
+                    layout.name);
+    timer.reserve(npass * nsamples / BATCH + 1);
+    timer.start();
+    for (int ip = 0; ip < npass; ip++) {
+        for (size_t i = 0; i < nsamples; ) {
+            size_t n = std::min(BATCH, nsamples - i);
+            for (size_t j = 0; j < n; j++, i++) {
+                const float* raw = layout.rawSample(i);
+                std::copy(raw, raw + layout.nvalues, values.begin());
+                if (usePlan)
+                    plan.apply(vars, i, values.data(), layout.nvalues);
+                else
+                    convertEach(vars, i, values.data());
+                sum += values[i % layout.nvalues];
+            }
+            timer.batch(n);
+        }
+    }
+    timer.stop();
+    // Keep the conversions from being optimized away.
+    if (sum == 1.2345f) cerr << sum << endl;
+    report.add(timer.getResult());
+}
+
+int
+usage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 <<
+        " [-n nsamples] [-p npass] [-c case] [-j file]\n"
+        "  -n nsamples: samples converted per pass, default 200000\n"
+        "  -p npass: passes over the samples, default 3\n"
+        "  -c case: only run cases whose name or layout contains\n"
+        "     this string\n"
+        "  -j file: write the results as JSON to file, '-' for stdout,\n"
+        "     instead of printing a table" << endl;
+    return 1;
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t nsamples = 200000;
+    int npass = 3;
+    string caseFilter;
+    string jsonFile;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:j:n:p:h")) != -1) {
+        switch (opt) {
+        case 'c':
+            caseFilter = optarg;
+            break;
+        case 'j':
+            jsonFile = optarg;
+            break;
+        case 'n':
+            nsamples = atol(optarg);
+            break;
+        case 'p':
+            npass = atoi(optarg);
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+    if (nsamples == 0 || npass < 1) return usage(argv[0]);
+
+    n_u::Logger::setScheme(
+        n_u::LogScheme("bench_conversions").addConfig("level=warning"));
+
+    BenchReport report("bench_conversions");
+    auto selected = [&caseFilter](const string& name, const string& input)
+    {
+        return caseFilter.empty() ||
+            name.find(caseFilter) != string::npos ||
+            input.find(caseFilter) != string::npos;
+    };
+
+    Layout a2d("a2d");
+    a2dLayout(a2d);
+    Layout histogram("histogram");
+    histogramLayout(histogram);
+    Layout mixed("mixed");
+    mixedLayout(mixed);
+
+    for (Layout* layout : { &a2d, &histogram, &mixed }) {
+        if (!checkLayout(*layout)) return 1;
+        if (selected("variable_convert", layout->name))
+            benchLayout(report, *layout, nsamples, npass, false);
+        if (selected("conversion_plan", layout->name))
+            benchLayout(report, *layout, nsamples, npass, true);
+    }
+
+    if (jsonFile.empty()) {
+        cout << "samples=" << nsamples << ", passes=" << npass << endl;
+        report.printTable(cout);
+    }
+    else if (jsonFile == "-") {
+        report.printJSON(cout);
+    }
+    else {
+        ofstream json(jsonFile.c_str());
+        report.printJSON(json);
+        if (!json) {
+            cerr << jsonFile << ": write failed" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,290 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Time the formatting of sample lines as data_dump and AsciiOutput print
+ * them, with ostream manipulators and UTime::format(), as they used to,
+ * and with FormatBuffer and UTimeFormatter.  The lines of both must be
+ * byte-identical.  Samples are generated at a fixed rate with random
+ * values, and the output throughput is reported in MB/s of text.
+ */
+
+#include <nidas/util/FormatBuffer.h>
+#include <nidas/util/UTime.h>
+#include <nidas/util/UTimeFormatter.h>
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+std::mt19937 rng(42);
+
+struct FakeSample
+{
+    long long tt;
+    unsigned int dsm;
+    unsigned int sid;
+    vector<float> values;
+    vector<unsigned char> bytes;
+};
+
+struct Case
+{
+    const char* name;
+    double rate;
+    int nvalues;
+    int nbytes;
+    bool csv;
+    bool ascii;     // AsciiOutput layout, otherwise data_dump
+};
+
+vector<FakeSample>
+makeSamples(const Case& c, int nsamples)
+{
+    std::normal_distribution<float> value(0, 200);
+    std::uniform_int_distribution<int> byte(0, 255);
+    vector<FakeSample> samples(nsamples);
+    long long t0 = n_u::UTime(true, 2026, 10, 17, 12, 0, 0).toUsecs();
+    for (int i = 0; i < nsamples; i++) {
+        FakeSample& s = samples[i];
+        s.tt = t0 + (long long)(i * USECS_PER_SEC / c.rate) + (i % 7);
+        s.dsm = 1 + i % 3;
+        s.sid = 100 + i % 5;
+        for (int j = 0; j < c.nvalues; j++) s.values.push_back(value(rng));
+        for (int j = 0; j < c.nbytes; j++) s.bytes.push_back(byte(rng));
+    }
+    return samples;
+}
+
+/*
+ * The line formatting of data_dump with an ostream, for float samples
+ * when nvalues > 0, otherwise hex.
+ */
+void
+dumpStream(ostream& ostr, const FakeSample& s, long long prev, bool csv)
+{
+    const char* sep = csv ? "," : " ";
+    double tdiff = prev ? (s.tt - prev) / (double)USECS_PER_SEC : 0.0;
+    if (!csv) ostr << setw(24);
+    ostr << n_u::UTime(s.tt).format(true, "%Y %m %d %H:%M:%S.%4f");
+    ostr << setprecision(4) << sep;
+    if (!csv) ostr << setw(7);
+    ostr << tdiff << sep;
+    if (!csv) ostr << setw(3);
+    ostr << s.dsm << "," << setw(4) << s.sid << sep;
+    if (!csv) ostr << setw(7);
+    ostr << (s.values.size() * 4 + s.bytes.size());
+    if (!s.values.empty()) {
+        ostr << setprecision(5);
+        for (size_t i = 0; i < s.values.size(); i++) {
+            ostr << sep;
+            if (!csv) ostr << setw(10);
+            ostr << (double)s.values[i];
+        }
+    }
+    else {
+        ostr << setfill('0');
+        for (size_t i = 0; i < s.bytes.size(); i++) {
+            ostr << sep;
+            if (!csv) ostr << setw(2);
+            ostr << hex << (unsigned int)s.bytes[i];
+        }
+        ostr << dec << setfill(' ');
+    }
+    ostr << '\n';
+}
+
+void
+dumpBuffer(n_u::FormatBuffer& buf, n_u::UTimeFormatter& tfmt,
+           const FakeSample& s, long long prev, bool csv)
+{
+    char sep = csv ? ',' : ' ';
+    double tdiff = prev ? (s.tt - prev) / (double)USECS_PER_SEC : 0.0;
+    size_t start = buf.size();
+    tfmt.append(buf, s.tt);
+    buf.justify(start, csv ? 0 : 24);
+    buf.append(sep);
+    buf.appendGeneral(tdiff, 4, csv ? 0 : 7);
+    buf.append(sep);
+    buf.appendUnsigned(s.dsm, csv ? 0 : 3);
+    buf.append(',');
+    buf.appendUnsigned(s.sid, 4);
+    buf.append(sep);
+    buf.appendUnsigned(s.values.size() * 4 + s.bytes.size(), csv ? 0 : 7);
+    for (size_t i = 0; i < s.values.size(); i++) {
+        buf.append(sep);
+        buf.appendGeneral(s.values[i], 5, csv ? 0 : 10);
+    }
+    for (size_t i = 0; i < s.bytes.size(); i++) {
+        buf.append(sep);
+        buf.appendHex(s.bytes[i], csv ? 0 : 2, '0');
+    }
+    buf.append('\n');
+}
+
+/*
+ * The line formatting of AsciiOutput with an ostream.
+ */
+void
+asciiStream(ostream& ostr, const FakeSample& s, long long prev)
+{
+    double tdiff = prev ? (s.tt - prev) / (double)USECS_PER_SEC : 0.0;
+    ostr << setw(3) << s.dsm << ',' << setw(5) << s.sid << ' ' <<
+        n_u::UTime(s.tt).format(true, "%Y %m %d %H:%M:%S.%3f ") <<
+        setfill(' ') << setprecision(3) << setw(5) << tdiff << ' ' <<
+        setw(7) << setfill(' ') << (s.values.size() * 4 + s.bytes.size()) <<
+        ' ';
+    if (!s.values.empty()) {
+        ostr << setprecision(7) << setfill(' ');
+        for (size_t i = 0; i < s.values.size(); i++)
+            ostr << setw(10) << (double)s.values[i] << ' ';
+    }
+    else {
+        ostr << setfill('0');
+        for (size_t i = 0; i < s.bytes.size(); i++)
+            ostr << hex << setw(2) << (unsigned int)s.bytes[i] << dec << ' ';
+        ostr << setfill(' ');
+    }
+    ostr << '\n';
+}
+
+void
+asciiBuffer(n_u::FormatBuffer& buf, n_u::UTimeFormatter& tfmt,
+            const FakeSample& s, long long prev)
+{
+    double tdiff = prev ? (s.tt - prev) / (double)USECS_PER_SEC : 0.0;
+    buf.appendUnsigned(s.dsm, 3);
+    buf.append(',');
+    buf.appendUnsigned(s.sid, 5);
+    buf.append(' ');
+    tfmt.append(buf, s.tt);
+    buf.appendGeneral(tdiff, 3, 5);
+    buf.append(' ');
+    buf.appendUnsigned(s.values.size() * 4 + s.bytes.size(), 7);
+    buf.append(' ');
+    for (size_t i = 0; i < s.values.size(); i++) {
+        buf.appendGeneral(s.values[i], 7, 10);
+        buf.append(' ');
+    }
+    for (size_t i = 0; i < s.bytes.size(); i++) {
+        buf.appendHex(s.bytes[i], 2, '0');
+        buf.append(' ');
+    }
+    buf.append('\n');
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    int niter = 5;
+    if (argc > 1)
+        niter = atoi(argv[1]);
+    const int nsamples = 50000;
+
+    const Case all[] = {
+        { "float-20Hz-8", 20, 8, 0, false, false },
+        { "float-1kHz-1", 1000, 1, 0, false, false },
+        { "float-csv", 20, 8, 0, true, false },
+        { "hex-40", 10, 0, 40, false, false },
+        { "ascii-float", 20, 8, 0, false, true },
+        { "ascii-hex", 10, 0, 40, false, true },
+    };
+
+    cout << "samples per case=" << nsamples << ", passes=" << niter << endl;
+    cout << setw(14) << left << "case" << right
+         << setw(14) << "ostream MB/s"
+         << setw(14) << "buffer MB/s"
+         << setw(10) << "speedup" << endl;
+
+    int status = 0;
+    for (size_t ic = 0; ic < sizeof(all) / sizeof(all[0]); ic++) {
+        const Case& c = all[ic];
+        vector<FakeSample> samples = makeSamples(c, nsamples);
+
+        string text[2];
+        double secs[2];
+
+        // ostream
+        {
+            long long t0 = n_u::getSystemTime();
+            for (int iter = 0; iter < niter; iter++) {
+                ostringstream ostr;
+                long long prev = 0;
+                for (size_t i = 0; i < samples.size(); i++) {
+                    if (c.ascii) asciiStream(ostr, samples[i], prev);
+                    else dumpStream(ostr, samples[i], prev, c.csv);
+                    prev = samples[i].tt;
+                }
+                if (iter == niter - 1) text[0] = ostr.str();
+            }
+            secs[0] = (n_u::getSystemTime() - t0) / (double)USECS_PER_SEC;
+        }
+
+        // FormatBuffer, one line at a time as in receive()
+        {
+            n_u::UTimeFormatter tfmt(c.ascii ? "%Y %m %d %H:%M:%S.%3f " :
+                                     "%Y %m %d %H:%M:%S.%4f");
+            n_u::FormatBuffer buf;
+            long long t0 = n_u::getSystemTime();
+            for (int iter = 0; iter < niter; iter++) {
+                string out;
+                long long prev = 0;
+                for (size_t i = 0; i < samples.size(); i++) {
+                    buf.clear();
+                    if (c.ascii) asciiBuffer(buf, tfmt, samples[i], prev);
+                    else dumpBuffer(buf, tfmt, samples[i], prev, c.csv);
+                    prev = samples[i].tt;
+                    if (iter == niter - 1) out.append(buf.data(), buf.size());
+                }
+                if (iter == niter - 1) text[1] = out;
+            }
+            secs[1] = (n_u::getSystemTime() - t0) / (double)USECS_PER_SEC;
+        }
+
+        double mb = (double)text[0].size() * niter / 1.e6;
+        cout << setw(14) << left << c.name << right << fixed
+             << setw(14) << setprecision(1) << mb / secs[0]
+             << setw(14) << setprecision(1) << mb / secs[1]
+             << setw(9) << setprecision(2) << secs[0] / secs[1] << "x";
+        if (text[0] != text[1]) {
+            cout << "  OUTPUT DIFFERS";
+            status = 1;
+        }
+        cout << endl;
+    }
+    return status;
+}
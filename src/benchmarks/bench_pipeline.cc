@@ -0,0 +1,920 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Time the components of the sample pipeline on synthetic sample
+ * streams and on recorded archives given on the command line, and
+ * report samples/s, ns/sample, allocations/sample and latency
+ * percentiles of each, as a table or as JSON.
+ *
+ * The synthetic stream has the sensor layout and sample rates of a
+ * small aircraft configuration, with samples arriving up to 20 msec
+ * out of time order, as they do from the DSMs.  A recorded archive is
+ * read with SampleInputStream, and its first samples are then replayed
+ * through the other components in the order they were archived.
+ *
+ * Latencies are the mean times per sample of consecutive batches of
+ * samples, except in the SampleSorter cases, where they are the times
+ * from SampleSorter::receive() to the distribution of each sample.
+ * Those depend on how quickly the length of the sorter is filled, and
+ * so should only be compared between runs with the same input.
+ */
+
+#include "BenchHarness.h"
+
+#include <nidas/core/AsciiSscanf.h>
+#include <nidas/core/DSMSensor.h>
+#include <nidas/core/FileSet.h>
+#include <nidas/core/IOStream.h>
+#include <nidas/core/Sample.h>
+#include <nidas/core/SampleInputHeader.h>
+#include <nidas/core/SampleScanner.h>
+#include <nidas/core/SampleSorter.h>
+#include <nidas/core/SampleSourceSupport.h>
+#include <nidas/core/SampleTag.h>
+#include <nidas/core/UnixIOChannel.h>
+#include <nidas/core/Variable.h>
+#include <nidas/core/Version.h>
+#include <nidas/dynld/SampleInputStream.h>
+#include <nidas/dynld/StatisticsCruncher.h>
+#include <nidas/dynld/StatisticsProcessor.h>
+#include <nidas/util/EOFException.h>
+#include <nidas/util/Logger.h>
+#include <nidas/util/UTime.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace nidas::core;
+using namespace std;
+
+using nidas::dynld::SampleInputStream;
+using nidas::dynld::StatisticsCruncher;
+using nidas::dynld::StatisticsProcessor;
+
+using bench::BenchReport;
+using bench::BenchResult;
+using bench::CaseTimer;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+std::mt19937 rng(42);
+
+/**
+ * Samples per latency batch.
+ */
+const size_t BATCH = 256;
+
+/**
+ * A stream of samples, in the order they arrive, holding a
+ * reference on each.
+ */
+struct SampleStream
+{
+    SampleStream(const string& n): name(n), samples() {}
+
+    ~SampleStream()
+    {
+        for (Sample* samp : samples) samp->freeReference();
+    }
+
+    string name;
+
+    vector<Sample*> samples;
+
+    SampleStream(const SampleStream&) = delete;
+    SampleStream& operator=(const SampleStream&) = delete;
+};
+
+dsm_sample_id_t
+makeId(unsigned int dsmid, unsigned int spsid)
+{
+    dsm_sample_id_t id = 0;
+    id = SET_DSM_ID(id, dsmid);
+    return SET_SPS_ID(id, spsid);
+}
+
+/**
+ * Raw float samples of four DSMs, with twelve sensors each at the
+ * usual rates and from 1 to 16 values per sample.  The arrival time
+ * of each sample is its time tag plus up to 20 msec.
+ */
+void
+syntheticStream(SampleStream& stream, size_t nsamples)
+{
+    const float rates[] = { 1, 10, 20, 25, 50, 100 };
+    struct Sensor
+    {
+        dsm_sample_id_t id;
+        float rate;
+        unsigned int nvalues;
+    };
+    vector<Sensor> sensors;
+    float totalRate = 0;
+    for (unsigned int dsmid = 1; dsmid <= 4; dsmid++) {
+        for (unsigned int is = 1; is <= 12; is++) {
+            Sensor sensor = { makeId(dsmid, is * 10), rates[(dsmid + is) % 6],
+                              1 + (dsmid * 7 + is * 5) % 16 };
+            sensors.push_back(sensor);
+            totalRate += sensor.rate;
+        }
+    }
+
+    struct Arrival
+    {
+        dsm_time_t arrival;
+        dsm_time_t tt;
+        size_t sensor;
+    };
+    vector<Arrival> arrivals;
+    double secs = nsamples / totalRate;
+    dsm_time_t t0 = n_u::UTime::parse(true, "2026 10 17 00:00:00").toUsecs();
+    std::uniform_int_distribution<int> delay(0, 20 * USECS_PER_MSEC);
+    for (size_t is = 0; is < sensors.size(); is++) {
+        dsm_time_t dt = (dsm_time_t)(USECS_PER_SEC / sensors[is].rate);
+        dsm_time_t tt = t0 + is * 997;
+        for (int i = 0; i < secs * sensors[is].rate; i++, tt += dt)
+            arrivals.push_back({ tt + delay(rng), tt, is });
+    }
+    std::sort(arrivals.begin(), arrivals.end(),
+        [](const Arrival& a, const Arrival& b)
+        { return a.arrival < b.arrival; });
+    if (arrivals.size() > nsamples) arrivals.resize(nsamples);
+
+    std::uniform_real_distribution<float> value(-100, 100);
+    for (const Arrival& a : arrivals) {
+        const Sensor& sensor = sensors[a.sensor];
+        SampleT<float>* samp = getSample<float>(sensor.nvalues);
+        samp->setId(sensor.id);
+        samp->setTimeTag(a.tt);
+        for (unsigned int i = 0; i < sensor.nvalues; i++)
+            samp->getDataPtr()[i] = value(rng);
+        stream.samples.push_back(samp);
+    }
+}
+
+/**
+ * A copy of a sample, from the pool.
+ */
+Sample*
+copySample(const Sample* samp)
+{
+    Sample* copy = getSample(samp->getType(), samp->getDataByteLength());
+    copy->setId(samp->getId());
+    copy->setTimeTag(samp->getTimeTag());
+    ::memcpy(copy->getVoidDataPtr(), samp->getConstVoidDataPtr(),
+             samp->getDataByteLength());
+    return copy;
+}
+
+/**
+ * Client which counts the samples it receives.
+ */
+class CountClient: public SampleClient
+{
+public:
+    CountClient(): count(0) {}
+
+    bool receive(const Sample*) throw()
+    {
+        count++;
+        return true;
+    }
+
+    void flush() throw() {}
+
+    long long count;
+};
+
+/**
+ * Client which holds the samples it receives, up to a maximum.
+ */
+class HoldClient: public SampleClient
+{
+public:
+    HoldClient(SampleStream& s, size_t max): stream(s), maxSamples(max) {}
+
+    bool receive(const Sample* samp) throw()
+    {
+        if (stream.samples.size() < maxSamples) {
+            samp->holdReference();
+            stream.samples.push_back(const_cast<Sample*>(samp));
+        }
+        return true;
+    }
+
+    void flush() throw() {}
+
+    SampleStream& stream;
+
+    size_t maxSamples;
+
+    HoldClient(const HoldClient&) = delete;
+    HoldClient& operator=(const HoldClient&) = delete;
+};
+
+/**
+ * Get samples from the pool and free them, with 256 held at once.
+ */
+void
+benchSamplePool(BenchReport& report, const SampleStream& stream, int npass)
+{
+    const vector<Sample*>& samps = stream.samples;
+    vector<Sample*> held(BATCH, 0);
+
+    // warm up the pools
+    for (size_t i = 0; i < samps.size() && i < 10 * BATCH; i++) {
+        Sample*& h = held[i % BATCH];
+        if (h) h->freeReference();
+        h = getSample(samps[i]->getType(), samps[i]->getDataByteLength());
+    }
+
+    CaseTimer timer("sample_pool", stream.name);
+    timer.reserve(npass * samps.size() / BATCH + 1);
+    timer.start();
+    for (int ip = 0; ip < npass; ip++) {
+        for (size_t i = 0; i < samps.size(); ) {
+            size_t n = std::min(BATCH, samps.size() - i);
+            for (size_t j = 0; j < n; j++, i++) {
+                Sample*& h = held[j];
+                if (h) h->freeReference();
+                h = getSample(samps[i]->getType(),
+                              samps[i]->getDataByteLength());
+            }
+            timer.batch(n);
+        }
+    }
+    timer.stop();
+    for (Sample* h : held) if (h) h->freeReference();
+    report.add(timer.getResult());
+}
+
+/**
+ * distribute() the samples to two clients of all samples and to a
+ * client of every fourth sample id, one sample at a time or in
+ * batches.
+ */
+void
+benchDistribute(BenchReport& report, const SampleStream& stream, int npass,
+                bool batched)
+{
+    const vector<Sample*>& samps = stream.samples;
+
+    SampleSourceSupport source(true);
+    CountClient all1, all2, some;
+    source.addSampleClient(&all1);
+    source.addSampleClient(&all2);
+
+    vector<dsm_sample_id_t> ids;
+    for (const Sample* samp : samps) ids.push_back(samp->getId());
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    vector<std::unique_ptr<SampleTag> > tags;
+    for (size_t i = 0; i < ids.size(); i += 4) {
+        tags.emplace_back(new SampleTag());
+        tags.back()->setDSMId(GET_DSM_ID(ids[i]));
+        tags.back()->setSensorId(GET_SPS_ID(ids[i]));
+        source.addSampleClientForTag(&some, tags.back().get());
+    }
+
+    CaseTimer timer(batched ? "distribute_batch" : "distribute", stream.name);
+    timer.reserve(npass * samps.size() / BATCH + 1);
+    timer.start();
+    for (int ip = 0; ip < npass; ip++) {
+        // distribute() frees a reference to each sample
+        timer.pause();
+        for (Sample* samp : samps) samp->holdReference();
+        timer.resume();
+        for (size_t i = 0; i < samps.size(); ) {
+            size_t n = std::min(BATCH, samps.size() - i);
+            if (batched) {
+                source.distribute(&samps[i], n);
+                i += n;
+            }
+            else {
+                for (size_t j = 0; j < n; j++)
+                    source.distribute(samps[i++]);
+            }
+            timer.batch(n);
+        }
+    }
+    timer.stop();
+    source.removeAllSampleClients();
+
+    if (all1.count != (long long)(npass * samps.size()))
+        cerr << timer.getResult().name << ": client received "
+             << all1.count << " samples, expected "
+             << npass * samps.size() << endl;
+    report.add(timer.getResult());
+}
+
+/**
+ * Write the samples to /dev/null with IOStream::write(), as
+ * SampleOutputStream does, copying all buffers or gathering the
+ * data of samples of 256 or more bytes.
+ */
+void
+benchIOStream(BenchReport& report, const SampleStream& stream, int npass,
+              bool gather)
+{
+    const vector<Sample*>& samps = stream.samples;
+    int fd = ::open("/dev/null", O_WRONLY);
+    if (fd < 0) throw n_u::IOException("/dev/null", "open", errno);
+    UnixIOChannel channel("/dev/null", fd);
+
+    CaseTimer timer(gather ? "iostream_write_gather" : "iostream_write",
+                    stream.name);
+    timer.reserve(npass * samps.size() / BATCH + 1);
+    {
+        IOStream iostream(channel);
+        if (gather) iostream.setGatherMinLength(256);
+        struct iovec iov[2];
+
+        timer.start();
+        for (int ip = 0; ip < npass; ip++) {
+            for (size_t i = 0; i < samps.size(); ) {
+                size_t n = std::min(BATCH, samps.size() - i);
+                for (size_t j = 0; j < n; j++) {
+                    const Sample* samp = samps[i++];
+                    iov[0].iov_base = const_cast<void*>(samp->getHeaderPtr());
+                    iov[0].iov_len = samp->getHeaderLength();
+                    iov[1].iov_base =
+                        const_cast<void*>(samp->getConstVoidDataPtr());
+                    iov[1].iov_len = samp->getDataByteLength();
+                    iostream.write(iov, 2, false, samp);
+                }
+                timer.batch(n);
+            }
+        }
+        iostream.flush();
+        timer.stop();
+    }
+    ::close(fd);
+    report.add(timer.getResult());
+}
+
+/**
+ * Client of a SampleSorter which records the time each sample
+ * comes out.
+ */
+class LatencyClient: public SampleClient
+{
+public:
+    LatencyClient(const unordered_map<const Sample*, size_t>& index,
+                  vector<long long>& times):
+        _index(index), _times(times), count(0)
+    {}
+
+    bool receive(const Sample* samp) throw()
+    {
+        long long t = bench::nanoTime();
+        unordered_map<const Sample*, size_t>::const_iterator si =
+            _index.find(samp);
+        if (si != _index.end()) _times[si->second] = t;
+        count++;
+        return true;
+    }
+
+    void flush() throw() {}
+
+private:
+    const unordered_map<const Sample*, size_t>& _index;
+
+    vector<long long>& _times;
+
+public:
+    long long count;
+
+    LatencyClient(const LatencyClient&) = delete;
+    LatencyClient& operator=(const LatencyClient&) = delete;
+};
+
+/**
+ * Sort copies of the samples with a one second SampleSorter, using
+ * the SortedSampleSet or the bucket sort.
+ */
+void
+benchSampleSorter(BenchReport& report, const SampleStream& stream,
+                  bool bucket)
+{
+    const vector<Sample*>& samps = stream.samples;
+    vector<Sample*> copies;
+    unordered_map<const Sample*, size_t> index;
+    for (size_t i = 0; i < samps.size(); i++) {
+        copies.push_back(copySample(samps[i]));
+        index[copies.back()] = i;
+    }
+    vector<long long> tin(copies.size(), 0);
+    vector<long long> tout(copies.size(), 0);
+
+    SampleSorter sorter("BenchSorter", true);
+    sorter.setLengthSecs(1.0);
+    sorter.setHeapMax(1000000000);
+    sorter.setHeapBlock(true);
+    sorter.setBucketSort(bucket);
+    LatencyClient client(index, tout);
+    sorter.addSampleClient(&client);
+    sorter.start();
+
+    CaseTimer timer(bucket ? "sample_sorter_bucket" : "sample_sorter",
+                    stream.name, "end_to_end");
+    timer.reserve(copies.size());
+    timer.start();
+    for (size_t i = 0; i < copies.size(); i++) {
+        tin[i] = bench::nanoTime();
+        sorter.receive(copies[i]);
+        copies[i]->freeReference();
+    }
+    sorter.flush();
+    timer.addItems(copies.size());
+    timer.stop();
+
+    sorter.interrupt();
+    sorter.join();
+    sorter.removeSampleClient(&client);
+
+    for (size_t i = 0; i < copies.size(); i++)
+        if (tout[i] > 0) timer.latency(tout[i] - tin[i]);
+    BenchResult result = timer.getResult();
+    std::sort(result.latencies.begin(), result.latencies.end());
+
+    if (client.count != (long long)copies.size())
+        cerr << result.name << ": client received " << client.count
+             << " samples, expected " << copies.size() << endl;
+    report.add(result);
+}
+
+/**
+ * Write the samples to an archive file, with a header.
+ */
+void
+writeArchive(const SampleStream& stream, const string& path)
+{
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) throw n_u::IOException(path, "open", errno);
+    UnixIOChannel channel(path, fd);
+    {
+        IOStream iostream(channel);
+        SampleInputHeader header;
+        header.setArchiveVersion(Version::getArchiveVersion());
+        header.setSoftwareVersion(Version::getSoftwareVersion());
+        header.setProjectName("bench");
+        header.setSystemName("bench");
+        header.setConfigName("bench.xml");
+        header.setConfigVersion("1");
+        header.write(&iostream);
+        struct iovec iov[2];
+        for (const Sample* samp : stream.samples) {
+            iov[0].iov_base = const_cast<void*>(samp->getHeaderPtr());
+            iov[0].iov_len = samp->getHeaderLength();
+            iov[1].iov_base = const_cast<void*>(samp->getConstVoidDataPtr());
+            iov[1].iov_len = samp->getDataByteLength();
+            iostream.write(iov, 2, false);
+        }
+        iostream.flush();
+    }
+    channel.close();
+}
+
+/**
+ * Read an archive with SampleInputStream, counting the samples with
+ * a client, as data_dump and the other readers do.
+ */
+long long
+readArchive(const string& path, SampleClient* client, CaseTimer* timer)
+{
+    list<string> files;
+    files.push_back(path);
+    nidas::core::FileSet* fset = nidas::core::FileSet::getFileSet(files);
+    SampleInputStream sis(fset->connect(), false);
+    CountClient counter;
+    sis.addSampleClient(&counter);
+    if (client) sis.addSampleClient(client);
+
+    if (timer) timer->resume();
+    sis.readInputHeader();
+    long long nlast = 0;
+    try {
+        for (;;) {
+            sis.readSamples();
+            if (timer && counter.count - nlast >= (long long)BATCH) {
+                timer->batch(counter.count - nlast);
+                nlast = counter.count;
+            }
+        }
+    }
+    catch (const n_u::EOFException&) {
+    }
+    if (timer) {
+        timer->batch(counter.count - nlast);
+        timer->pause();
+    }
+
+    sis.removeSampleClient(&counter);
+    if (client) sis.removeSampleClient(client);
+    sis.close();
+    return counter.count;
+}
+
+/**
+ * Time the reading of an archive, after a first pass which reads it
+ * into the page cache.  If hold is non-null, the first maxHold samples
+ * of the first pass are kept in it.
+ */
+void
+benchSampleInputStream(BenchReport& report, const string& path,
+                       const string& input, int npass,
+                       SampleStream* hold = 0, size_t maxHold = 0)
+{
+    std::unique_ptr<HoldClient> holder;
+    if (hold) holder.reset(new HoldClient(*hold, maxHold));
+    readArchive(path, holder.get(), 0);
+
+    CaseTimer timer("sample_input_stream", input);
+    timer.reserve(100000);
+    timer.start();
+    timer.pause();
+    for (int ip = 0; ip < npass; ip++)
+        readArchive(path, 0, &timer);
+    timer.resume();
+    timer.stop();
+    report.add(timer.getResult());
+}
+
+/**
+ * Sonic anemometer messages, as a CSAT3 sends them when
+ * configured for ASCII output.
+ */
+string
+sonicMessages(size_t nmessages)
+{
+    std::uniform_real_distribution<double> wind(-10, 10);
+    std::uniform_real_distribution<double> temp(-20, 35);
+    string msgs;
+    char buf[128];
+    for (size_t i = 0; i < nmessages; i++) {
+        snprintf(buf, sizeof(buf), "%7.3f %7.3f %7.3f %6.2f %d %d\r\n",
+                 wind(rng), wind(rng), wind(rng) / 3, temp(rng),
+                 (int)(i % 64), (int)(i % 2));
+        msgs += buf;
+    }
+    return msgs;
+}
+
+/**
+ * DSMSensor which reads from a string, for MessageStreamScanner.
+ */
+class StringSensor: public DSMSensor
+{
+public:
+    StringSensor(const string& data): _data(data), _pos(0)
+    {
+        setId(makeId(1, 100));
+    }
+
+    IODevice* buildIODevice() { return 0; }
+
+    SampleScanner* buildSampleScanner() { return 0; }
+
+    size_t read(void *buf, size_t len)
+    {
+        len = std::min(len, _data.length() - _pos);
+        ::memcpy(buf, _data.data() + _pos, len);
+        _pos += len;
+        return len;
+    }
+
+    size_t read(void *buf, size_t len, int)
+    {
+        return read(buf, len);
+    }
+
+    bool atEnd() const { return _pos == _data.length(); }
+
+    void rewind() { _pos = 0; }
+
+private:
+    const string& _data;
+
+    size_t _pos;
+};
+
+/**
+ * Split a stream of messages at their CR-NL separators with a
+ * MessageStreamScanner, reading it in buffers as a CharacterSensor
+ * does from a serial port.
+ */
+void
+benchMessageStreamScanner(BenchReport& report, size_t nmessages, int npass)
+{
+    string data = sonicMessages(nmessages);
+    StringSensor sensor(data);
+    MessageStreamScanner scanner;
+    scanner.setMessageParameters(0, "\\r\\n", true);
+
+    CaseTimer timer("message_stream_scanner", "synthetic");
+    timer.reserve(npass * nmessages / 32 + 1);
+    timer.start();
+    for (int ip = 0; ip < npass; ip++) {
+        sensor.rewind();
+        while (!sensor.atEnd()) {
+            bool exhausted;
+            scanner.readBuffer(&sensor, exhausted);
+            long long n = 0;
+            while (Sample* samp = scanner.nextSample(&sensor)) {
+                samp->freeReference();
+                n++;
+            }
+            timer.batch(n);
+        }
+    }
+    timer.stop();
+    report.add(timer.getResult());
+}
+
+/**
+ * Scan the sonic messages with AsciiSscanf, using the compiled
+ * format.
+ */
+void
+benchAsciiSscanf(BenchReport& report, size_t nmessages, int npass)
+{
+    string data = sonicMessages(nmessages);
+    vector<string> msgs;
+    for (size_t p = 0; p < data.length(); ) {
+        size_t e = data.find('\n', p) + 1;
+        msgs.push_back(data.substr(p, e - p));
+        p = e;
+    }
+
+    AsciiSscanf scanner;
+    scanner.setFormat("%f %f %f %f %*d %*d");
+    float values[4];
+
+    CaseTimer timer("ascii_sscanf", "synthetic");
+    timer.reserve(npass * msgs.size() / BATCH + 1);
+    timer.start();
+    int nbad = 0;
+    for (int ip = 0; ip < npass; ip++) {
+        for (size_t i = 0; i < msgs.size(); ) {
+            size_t n = std::min(BATCH, msgs.size() - i);
+            for (size_t j = 0; j < n; j++)
+                if (scanner.sscanf(msgs[i++].c_str(), values, 4) != 4) nbad++;
+            timer.batch(n);
+        }
+    }
+    timer.stop();
+    if (nbad) cerr << "ascii_sscanf: " << nbad << " messages not scanned"
+                   << endl;
+    report.add(timer.getResult());
+}
+
+/**
+ * Covariances of five variables of a 20 Hz sample over 5 minute
+ * periods, with a StatisticsCruncher connected to a SampleSource
+ * of the samples, as in statsproc.
+ */
+void
+benchStatisticsCruncher(BenchReport& report, size_t nsamples, int npass)
+{
+    const char* names[] = { "u", "v", "w", "tc", "h2o" };
+    const int nvars = 5;
+
+    SampleTag intag;
+    intag.setDSMId(1);
+    intag.setSensorId(10);
+    intag.setRate(20.0);
+    SampleTag reqtag;
+    reqtag.setDSMId(1);
+    reqtag.setSensorId(0x8000);
+    reqtag.setRate(1.0 / 300.0);
+    for (int i = 0; i < nvars; i++) {
+        Variable* var = new Variable();
+        var->setName(names[i]);
+        intag.addVariable(var);
+        var = new Variable();
+        var->setName(names[i]);
+        reqtag.addVariable(var);
+    }
+
+    SampleSourceSupport source(false);
+    source.addSampleTag(&intag);
+
+    StatisticsProcessor proc;
+    StatisticsCruncher cruncher(&proc, &reqtag,
+        StatisticsCruncher::STATS_COV, "", false);
+    cruncher.connect(&source);
+    CountClient out;
+    cruncher.addSampleClient(&out);
+
+    SampleStream stream("synthetic");
+    std::normal_distribution<float> value(0, 2);
+    dsm_time_t t0 = n_u::UTime::parse(true, "2026 10 17 00:00:00").toUsecs();
+    for (size_t i = 0; i < nsamples; i++) {
+        SampleT<float>* samp = getSample<float>(nvars);
+        samp->setId(intag.getId());
+        samp->setTimeTag(t0 + i * USECS_PER_SEC / 20);
+        for (int j = 0; j < nvars; j++)
+            samp->getDataPtr()[j] = value(rng);
+        stream.samples.push_back(samp);
+    }
+
+    CaseTimer timer("statistics_cov", stream.name);
+    timer.reserve(npass * nsamples / BATCH + 1);
+    timer.start();
+    for (int ip = 0; ip < npass; ip++) {
+        // Shift the time tags of each pass past the previous one,
+        // and hold a reference for distribute() to free.
+        timer.pause();
+        dsm_time_t dt = (dsm_time_t) nsamples * USECS_PER_SEC / 20;
+        for (Sample* samp : stream.samples) {
+            if (ip > 0) samp->setTimeTag(samp->getTimeTag() + dt);
+            samp->holdReference();
+        }
+        timer.resume();
+        for (size_t i = 0; i < nsamples; ) {
+            size_t n = std::min(BATCH, nsamples - i);
+            for (size_t j = 0; j < n; j++)
+                source.distribute(stream.samples[i++]);
+            timer.batch(n);
+        }
+    }
+    timer.stop();
+    cruncher.flush();
+    cruncher.disconnect(&source);
+    cruncher.removeSampleClient(&out);
+
+    const BenchResult& result = timer.getResult();
+    if (out.count == 0)
+        cerr << result.name << ": no statistics were computed" << endl;
+    report.add(result);
+}
+
+int
+usage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 <<
+        " [-n nsamples] [-p npass] [-c case] [-j file] [archive ...]\n"
+        "  -n nsamples: length of the synthetic streams, and maximum\n"
+        "     number of samples of an archive to replay, default 200000\n"
+        "  -p npass: passes over each stream, default 3\n"
+        "  -c case: only run cases whose name contains this string\n"
+        "  -j file: write the results as JSON to file, '-' for stdout,\n"
+        "     instead of printing a table\n"
+        "  archive: NIDAS archive files of raw samples to read and\n"
+        "     replay, in addition to the synthetic streams" << endl;
+    return 1;
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t nsamples = 200000;
+    int npass = 3;
+    string caseFilter;
+    string jsonFile;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:j:n:p:h")) != -1) {
+        switch (opt) {
+        case 'c':
+            caseFilter = optarg;
+            break;
+        case 'j':
+            jsonFile = optarg;
+            break;
+        case 'n':
+            nsamples = atol(optarg);
+            break;
+        case 'p':
+            npass = atoi(optarg);
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+    if (nsamples == 0 || npass < 1) return usage(argv[0]);
+    vector<string> archives(argv + optind, argv + argc);
+
+    n_u::Logger::setScheme(
+        n_u::LogScheme("bench_pipeline").addConfig("level=warning"));
+
+    BenchReport report("bench_pipeline");
+    auto selected = [&caseFilter](const string& name)
+    {
+        return caseFilter.empty() || name.find(caseFilter) != string::npos;
+    };
+
+    try {
+        vector<std::unique_ptr<SampleStream> > streams;
+        streams.emplace_back(new SampleStream("synthetic"));
+        syntheticStream(*streams.back(), nsamples);
+
+        if (selected("sample_input_stream")) {
+            char tmpl[] = "/tmp/bench_pipeline_XXXXXX";
+            int fd = ::mkstemp(tmpl);
+            if (fd < 0) throw n_u::IOException(tmpl, "mkstemp", errno);
+            ::close(fd);
+            try {
+                writeArchive(*streams.front(), tmpl);
+                benchSampleInputStream(report, tmpl, "synthetic", npass);
+            }
+            catch (const n_u::Exception&) {
+                ::unlink(tmpl);
+                throw;
+            }
+            ::unlink(tmpl);
+        }
+        for (const string& archive : archives) {
+            streams.emplace_back(new SampleStream(archive));
+            benchSampleInputStream(report, archive, archive, npass,
+                                   streams.back().get(), nsamples);
+        }
+
+        for (const auto& stream : streams) {
+            if (stream->samples.empty()) continue;
+            if (selected("sample_pool"))
+                benchSamplePool(report, *stream, npass);
+            if (selected("distribute"))
+                benchDistribute(report, *stream, npass, false);
+            if (selected("distribute_batch"))
+                benchDistribute(report, *stream, npass, true);
+            if (selected("iostream_write"))
+                benchIOStream(report, *stream, npass, false);
+            if (selected("iostream_write_gather"))
+                benchIOStream(report, *stream, npass, true);
+            if (selected("sample_sorter"))
+                benchSampleSorter(report, *stream, false);
+            if (selected("sample_sorter_bucket"))
+                benchSampleSorter(report, *stream, true);
+        }
+
+        if (selected("message_stream_scanner"))
+            benchMessageStreamScanner(report, nsamples, npass);
+        if (selected("ascii_sscanf"))
+            benchAsciiSscanf(report, nsamples, npass);
+        if (selected("statistics_cov"))
+            benchStatisticsCruncher(report, nsamples, npass);
+    }
+    catch (const n_u::Exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    if (jsonFile.empty()) {
+        cout << "samples per stream=" << nsamples << ", passes=" << npass
+             << endl;
+        report.printTable(cout);
+    }
+    else if (jsonFile == "-") {
+        report.printJSON(cout);
+    }
+    else {
+        ofstream json(jsonFile.c_str());
+        report.printJSON(json);
+        if (!json) {
+            cerr << jsonFile << ": write failed" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
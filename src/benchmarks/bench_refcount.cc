@@ -0,0 +1,206 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Throughput of Sample::holdReference()/freeReference() pairs from
+ * 1 to 16 threads, compared against a mutex-protected counter like the
+ * one Sample used before it switched to an atomic reference count.
+ *
+ * Two access patterns are timed: every thread hammering the same
+ * sample, as happens when SampleSourceSupport::distribute() fans one
+ * sample out to many clients, and each thread working on its own
+ * sample, which has no contention on the count itself.
+ */
+
+#include <nidas/core/Sample.h>
+#include <nidas/util/Thread.h>
+#include <nidas/util/UTime.h>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <cstdlib>
+
+using namespace nidas::core;
+using namespace std;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+/**
+ * The reference count of a Sample before the atomic change, for
+ * comparison.
+ */
+class MutexRefCount
+{
+public:
+    MutexRefCount(): _refCount(1), _refLock() {}
+
+    void holdReference()
+    {
+        _refLock.lock();
+        _refCount++;
+        _refLock.unlock();
+    }
+
+    bool freeReference()
+    {
+        _refLock.lock();
+        bool ref0 = --_refCount == 0;
+        _refLock.unlock();
+        return ref0;
+    }
+
+private:
+    int _refCount;
+    n_u::Mutex _refLock;
+};
+
+class AtomicLoop: public n_u::Thread
+{
+public:
+    AtomicLoop(const Sample* samp, long niter):
+        n_u::Thread("AtomicLoop"), _samp(samp), _niter(niter)
+    {}
+
+    int run() override
+    {
+        for (long i = 0; i < _niter; ++i) {
+            _samp->holdReference();
+            _samp->freeReference();
+        }
+        return RUN_OK;
+    }
+
+private:
+    const Sample* _samp;
+    long _niter;
+
+    AtomicLoop(const AtomicLoop&) = delete;
+    AtomicLoop& operator=(const AtomicLoop&) = delete;
+};
+
+class MutexLoop: public n_u::Thread
+{
+public:
+    MutexLoop(MutexRefCount* ref, long niter):
+        n_u::Thread("MutexLoop"), _ref(ref), _niter(niter)
+    {}
+
+    int run() override
+    {
+        for (long i = 0; i < _niter; ++i) {
+            _ref->holdReference();
+            _ref->freeReference();
+        }
+        return RUN_OK;
+    }
+
+private:
+    MutexRefCount* _ref;
+    long _niter;
+
+    MutexLoop(const MutexLoop&) = delete;
+    MutexLoop& operator=(const MutexLoop&) = delete;
+};
+
+/**
+ * Start and join the threads, returning the elapsed time in seconds.
+ */
+double
+runThreads(vector<n_u::Thread*>& threads)
+{
+    long long t0 = n_u::getSystemTime();
+    for (auto thr : threads)
+        thr->start();
+    for (auto thr : threads)
+        thr->join();
+    long long t1 = n_u::getSystemTime();
+    for (auto thr : threads)
+        delete thr;
+    threads.clear();
+    return (t1 - t0) / (double)USECS_PER_SEC;
+}
+
+void
+report(const string& name, int nthreads, long niter, double secs)
+{
+    double nops = (double)nthreads * niter;
+    cout << setw(14) << left << name << right
+         << setw(4) << nthreads
+         << setw(14) << fixed << setprecision(1) << nops / secs / 1.e6
+         << setw(12) << setprecision(2) << secs * 1.e9 / nops
+         << endl;
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    long niter = 2000000;
+    if (argc > 1)
+        niter = atol(argv[1]);
+
+    cout << "sizeof(SampleT<float>)=" << sizeof(SampleT<float>)
+         << ", pairs per thread=" << niter << endl;
+    cout << setw(14) << left << "mode" << right
+         << setw(4) << "thr"
+         << setw(14) << "Mpairs/s"
+         << setw(12) << "ns/pair" << endl;
+
+    SampleT<float>* shared = getSample<float>(1);
+
+    for (int nthreads = 1; nthreads <= 16; nthreads *= 2) {
+        vector<n_u::Thread*> threads;
+
+        for (int i = 0; i < nthreads; ++i)
+            threads.push_back(new AtomicLoop(shared, niter));
+        report("atomic-shared", nthreads, niter, runThreads(threads));
+
+        vector<SampleT<float>*> samps;
+        for (int i = 0; i < nthreads; ++i) {
+            samps.push_back(getSample<float>(1));
+            threads.push_back(new AtomicLoop(samps.back(), niter));
+        }
+        report("atomic-own", nthreads, niter, runThreads(threads));
+        for (auto samp : samps)
+            samp->freeReference();
+
+        MutexRefCount sharedRef;
+        for (int i = 0; i < nthreads; ++i)
+            threads.push_back(new MutexLoop(&sharedRef, niter));
+        report("mutex-shared", nthreads, niter, runThreads(threads));
+
+        vector<MutexRefCount> refs(nthreads);
+        for (int i = 0; i < nthreads; ++i)
+            threads.push_back(new MutexLoop(&refs[i], niter));
+        report("mutex-own", nthreads, niter, runThreads(threads));
+    }
+    shared->freeReference();
+    SamplePools::deleteInstance();
+    return 0;
+}
@@ -0,0 +1,276 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Time the per-sample lookup of a sample id in a SampleIdMap, compared
+ * with the std::map and std::unordered_map it replaced in
+ * SampleSourceSupport::distribute(), StatisticsCruncher, the
+ * resamplers, SyncRecordSource and SampleMatcher.
+ *
+ * The ids are either those of an XML configuration given on the
+ * command line, raw and processed, or sets generated with the layout
+ * of typical configurations.  The lookups follow the sample rates, so
+ * a 100 Hz sample is looked up 100 times as often as a 1 Hz one, and
+ * one lookup in ten is of an id which is not in the map, as when a
+ * client only wants some of the samples of a source.
+ */
+
+#include <nidas/core/SampleIdMap.h>
+#include <nidas/core/Project.h>
+#include <nidas/core/DSMConfig.h>
+#include <nidas/core/DSMSensor.h>
+#include <nidas/core/XMLParser.h>
+#include <nidas/util/UTime.h>
+#include <nidas/util/auto_ptr.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace nidas::core;
+using namespace std;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+std::mt19937 rng(42);
+
+struct IdRate
+{
+    dsm_sample_id_t id;
+    float rate;
+};
+
+dsm_sample_id_t
+makeId(unsigned int dsmid, unsigned int spsid)
+{
+    dsm_sample_id_t id = 0;
+    id = SET_DSM_ID(id, dsmid);
+    return SET_SPS_ID(id, spsid);
+}
+
+const float rates[] = { 1, 10, 20, 25, 50, 100 };
+
+/**
+ * A few sensors on one DSM, as data_dump sees them.
+ */
+vector<IdRate>
+smallIds()
+{
+    vector<IdRate> ids;
+    for (unsigned int is = 1; is <= 5; is++) {
+        ids.push_back({ makeId(1, is * 10), rates[is % 6] });
+        ids.push_back({ makeId(1, is * 10 + 1), rates[is % 6] });
+    }
+    return ids;
+}
+
+/**
+ * An aircraft: DSMs with sensor ids in steps of 10 or 100 and one
+ * to three processed samples per sensor, and ARINC sensors with a
+ * sample for each of their octal labels.
+ */
+vector<IdRate>
+aircraftIds()
+{
+    const unsigned int dsms[] = { 4, 5, 10, 12, 46, 47, 50, 51 };
+    vector<IdRate> ids;
+    for (unsigned int id = 0; id < 8; id++) {
+        unsigned int dsmid = dsms[id];
+        for (unsigned int is = 1; is <= 12; is++) {
+            unsigned int sensorid = is * (id % 2 ? 10 : 100);
+            float rate = rates[(id + is) % 6];
+            ids.push_back({ makeId(dsmid, sensorid), rate });
+            for (unsigned int isamp = 1; isamp <= 1 + is % 3; isamp++)
+                ids.push_back({ makeId(dsmid, sensorid + isamp), rate });
+        }
+    }
+    for (unsigned int label = 0200; label < 0400; label += 3)
+        ids.push_back({ makeId(50, 4000 + label), label % 2 ? 16.f : 2.f });
+    return ids;
+}
+
+/**
+ * ISFS: many DSMs with Wisard motes, whose processed sample
+ * ids combine the mote id and the sensor type.
+ */
+vector<IdRate>
+isfsIds()
+{
+    vector<IdRate> ids;
+    for (unsigned int dsmid = 1; dsmid <= 40; dsmid++) {
+        ids.push_back({ makeId(dsmid, 10), 20 });
+        ids.push_back({ makeId(dsmid, 11), 20 });
+        for (unsigned int mote = 1; mote <= 2; mote++) {
+            for (unsigned int stype = 0x10; stype < 0x40; stype += 3)
+                ids.push_back({ makeId(dsmid, 0x8000 + (mote << 8) + stype),
+                                stype < 0x20 ? 1.f : 0.2f });
+        }
+    }
+    return ids;
+}
+
+/**
+ * Raw and processed sample ids of the sensors in a configuration.
+ */
+vector<IdRate>
+configIds(const string& xmlFileName)
+{
+    n_u::auto_ptr<xercesc::DOMDocument> doc(parseXMLConfigFile(xmlFileName));
+    Project project;
+    project.fromDOMElement(doc->getDocumentElement());
+
+    vector<IdRate> ids;
+    for (DSMConfigIterator di = project.getDSMConfigIterator();
+            di.hasNext(); ) {
+        const DSMConfig* dsm = di.next();
+        for (SensorIterator si = dsm->getSensorIterator(); si.hasNext(); ) {
+            DSMSensor* sensor = si.next();
+            float rate = 0;
+            for (SampleTagIterator ti = sensor->getSampleTagIterator();
+                    ti.hasNext(); ) {
+                const SampleTag* tag = ti.next();
+                float trate = std::max((float)tag->getRate(), 0.1f);
+                rate += trate;
+                ids.push_back({ tag->getId(), trate });
+            }
+            ids.push_back({ sensor->getId(), std::max(rate, 0.1f) });
+        }
+    }
+    XMLImplementation::terminate();
+    return ids;
+}
+
+/**
+ * A stream of ids to look up, in proportion to their rates, with
+ * one in ten not in the map.
+ */
+vector<dsm_sample_id_t>
+lookupStream(const vector<IdRate>& ids, size_t n)
+{
+    vector<double> weights;
+    for (const IdRate& ir : ids)
+        weights.push_back(ir.rate);
+    std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+
+    vector<dsm_sample_id_t> stream;
+    for (size_t i = 0; i < n; i++) {
+        dsm_sample_id_t id = ids[pick(rng)].id;
+        if (i % 10 == 9) id = SET_DSM_ID(id, 1000 + i % 23);
+        stream.push_back(id);
+    }
+    return stream;
+}
+
+template <typename M>
+double
+timeLookups(const M& m, const vector<dsm_sample_id_t>& stream, int npass,
+            long& sum)
+{
+    long long t0 = n_u::getSystemTime();
+    for (int ip = 0; ip < npass; ip++) {
+        for (dsm_sample_id_t id : stream) {
+            typename M::const_iterator mi = m.find(id);
+            if (mi != m.end()) sum += mi->second;
+        }
+    }
+    long long t1 = n_u::getSystemTime();
+    return (t1 - t0) * 1000.0 / ((double)npass * stream.size());
+}
+
+void
+runCase(const string& name, const vector<IdRate>& ids, int npass)
+{
+    std::map<dsm_sample_id_t, int> stdmap;
+    std::unordered_map<dsm_sample_id_t, int> hashmap;
+    SampleIdMap<int> idmap;
+    for (size_t i = 0; i < ids.size(); i++) {
+        stdmap[ids[i].id] = i;
+        hashmap[ids[i].id] = i;
+        idmap[ids[i].id] = i;
+    }
+
+    vector<dsm_sample_id_t> stream = lookupStream(ids, 100000);
+
+    long sums[3] = { 0, 0, 0 };
+    double ns[3];
+    ns[0] = timeLookups(stdmap, stream, npass, sums[0]);
+    ns[1] = timeLookups(hashmap, stream, npass, sums[1]);
+    ns[2] = timeLookups(idmap, stream, npass, sums[2]);
+
+    cout << setw(10) << left << name << right
+         << setw(6) << idmap.size()
+         << fixed << setprecision(2)
+         << setw(12) << ns[0] << setw(14) << ns[1] << setw(14) << ns[2]
+         << setw(10) << ns[0] / ns[2];
+    if (sums[0] != sums[1] || sums[0] != sums[2])
+        cout << "  MISMATCH";
+    cout << endl;
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    int npass = 100;
+    string xmlFileName;
+    for (int i = 1; i < argc; i++) {
+        string arg(argv[i]);
+        if (arg.find(".xml") != string::npos)
+            xmlFileName = arg;
+        else
+            npass = atoi(argv[i]);
+    }
+
+    cout << "ns per lookup, 100000 lookups, passes=" << npass << endl;
+    cout << setw(10) << left << "ids" << right
+         << setw(6) << "n"
+         << setw(12) << "std::map"
+         << setw(14) << "unordered_map"
+         << setw(14) << "SampleIdMap"
+         << setw(10) << "speedup" << endl;
+
+    runCase("small", smallIds(), npass);
+    runCase("aircraft", aircraftIds(), npass);
+    runCase("isfs", isfsIds(), npass);
+    if (!xmlFileName.empty()) {
+        try {
+            runCase("config", configIds(xmlFileName), npass);
+        }
+        catch (const n_u::Exception& e) {
+            cerr << xmlFileName << ": " << e.what() << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,526 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Compare MessageStreamScanner splitting of character streams at an
+ * end-of-message separator with the character at a time scanning
+ * that it did before, on synthetic sensor messages and on the raw
+ * streams of ASCII sensors rebuilt from recorded archives.  The
+ * messages from both scanners are checked to be identical before
+ * timing.  A stream of messages with a beginning-of-message separator
+ * is also timed.
+ */
+
+#include "BenchHarness.h"
+
+#include <nidas/core/DSMSensor.h>
+#include <nidas/core/FileSet.h>
+#include <nidas/core/Sample.h>
+#include <nidas/core/SampleScanner.h>
+#include <nidas/dynld/SampleInputStream.h>
+#include <nidas/util/EOFException.h>
+#include <nidas/util/Logger.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace nidas::core;
+using namespace std;
+
+using bench::BenchReport;
+using bench::CaseTimer;
+using nidas::dynld::SampleInputStream;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+std::mt19937 rng(42);
+
+/**
+ * MessageStreamScanner which copies and matches the end-of-message
+ * separator one character at a time.
+ */
+class CharScanner: public MessageStreamScanner
+{
+public:
+
+    Sample* nextSampleSepEOM(DSMSensor* sensor)
+    {
+        Sample* result = 0;
+
+        if (!_osamp) {
+            if (_buftail == _bufhead) return 0;
+            _osamp = getSample<char>(_sampleLengthAlloc);
+            _osamp->setId(sensor->getId());
+            dsm_time_t ttag = _tfirstchar + _buftail * getUsecsPerByte();
+            if (ttag <= _lastSampleTime) ttag = _lastSampleTime + 1;
+            _lastSampleTime = ttag;
+            _osamp->setTimeTag(ttag);
+            _outSampDataPtr = (char*) _osamp->getVoidDataPtr();
+            _outSampLengthAlloc = _osamp->getAllocByteLength();
+            _outSampRead = 0;
+            _separatorCnt = 0;
+        }
+
+        int nterm = getNullTerminate() ? 1 : 0;
+
+        while (_buftail < _bufhead) {
+            if (_outSampRead + 1 + nterm > _outSampLengthAlloc &&
+                    (result = requestBiggerSample(1 + nterm))) return result;
+
+            char c = _buffer[_buftail++];
+            _outSampDataPtr[_outSampRead++] = c;
+
+            if ((_separatorCnt = matchSeparatorEOM(c, _separatorCnt)) ==
+                    _separatorLen) {
+                if (nterm) _outSampDataPtr[_outSampRead++] = '\0';
+                _osamp->setDataLength(_outSampRead);
+                addSampleToStats(_outSampRead);
+                result = _osamp;
+                _osamp = 0;
+                adjustSampleLengthAlloc(_outSampRead);
+                break;
+            }
+        }
+        return result;
+    }
+};
+
+/**
+ * DSMSensor which reads from a string, in reads of at most readLen
+ * bytes, as a CharacterSensor reads from a serial port.
+ */
+class StringSensor: public DSMSensor
+{
+public:
+    StringSensor(const string& data, size_t readLen):
+        _data(data), _pos(0), _readLen(readLen)
+    {
+        setDSMId(1);
+        setSensorId(100);
+    }
+
+    IODevice* buildIODevice() { return 0; }
+
+    SampleScanner* buildSampleScanner() { return 0; }
+
+    size_t read(void *buf, size_t len)
+    {
+        len = std::min(std::min(len, _readLen), _data.length() - _pos);
+        ::memcpy(buf, _data.data() + _pos, len);
+        _pos += len;
+        return len;
+    }
+
+    size_t read(void *buf, size_t len, int)
+    {
+        return read(buf, len);
+    }
+
+    bool atEnd() const { return _pos == _data.length(); }
+
+    void rewind() { _pos = 0; }
+
+private:
+    const string& _data;
+
+    size_t _pos;
+
+    size_t _readLen;
+};
+
+/**
+ * A stream of messages and how it is split.
+ */
+struct MessageStream
+{
+    MessageStream():
+        name(), input(), separator(), eom(true), data(), nmsgs(0)
+    {}
+
+    string name;
+    string input;
+    string separator;
+    bool eom;
+    string data;
+
+    /**
+     * Number of recorded messages in the stream, 0 if not known.
+     */
+    long long nmsgs;
+};
+
+/**
+ * Split a stream with a scanner, returning the number of messages.
+ * If msgs is non-null the messages are appended to it.
+ */
+long long
+scanStream(MessageStreamScanner& scanner, StringSensor& sensor,
+           CaseTimer* timer, vector<string>* msgs)
+{
+    long long nmsgs = 0;
+    sensor.rewind();
+    while (!sensor.atEnd()) {
+        bool exhausted;
+        scanner.readBuffer(&sensor, exhausted);
+        long long n = 0;
+        while (Sample* samp = scanner.nextSample(&sensor)) {
+            if (msgs)
+                msgs->push_back(string((const char*)
+                    samp->getConstVoidDataPtr(), samp->getDataByteLength()));
+            samp->freeReference();
+            n++;
+        }
+        if (timer) timer->batch(n);
+        nmsgs += n;
+    }
+    return nmsgs;
+}
+
+/**
+ * Check that the reference and the current scanner split a stream
+ * into the same messages.
+ */
+bool
+checkStream(const MessageStream& stream, size_t readLen)
+{
+    StringSensor sensor(stream.data, readLen);
+    CharScanner ref;
+    MessageStreamScanner scanner;
+    ref.setMessageParameters(0, stream.separator, stream.eom);
+    scanner.setMessageParameters(0, stream.separator, stream.eom);
+    ref.setNullTerminate(true);
+    scanner.setNullTerminate(true);
+
+    vector<string> refmsgs;
+    vector<string> msgs;
+    scanStream(ref, sensor, 0, &refmsgs);
+    scanStream(scanner, sensor, 0, &msgs);
+    if (msgs != refmsgs) {
+        cerr << stream.name << ' ' << stream.input <<
+            ": messages differ, " << refmsgs.size() << " versus " <<
+            msgs.size() << endl;
+        return false;
+    }
+    if (stream.nmsgs > 0 && (long long)msgs.size() != stream.nmsgs) {
+        cerr << stream.name << ' ' << stream.input << ": " <<
+            msgs.size() << " messages, versus " << stream.nmsgs <<
+            " recorded" << endl;
+        return false;
+    }
+    return true;
+}
+
+void
+benchStream(BenchReport& report, const MessageStream& stream,
+            size_t readLen, int npass, bool reference)
+{
+    StringSensor sensor(stream.data, readLen);
+    CharScanner ref;
+    MessageStreamScanner current;
+    MessageStreamScanner& scanner = reference ? ref : current;
+    scanner.setMessageParameters(0, stream.separator, stream.eom);
+    scanner.setNullTerminate(true);
+
+    CaseTimer timer(stream.name + (reference ? "_char" : "_memchr"),
+                    stream.input);
+    timer.reserve(npass * stream.data.length() / 16 + 1);
+    timer.start();
+    for (int ip = 0; ip < npass; ip++)
+        scanStream(scanner, sensor, &timer, 0);
+    timer.stop();
+    report.add(timer.getResult());
+}
+
+/**
+ * Sonic anemometer messages, as a CSAT3 sends them when
+ * configured for ASCII output.
+ */
+string
+sonicMessages(size_t nbytes)
+{
+    std::uniform_real_distribution<double> wind(-10, 10);
+    std::uniform_real_distribution<double> temp(-20, 35);
+    string msgs;
+    char buf[128];
+    for (size_t i = 0; msgs.length() < nbytes; i++) {
+        snprintf(buf, sizeof(buf), "%7.3f %7.3f %7.3f %6.2f %d %d\r\n",
+                 wind(rng), wind(rng), wind(rng) / 3, temp(rng),
+                 (int)(i % 64), (int)(i % 2));
+        msgs += buf;
+    }
+    return msgs;
+}
+
+/**
+ * GPS NMEA sentences, with a '$' separator at the beginning of
+ * each message if bom, otherwise with a CR-NL at the end.
+ */
+string
+nmeaMessages(size_t nbytes, bool bom)
+{
+    std::uniform_real_distribution<double> frac(0, 1);
+    string msgs;
+    char buf[128];
+    for (size_t i = 0; msgs.length() < nbytes; i++) {
+        int sec = i % 86400;
+        snprintf(buf, sizeof(buf),
+            "%sGPGGA,%02d%02d%02d.00,4001.%05d,N,10515.%05d,W,1,09,0.9,"
+            "%.1f,M,-21.0,M,,*%02X%s", bom ? "$" : "",
+            sec / 3600, (sec / 60) % 60, sec % 60,
+            (int)(frac(rng) * 99999), (int)(frac(rng) * 99999),
+            1600 + frac(rng) * 10, (unsigned)(i % 256), bom ? "" : "\r\n");
+        msgs += buf;
+    }
+    return msgs;
+}
+
+/**
+ * Long messages of a gas analyzer, separated by NL.
+ */
+string
+analyzerMessages(size_t nbytes)
+{
+    std::uniform_real_distribution<double> val(0, 1000);
+    string msgs;
+    char buf[64];
+    for (size_t i = 0; msgs.length() < nbytes; i++) {
+        msgs += "(Data (Date 2026-10-17)(Time 12:00:00:000)";
+        for (int j = 0; j < 12; j++) {
+            snprintf(buf, sizeof(buf), "(V%d %.4f)", j, val(rng));
+            msgs += buf;
+        }
+        msgs += ")\n";
+    }
+    return msgs;
+}
+
+/**
+ * SampleClient which appends the character samples of each sensor
+ * to a string, without their null terminators.
+ */
+class StreamClient: public SampleClient
+{
+public:
+    StreamClient(): streams(), counts() {}
+
+    bool receive(const Sample* samp) throw()
+    {
+        if (samp->getType() != CHAR_ST) return true;
+        const char* cp = (const char*) samp->getConstVoidDataPtr();
+        size_t len = samp->getDataByteLength();
+        while (len > 0 && cp[len-1] == '\0') len--;
+        if (len == 0) return true;
+        dsm_sample_id_t id = samp->getId();
+        streams[id].append(cp, len);
+        counts[id]++;
+        return true;
+    }
+
+    void flush() throw() {}
+
+    map<dsm_sample_id_t, string> streams;
+
+    map<dsm_sample_id_t, long long> counts;
+};
+
+/**
+ * Rebuild the raw streams of the ASCII sensors in an archive, by
+ * concatenating their raw samples. A sensor's stream is kept if every
+ * sample ends with a NL, or CR-NL, and does not otherwise contain a NL,
+ * so that it should be split back into the recorded samples.  The
+ * kept streams are merged into one, which is checked to be split into
+ * the same number of messages as were recorded.
+ */
+void
+archiveStreams(const string& path, vector<MessageStream>& streams)
+{
+    list<string> files;
+    files.push_back(path);
+    FileSet* fset = FileSet::getFileSet(files);
+    SampleInputStream sis(fset->connect(), false);
+    StreamClient client;
+    sis.addSampleClient(&client);
+    sis.readInputHeader();
+    try {
+        for (;;) sis.readSamples();
+    }
+    catch (const n_u::EOFException&) {
+    }
+    sis.removeSampleClient(&client);
+    sis.close();
+
+    string input = path.substr(path.rfind('/') + 1);
+    MessageStream merged;
+    merged.name = "archive";
+    merged.input = input;
+    merged.separator = "\\n";
+    unsigned int nsensors = 0;
+
+    for (auto& sp : client.streams) {
+        const string& data = sp.second;
+        if (data[data.length() - 1] != '\n') continue;
+        long long nnl = std::count(data.begin(), data.end(), '\n');
+        if (nnl != client.counts[sp.first]) continue;
+        merged.data += data;
+        merged.nmsgs += nnl;
+        nsensors++;
+    }
+    if (nsensors > 0) {
+        cerr << input << ": " << nsensors << " ASCII sensors, " <<
+            merged.data.length() << " bytes" << endl;
+        streams.push_back(merged);
+    }
+    else cerr << input << ": no ASCII sensor streams" << endl;
+}
+
+int
+usage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 <<
+        " [-b nbytes] [-p npass] [-r readlen] [-c case] [-j file] "
+        "[archive ...]\n"
+        "  -b nbytes: size of the synthetic streams, default 4000000\n"
+        "  -p npass: passes over each stream, default 5\n"
+        "  -r readlen: maximum bytes returned by each read of the sensor,\n"
+        "     default 4096, the scanner buffer size\n"
+        "  -c case: only run cases whose name or input contains\n"
+        "     this string\n"
+        "  -j file: write the results as JSON to file, '-' for stdout,\n"
+        "     instead of printing a table\n"
+        "  archive: raw sample archives, whose ASCII sensor messages\n"
+        "     are rebuilt into streams and scanned" << endl;
+    return 1;
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t nbytes = 4000000;
+    int npass = 5;
+    size_t readLen = 4096;
+    string caseFilter;
+    string jsonFile;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "b:c:j:p:r:h")) != -1) {
+        switch (opt) {
+        case 'b':
+            nbytes = atol(optarg);
+            break;
+        case 'c':
+            caseFilter = optarg;
+            break;
+        case 'j':
+            jsonFile = optarg;
+            break;
+        case 'p':
+            npass = atoi(optarg);
+            break;
+        case 'r':
+            readLen = atol(optarg);
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+    if (nbytes == 0 || npass < 1 || readLen == 0) return usage(argv[0]);
+
+    n_u::Logger::setScheme(
+        n_u::LogScheme("bench_scanner").addConfig("level=error"));
+
+    vector<MessageStream> streams(3);
+    streams[0].name = "sonic";
+    streams[0].separator = "\\r\\n";
+    streams[0].data = sonicMessages(nbytes);
+    streams[1].name = "nmea";
+    streams[1].separator = "\\r\\n";
+    streams[1].data = nmeaMessages(nbytes, false);
+    streams[2].name = "analyzer";
+    streams[2].separator = "\\n";
+    streams[2].data = analyzerMessages(nbytes);
+    for (MessageStream& stream : streams) stream.input = "synthetic";
+
+    for (int i = optind; i < argc; i++)
+        archiveStreams(argv[i], streams);
+
+    BenchReport report("bench_scanner");
+    auto selected = [&caseFilter](const string& name, const string& input)
+    {
+        return caseFilter.empty() ||
+            name.find(caseFilter) != string::npos ||
+            input.find(caseFilter) != string::npos;
+    };
+
+    for (const MessageStream& stream : streams) {
+        if (!selected(stream.name, stream.input)) continue;
+        if (!checkStream(stream, readLen)) return 1;
+        benchStream(report, stream, readLen, npass, true);
+        benchStream(report, stream, readLen, npass, false);
+    }
+
+    // The beginning-of-message scan is timed without a character
+    // at a time reference.
+    MessageStream bom;
+    bom.name = "nmea_bom";
+    bom.input = "synthetic";
+    bom.separator = "$";
+    bom.eom = false;
+    bom.data = nmeaMessages(nbytes, true);
+    if (selected(bom.name, bom.input))
+        benchStream(report, bom, readLen, npass, false);
+
+    if (jsonFile.empty()) {
+        cout << "bytes=" << nbytes << ", passes=" << npass <<
+            ", readlen=" << readLen << endl;
+        report.printTable(cout);
+    }
+    else if (jsonFile == "-") {
+        report.printJSON(cout);
+    }
+    else {
+        ofstream json(jsonFile.c_str());
+        report.printJSON(json);
+        if (!json) {
+            cerr << jsonFile << ": write failed" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
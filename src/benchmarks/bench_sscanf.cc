@@ -0,0 +1,279 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Time AsciiSscanf on sensor messages of the kind CharacterSensor
+ * scans, with the format compiled by CompiledSscanf and with ::sscanf.
+ * The formats are from project configurations, and the messages are
+ * generated in the layout each sensor sends, with random values.
+ *
+ * As in CharacterSensor, each message is tried against the formats of
+ * its sensor in turn, starting with the one after the last that matched,
+ * until one of them converts some fields.
+ */
+
+#include <nidas/core/AsciiSscanf.h>
+#include <nidas/util/UTime.h>
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace nidas::core;
+using namespace std;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+std::mt19937 rng(42);
+
+double uniform(double lo, double hi)
+{
+    return std::uniform_real_distribution<double>(lo, hi)(rng);
+}
+
+int uniformInt(int lo, int hi)
+{
+    return std::uniform_int_distribution<int>(lo, hi)(rng);
+}
+
+/**
+ * Print into a string.
+ */
+string sformat(const char* fmt, ...) __attribute__((format(printf, 1, 2)));
+
+string sformat(const char* fmt, ...)
+{
+    char buf[4096];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+string sonicMessage()
+{
+    return sformat("%7.3f %7.3f %7.3f %6.2f %6.1f %d %5.1f\r\n",
+        uniform(-10, 10), uniform(-10, 10), uniform(-3, 3),
+        uniform(-20, 35), uniform(300, 360), uniformInt(0, 3),
+        uniform(0, 20));
+}
+
+string gillMessage()
+{
+    return sformat("A,%+07.2f,%+07.2f,%+07.2f,M,%+07.2f,%+06.2f,%02d\r\n",
+        uniform(-10, 10), uniform(-10, 10), uniform(-3, 3),
+        uniform(300, 360), uniform(-20, 35), uniformInt(0, 9));
+}
+
+string trhMessage()
+{
+    return sformat("TRH%d %.2f %.2f %d %d %d %d\r\n",
+        uniformInt(100, 120), uniform(-20, 35), uniform(5, 100),
+        uniformInt(0, 4095), uniformInt(0, 4095), uniformInt(0, 4095),
+        uniformInt(0, 4095));
+}
+
+string hexMessage()
+{
+    return sformat("H%d,%x,%x\r\n", uniformInt(0, 99),
+        uniformInt(0, 0xffff), uniformInt(0, 0xffff));
+}
+
+string paroMessage()
+{
+    if (uniformInt(0, 1))
+        return sformat("*01%02d%.3f\r\n", uniformInt(0, 99),
+            uniform(600, 1050));
+    return sformat("?%02dCP=%.4f\r\n", uniformInt(0, 99), uniform(600, 1050));
+}
+
+string paroTempMessage()
+{
+    return sformat("?%02dCT=%.3f\r\n", uniformInt(0, 99), uniform(-20, 35));
+}
+
+string spectrumMessage()
+{
+    string msg = sformat("SPEC2D,2026-10-17T12:%02d:%02d.%03d",
+        uniformInt(0, 59), uniformInt(0, 59), uniformInt(0, 999));
+    for (int i = 0; i < 40; i++)
+        msg += sformat(",%.5g", uniform(0, 1000));
+    return msg + "\r\n";
+}
+
+struct Case
+{
+    const char* name;
+    vector<string> formats;
+    vector<string (*)()> generators;
+};
+
+vector<Case> cases()
+{
+    vector<Case> result;
+    Case c;
+
+    c.name = "sonic";
+    c.formats = { "%f %f %f %f %f %*d %*f" };
+    c.generators = { sonicMessage };
+    result.push_back(c);
+
+    c.name = "gill";
+    c.formats = { "%*c,%f,%f,%f,M,%*f,%f,%d" };
+    c.generators = { gillMessage };
+    result.push_back(c);
+
+    c.name = "trh";
+    c.formats = { "TRH%*d %f %f %d %d %d %d" };
+    c.generators = { trhMessage };
+    result.push_back(c);
+
+    c.name = "hex";
+    c.formats = { "H%d,%x,%x" };
+    c.generators = { hexMessage };
+    result.push_back(c);
+
+    c.name = "paro-2fmt";
+    c.formats = { "?%*2dCP=%f", "?%*2dCT=%f" };
+    c.generators = { paroMessage, paroTempMessage };
+    result.push_back(c);
+
+    string spec = "SPEC2D,%*d-%*d-%*dT%*d:%*d:%*d.%*d";
+    for (int i = 0; i < 40; i++) spec += ",%f";
+    c.name = "spectrum";
+    c.formats = { spec };
+    c.generators = { spectrumMessage };
+    result.push_back(c);
+
+    return result;
+}
+
+/**
+ * Scan the messages with the formats, niter times, as CharacterSensor
+ * does.  Returns the elapsed seconds.  The values of the last pass are
+ * left in results.
+ */
+double
+scanMessages(vector<AsciiSscanf*>& scanners, const vector<string>& messages,
+             int niter, vector<vector<float> >& results)
+{
+    int nfields = 0;
+    for (size_t i = 0; i < scanners.size(); i++)
+        nfields = std::max(nfields, scanners[i]->getNumberOfFields());
+    vector<float> data(nfields);
+    results.assign(messages.size(), vector<float>());
+    size_t next = 0;
+
+    long long t0 = n_u::getSystemTime();
+    for (int iter = 0; iter < niter; iter++) {
+        for (size_t im = 0; im < messages.size(); im++) {
+            const char* msg = messages[im].c_str();
+            size_t checkdone = next;
+            int nparsed = 0;
+            do {
+                AsciiSscanf* scanner = scanners[next];
+                nparsed = scanner->sscanf(msg, &data[0],
+                    scanner->getNumberOfFields());
+                if (++next == scanners.size()) next = 0;
+            } while (nparsed == 0 && next != checkdone);
+            if (iter == niter - 1)
+                results[im].assign(data.begin(), data.begin() + nparsed);
+        }
+    }
+    long long t1 = n_u::getSystemTime();
+    return (t1 - t0) / (double)USECS_PER_SEC;
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    int niter = 200;
+    if (argc > 1)
+        niter = atoi(argv[1]);
+    const int nmessages = 1000;
+
+    cout << "messages per case=" << nmessages << ", passes=" << niter << endl;
+    cout << setw(12) << left << "case" << right
+         << setw(14) << "sscanf ns/msg"
+         << setw(16) << "compiled ns/msg"
+         << setw(10) << "speedup" << endl;
+
+    vector<Case> all = cases();
+    int status = 0;
+    for (size_t ic = 0; ic < all.size(); ic++) {
+        const Case& c = all[ic];
+
+        vector<string> messages;
+        for (int i = 0; i < nmessages; i++)
+            messages.push_back(c.generators[i % c.generators.size()]());
+
+        vector<AsciiSscanf*> scanners;
+        for (size_t i = 0; i < c.formats.size(); i++) {
+            scanners.push_back(new AsciiSscanf());
+            scanners.back()->setFormat(c.formats[i]);
+        }
+
+        double secs[2];
+        vector<vector<float> > results[2];
+        bool compiled = true;
+        for (int mode = 0; mode < 2; mode++) {
+            for (size_t i = 0; i < scanners.size(); i++) {
+                scanners[i]->setCompiledScan(mode == 1);
+                if (mode == 1) compiled = compiled &&
+                    scanners[i]->isCompiledScan();
+            }
+            secs[mode] = scanMessages(scanners, messages, niter,
+                                      results[mode]);
+        }
+
+        double nmsg = (double)niter * nmessages;
+        cout << setw(12) << left << c.name << right << fixed
+             << setw(14) << setprecision(1) << secs[0] * 1.e9 / nmsg
+             << setw(16) << setprecision(1) << secs[1] * 1.e9 / nmsg
+             << setw(9) << setprecision(2) << secs[0] / secs[1] << "x";
+        if (!compiled) cout << "  (not compiled)";
+        if (results[0] != results[1]) {
+            cout << "  RESULTS DIFFER";
+            status = 1;
+        }
+        cout << endl;
+
+        for (size_t i = 0; i < scanners.size(); i++)
+            delete scanners[i];
+    }
+    return status;
+}
@@ -0,0 +1,552 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * Compare the analysis of optical array probe image slices one byte at
+ * a time, as TwoD_Processing::processParticleSlice() did, with the
+ * word at a time analysis of processParticleSlice() and
+ * processParticleSlices(), on synthetic particle images with the
+ * geometries of a Fast2DC (TwoD64_USB, 64 diodes) and a 2D-S (TwoDS,
+ * 128 diodes).  The size-distribution samples and the reject counts
+ * of the three are checked to be identical before timing.
+ */
+
+#include "BenchHarness.h"
+
+#include <nidas/core/DSMSensor.h>
+#include <nidas/core/Parameter.h>
+#include <nidas/core/Sample.h>
+#include <nidas/core/SampleTag.h>
+#include <nidas/core/Variable.h>
+#include <nidas/dynld/raf/TwoD_Processing.h>
+#include <nidas/util/Logger.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+using namespace nidas::core;
+using namespace std;
+
+using bench::BenchReport;
+using bench::CaseTimer;
+using nidas::dynld::raf::TwoD_Processing;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+std::mt19937 rng(42);
+
+/**
+ * Particles per latency batch.
+ */
+const size_t BATCH = 256;
+
+/**
+ * How the slices of a particle are passed to the processor.
+ */
+enum SliceFeed {
+    BYTE_SLICE,         // ByteSliceProcessing::processParticleSlice()
+    WORD_SLICE,         // TwoD_Processing::processParticleSlice()
+    WORD_BLOCK          // TwoD_Processing::processParticleSlices()
+};
+
+const char* feedName(SliceFeed feed)
+{
+    switch (feed) {
+    case BYTE_SLICE: return "byte_slice";
+    case WORD_SLICE: return "word_slice";
+    default: return "word_block";
+    }
+}
+
+/**
+ * TwoD_Processing with the byte at a time analysis of a slice.
+ */
+class ByteSliceProcessing: public TwoD_Processing
+{
+public:
+    ByteSliceProcessing(size_t nDiodes, DSMSensor* sensor):
+        TwoD_Processing("byte_slice", nDiodes, sensor)
+    {}
+
+    void processParticleSlice(const unsigned char* data)
+    {
+        int nBytes = NumberOfDiodes() / 8;
+
+        unsigned char slice[nBytes];
+        for (int i = 0; i < nBytes; ++i)
+            slice[i] = ~(data[i]);
+
+        _particle.width++;
+
+        if ((slice[0] & 0x80))
+            _particle.edgeTouch |= 0x0F;
+
+        if ((slice[nBytes-1] & 0x01))
+            _particle.edgeTouch |= 0xF0;
+
+        for (int i = 0; i < nBytes; ++i)
+        {
+            unsigned char c = slice[i];
+            for (; c; _particle.area++)
+                c &= c - 1;
+        }
+
+        int h = NumberOfDiodes();
+        for (int i = 0; i < nBytes; ++i)
+        {
+            if (slice[i] == 0)
+            {
+                h -= 8;
+                continue;
+            }
+            int r = 7;
+            unsigned char v = slice[i];
+            while (v >>= 1)
+                r--;
+            h -= r;
+            break;
+        }
+        for (int i = nBytes-1; i >= 0; --i)
+        {
+            if (slice[i] == 0)
+            {
+                h -= 8;
+                continue;
+            }
+            int r = 0;
+            unsigned char v = slice[i];
+            while ((v & 0x01) == 0)
+            {
+                r++;
+                v >>= 1;
+            }
+            h -= r;
+            break;
+        }
+
+        if (h > 0)
+            _particle.height = std::max((unsigned)h, _particle.height);
+    }
+};
+
+/**
+ * DSMSensor with the RESOLUTION parameter and the 1D and 2D histogram
+ * sample tags of a probe, for TwoD_Processing::init().
+ */
+class ProbeSensor: public DSMSensor
+{
+public:
+    ProbeSensor(unsigned int nDiodes, int resolution)
+    {
+        setDSMId(1);
+        setSensorId(200);
+        addParameter(new Parameter("RESOLUTION", resolution));
+
+        SampleTag* tag = new SampleTag(this);
+        tag->setSampleId(1);
+        Variable* var = new Variable();
+        var->setName("A1D");
+        var->setLength(nDiodes);
+        tag->addVariable(var);
+        var = new Variable();
+        var->setName("DT1D");
+        tag->addVariable(var);
+        addSampleTag(tag);
+
+        tag = new SampleTag(this);
+        tag->setSampleId(2);
+        var = new Variable();
+        var->setName("A2D");
+        var->setLength(nDiodes * 2);
+        tag->addVariable(var);
+        addSampleTag(tag);
+    }
+
+    IODevice* buildIODevice() { return 0; }
+
+    SampleScanner* buildSampleScanner() { return 0; }
+};
+
+/**
+ * Images of a sequence of particles.  The slices of all the particles
+ * are contiguous, uncomplemented and big-endian, as a probe records
+ * them.
+ */
+struct ParticleImages
+{
+    ParticleImages(const string& n, unsigned int nd, int res):
+        name(n), nDiodes(nd), resolution(res), sliceBytes(nd / 8),
+        slices(), particles()
+    {}
+
+    struct Particle
+    {
+        size_t offset;
+        unsigned int nSlices;
+        dsm_time_t time;
+    };
+
+    const unsigned char* slice(const Particle& p) const
+    {
+        return slices.data() + p.offset;
+    }
+
+    size_t totalSlices() const
+    {
+        return slices.size() / sliceBytes;
+    }
+
+    string name;
+
+    unsigned int nDiodes;
+
+    int resolution;
+
+    unsigned int sliceBytes;
+
+    vector<unsigned char> slices;
+
+    vector<Particle> particles;
+};
+
+/**
+ * Shadow diodes [d0, d1] of the last slice of the images.
+ */
+void
+shadow(ParticleImages& images, int d0, int d1)
+{
+    unsigned char* cp = images.slices.data() + images.slices.size() -
+        images.sliceBytes;
+    d0 = std::max(d0, 0);
+    d1 = std::min(d1, (int)images.nDiodes - 1);
+    for (int d = d0; d <= d1; ++d)
+        cp[d / 8] &= ~(0x80 >> (d % 8));
+}
+
+/**
+ * Generate images of nparticles roughly elliptical particles, with an
+ * exponential distribution of diameters, some of them touching or
+ * crossing the ends of the array, some with holes in their center as
+ * from a Poisson spot, and a few stuck bits.  The particles arrive
+ * from 20 to 2000 microseconds apart, so that a histogram period has
+ * some thousands of them.
+ */
+void
+generateImages(ParticleImages& images, size_t nparticles)
+{
+    const int nd = images.nDiodes;
+    std::exponential_distribution<double> diameter(8.0 / nd);
+    std::uniform_real_distribution<double> uniform(0.0, 1.0);
+    std::uniform_int_distribution<int> interval(20, 2000);
+    dsm_time_t tt = 1000000000000000LL;
+
+    for (size_t ip = 0; ip < nparticles; ++ip) {
+        ParticleImages::Particle p;
+        p.offset = images.slices.size();
+        tt += interval(rng);
+        p.time = tt;
+
+        double u = uniform(rng);
+        if (u < 0.02) {
+            // stuck bit
+            int d = uniform(rng) * nd;
+            p.nSlices = 4 + uniform(rng) * 20;
+            for (unsigned int s = 0; s < p.nSlices; ++s) {
+                images.slices.resize(images.slices.size() +
+                    images.sliceBytes, 0xff);
+                shadow(images, d, d);
+            }
+        }
+        else {
+            double dia = std::min(1.0 + diameter(rng), 2.0 * nd);
+            double aspect = 0.7 + 0.6 * uniform(rng);
+            double center = -dia / 4 + uniform(rng) * (nd + dia / 2);
+            bool hole = dia > 12 && uniform(rng) < 0.05;
+            p.nSlices = std::max(1, (int)::lround(dia * aspect));
+            for (unsigned int s = 0; s < p.nSlices; ++s) {
+                images.slices.resize(images.slices.size() +
+                    images.sliceBytes, 0xff);
+                double x = (s + 0.5) / p.nSlices * 2.0 - 1.0;
+                double chord = dia / 2 * std::sqrt(1.0 - x * x);
+                int d0 = ::lround(center - chord);
+                int d1 = ::lround(center + chord);
+                if (hole) {
+                    int h = ::lround(chord / 3);
+                    shadow(images, d0, (int)center - h);
+                    shadow(images, (int)center + h, d1);
+                }
+                else
+                    shadow(images, d0, d1);
+            }
+        }
+        images.particles.push_back(p);
+    }
+}
+
+/**
+ * Pass the slices of particles [i0, i1) of the images to proc, and
+ * count them, as TwoD_SPEC::processImageRecord() does.
+ */
+inline void
+processParticles(TwoD_Processing& proc, const ParticleImages& images,
+                 size_t i0, size_t i1, SliceFeed feed,
+                 list<const Sample*>& results)
+{
+    float resolutionUsec = images.resolution / 200.0;
+    for (size_t i = i0; i < i1; ++i) {
+        const ParticleImages::Particle& p = images.particles[i];
+        const unsigned char* cp = images.slice(p);
+
+        proc._particle.zero();
+        proc._totalParticles++;
+        if (feed == WORD_BLOCK)
+            proc.processParticleSlices(cp, p.nSlices);
+        else {
+            for (unsigned int s = 0; s < p.nSlices; ++s)
+                proc.processParticleSlice(cp + s * images.sliceBytes);
+        }
+        proc.createSamples(p.time, results);
+        proc.countParticle(resolutionUsec);
+    }
+}
+
+void
+freeSamples(list<const Sample*>& results)
+{
+    for (const Sample* samp : results)
+        samp->freeReference();
+    results.clear();
+}
+
+/**
+ * Compare two size-distribution samples.  createSamples() does not set
+ * the last value of the 2D sample, which has 2 * nDiodes + 1 values,
+ * so that one is not compared.
+ */
+bool
+sameSample(const Sample* a, const Sample* b, dsm_sample_id_t id2D)
+{
+    if (a->getId() != b->getId() || a->getTimeTag() != b->getTimeTag() ||
+        a->getDataLength() != b->getDataLength())
+        return false;
+    unsigned int n = a->getDataLength();
+    if (a->getId() == id2D) n--;
+    return ::memcmp(a->getConstVoidDataPtr(), b->getConstVoidDataPtr(),
+                    n * sizeof(float)) == 0;
+}
+
+TwoD_Processing*
+newProcessor(ProbeSensor& sensor, const ParticleImages& images,
+             SliceFeed feed)
+{
+    TwoD_Processing* proc;
+    if (feed == BYTE_SLICE)
+        proc = new ByteSliceProcessing(images.nDiodes, &sensor);
+    else
+        proc = new TwoD_Processing("word", images.nDiodes, &sensor);
+    proc->init();
+    return proc;
+}
+
+/**
+ * Process all the images with each of the slice feeds, flush the last
+ * histograms, and check that the size-distribution samples and reject
+ * counts are identical.
+ */
+bool
+checkImages(ProbeSensor& sensor, const ParticleImages& images)
+{
+    list<const Sample*> results[3];
+    unsigned int rejects[3][3];
+    const SliceFeed feeds[] = { BYTE_SLICE, WORD_SLICE, WORD_BLOCK };
+    dsm_sample_id_t id2D = 0;
+
+    for (int i = 0; i < 3; ++i) {
+        TwoD_Processing* proc = newProcessor(sensor, images, feeds[i]);
+        id2D = proc->_2dcID;
+        processParticles(*proc, images, 0, images.particles.size(),
+                         feeds[i], results[i]);
+        proc->createSamples(images.particles.back().time + 2 * USECS_PER_SEC,
+                            results[i]);
+        rejects[i][0] = proc->_rejected1D_Cntr;
+        rejects[i][1] = proc->_rejected2D_Cntr;
+        rejects[i][2] = proc->_overSizeCount_2D;
+        delete proc;
+    }
+
+    bool same = true;
+    size_t nhisto = results[0].size();
+    for (int i = 1; same && i < 3; ++i) {
+        same = results[i].size() == nhisto &&
+            std::equal(rejects[i], rejects[i] + 3, rejects[0]);
+        auto s0 = results[0].begin();
+        auto si = results[i].begin();
+        for ( ; same && si != results[i].end(); ++s0, ++si)
+            same = sameSample(*s0, *si, id2D);
+        if (!same)
+            cerr << images.name << ": " << feedName(feeds[i]) <<
+                " size distributions differ from " <<
+                feedName(feeds[0]) << endl;
+    }
+    if (same)
+        cout << images.name << ": " << nhisto <<
+            " size-distribution samples identical, " <<
+            rejects[0][0] << " 1D and " << rejects[0][1] <<
+            " 2D rejects" << endl;
+
+    for (auto& res : results)
+        freeSamples(res);
+    return same;
+}
+
+void
+benchImages(BenchReport& report, ProbeSensor& sensor,
+            const ParticleImages& images, int npass, SliceFeed feed)
+{
+    TwoD_Processing* proc = newProcessor(sensor, images, feed);
+    list<const Sample*> results;
+    size_t nparticles = images.particles.size();
+
+    CaseTimer timer(feedName(feed), images.name);
+    timer.reserve(npass * nparticles / BATCH + 1);
+    timer.start();
+    for (int ip = 0; ip < npass; ++ip) {
+        for (size_t i = 0; i < nparticles; ) {
+            size_t n = std::min(BATCH, nparticles - i);
+            processParticles(*proc, images, i, i + n, feed, results);
+            i += n;
+            timer.batch(n);
+        }
+        timer.pause();
+        freeSamples(results);
+        proc->clearData();
+        proc->_histoEndTime = 0;
+        timer.resume();
+    }
+    timer.stop();
+    delete proc;
+    report.add(timer.getResult());
+}
+
+int
+usage(const char* argv0)
+{
+    cerr << "Usage: " << argv0 <<
+        " [-n nparticles] [-p npass] [-c case] [-j file]\n"
+        "  -n nparticles: particles processed per pass, default 100000\n"
+        "  -p npass: passes over the particles, default 3\n"
+        "  -c case: only run cases whose name or probe contains\n"
+        "     this string\n"
+        "  -j file: write the results as JSON to file, '-' for stdout,\n"
+        "     instead of printing a table" << endl;
+    return 1;
+}
+
+}   // namespace
+
+int
+main(int argc, char** argv)
+{
+    size_t nparticles = 100000;
+    int npass = 3;
+    string caseFilter;
+    string jsonFile;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "c:j:n:p:h")) != -1) {
+        switch (opt) {
+        case 'c':
+            caseFilter = optarg;
+            break;
+        case 'j':
+            jsonFile = optarg;
+            break;
+        case 'n':
+            nparticles = atol(optarg);
+            break;
+        case 'p':
+            npass = atoi(optarg);
+            break;
+        default:
+            return usage(argv[0]);
+        }
+    }
+    if (nparticles == 0 || npass < 1) return usage(argv[0]);
+
+    n_u::Logger::setScheme(
+        n_u::LogScheme("bench_twod").addConfig("level=warning"));
+
+    BenchReport report("bench_twod");
+    auto selected = [&caseFilter](const string& name, const string& input)
+    {
+        return caseFilter.empty() ||
+            name.find(caseFilter) != string::npos ||
+            input.find(caseFilter) != string::npos;
+    };
+
+    // Fast2DC (TwoD64_USB), 64 diodes of 25 um, and 2D-S (TwoDS),
+    // 128 diodes of 10 um.
+    ParticleImages fast2d("fast2dc", 64, 25);
+    ParticleImages twods("2ds", 128, 10);
+
+    for (ParticleImages* images : { &fast2d, &twods }) {
+        generateImages(*images, nparticles);
+        ProbeSensor sensor(images->nDiodes, images->resolution);
+        if (!checkImages(sensor, *images)) return 1;
+        for (SliceFeed feed : { BYTE_SLICE, WORD_SLICE, WORD_BLOCK }) {
+            if (selected(feedName(feed), images->name))
+                benchImages(report, sensor, *images, npass, feed);
+        }
+    }
+
+    if (jsonFile.empty()) {
+        cout << "particles=" << nparticles << ", passes=" << npass << endl;
+        report.printTable(cout);
+    }
+    else if (jsonFile == "-") {
+        report.printJSON(cout);
+    }
+    else {
+        ofstream json(jsonFile.c_str());
+        report.printJSON(json);
+        if (!json) {
+            cerr << jsonFile << ": write failed" << endl;
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,695 @@
+/* -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; -*- */
+/* vim: set shiftwidth=4 softtabstop=4 expandtab: */
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+/*
+ * The batching writer of data_influxdb, in a header of its own so that
+ * tests/data_influxdb can run it against a stub http server.
+ */
+
+#ifndef NIDAS_APPS_INFLUXWRITER_H
+#define NIDAS_APPS_INFLUXWRITER_H
+
+#include <nidas/util/Logger.h>
+
+#include <curl/curl.h>
+#include <zlib.h>     // gzip request bodies
+#include <json/json.h>
+
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Return a description of the errors in the result of an http request
+ * to the database, or an empty string if it succeeded: the curl result
+ * @p res with the curl error buffer @p curlerrs, the error field of the
+ * json @p response, or the http status @p httpcode.
+ **/
+inline std::string
+influxErrors(CURLcode res, const char* curlerrs, long httpcode,
+             const std::string& response)
+{
+    std::ostringstream errs;
+
+    // First see if the curl call itself failed.
+    if (res != CURLE_OK)
+    {
+        errs << "http post failed: " << curlerrs;
+    }
+    // Then see if the json result indicates an error.
+    else if (!response.empty())
+    {
+        try {
+            std::istringstream js(response);
+            Json::Value root;
+            js >> root;
+            Json::Value error = root["error"];
+            std::string dnf = "database not found";
+            if (!error.isNull() &&
+                error.asString().substr(0, dnf.size()) == dnf)
+            {
+                errs << error.asString()
+                     << "; maybe use --create to create it first?";
+            }
+            else if (!error.isNull())
+            {
+                errs << error.asString();
+            }
+            else
+            {
+                // Show the output in debug mode, just in case there are useful messages
+                // in it, but assume the command succeeded.
+                DLOG(("") << response);
+            }
+        }
+        catch (const Json::LogicError&)
+        {
+            errs << "Server response could not be parsed as json: ";
+            errs << response;
+        }
+    }
+    if (errs.tellp() == 0 && httpcode >= 400)
+    {
+        errs << "http post failed with status " << httpcode;
+    }
+    return errs.str();
+}
+
+
+/**
+ * Compress @p data into @p out in gzip format, for a request body with
+ * Content-Encoding: gzip.  Line protocol is very repetitive, so the
+ * fastest compression level already shrinks it several times.
+ **/
+inline void
+gzipBody(const std::string& data, std::string& out)
+{
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    // 16 + MAX_WBITS selects a gzip header and trailer.
+    if (deflateInit2(&zs, Z_BEST_SPEED, Z_DEFLATED, 16 + MAX_WBITS, 8,
+                     Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        throw std::runtime_error("deflateInit2 failed.");
+    }
+    out.resize(deflateBound(&zs, data.size()));
+    zs.next_in = (Bytef*)data.data();
+    zs.avail_in = data.size();
+    zs.next_out = (Bytef*)&out[0];
+    zs.avail_out = out.size();
+    int res = deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    if (res != Z_STREAM_END)
+    {
+        throw std::runtime_error("deflate failed.");
+    }
+}
+
+
+/**
+ * Counts of the batches posted by an InfluxWriter, and of the times
+ * the sample reading thread had to wait for room in the queue.
+ **/
+struct InfluxWriterStats
+{
+    InfluxWriterStats() :
+        batches(0), lines(0), bytes(0), sentBytes(0), agedBatches(0),
+        maxQueued(0), stalls(0), stallSecs(0), postSecs(0)
+    {}
+
+    // batches and lines posted successfully
+    unsigned long long batches;
+    unsigned long long lines;
+
+    // line protocol bytes, and bytes sent after compression
+    unsigned long long bytes;
+    unsigned long long sentBytes;
+
+    // batches queued because they reached the maximum age
+    unsigned long long agedBatches;
+
+    // most batches waiting in the queue at once
+    unsigned int maxQueued;
+
+    // number of times and total seconds add() waited for the queue
+    unsigned long long stalls;
+    double stallSecs;
+
+    // total seconds of the http requests
+    double postSecs;
+};
+
+
+/**
+ * Accumulate line protocol into batches and post them to the database
+ * from a background thread, so slow writes do not stall the reading of
+ * samples.  A batch is queued when it has reached the maximum number of
+ * lines or the maximum age.  Batches wait in a bounded queue: when it is
+ * full, add() blocks, and the waits are counted in the statistics as
+ * back-pressure.  The sender thread posts up to getMaxRequests() batches
+ * at once on a curl multi handle, which keeps connections to the server
+ * alive between requests, and the request bodies are gzip compressed
+ * unless disabled.
+ *
+ * Like the synchronous posts it replaces, the writer stops at the first
+ * failed post: the error is returned by getErrors(), queued batches are
+ * discarded, and add() returns false.
+ **/
+class InfluxWriter
+{
+public:
+    typedef std::chrono::steady_clock clock_t;
+
+    InfluxWriter() :
+        _url(),
+        _maxLines(5000),
+        _maxAge(std::chrono::seconds(5)),
+        _maxQueue(4),
+        _gzip(true),
+        _current(),
+        _currentLines(0),
+        _currentStart(),
+        _queue(),
+        _requests(2),
+        _running(0),
+        _errs(),
+        _stats(),
+        _quit(false),
+        _mutex(),
+        _cond(),
+        _multi(0),
+        _thread()
+    {}
+
+    ~InfluxWriter()
+    {
+        stop();
+    }
+
+    /**
+     * Set the database write url.  Takes effect when the thread starts,
+     * on the first call to add().
+     **/
+    void
+    setURL(const std::string& url)
+    {
+        _url = url;
+    }
+
+    void
+    setMaxLines(unsigned int nlines)
+    {
+        _maxLines = std::max(nlines, 1u);
+    }
+
+    void
+    setMaxAge(double secs)
+    {
+        _maxAge = std::chrono::duration_cast<clock_t::duration>(
+            std::chrono::duration<double>(secs));
+    }
+
+    void
+    setMaxQueue(unsigned int nbatches)
+    {
+        _maxQueue = std::max(nbatches, 1u);
+    }
+
+    void
+    setMaxRequests(unsigned int nrequests)
+    {
+        _requests.resize(std::max(nrequests, 1u));
+    }
+
+    unsigned int
+    getMaxRequests()
+    {
+        return _requests.size();
+    }
+
+    void
+    setGzip(bool gzip)
+    {
+        _gzip = gzip;
+    }
+
+    /**
+     * Add one or more lines of line protocol, each terminated by a
+     * newline, counted as @p nlines lines.  Return false if the writer
+     * has failed.
+     **/
+    bool
+    add(const std::string& lines, unsigned int nlines = 1)
+    {
+        if (!_thread.joinable())
+            start();
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_errs.empty())
+            return false;
+        if (_current.empty())
+        {
+            // Wake the sender so it watches the age of the new batch.
+            _currentStart = clock_t::now();
+            _cond.notify_all();
+        }
+        _current += lines;
+        _currentLines += nlines;
+        if (_currentLines >= _maxLines)
+        {
+            queueCurrent(lock);
+        }
+        return _errs.empty();
+    }
+
+    /**
+     * Queue the current batch and wait until all batches have been
+     * posted.  Return false if the writer has failed.
+     **/
+    bool
+    flush()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        if (!_current.empty() && _errs.empty())
+        {
+            queueCurrent(lock);
+        }
+        while ((!_queue.empty() || _running > 0) && _errs.empty())
+        {
+            _cond.wait(lock);
+        }
+        return _errs.empty();
+    }
+
+    /**
+     * Post any queued batches and stop the sender thread.  Lines which
+     * have not been queued are discarded, so call flush() first.
+     **/
+    void
+    stop()
+    {
+        if (!_thread.joinable())
+            return;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _quit = true;
+            _cond.notify_all();
+        }
+        wakeup();
+        _thread.join();
+        curl_multi_cleanup(_multi);
+        _multi = 0;
+        for (auto& req : _requests)
+        {
+            if (req.curl)
+                curl_easy_cleanup(req.curl);
+            if (req.headers)
+                curl_slist_free_all(req.headers);
+            req.curl = 0;
+            req.headers = 0;
+        }
+    }
+
+    std::string
+    getErrors()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _errs;
+    }
+
+    InfluxWriterStats
+    getStats()
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        return _stats;
+    }
+
+    void
+    logStats()
+    {
+        InfluxWriterStats stats = getStats();
+        ILOG(("") << "posted " << stats.lines << " lines in "
+             << stats.batches << " batches, " << stats.agedBatches
+             << " queued by age; " << stats.bytes << " bytes, "
+             << stats.sentBytes << " sent; "
+             << std::fixed << std::setprecision(3)
+             << stats.postSecs << " secs posting");
+        ILOG(("") << "queue: max " << stats.maxQueued << " of " << _maxQueue
+             << " batches; reader waited " << stats.stalls << " times, "
+             << std::fixed << std::setprecision(3)
+             << stats.stallSecs << " secs");
+    }
+
+private:
+
+    struct Batch
+    {
+        std::string data;
+        unsigned int nlines;
+    };
+
+    /**
+     * A request in flight on the multi handle.  The easy handles are
+     * kept, so curl can reuse their connections.
+     **/
+    struct Request
+    {
+        Request() :
+            curl(0), headers(0), body(), response(), nlines(0),
+            nbytes(0), start(), busy(false)
+        {
+            errors[0] = '\0';
+        }
+        CURL* curl;
+        curl_slist* headers;
+        std::string body;
+        std::string response;
+        unsigned int nlines;
+        size_t nbytes;
+        clock_t::time_point start;
+        bool busy;
+        char errors[CURL_ERROR_SIZE];
+    };
+
+    void
+    start()
+    {
+        _multi = curl_multi_init();
+        if (!_multi)
+        {
+            throw std::runtime_error("curl_multi_init failed.");
+        }
+        for (auto& req : _requests)
+        {
+            req.curl = curl_easy_init();
+            if (!req.curl)
+            {
+                throw std::runtime_error("curl_easy_init failed.");
+            }
+            req.headers = curl_slist_append(0, "Content-Type: text/plain");
+            if (_gzip)
+            {
+                req.headers = curl_slist_append(req.headers,
+                                                "Content-Encoding: gzip");
+            }
+            curl_easy_setopt(req.curl, CURLOPT_URL, _url.c_str());
+            curl_easy_setopt(req.curl, CURLOPT_HTTPHEADER, req.headers);
+            curl_easy_setopt(req.curl, CURLOPT_TCP_KEEPALIVE, 1L);
+            curl_easy_setopt(req.curl, CURLOPT_WRITEFUNCTION, writeResponse);
+            curl_easy_setopt(req.curl, CURLOPT_WRITEDATA, &req.response);
+            curl_easy_setopt(req.curl, CURLOPT_ERRORBUFFER, req.errors);
+            curl_easy_setopt(req.curl, CURLOPT_PRIVATE, &req);
+        }
+        _thread = std::thread(&InfluxWriter::run, this);
+    }
+
+    static size_t
+    writeResponse(void *buffer, size_t size, size_t nmemb, void *userp)
+    {
+        static_cast<std::string*>(userp)->append((const char*)buffer,
+                                                 size * nmemb);
+        return size * nmemb;
+    }
+
+    /**
+     * Move the current batch to the queue, waiting for room.
+     * _mutex must be locked.
+     **/
+    void
+    queueCurrent(std::unique_lock<std::mutex>& lock)
+    {
+        if (_queue.size() >= _maxQueue)
+        {
+            clock_t::time_point t0 = clock_t::now();
+            ++_stats.stalls;
+            while (_queue.size() >= _maxQueue && _errs.empty())
+            {
+                _cond.wait(lock);
+            }
+            _stats.stallSecs +=
+                std::chrono::duration<double>(clock_t::now() - t0).count();
+        }
+        if (_errs.empty())
+        {
+            pushCurrent();
+            wakeup();
+        }
+        else
+        {
+            _current.clear();
+            _currentLines = 0;
+        }
+    }
+
+    /**
+     * Move the current batch to the end of the queue.  _mutex must be
+     * locked.
+     **/
+    void
+    pushCurrent()
+    {
+        _queue.push_back(Batch());
+        _queue.back().data.swap(_current);
+        _queue.back().nlines = _currentLines;
+        _current.clear();
+        _currentLines = 0;
+        _stats.maxQueued = std::max(_stats.maxQueued,
+                                    (unsigned int)_queue.size());
+        _cond.notify_all();
+    }
+
+    /**
+     * Queue the current batch if it is older than _maxAge, unless the
+     * queue is full.  Return the time until it will be.  _mutex must be
+     * locked.
+     **/
+    clock_t::duration
+    queueAged()
+    {
+        if (_current.empty())
+            return _maxAge;
+        clock_t::duration age = clock_t::now() - _currentStart;
+        if (age < _maxAge)
+            return _maxAge - age;
+        if (_queue.size() < _maxQueue)
+        {
+            ++_stats.agedBatches;
+            pushCurrent();
+            return _maxAge;
+        }
+        return std::chrono::milliseconds(100);
+    }
+
+    /**
+     * Wake the sender from curl_multi_poll().
+     **/
+    void
+    wakeup()
+    {
+#if LIBCURL_VERSION_NUM >= 0x074400
+        if (_multi)
+            curl_multi_wakeup(_multi);
+#endif
+    }
+
+    /**
+     * Compress the batch into a free request and add it to the
+     * multi handle.
+     **/
+    void
+    post(Batch& batch)
+    {
+        Request* req = 0;
+        for (auto& r : _requests)
+        {
+            if (!r.busy)
+            {
+                req = &r;
+                break;
+            }
+        }
+        req->busy = true;
+        req->nlines = batch.nlines;
+        req->nbytes = batch.data.size();
+        req->response.clear();
+        req->errors[0] = '\0';
+        if (_gzip)
+            gzipBody(batch.data, req->body);
+        else
+            req->body.swap(batch.data);
+        DLOG(("posting ") << req->nlines << " measurements, "
+             << req->body.size() << " bytes: " << _url);
+        curl_easy_setopt(req->curl, CURLOPT_POSTFIELDS, req->body.data());
+        curl_easy_setopt(req->curl, CURLOPT_POSTFIELDSIZE_LARGE,
+                         (curl_off_t)req->body.size());
+        req->start = clock_t::now();
+        curl_multi_add_handle(_multi, req->curl);
+    }
+
+    /**
+     * Handle a completed request.
+     **/
+    void
+    finish(CURL* curl, CURLcode res)
+    {
+        Request* req = 0;
+        curl_easy_getinfo(curl, CURLINFO_PRIVATE, (char**)&req);
+        curl_multi_remove_handle(_multi, curl);
+        long httpcode = 0;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &httpcode);
+        std::string errs = influxErrors(res, req->errors, httpcode,
+                                        req->response);
+
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (errs.empty())
+        {
+            ++_stats.batches;
+            _stats.lines += req->nlines;
+            _stats.bytes += req->nbytes;
+            _stats.sentBytes += req->body.size();
+            _stats.postSecs += std::chrono::duration<double>(
+                clock_t::now() - req->start).count();
+        }
+        else if (_errs.empty())
+        {
+            ELOG(("database write failed: ") << errs);
+            _errs = errs;
+            // Nothing more will be posted, so release the waiters.
+            _queue.clear();
+        }
+        req->busy = false;
+        --_running;
+        _cond.notify_all();
+    }
+
+    void
+    run()
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        for (;;)
+        {
+            clock_t::duration wait = queueAged();
+            while (!_queue.empty() && _running < _requests.size())
+            {
+                Batch batch;
+                batch.data.swap(_queue.front().data);
+                batch.nlines = _queue.front().nlines;
+                _queue.pop_front();
+                ++_running;
+                // There is room in the queue.
+                _cond.notify_all();
+                lock.unlock();
+                post(batch);
+                lock.lock();
+            }
+            if (_running == 0)
+            {
+                if (_quit)
+                    break;
+                _cond.wait_for(lock, wait);
+                continue;
+            }
+            lock.unlock();
+
+            int nrunning;
+            curl_multi_perform(_multi, &nrunning);
+            CURLMsg* msg;
+            int nmsgs;
+            while ((msg = curl_multi_info_read(_multi, &nmsgs)))
+            {
+                if (msg->msg == CURLMSG_DONE)
+                    finish(msg->easy_handle, msg->data.result);
+            }
+#if LIBCURL_VERSION_NUM >= 0x074400
+            const std::chrono::milliseconds maxPoll(1000);
+#else
+            // Without curl_multi_wakeup(), poll for new batches.
+            const std::chrono::milliseconds maxPoll(20);
+#endif
+            // Limit the wait before converting it to an int.
+            int timeout = std::chrono::duration_cast<
+                std::chrono::milliseconds>(
+                    std::min<clock_t::duration>(wait, maxPoll)).count();
+#if LIBCURL_VERSION_NUM >= 0x074400
+            curl_multi_poll(_multi, 0, 0, timeout, 0);
+#else
+            curl_multi_wait(_multi, 0, 0, timeout, 0);
+#endif
+            lock.lock();
+        }
+    }
+
+    std::string _url;
+
+    unsigned int _maxLines;
+
+    clock_t::duration _maxAge;
+
+    unsigned int _maxQueue;
+
+    bool _gzip;
+
+    // The batch being filled by add(), and when its first line was added.
+    std::string _current;
+    unsigned int _currentLines;
+    clock_t::time_point _currentStart;
+
+    std::deque<Batch> _queue;
+
+    std::vector<Request> _requests;
+
+    // Number of requests in flight.
+    unsigned int _running;
+
+    std::string _errs;
+
+    InfluxWriterStats _stats;
+
+    bool _quit;
+
+    // Protects the members above which are shared with the sender thread.
+    std::mutex _mutex;
+
+    // Signals changes in _queue, _running, _current and _errs.
+    std::condition_variable _cond;
+
+    CURLM* _multi;
+
+    std::thread _thread;
+
+    InfluxWriter(const InfluxWriter&) = delete;
+    InfluxWriter& operator=(const InfluxWriter&) = delete;
+};
+
+#endif
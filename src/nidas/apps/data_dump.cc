@@ -41,9 +41,12 @@
 #include <nidas/util/util.h>
 #include <nidas/util/auto_ptr.h>
 #include <nidas/util/EndianConverter.h>
+#include <nidas/util/FormatBuffer.h>
+#include <nidas/util/UTimeFormatter.h>
 #include <nidas/core/NidasApp.h>
 #include <nidas/core/BadSampleFilter.h>
 #include <nidas/core/Variable.h>
+#include <nidas/core/SampleIdMap.h>
 
 #include <set>
 #include <map>
@@ -74,6 +77,7 @@ public:
     void
     flush() throw()
     {
+        ostr.flush();
     }
 
     bool receive(const Sample* samp) throw();
@@ -109,7 +113,7 @@ public:
     void
     setTimeFormat(const std::string& fmt)
     {
-        timeformat = fmt;
+        _timeFormat.setFormat(fmt, true);
     }
 
     void
@@ -118,6 +122,17 @@ public:
         csv = enable;
     }
 
+    /**
+     * Whether to flush the output after every line, as when reading
+     * samples in real-time.  Otherwise output is flushed when the
+     * stream buffer fills, and by flush().
+     */
+    void
+    setLineFlush(bool enable)
+    {
+        lineflush = enable;
+    }
+
     void setSensors(list<DSMSensor*>& sensors);
 
 private:
@@ -135,8 +150,8 @@ private:
     bool showdeltat;
     int precision;
     bool showlen;
-    string timeformat;
     bool csv;
+    bool lineflush;
 
     vector<string> vnames;
     /// Map a column name to a width.
@@ -155,6 +170,42 @@ private:
     std::ostream& setfield(std::ostream& out, const std::string& name,
                            int width = 0);
 
+    /**
+     * Lines are formatted into _buf and written to ostr in one call.
+     * The formatting matches what setfield() does for each field on
+     * an ostream: a separator, except before the datetime, and the
+     * field width, except in CSV.
+     */
+    n_u::FormatBuffer _buf;
+
+    n_u::UTimeFormatter _timeFormat;
+
+    /// Field widths, looked up from widths once rather than per field.
+    int _wdatetime;
+    int _wdeltat;
+    int _wdsm;
+    int _wlen;
+    int _wdata;
+
+    void cacheWidths();
+
+    int
+    fieldWidth(int width) const
+    {
+        return csv ? 0 : width;
+    }
+
+    void
+    separator()
+    {
+        _buf.append(csv ? ',' : ' ');
+    }
+
+    /// Formatted sample ids, by sample id.
+    SampleIdMap<std::string> _sampleIds;
+
+    const std::string& formatSampleId(dsm_sample_id_t sampid);
+
     void dumpNaked(const Sample* samp);
 
     DumpClient(const DumpClient&);
@@ -175,11 +226,40 @@ DumpClient::DumpClient(const SampleMatcher& matcher, dump_format_t fmt,
     showdeltat(true),
     precision(0),
     showlen(true),
-    timeformat(DEFTIMEFMT),
     csv(false),
+    lineflush(true),
     vnames(),
-    widths()
+    widths(),
+    _buf(),
+    _timeFormat(DEFTIMEFMT),
+    _wdatetime(0), _wdeltat(0), _wdsm(0), _wlen(0), _wdata(0),
+    _sampleIds()
 {
+    cacheWidths();
+}
+
+void
+DumpClient::cacheWidths()
+{
+    _wdatetime = getWidth("datetime");
+    _wdeltat = getWidth("deltaT");
+    _wdsm = getWidth("dsm");
+    _wlen = getWidth("len");
+    _wdata = getWidth("data");
+}
+
+const std::string&
+DumpClient::formatSampleId(dsm_sample_id_t sampid)
+{
+    SampleIdMap<std::string>::iterator it = _sampleIds.find(sampid);
+    if (it == _sampleIds.end())
+    {
+        NidasApp* app = NidasApp::getApplicationInstance();
+        ostringstream out;
+        app->formatSampleId(out, sampid);
+        it = _sampleIds.insert(make_pair(sampid, out.str())).first;
+    }
+    return it->second;
 }
 
 void
@@ -278,6 +358,7 @@ DumpClient::printHeader()
         setfield(ostr, "data", 1) << "data...";
     }
     ostr << endl;
+    cacheWidths();
 }
 
 /*
@@ -352,27 +433,30 @@ DumpClient::receive(const Sample* samp) throw()
                  << endl;
         }
     }
-    setfield(ostr, "datetime") << n_u::UTime(tt).format(true, timeformat);
+    _buf.clear();
+    _timeFormat.append(_buf, tt);
+    _buf.justify(0, fieldWidth(_wdatetime));
 
-    ostr << setprecision(4);
     if (showdeltat)
     {
-        setfield(ostr, "deltaT") << tdiff;
+        separator();
+        _buf.appendGeneral(tdiff, 4, fieldWidth(_wdeltat));
     }
 
     if (!_samples.exclusiveMatch())
     {
-        NidasApp* app = NidasApp::getApplicationInstance();
-        setfield(ostr, "dsm") << GET_DSM_ID(sampid);
+        separator();
+        _buf.appendUnsigned(GET_DSM_ID(sampid), fieldWidth(_wdsm));
         // By convention, IDs are always separated by a comma, even when CSV
         // is not in effect.
-        ostr << ",";
-        app->formatSampleId(ostr, sampid);
+        _buf.append(',');
+        _buf.append(formatSampleId(sampid));
     }
 
     if (showlen)
     {
-        setfield(ostr, "len") << samp->getDataByteLength();
+        separator();
+        _buf.appendUnsigned(samp->getDataByteLength(), fieldWidth(_wlen));
     }
     prev_tt = tt;
 
@@ -406,18 +490,20 @@ DumpClient::receive(const Sample* samp) throw()
             if (sample_format == dump_format_t::ASCII_7)
                 *xp = *xp & 0x7f;
         }
-        setfield(ostr, "data", 1)
-            << n_u::addBackslashSequences(string(cp7, l));
+        separator();
+        _buf.append(n_u::addBackslashSequences(string(cp7, l)),
+                    fieldWidth(1));
     }
     break;
     case dump_format_t::HEX_FMT:
     {
         const unsigned char* cp =
             (const unsigned char*)samp->getConstVoidDataPtr();
-        ostr << setfill('0');
         for (unsigned int i = 0; i < samp->getDataByteLength(); i++)
-            setfield(ostr, "data", 2) << hex << (unsigned int)cp[i];
-        ostr << dec << setfill(' ');
+        {
+            separator();
+            _buf.appendHex(cp[i], fieldWidth(2), '0');
+        }
     }
     break;
     case dump_format_t::SIGNED_SHORT:
@@ -425,7 +511,10 @@ DumpClient::receive(const Sample* samp) throw()
         const short* sp = (const short*)samp->getConstVoidDataPtr();
         for (unsigned int i = 0; i < samp->getDataByteLength() / sizeof(short);
              i++)
-            setfield(ostr, "data", 6) << sp[i];
+        {
+            separator();
+            _buf.appendInt(sp[i], fieldWidth(6));
+        }
     }
     break;
     case dump_format_t::UNSIGNED_SHORT:
@@ -434,19 +523,29 @@ DumpClient::receive(const Sample* samp) throw()
             (const unsigned short*)samp->getConstVoidDataPtr();
         for (unsigned int i = 0; i < samp->getDataByteLength() / sizeof(short);
              i++)
-            setfield(ostr, "data", 6) << sp[i];
+        {
+            separator();
+            _buf.appendUnsigned(sp[i], fieldWidth(6));
+        }
     }
     break;
     case dump_format_t::FLOAT:
+    {
         p = (p != 0) ? p : (samp->getType() == DOUBLE_ST ? 10 : 5);
-        ostr << setprecision(p);
-        ostr << setfill(' ');
-
+        int width = fieldWidth(_wdata);
         for (unsigned int i = 0; i < samp->getDataLength(); i++)
-            setfield(ostr, "data") << samp->getDataValue(i);
-        break;
+        {
+            separator();
+            _buf.appendGeneral(samp->getDataValue(i), p, width);
+        }
+    }
+    break;
     case dump_format_t::IRIG:
     {
+        // Rare enough to leave on the ostream.
+        ostr.write(_buf.data(), _buf.size());
+        _buf.clear();
+
         const unsigned char* statusp = IRIGSensor::getStatusPtr(samp);
         unsigned char status = *statusp++;
 
@@ -482,7 +581,10 @@ DumpClient::receive(const Sample* samp) throw()
         const int* lp = (const int*)samp->getConstVoidDataPtr();
         for (unsigned int i = 0; i < samp->getDataByteLength() / sizeof(int);
              i++)
-            setfield(ostr, "data", 8) << lp[i];
+        {
+            separator();
+            _buf.appendInt(lp[i], fieldWidth(8));
+        }
     }
     break;
     case dump_format_t::NAKED:
@@ -490,7 +592,10 @@ DumpClient::receive(const Sample* samp) throw()
     case dump_format_t::DEFAULT:
         break;
     }
-    ostr << endl;
+    _buf.append('\n');
+    ostr.write(_buf.data(), _buf.size());
+    if (lineflush)
+        ostr.flush();
     return true;
 }
 
@@ -569,7 +674,7 @@ DataDump::parseRunstring(int argc, char** argv)
                         app.Version | app.InputFiles | app.ProcessData |
                         app.Help | app.Version | WarnTime | NoDeltaT | NoLen |
                         FormatTimeISO | CSV | FilterArg | app.Precision |
-                        TimeFormat);
+                        TimeFormat | app.MappedInput);
 
     app.InputFiles.allowFiles = true;
     app.InputFiles.allowSockets = true;
@@ -700,6 +805,7 @@ DataDump::run() throw()
         // If you want to process data, get the raw stream
         SampleInputStream sis(iochan, app.processData());
         // SampleStream now owns the iochan ptr.
+        if (app.MappedInput.asBool()) sis.setMappedInput(true);
 
         BadSampleFilter& bsf = FilterArg.getFilter();
         bsf.setDefaultTimeRange(app.getStartTime(), app.getEndTime());
@@ -762,6 +868,8 @@ DataDump::run() throw()
         dumper.setShowLen(!NoLen.asBool());
         dumper.setSensors(allsensors);
         dumper.setCSV(CSV.asBool());
+        // Samples from a socket are shown as they arrive.
+        dumper.setLineFlush(app.dataFileNames().empty());
 
         if (FormatTimeISO.asBool())
             dumper.setTimeFormat(ISOFORMAT);
@@ -823,6 +931,7 @@ DataDump::run() throw()
         {
             sis.removeSampleClient(&dumper);
         }
+        dumper.flush();
         sis.close();
         pipeline.interrupt();
         pipeline.join();
@@ -61,11 +61,18 @@
 #include <stdio.h> // for making an api request to insert data into influxdb
 #include <curl/curl.h>
 #include <curl/easy.h>
-#include <future> //async function calls
-#include <mutex> //locking the string of data to reset to empty, may not be useful?
+#include <zlib.h>     // gzip request bodies
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
 
 #include <json/json.h>
 
+#include "InfluxWriter.h"
+
 
 using namespace nidas::core;
 using namespace nidas::dynld;
@@ -179,13 +186,10 @@ string_to_lower(const std::string& upper)
 
 
 
-CURLcode
-dataToInfluxDB(CURL* curl, const std::string& url,
-               CharBuffer* data, unsigned int nmeasurements);
-
 size_t
 writeInfluxResult(void *buffer, size_t size, size_t nmemb, void *userp);
 
+
 /**
  * Methods and memory for creating an Influx database, accumulating
  * measurements, and posting them to the database.
@@ -201,9 +205,7 @@ public:
              const std::string& dbname = "") :
         _url(url),
         _dbname(dbname),
-        _data(0),
-        _data1(),
-        _data2(),
+        _data(),
         _result(),
         _errs(),
         _nmeasurements(0),
@@ -212,9 +214,8 @@ public:
         _echo(false),
         _async(true),
         _curl(0),
-        _post()
+        _writer()
     {
-        _data = &_data1;
     }
 
     inline bool
@@ -316,6 +317,13 @@ public:
     setCount(unsigned int count)
     {
         _count = count;
+        _writer.setMaxLines(count);
+    }
+
+    InfluxWriter&
+    getWriter()
+    {
+        return _writer;
     }
 
     /**
@@ -330,7 +338,8 @@ public:
 
     /**
      * If @p enable is true, data will be posted to the database
-     * asynchronously.
+     * asynchronously by the InfluxWriter.  Otherwise, addMeasurement()
+     * waits for each batch to be posted.
      **/
     void
     setAsync(bool enable)
@@ -340,6 +349,7 @@ public:
 
     ~InfluxDB()
     {
+        _writer.stop();
         if (_curl)
         {
             curl_easy_cleanup(_curl);
@@ -370,77 +380,60 @@ public:
 
     /**
      * Return false if there is an error adding this measurement.  If
-     * enough measurements have accumulated, then this will post the
-     * current buffer to the database. If there is an error, the
+     * enough measurements have accumulated, then the current buffer
+     * is queued to be posted to the database. If there is an error, the
      * description will be in getError().
      **/
     bool
     addMeasurement(const std::string& data)
     {
-        char* buf = _data->getSpace(data.length());
         VLOG(("adding data to buffer..."));
-        strcpy(buf, data.c_str());
         ++_nmeasurements;
-        if (_nmeasurements >= _count)
+        if (_echo)
         {
-            return sendData();
+            strcpy(_data.getSpace(data.length()), data.c_str());
+            if (_nmeasurements >= _count)
+            {
+                sendData();
+            }
+            return true;
         }
-        return true;
-    }
-
-    bool
-    sendData()
-    {
-        if (!_echo && !isOpen())
-            open();
         if (!_errs.empty())
         {
             // We're in an error state, meaning some previous attempt to
-            // write data has failed, and no further attempts will be made,
-            // so just clear the data.
-            _data->clear();
+            // write data has failed, and no further attempts will be made.
             return false;
         }
-
-        DLOG(("sendData()...") << "async:" << _async);
-
-        // Do one of three things with the current data: echo, send it
-        // asynchronously, or send it synchronously.
-        CURLcode res = CURLE_OK;
-        if (_echo)
+        if (!_writer.add(data) ||
+            (!_async && _nmeasurements >= _count && !_writer.flush()))
         {
-            std::cout << _data->get();
-            _data->clear();
+            _errs = _writer.getErrors();
+            return false;
         }
-        else if (_async)
+        if (_nmeasurements >= _count)
         {
-            // Make sure any current _post future is finished before
-            // launching another one on the next buffer.
-            if (_post.valid())
-            {
-                res = _post.get();
-            }
+            _total_measurements += _nmeasurements;
+            _nmeasurements = 0;
         }
-        else if (!_data->empty())
+        return true;
+    }
+
+    /**
+     * Send whatever is in the current buffer: print it if echo is
+     * enabled, otherwise queue it to be posted.
+     **/
+    bool
+    sendData()
+    {
+        if (_echo)
         {
-            res = dataToInfluxDB(_curl, getWriteURL(), _data, _nmeasurements);
+            std::cout << _data.get();
+            _data.clear();
         }
-        handleResult(res);
-
-        if (_async && _errs.empty() && !_data->empty())
+        else if (_errs.empty() && !_writer.flush())
         {
-            _post = std::async(std::launch::async, &dataToInfluxDB,
-                               _curl, getWriteURL(), _data, _nmeasurements);
-            // Now swap the _data pointer to stop writing into the buffer
-            // which has just been passed to the async call.  This only has
-            // to happen if async enabled, since otherwise we can just keep
-            // rewriting the same buffer.
-            if (_data == &_data1)
-                _data = &_data2;
-            else
-                _data = &_data1;
+            _errs = _writer.getErrors();
         }
-
         if (_errs.empty())
         {
             _total_measurements += _nmeasurements;
@@ -451,8 +444,7 @@ public:
 
     /**
      * Return the total number of measurements written to the database so
-     * far.  This does not include the measurements currently in the buffer
-     * and not yet written.
+     * far.  This includes measurements queued but not yet posted.
      **/
     unsigned int
     totalMeasurements()
@@ -468,13 +460,12 @@ public:
     flush()
     {
         ILOG(("flushing database writes..."));
-        sendData();
-        // In case the first sendData() call started an async posting,
-        // call it again to make sure it finishes.
         if (!sendData())
         {
             throw n_u::Exception(getErrors());
         }
+        if (!_echo)
+            _writer.logStats();
     }
 
     void
@@ -484,55 +475,18 @@ public:
     handleResult(CURLcode res)
     {
         // If any error messages are accumulated in this stream, they are
-        // set to the error string member.  We don't throw exceptions in
-        // this method because it is likely called from a receive() method
-        // which is not running in the main thread.
-        std::ostringstream errs;
-
-        // First see if the curl call itself failed.
-        if (res != CURLE_OK)
-        {
-            errs << "http post failed: " << _curl_errors;
-        }
-        // Then see if the json result indicates an error.
-        if (!_result.empty())
-        {
-            try {
-                std::istringstream js(_result.get());
-                Json::Value root;
-                js >> root;
-                Json::Value error = root["error"];
-                string dnf = "database not found";
-                if (!error.isNull() &&
-                    error.asString().substr(0, dnf.size()) == dnf)
-                {
-                    errs << error.asString()
-                         << "; maybe use --create to create it first?";
-                }
-                else if (!error.isNull())
-                {
-                    errs << error.asString();
-                }
-                else
-                {
-                    // Show the output in debug mode, just in case there are useful messages
-                    // in it, but assume the command succeeded.
-                    DLOG(("") << _result.get());
-                }
-            }
-            catch (const Json::LogicError&)
-            {
-                errs << "Server response could not be parsed as json: ";
-                errs << _result.get();
-            }
-        }
+        // set to the error string member.
+        long httpcode = 0;
+        curl_easy_getinfo(_curl, CURLINFO_RESPONSE_CODE, &httpcode);
+        _errs = influxErrors(res, _curl_errors, httpcode,
+                             _result.empty() ? "" : _result.get());
 
         // Done with the result, prepare it for another posting.
         _result.clear();
-        _errs = errs.str();
     }
 
 
+
 private:
 
     InfluxDB(const InfluxDB&);
@@ -543,12 +497,8 @@ private:
     string _username;
     string _password;
 
-    // _data points to the current data buffer to which data will be added.
-    // This is a double-buffering scheme to allow one buffer to be written
-    // while the other posts to influxdb.
-    CharBuffer* _data;
-    CharBuffer _data1;
-    CharBuffer _data2;
+    // Data accumulated for echo.
+    CharBuffer _data;
     CharBuffer _result;
 
     // If an error is encountered, preserve the information here and then
@@ -568,13 +518,14 @@ private:
 
     bool _echo;
 
-    // Use asynchronous calls to post data buffer to the database.
+    // Post batches to the database without waiting for them.
     bool _async;
     
+    // Connection for createInfluxDB().
     CURL *_curl;
     char _curl_errors[CURL_ERROR_SIZE];
 
-    std::future<CURLcode> _post;
+    InfluxWriter _writer;
 };
 
 
@@ -908,33 +859,6 @@ writeInfluxResult(void *buffer, size_t size, size_t nmemb, void *userp)
 }
 
 
-/**
- * Post the given data buffer to the database, then clear it.  This is a
- * function and not a method of InfluxDB, so that it only uses the
- * variables passed into it and no locking is needed to ensure exclusive
- * access to the object.  The CURL pointer is only ever used here, so as
- * long as only double-buffering is used, only one thread should ever call
- * into the curl library at a time.
- **/
-CURLcode
-dataToInfluxDB(CURL* curl, const std::string& url,
-               CharBuffer* data, unsigned int nmeasurements)
-{
-    DLOG(("posting ") << nmeasurements << " measurements: " << url);
-    DLOG(("data:") << data->get());
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, data->get());
-    CURLcode res = curl_easy_perform(curl);
-    data->clear();
-    if (res != CURLE_OK)
-    {
-        ELOG(("database write failed: ") << res);
-    }
-    DLOG(("posting done."));
-    return res;
-}
-
-
 void SampleToDatabase::
 accumulate(const Sample *samp)
 {
@@ -1151,6 +1075,10 @@ class DataInfluxdb
     NidasAppArg Database;
     NidasAppArg Echo;
     NidasAppArg Async;
+    NidasAppArg MaxAge;
+    NidasAppArg Queue;
+    NidasAppArg Requests;
+    NidasAppArg Gzip;
     NidasAppArg Create;
     NidasAppArg User;
     NidasAppArg Password;
@@ -1178,6 +1106,21 @@ DataInfluxdb::DataInfluxdb() :
     Async("--async", "{yes|no}",
           "Specify yes to post data to the database asynchronously.",
           "yes"),
+    MaxAge("--max-age", "<seconds>",
+           "Post the measurements accumulated so far when the oldest "
+           "has waited this long, even if there are fewer than <count>. "
+           "At most 86400.",
+           "5"),
+    Queue("--queue", "<batches>",
+          "Number of batches which can wait to be posted before reading "
+          "samples waits for them.",
+          "4"),
+    Requests("--requests", "<n>",
+             "Number of batches which can be posted at once.",
+             "2"),
+    Gzip("--gzip", "{yes|no}",
+         "Specify yes to gzip compress the posted data.",
+         "yes"),
     Create("--create", "",
            "Create the given database before posting data to it."),
     User("-u,--user", "username",
@@ -1192,6 +1135,7 @@ DataInfluxdb::DataInfluxdb() :
     app.enableArguments(app.XmlHeaderFile | app.loggingArgs() | app.Help |
                         app.SampleRanges | app.Version | app.InputFiles |
                         Count | URL | Database | Echo | Create | Async |
+                        MaxAge | Queue | Requests | Gzip |
                         User | Password);
     app.InputFiles.allowFiles = true;
     app.InputFiles.allowSockets = true;
@@ -1232,6 +1176,22 @@ parseRunstring(int argc, char **argv)
         if (Async.getValue() != "yes" && Async.getValue() != "no")
             throw NidasAppException("--async must be 'yes' or 'no'.");
         _db.setAsync(Async.getValue() == "yes");
+        // An age of more than a day would only delay the data, and
+        // a much larger one overflows the clock duration.
+        if (MaxAge.asFloat() <= 0 || MaxAge.asFloat() > 86400)
+            throw NidasAppException("--max-age must be positive, "
+                                    "and at most 86400 seconds.");
+        if (Queue.asInt() < 1 || Requests.asInt() < 1)
+            throw NidasAppException("--queue and --requests must be "
+                                    "at least 1.");
+        if (Gzip.getValue() != "yes" && Gzip.getValue() != "no")
+            throw NidasAppException("--gzip must be 'yes' or 'no'.");
+        InfluxWriter& writer = _db.getWriter();
+        writer.setURL(_db.getWriteURL());
+        writer.setMaxAge(MaxAge.asFloat());
+        writer.setMaxQueue(Queue.asInt());
+        writer.setMaxRequests(Requests.asInt());
+        writer.setGzip(Gzip.getValue() == "yes");
         app.parseInputs(args);
     }
     catch (NidasAppException &ex)
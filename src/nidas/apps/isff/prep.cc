@@ -474,7 +474,9 @@ int DataPrep::parseRunstring(int argc, char** argv)
                          _app.DatasetName | ConfigsName | DSMName |
                          DumpASCII | DumpBINARY | DOSOutput |
                          NetcdfOutput | _app.Clipping | _FilterArg |
-                         _app.SorterLength | HeapSize | Precision | NoHeader |
+                         _app.SorterLength | _app.ProcessThreads |
+                         _app.AsyncProcessThreads |
+                         HeapSize | Precision | NoHeader |
                          _app.loggingArgs() | _app.XmlHeaderFile |
                          _app.Version | _app.Help);
 
@@ -552,6 +554,25 @@ int DataPrep::parseRunstring(int argc, char** argv)
     _doHeader = !NoHeader.asBool();
     _xmlFileName = _app.xmlHeaderFile();
     _sorterLength = _app.getSorterLength(0, 10000);
+    if (_app.ProcessThreads.asInt() < 0)
+    {
+        cerr << "Invalid number of process threads: " <<
+            _app.ProcessThreads.getValue() << endl;
+        return 1;
+    }
+    if (_app.AsyncProcessThreads.asInt() < 0)
+    {
+        cerr << "Invalid number of async threads: " <<
+            _app.AsyncProcessThreads.getValue() << endl;
+        return 1;
+    }
+    if ((_app.ProcessThreads.asInt() > 0 ||
+         _app.AsyncProcessThreads.asInt() > 0) && _sorterLength <= 0)
+    {
+        cerr << "--process-threads and --async-threads require a "
+            "sorter length greater than 0" << endl;
+        return 1;
+    }
 
     _asciiPrecision = Precision.asInt();
     if (_asciiPrecision < 1)
@@ -878,6 +899,8 @@ int DataPrep::run() throw()
              << HeapSize.asInt()*1024 << " KB");
         pipeline.setRawLateSampleCacheSize(0);
         pipeline.setProcLateSampleCacheSize(5);
+        pipeline.setProcessThreads(_app.ProcessThreads.asInt());
+        pipeline.setAsyncProcessThreads(_app.AsyncProcessThreads.asInt());
 
         if (_xmlFileName.length() == 0) {
             sis.readInputHeader();
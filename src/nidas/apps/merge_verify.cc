@@ -356,13 +356,7 @@ int MergeVerifier::run() throw()
         list<string>::const_iterator fi = mergeFileNames.begin();
 
         if (mergeFileNames.size() == 1 && fi->find('%') != string::npos) {
-#ifdef HAVE_BZLIB_H
-            if (fi->find(".bz2") != string::npos)
-                fset = new nidas::core::Bzip2FileSet();
-            else
-#endif
-                fset = new nidas::core::FileSet();
-            fset->setFileName(*fi);
+            fset = nidas::core::FileSet::createFileSet(*fi);
             fset->setStartTime(startTime);
             fset->setEndTime(endTime);
         }
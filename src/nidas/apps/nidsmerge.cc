@@ -64,13 +64,19 @@
 #include <nidas/core/NidasApp.h>
 #include <nidas/core/BadSampleFilter.h>
 #include <nidas/util/Logger.h>
+#include <nidas/util/Thread.h>
+#include <nidas/util/ThreadSupport.h>
 
 #include <unistd.h>
 
 #include <csignal>
 #include <climits>
 
+#include <atomic>
 #include <iomanip>
+#include <list>
+#include <sstream>
+#include <vector>
 
 using namespace nidas::core;
 using namespace nidas::dynld;
@@ -80,6 +86,323 @@ using nidas::util::IOException;
 using nidas::util::EOFException;
 using nidas::util::UTime;
 
+namespace n_u = nidas::util;
+
+
+
+/**
+ * A queue passing items from one thread to another, which blocks the
+ * producer when the queue is full and the consumer when it is empty.
+ */
+template <typename T>
+class BoundedQueue
+{
+public:
+
+    BoundedQueue(size_t maxLength):
+        _queue(),_maxLength(std::max(maxLength, (size_t)1)),
+        _closed(false),_busy(false),_cond()
+    {}
+
+    /**
+     * Add an item, waiting while the queue is full.  Returns false
+     * if the queue has been closed.
+     */
+    bool put(const T& item)
+    {
+        n_u::Autolock autolock(_cond);
+        while (_queue.size() >= _maxLength && !_closed)
+            _cond.wait();
+        if (_closed) return false;
+        _queue.push_back(item);
+        // the consumer only waits when the queue is empty.
+        if (_queue.size() == 1) _cond.broadcast();
+        return true;
+    }
+
+    /**
+     * Take all the items in the queue, waiting while it is empty and
+     * not closed.  @p items must be empty.  Returns false if the queue
+     * is closed and empty.  The consumer calls done() when it has
+     * handled the items.
+     */
+    bool take(std::vector<T>& items)
+    {
+        n_u::Autolock autolock(_cond);
+        while (_queue.empty() && !_closed)
+            _cond.wait();
+        if (_queue.empty()) return false;
+        items.swap(_queue);
+        _busy = true;
+        // wake a put() waiting for room
+        _cond.broadcast();
+        return true;
+    }
+
+    void done()
+    {
+        n_u::Autolock autolock(_cond);
+        _busy = false;
+        _cond.broadcast();
+    }
+
+    /**
+     * Wait until the consumer has handled all items put in the queue.
+     */
+    void drain()
+    {
+        n_u::Autolock autolock(_cond);
+        while ((!_queue.empty() || _busy) && !_closed)
+            _cond.wait();
+    }
+
+    /**
+     * No more items will be put in the queue.  Waiting put() and
+     * take() calls return.
+     */
+    void close()
+    {
+        n_u::Autolock autolock(_cond);
+        _closed = true;
+        _cond.broadcast();
+    }
+
+    /**
+     * Remove the items left in the queue, after it has been closed.
+     */
+    std::vector<T> clear()
+    {
+        n_u::Autolock autolock(_cond);
+        std::vector<T> items;
+        items.swap(_queue);
+        return items;
+    }
+
+private:
+    std::vector<T> _queue;
+
+    size_t _maxLength;
+
+    bool _closed;
+
+    bool _busy;
+
+    n_u::Cond _cond;
+
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+};
+
+
+/**
+ * A thread which reads and decodes the samples of one input, including
+ * any bzip2 decompression, into a bounded queue for the merge loop.
+ */
+class InputReader: public n_u::Thread
+{
+public:
+
+    InputReader(SampleInputStream* input, size_t maxQueueLength):
+        n_u::Thread(input->getName()),_input(input),
+        _queue(maxQueueLength),_names(),_taken(),_next(0),_lastName(0),
+        _eofx("", ""),_ioerror(0),_error(0)
+    {
+    }
+
+    ~InputReader()
+    {
+        for (size_t i = _next; i < _taken.size(); i++)
+            if (_taken[i].samp) _taken[i].samp->freeReference();
+        for (auto& item : _queue.clear())
+            if (item.samp) item.samp->freeReference();
+        delete _ioerror;
+        delete _error;
+    }
+
+    int run()
+    {
+        try {
+            for (;;) {
+                Sample* samp = _input->readSample();
+                std::string name = _input->getName();
+                if (_names.empty() || name != _names.back())
+                    _names.push_back(name);
+                if (!_queue.put(Item{samp, &_names.back()})) {
+                    samp->freeReference();
+                    break;
+                }
+            }
+        }
+        catch (const EOFException& e) {
+            _eofx = e;
+        }
+        catch (const IOException& e) {
+            _ioerror = new IOException(e);
+        }
+        catch (const n_u::Exception& e) {
+            _error = new n_u::Exception(e);
+        }
+        catch (const std::exception& e) {
+            _error = new n_u::Exception(getName(), e.what());
+        }
+        catch (...) {
+            _error = new n_u::Exception(getName(), "unknown exception");
+        }
+        // A null sample marks the end of the input, including when
+        // reading failed, so that readSample() doesn't wait forever.
+        _queue.put(Item{0, 0});
+        return RUN_OK;
+    }
+
+    void interrupt()
+    {
+        Thread::interrupt();
+        _queue.close();
+    }
+
+    /**
+     * Return the next sample of the input, and set @p name to the
+     * name of the file it was read from, if that has changed since
+     * the last call.
+     *
+     * @throws EOFException
+     * @throws IOException
+     * @throws n_u::Exception for other errors of the input.
+     */
+    Sample* readSample(std::string& name)
+    {
+        if (_next == _taken.size()) {
+            _taken.clear();
+            _next = 0;
+            _queue.done();
+            _queue.take(_taken);
+        }
+        if (_next == _taken.size() || !_taken[_next].samp) {
+            if (_ioerror) throw IOException(*_ioerror);
+            if (_error) throw n_u::Exception(*_error);
+            throw _eofx;
+        }
+        const Item& item = _taken[_next++];
+        if (item.name != _lastName) {
+            _lastName = item.name;
+            name = *item.name;
+        }
+        return item.samp;
+    }
+
+private:
+
+    struct Item
+    {
+        Sample* samp;
+        const std::string* name;
+    };
+
+    SampleInputStream* _input;
+
+    BoundedQueue<Item> _queue;
+
+    /**
+     * Names of the files read, referenced by the queued items.
+     */
+    std::list<std::string> _names;
+
+    /**
+     * Items taken from the queue by readSample().
+     */
+    std::vector<Item> _taken;
+
+    size_t _next;
+
+    const std::string* _lastName;
+
+    EOFException _eofx;
+
+    IOException* _ioerror;
+
+    n_u::Exception* _error;
+
+    InputReader(const InputReader&) = delete;
+    InputReader& operator=(const InputReader&) = delete;
+};
+
+
+/**
+ * A thread which writes merged samples to the output.
+ */
+class OutputWriter: public n_u::Thread
+{
+public:
+
+    OutputWriter(SampleOutputStream& output, size_t maxQueueLength):
+        n_u::Thread("OutputWriter"),_output(output),
+        _queue(maxQueueLength),_failed(false)
+    {
+    }
+
+    ~OutputWriter()
+    {
+        for (auto& samp : _queue.clear())
+            samp->freeReference();
+    }
+
+    /**
+     * Queue a sample for output, holding a reference to it.
+     */
+    void write(const Sample* samp)
+    {
+        samp->holdReference();
+        if (!_queue.put(samp)) samp->freeReference();
+    }
+
+    /**
+     * Wait until all queued samples have been written.
+     */
+    void drain()
+    {
+        _queue.drain();
+    }
+
+    /**
+     * Whether the output has failed.
+     */
+    bool failed() const
+    {
+        return _failed;
+    }
+
+    int run()
+    {
+        std::vector<const Sample*> samps;
+        while (_queue.take(samps)) {
+            for (auto& samp : samps) {
+                if (!_failed && !_output.receive(samp))
+                    _failed = true;
+                samp->freeReference();
+            }
+            samps.clear();
+            _queue.done();
+        }
+        return RUN_OK;
+    }
+
+    void interrupt()
+    {
+        Thread::interrupt();
+        _queue.close();
+    }
+
+private:
+
+    SampleOutputStream& _output;
+
+    BoundedQueue<const Sample*> _queue;
+
+    std::atomic<bool> _failed;
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+};
 
 
 struct InputStats
@@ -109,9 +432,13 @@ struct InputInfo
     // sum of stats over entire input
     InputStats total_stats{};
     bool eof{false};
+    // reads the stream on its own thread, with --parallel
+    InputReader* reader{nullptr};
+    // name of the stream when the last sample was read
+    std::string name{};
 
     InputInfo(SampleInputStream* sis):
-        stream(sis)
+        stream(sis), name(sis->getName())
     {
     }
 
@@ -150,8 +477,30 @@ private:
 
     void addInputStream(const list<string>& inputFiles);
 
+    /**
+     * Read the next sample of an input, from its InputReader if
+     * it has one.
+     */
+    Sample* readSample(InputInfo& input);
+
     dsm_time_t flushSorter(dsm_time_t tcur, SampleOutputStream& outStream);
 
+    /**
+     * With --parallel, wait for the OutputWriter to write all the
+     * samples passed to it, and throw IOException if it failed.
+     */
+    void drainOutput();
+
+    /**
+     * Stop and delete the InputReader and OutputWriter threads.
+     */
+    void stopThreads();
+
+    /**
+     * Print the rate of samples and bytes passed to the output.
+     */
+    void printThroughput();
+
     vector<list<string> > inputFileNames;
 
     string outputFileName;
@@ -166,6 +515,8 @@ private:
 
     int outputFileLength;
 
+    float indexInterval;
+
     SampleInputHeader header;
 
     string configName;
@@ -205,6 +556,16 @@ private:
 
     unsigned long ndropped;
 
+    OutputWriter* writer;
+
+    // samples and bytes passed to the output, for throughput reports
+    size_t nwritten;
+    long long nbyteswritten;
+    long long runStartTime;
+    long long lastFlushTime;
+    size_t lastFlushWritten;
+    long long lastFlushBytes;
+
     NidasApp _app;
 
     BadSampleFilterArg FilterArg;
@@ -219,6 +580,13 @@ sorter.  This should be an unusual requirement, since NIDAS normally enforces
 increasing sample times when the samples are read from a sensor, thus
 it is disabled by default.)"""
     };
+    NidasAppArg Parallel{
+        "--parallel", "",R"""(
+Read and decode each input, including any bzip2 decompression, on its
+own thread, and write the output on another thread, so that merging
+many inputs can use more than one processor.  The merged output is the
+same as without this option.)"""
+    };
 };
 
 bool
@@ -289,6 +657,10 @@ int NidsMerge::main(int argc, char** argv)
         cerr << ioe.what() << endl;
         return 1;
     }
+    catch (n_u::Exception& e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
     return 0;
 }
 
@@ -296,10 +668,13 @@ int NidsMerge::main(int argc, char** argv)
 NidsMerge::NidsMerge():
     inputFileNames(),outputFileName(),inputs(),
     readAheadUsecs(30*USECS_PER_SEC),startTime(UTime::MIN),
-    endTime(UTime::MAX), outputFileLength(0),header(),
+    endTime(UTime::MAX), outputFileLength(0),indexInterval(0),header(),
     configName(), allowed_dsms(),
     sorter(),
     ndropped(0),
+    writer(nullptr),
+    nwritten(0),nbyteswritten(0),runStartTime(0),lastFlushTime(0),
+    lastFlushWritten(0),lastFlushBytes(0),
     _app("nidsmerge"),
     FilterArg(),
     KeepOpening
@@ -362,6 +737,12 @@ int NidsMerge::parseRunstring(int argc, char** argv)
         ("-r,--readahead", "seconds",
          "How much time to read ahead and sort the input samples\n"
          "before outputting the sorted, merged samples.", "30");
+    NidasAppArg IndexInterval
+        ("--index", "seconds",
+         "Write a sample index file alongside each output file, with\n"
+         "an entry every <seconds> of data, so that later reads of the\n"
+         "output with a start time can skip directly to that time.\n"
+         "0 disables the index.", "0");
     NidasAppArg ConfigName
         ("-c,--config", "configname",
          "Set the config name for the output header.\n"
@@ -377,9 +758,11 @@ int NidsMerge::parseRunstring(int argc, char** argv)
                         app.LogParam | app.StartTime | app.EndTime |
                         app.OutputFiles | app.Clipping | KeepOpening |
                         FilterArg | InputFileSet | InputFileSetFile |
-                        ReadAhead | ConfigName | app.OutputFileLength |
+                        ReadAhead | IndexInterval |
+                        ConfigName | app.OutputFileLength |
                         app.SampleRanges | PrintHeader |
-                        ForceIncreasingTimes | app.Version | app.Help);
+                        ForceIncreasingTimes | app.MappedInput | Parallel |
+                        app.Version | app.Help);
     // -i conflicts with input specifiers, so require --samples
     app.SampleRanges.acceptShortFlag(false);
     app.InputFiles.allowFiles = true;
@@ -450,6 +833,7 @@ int NidsMerge::parseRunstring(int argc, char** argv)
         throw NidasAppException(xmsg.str());
     }
     readAheadUsecs = ReadAhead.asInt() * (long long)USECS_PER_SEC;
+    indexInterval = IndexInterval.asFloat();
     configName = ConfigName.getValue();
     startTime = app.getStartTime();
     endTime = app.getEndTime();
@@ -519,6 +903,15 @@ print_column(const header_t& h, const T& val)
 }
 
 
+inline std::string
+rate_format(double rate)
+{
+    std::ostringstream ost;
+    ost << fixed << setprecision(2) << rate;
+    return ost.str();
+}
+
+
 void print_headers(std::ostream& out, const vector<header_t>& headers)
 {
     for (auto& h : headers)
@@ -582,21 +975,37 @@ NidsMerge::flushSorter(dsm_time_t tcur,
         const Sample *sample = *si;
         if (!endTime.isSet() || (sample->getTimeTag() < endTime.toUsecs()))
         {
-            bool ok = outStream.receive(sample);
-            if (!ok)
+            if (writer)
+                writer->write(sample);
+            else if (!outStream.receive(sample))
                 throw IOException("send sample",
                     "Send failed, output disconnected.");
             noutput++;
+            nbyteswritten += sample->getHeaderLength() +
+                sample->getDataByteLength();
             last_written = sample->getTimeTag();
         }
     }
+    nwritten += noutput;
+    if (writer && writer->failed())
+        throw IOException("send sample", "Send failed, output disconnected.");
     size_t nremoved = remove_samples(sorter, rsb, rsi);
     size_t after = sorter.size();
     size_t before = after + nremoved;
 
+    // output rates since the last flush
+    long long tnow = n_u::getSystemTime();
+    double dt = std::max(tnow - lastFlushTime, 1LL) / (double)USECS_PER_SEC;
+    double srate = (nwritten - lastFlushWritten) / dt;
+    double mbrate = (nbyteswritten - lastFlushBytes) / dt / 1.e6;
+    lastFlushTime = tnow;
+    lastFlushWritten = nwritten;
+    lastFlushBytes = nbyteswritten;
+
     static vector<header_t> headers = {
         {"flush output end time", 30},
-        {"before", 8}, {"after", 8}, {"output", 8}, {"removed", 8}
+        {"before", 8}, {"after", 8}, {"output", 8}, {"removed", 8},
+        {"samp/s", 9}, {"MB/s", 7}
     };
     print_headers(cout, headers);
     print_column(headers[0], tformat(tcur));
@@ -604,10 +1013,74 @@ NidsMerge::flushSorter(dsm_time_t tcur,
     print_column(headers[2], after);
     print_column(headers[3], noutput);
     print_column(headers[4], nremoved);
+    print_column(headers[5], (long long)srate);
+    print_column(headers[6], rate_format(mbrate));
     cout << endl;
     return last_written;
 }
 
+Sample*
+NidsMerge::readSample(InputInfo& input)
+{
+    if (input.reader)
+        return input.reader->readSample(input.name);
+    Sample* samp = input.stream->readSample();
+    input.name = input.stream->getName();
+    return samp;
+}
+
+
+void
+NidsMerge::drainOutput()
+{
+    if (!writer)
+        return;
+    writer->drain();
+    if (writer->failed())
+        throw IOException("send sample", "Send failed, output disconnected.");
+}
+
+
+template <typename T>
+void
+stop_thread(T*& thread)
+{
+    if (!thread)
+        return;
+    thread->interrupt();
+    try {
+        thread->join();
+    }
+    catch (const n_u::Exception& e) {
+        WLOG(("%s: %s", thread->getName().c_str(), e.what()));
+    }
+    delete thread;
+    thread = nullptr;
+}
+
+
+void
+NidsMerge::stopThreads()
+{
+    stop_thread(writer);
+    for (auto& input : inputs)
+        stop_thread(input.reader);
+}
+
+
+void
+NidsMerge::printThroughput()
+{
+    long long tnow = n_u::getSystemTime();
+    double dt = std::max(tnow - runStartTime, 1LL) / (double)USECS_PER_SEC;
+    cout << "Wrote " << nwritten << " samples, "
+         << rate_format(nbyteswritten / 1.e6) << " MB in "
+         << rate_format(dt) << " seconds: "
+         << (long long)(nwritten / dt) << " samples/s, "
+         << rate_format(nbyteswritten / dt / 1.e6) << " MB/s" << endl;
+}
+
+
 void
 NidsMerge::addInputStream(const list<string>& inputFiles)
 {
@@ -636,6 +1109,7 @@ NidsMerge::addInputStream(const list<string>& inputFiles)
     // SampleInputStream owns the iochan ptr.
     SampleInputStream* input = new SampleInputStream(fset);
     inputs.push_back(InputInfo(input));
+    if (_app.MappedInput.asBool()) input->setMappedInput(true);
 
     // Set the input stream filter in case other options were set
     // from the command-line that do not filter samples, like
@@ -646,6 +1120,7 @@ NidsMerge::addInputStream(const list<string>& inputFiles)
 
     try {
         input->readInputHeader();
+        inputs.back().name = input->getName();
         // save header for later writing to output
         header = input->getInputHeader();
     }
@@ -706,18 +1181,18 @@ duplicateSample(const Sample* samp)
 
 struct OSample
 {
-    SampleInputStream* input;
-    Sample* samp;
+    const std::string& name;
+    const Sample* samp;
 
-    OSample(SampleInputStream* sis, Sample* s):
-        input(sis), samp(s)
+    OSample(const std::string& n, const Sample* s):
+        name(n), samp(s)
     {
     }
 };
 
 ostream& operator<<(ostream& os, const OSample& osamp)
 {
-    os << "[" << osamp.input->getName() << ": "
+    os << "[" << osamp.name << ": "
        << "tt=" << tformat(osamp.samp->getTimeTag())
        << " (" << osamp.samp->getDSMId()
        << "," << osamp.samp->getSpSId() << ")]";
@@ -748,7 +1223,7 @@ NidsMerge::printStats(dsm_time_t tcur, bool totals)
         print_column(headers[2], stats.nunique);
         print_column(headers[3], stats.nnonincr);
         print_column(headers[4], stats.nnonincr_free);
-        print_column(headers[5], input.stream->getName());
+        print_column(headers[5], input.name);
         cout << endl;
     }
 }
@@ -761,12 +1236,39 @@ int NidsMerge::run()
 
     SampleOutputStream outStream(outSet);
     outStream.setHeaderSource(this);
+    outStream.setIndexInterval(indexInterval);
 
     for (unsigned int ii = 0; ii < inputFileNames.size(); ii++)
     {
         addInputStream(inputFileNames[ii]);
     }
 
+    // Stop the threads before outStream is destroyed, on any return
+    // or exception.
+    struct ThreadStopper
+    {
+        NidsMerge& merge;
+        ~ThreadStopper() { merge.stopThreads(); }
+    } stopper{*this};
+
+    if (Parallel.asBool())
+    {
+        // Maximum number of samples queued by each thread.  The merge
+        // loop reads each input a readahead window at a time, so
+        // this only needs to keep the input threads busy meanwhile.
+        const size_t queueLength = 10000;
+        for (auto& input : inputs)
+        {
+            if (input.eof)
+                continue;
+            input.reader = new InputReader(input.stream, queueLength);
+            input.reader->start();
+        }
+        writer = new OutputWriter(outStream, queueLength);
+        writer->start();
+    }
+    runStartTime = lastFlushTime = n_u::getSystemTime();
+
     SampleMatcher& matcher = _app.sampleMatcher();
 
     // samples with non-increasing time tags
@@ -811,14 +1313,14 @@ int NidsMerge::run()
             InputStats& stats = inputs[ii].window_stats;
             stats = InputStats(); // reset window stats
 
-            DLOG(("") << "filling input " << input->getName()
+            DLOG(("") << "filling input " << inputs[ii].name
                       << " up to filltime " << tformat(filltime)
                       << ", lastTime=" << tformat(lastTime));
             while (lastTime < filltime && !_app.interrupted())
             {
                 Sample* samp{ nullptr };
                 try {
-                    samp = input->readSample();
+                    samp = readSample(inputs[ii]);
                 }
                 catch (const EOFException& e) {
                     cerr << e.what() << endl;
@@ -831,7 +1333,7 @@ int NidsMerge::run()
                 // stream, so the filename matching does not need to be
                 // done each time since it shouldn't change within the
                 // same input stream...
-                if (!matcher.match(samp, input->getName()))
+                if (!matcher.match(samp, inputs[ii].name))
                 {
                     samp->freeReference();
                     continue;
@@ -855,7 +1357,7 @@ int NidsMerge::run()
                     DLOG(("dropping sample ") << ndropped
                             << " precedes start "
                             << tformat(startTime.toUsecs()) << ": "
-                            << OSample(input, samp));
+                            << OSample(inputs[ii].name, samp));
                     samp->freeReference();
                     continue;
                 }
@@ -873,7 +1375,8 @@ int NidsMerge::run()
                     && lastTime <= lastSampleTime)
                 {
                     stats.nnonincr++;
-                    VLOG(("non-increasing sample: ") << OSample(input, samp)
+                    VLOG(("non-increasing sample: ")
+                         << OSample(inputs[ii].name, samp)
                          << ", nnonincr=" << stats.nnonincr);
 
                     if (forceIncreasingTimes)
@@ -903,7 +1406,7 @@ int NidsMerge::run()
                         {
                             duplog.log()
                                 << "found dup sample in non-increasing set, discarding: "
-                                << OSample(input, samp)
+                                << OSample(inputs[ii].name, samp)
                                 << ", nnonincr=" << nonincr.size();
                         }
                         samp->freeReference();
@@ -927,7 +1430,8 @@ int NidsMerge::run()
                     {
                         duplog.log()
                             << (time_shifted ? "time-shifted " : "")
-                            << "duplicate sample: " << OSample(input, samp);
+                            << "duplicate sample: "
+                            << OSample(inputs[ii].name, samp);
                     }
                 }
                 else
@@ -975,6 +1479,9 @@ int NidsMerge::run()
         dsm_time_t last_written = flushSorter(UTime::MAX.toUsecs(), outStream);
         printStats(last_written, true);
     }
+    drainOutput();
+    stopThreads();
+    printThroughput();
     outStream.flush();
     outStream.close();
     clearNonIncr(nonincr);
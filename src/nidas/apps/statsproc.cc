@@ -131,6 +131,7 @@ private:
     NidasAppArg DaemonMode;
     NidasAppArg SetDSM;
     NidasAppArg DSMName;
+    NidasAppArg Threads;
     BadSampleFilterArg FilterArg;
 };
 
@@ -194,6 +195,12 @@ StatsProcess::StatsProcess():
     ("-d,--dsmname", "<dsmname>",
      "Look for a <fileset> belonging to the given dsm to "
      "determine input file names."),
+    Threads
+    ("--threads", "<nthreads>",
+     "Compute the statistics on nthreads threads, each running a\n"
+     "share of the StatisticsCrunchers.  The output samples are\n"
+     "merged back into time order before they are written.\n"
+     "0 computes all statistics on the input thread.", "0"),
     FilterArg()
 {
 }
@@ -235,9 +242,9 @@ int StatsProcess::parseRunstring(int argc, char** argv)
     app.enableArguments(app.DatasetName | app.Hostname |
                         app.StartTime | app.EndTime | app.XmlHeaderFile |
                         app.InputFiles | Period | app.SorterLength |
-                        app.Clipping |
+                        app.Clipping | app.MappedInput |
                         NiceValue | DaemonMode | SetDSM | DSMName |
-                        FilterArg |
+                        Threads | FilterArg |
                         app.loggingArgs() | app.Version | app.Help);
     app.StartTime.setFlags("-B,--start");
     app.EndTime.setFlags("-E,--end");
@@ -266,6 +273,11 @@ int StatsProcess::parseRunstring(int argc, char** argv)
     {
         throw NidasAppException("Invalid period: " + Period.getValue());
     }
+    if (Threads.asInt() < 0)
+    {
+        throw NidasAppException("Invalid number of threads: " +
+                                Threads.getValue());
+    }
 
     extern char *optarg;       /* set by getopt() */
     extern int optind;       /* "  "     "     */
@@ -556,6 +568,9 @@ int StatsProcess::run() throw()
         }
 
         RawSampleInputStream sis(iochan.release());
+        if (_app.MappedInput.asBool()) sis.setMappedInput(true);
+        sis.setKeepStats(true);
+        long long runStartTime = n_u::getSystemTime();
         BadSampleFilter& bsf = FilterArg.getFilter();
         bsf.setDefaultTimeRange(_startTime, _endTime);
         sis.setBadSampleFilter(bsf);
@@ -628,6 +643,7 @@ int StatsProcess::run() throw()
         }
 
         sproc->setFillGaps(getFillGaps());
+        sproc->setProcessThreads(Threads.asInt());
 
         if (_selectedOutputSampleIds.size() > 0)
             sproc->selectRequestedSampleTags(_selectedOutputSampleIds);
@@ -668,6 +684,7 @@ int StatsProcess::run() throw()
                 }
             }
 
+            runStartTime = n_u::getSystemTime();
             DLOG(("entering readSamples loop..."));
             for (;;) {
                 if (_app.interrupted()) break;
@@ -691,6 +708,16 @@ int StatsProcess::run() throw()
         pipeline.interrupt();
         pipeline.join();
         sproc->disconnectSource(&pipeline);
+
+        double dt = std::max(n_u::getSystemTime() - runStartTime, 1LL) /
+            (double)USECS_PER_SEC;
+        const SampleStats& stats = sis.getSampleStats();
+        ILOG(("") << "Read " << stats.getNumSamples() << " samples, "
+             << setprecision(3) << stats.getNumBytes() / 1.e6 << " MB in "
+             << dt << " seconds: "
+             << (long long)(stats.getNumSamples() / dt) << " samples/s, "
+             << stats.getNumBytes() / dt / 1.e6 << " MB/s, "
+             << sproc->getProcessThreads() << " threads");
     }
     catch (n_u::Exception& e) {
         // caution, don't use PLOG((e.what())), because e.what() may
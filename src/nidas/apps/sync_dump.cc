@@ -93,13 +93,19 @@ private:
     string _dumpHeader;
 
     string _dumpJSON;
+
+    bool _columns;
+
+    bool _float32;
 };
 
 SyncDumper::SyncDumper(): _dataFileName(),_sockAddr(),
 			  _varnames(),
 			  _vars(),
 			  _dumpHeader(),
-			  _dumpJSON()
+			  _dumpJSON(),
+			  _columns(false),
+			  _float32(false)
 {
 }
 
@@ -109,8 +115,15 @@ int SyncDumper::parseRunstring(int argc, char** argv)
     extern int optind;       /* "  "     "     */
     int opt_char;     /* option character */
 
-    while ((opt_char = getopt(argc, argv, "h:j:")) != -1) {
+    while ((opt_char = getopt(argc, argv, "cfh:j:")) != -1) {
 	switch (opt_char) {
+	case 'c':
+	    _columns = true;
+	    break;
+	case 'f':
+	    _columns = true;
+	    _float32 = true;
+	    break;
 	case 'h':
 	    _dumpHeader = string(optarg);
 	    break;
@@ -168,8 +181,11 @@ int SyncDumper::parseRunstring(int argc, char** argv)
 int SyncDumper::usage(const char* argv0)
 {
     cerr << "\
-Usage: " << argv0 << " [-h <file>] [-j <file>] [<variable> ...] inputURL\n\
+Usage: " << argv0 << " [-c] [-f] [-h <file>] [-j <file>] [<variable> ...] inputURL\n\
     <variable>: A variable name.  If none specified, then all variables.\n\
+    -c         Subscribe to binary columns of just the listed variables from\n\
+               a sync_server run with --subscribe.  Socket inputs only.\n\
+    -f         Like -c, with the values sent as float32.\n\
     -h <file>  Print the header to <file>, where <file> can be - for stdout.\n\
     -j <file>  Dump all sync samples as JSON to the given <file>.\n\
     inputURL: data input (required). One of the following:\n\
@@ -248,8 +264,19 @@ int SyncDumper::run()
 	iochan = new nidas::core::Socket(sock);
     }
 
+    if (_columns && _dataFileName.length() > 0) {
+        cerr << "-c and -f require a socket input" << endl;
+        delete iochan;
+        return 1;
+    }
+
     // SyncRecordReader owns the iochan
-    SyncRecordReader reader(iochan);
+    n_u::auto_ptr<SyncRecordReader> readerp;
+    if (_columns)
+        readerp.reset(new SyncRecordReader(iochan, _varnames, _float32));
+    else
+        readerp.reset(new SyncRecordReader(iochan));
+    SyncRecordReader& reader = *readerp;
     ofstream json;
 
     if (_dumpHeader == "-")
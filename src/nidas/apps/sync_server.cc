@@ -58,6 +58,14 @@ int usage(const std::string& argv0)
         " -p <port>\n"
         "   sync record output socket port number: default="
                   << SyncServer::DEFAULT_PORT << "\n"
+        " --columns <var>[,<var>...]|all\n"
+        "   send columnar binary blocks of the listed variables instead of\n"
+        "   full sync records\n"
+        " --float32\n"
+        "   with --columns, send the values as float32 instead of float64\n"
+        " --subscribe\n"
+        "   read the columns to send from a subscription line written by\n"
+        "   the client after it connects, as with sync_dump -c\n"
         " <raw_data_file> ...\n"
         "   names of one or more raw data files, separated by spaces\n"
                   << std::endl;
@@ -80,6 +88,9 @@ int parseRunstring(SyncServer& sync, ArgVector& args)
     args = app.parseArgs(args);
 
     std::list<std::string> dataFileNames;
+    std::vector<std::string> columns;
+    bool columnar = false;
+    bool float32 = false;
 
     unsigned int i = 1;
     while (i < args.size())
@@ -120,6 +131,26 @@ int parseRunstring(SyncServer& sync, ArgVector& args)
                 sync.resetAddress(new n_u::Inet4SocketAddress(port));
             ++i;
         }
+        else if (arg == "--columns" && !optarg.empty())
+        {
+            columnar = true;
+            if (optarg != "all")
+            {
+                std::istringstream ist(optarg);
+                std::string name;
+                while (std::getline(ist, name, ','))
+                    if (!name.empty()) columns.push_back(name);
+            }
+            ++i;
+        }
+        else if (arg == "--float32")
+        {
+            float32 = true;
+        }
+        else if (arg == "--subscribe")
+        {
+            sync.setSubscribe(true);
+        }
         else if (arg[0] == '-')
         {
 	    return usage(args[0]);
@@ -136,6 +167,8 @@ int parseRunstring(SyncServer& sync, ArgVector& args)
     if (dataFileNames.size() == 0)
         return usage(args[0]);
     sync.setDataFileNames(dataFileNames);
+    if (columnar)
+        sync.setColumns(columns, float32);
     return 0;
 }
 
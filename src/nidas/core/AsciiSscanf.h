@@ -42,6 +42,7 @@
 
 
 #include "Sample.h"
+#include "CompiledSscanf.h"
 #include <nidas/util/ParseException.h>
 
 #include <vector>
@@ -106,6 +107,22 @@ public:
 
     int getNumberOfFields() const { return _fields.size(); }
 
+    /**
+     * Whether sscanf() uses a compiled form of the format,
+     * see CompiledSscanf, instead of calling ::sscanf with the format.
+     * The results are the same.  Default: true. A format which
+     * cannot be compiled is always passed to ::sscanf.
+     */
+    void setCompiledScan(bool val) { _useCompiled = val; }
+
+    /**
+     * Whether sscanf() is using a compiled format.
+     */
+    bool isCompiledScan() const
+    {
+        return _useCompiled && _compiled.isCompiled();
+    }
+
     /**
      * Maximum number of fields that we can scan.
      */
@@ -178,6 +195,10 @@ private:
 
     AsciiSscanfAdapter* _lexer;
 
+    CompiledSscanf _compiled;
+
+    bool _useCompiled;
+
     /** No copying */
     AsciiSscanf(const AsciiSscanf& );
 
@@ -153,7 +153,7 @@ AsciiSscanf::AsciiSscanf():
 	MAX_OUTPUT_VALUES(130),_format(),_charfmt(0),
         _lexpos(0),_currentField(0),_fields(),_allFloats(true),
         _databuf0(0),_bufptrs(new char*[MAX_OUTPUT_VALUES]),
-	_sampleTag(0), _lexer(0)
+	_sampleTag(0), _lexer(0), _compiled(), _useCompiled(true)
 {
     for (int i = 0; i < MAX_OUTPUT_VALUES; i++)
     	_bufptrs[i] = 0;
@@ -289,6 +289,12 @@ void AsciiSscanf::setFormat(const std::string& val)
     // It should never be dereferenced, but valgrind complains
     for ( ; nfields < MAX_OUTPUT_VALUES; nfields++)
     	_bufptrs[nfields] = _bufptrs[nfields-1];
+
+    // The lexer above skips things it does not recognize, which ::sscanf
+    // may still convert.  Only use the compiled format if it agrees.
+    if (_compiled.compile(_format) &&
+        _compiled.getNumberOfFields() != (int)_fields.size())
+        _compiled = CompiledSscanf();
 }
 
 int AsciiSscanf::sscanf(const char* input, float* output, int nout) throw()
@@ -303,6 +309,9 @@ int AsciiSscanf::sscanf(const char* input, float* output, int nout) throw()
     // asserts with #define NDEBUG.
     assert(nout <= MAX_OUTPUT_VALUES);
 
+    if (_useCompiled && _compiled.isCompiled())
+        return _compiled.scan(input, output, nout);
+
     /*
      * The following sscanf parses up to 70 values.  If one wants
      * to increase MAX_OUTPUT_VALUES, then one must add more
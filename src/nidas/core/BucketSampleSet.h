@@ -0,0 +1,267 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+#ifndef NIDAS_CORE_BUCKETSAMPLESET_H
+#define NIDAS_CORE_BUCKETSAMPLESET_H
+
+#include "SortedSampleSet.h"
+
+#include <algorithm>
+#include <cassert>
+#include <map>
+#include <vector>
+
+namespace nidas { namespace core {
+
+/**
+ * A container of samples sorted by time, which keeps samples in
+ * buckets of a fixed time width rather than in a tree.  A sample is
+ * appended to the vector of its bucket, and a bucket is only sorted
+ * when samples are taken out of it, or when a late sample is looked
+ * up by position.  Since most samples arrive in time order, a bucket
+ * usually stays sorted as samples are appended, and no sort is needed.
+ *
+ * Unlike a std::multiset, there is no node allocation for each sample.
+ * Bucket vectors are recycled once emptied.
+ *
+ * The order of samples taken out of the set is the same as the order
+ * of a std::multiset<const Sample*, Compare> into which the samples
+ * were inserted at end(): the order defined by Compare, and insertion
+ * order for samples which compare equal.  Compare must order samples
+ * first by time tag, as do SampleTimetagComparator,
+ * SampleHeaderComparator and FullSampleComparator.  Unlike the
+ * std::set of SortedSampleSet2 and SortedSampleSet3, samples which
+ * compare equal are all kept.
+ */
+template <typename Compare = SampleTimetagComparator>
+class BucketSampleSet
+{
+public:
+
+    /**
+     * @param bucketUsec Time width of each bucket, in microseconds.
+     */
+    BucketSampleSet(long long bucketUsec = USECS_PER_MSEC * 10):
+        _bucketUsec(std::max(bucketUsec, 1LL)),_buckets(),_spares(),
+        _size(0),_latest(0),_lastIdx(0),_lastBucket(0),_comp()
+    {}
+
+    /**
+     * Change the bucket width.  The set must be empty.
+     */
+    void setBucketUsec(long long val)
+    {
+        assert(_size == 0);
+        _bucketUsec = std::max(val, 1LL);
+    }
+
+    long long getBucketUsec() const { return _bucketUsec; }
+
+    size_t size() const { return _size; }
+
+    bool empty() const { return _size == 0; }
+
+    void insert(const Sample* samp)
+    {
+        Bucket& bucket = getBucket(bucketIndex(samp->getTimeTag()));
+        if (bucket._sorted && bucket._samples.size() > bucket._head &&
+            _comp(samp, bucket._samples.back()))
+            bucket._sorted = false;
+        bucket._samples.push_back(samp);
+        _size++;
+        if (!_latest || !_comp(samp, _latest)) _latest = samp;
+    }
+
+    /**
+     * The last sample in sorted order, or null if the set is empty.
+     */
+    const Sample* latest() const { return _latest; }
+
+    /**
+     * The sample n positions before the last sample in sorted order,
+     * where nthLatest(0) is latest().  n must be less than size().
+     */
+    const Sample* nthLatest(size_t n)
+    {
+        assert(n < _size);
+        typename std::map<long long, Bucket>::reverse_iterator bi =
+            _buckets.rbegin();
+        for ( ; ; ++bi) {
+            Bucket& bucket = bi->second;
+            size_t nb = bucket._samples.size() - bucket._head;
+            if (n < nb) {
+                sortBucket(bucket);
+                return bucket._samples[bucket._samples.size() - 1 - n];
+            }
+            n -= nb;
+        }
+    }
+
+    /**
+     * Remove all samples whose time tags are less than tt, appending
+     * them in sorted order to result.
+     */
+    void extractBefore(dsm_time_t tt, std::vector<const Sample*>& result)
+    {
+        long long last = bucketIndex(tt);
+        typename std::map<long long, Bucket>::iterator bi = _buckets.begin();
+        for ( ; bi != _buckets.end() && bi->first <= last; ) {
+            Bucket& bucket = bi->second;
+            sortBucket(bucket);
+            std::vector<const Sample*>& samps = bucket._samples;
+            size_t i = bucket._head;
+            if (bi->first < last) i = samps.size();
+            else {
+                for ( ; i < samps.size() && samps[i]->getTimeTag() < tt; ++i);
+            }
+            result.insert(result.end(), samps.begin() + bucket._head,
+                samps.begin() + i);
+            _size -= i - bucket._head;
+            bucket._head = i;
+            if (bucket._head < samps.size()) break;
+            recycle(bucket);
+            if (&bucket == _lastBucket) _lastBucket = 0;
+            _buckets.erase(bi++);
+        }
+        if (_size == 0) _latest = 0;
+    }
+
+    /**
+     * Remove all samples, appending them in sorted order to result.
+     */
+    void extractAll(std::vector<const Sample*>& result)
+    {
+        typename std::map<long long, Bucket>::iterator bi = _buckets.begin();
+        for ( ; bi != _buckets.end(); ++bi) {
+            Bucket& bucket = bi->second;
+            sortBucket(bucket);
+            result.insert(result.end(),
+                bucket._samples.begin() + bucket._head,
+                bucket._samples.end());
+            recycle(bucket);
+        }
+        _buckets.clear();
+        _lastBucket = 0;
+        _size = 0;
+        _latest = 0;
+    }
+
+private:
+
+    struct Bucket
+    {
+        Bucket(): _samples(),_head(0),_sorted(true) {}
+
+        /**
+         * Samples in the order received, unless _sorted.
+         */
+        std::vector<const Sample*> _samples;
+
+        /**
+         * Index of the first sample not yet taken out of the bucket.
+         * Samples are only taken out of a sorted bucket, so those
+         * before _head were the earliest.
+         */
+        size_t _head;
+
+        bool _sorted;
+    };
+
+    long long bucketIndex(dsm_time_t tt) const
+    {
+        long long idx = tt / _bucketUsec;
+        if (tt < 0 && idx * _bucketUsec != tt) idx--;
+        return idx;
+    }
+
+    Bucket& getBucket(long long idx)
+    {
+        // Most samples go into the same bucket as the previous one.
+        if (_lastBucket && idx == _lastIdx) return *_lastBucket;
+        typename std::map<long long, Bucket>::iterator bi =
+            _buckets.lower_bound(idx);
+        if (bi == _buckets.end() || bi->first != idx) {
+            bi = _buckets.insert(bi, std::make_pair(idx, Bucket()));
+            if (!_spares.empty()) {
+                bi->second._samples.swap(_spares.back());
+                _spares.pop_back();
+            }
+        }
+        _lastIdx = idx;
+        _lastBucket = &bi->second;
+        return bi->second;
+    }
+
+    void sortBucket(Bucket& bucket)
+    {
+        if (bucket._sorted) return;
+        // stable, so that equal samples stay in insertion order.
+        std::stable_sort(bucket._samples.begin() + bucket._head,
+            bucket._samples.end(), _comp);
+        bucket._sorted = true;
+    }
+
+    /**
+     * Save the vector of an emptied bucket for re-use.
+     */
+    void recycle(Bucket& bucket)
+    {
+        bucket._samples.clear();
+        _spares.push_back(std::vector<const Sample*>());
+        _spares.back().swap(bucket._samples);
+    }
+
+    long long _bucketUsec;
+
+    std::map<long long, Bucket> _buckets;
+
+    /**
+     * Emptied bucket vectors, kept to avoid re-allocating them.
+     */
+    std::vector<std::vector<const Sample*> > _spares;
+
+    size_t _size;
+
+    const Sample* _latest;
+
+    /**
+     * Index and pointer of the bucket of the last insert.
+     */
+    long long _lastIdx;
+
+    Bucket* _lastBucket;
+
+    Compare _comp;
+
+    /** No copying. */
+    BucketSampleSet(const BucketSampleSet&) = delete;
+
+    /** No assignment. */
+    BucketSampleSet& operator=(const BucketSampleSet&) = delete;
+};
+
+}}	// namespace nidas namespace core
+
+#endif
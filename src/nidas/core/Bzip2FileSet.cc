@@ -28,6 +28,10 @@
 
 #ifdef HAVE_BZLIB_H
 
+#include <nidas/util/InvalidParameterException.h>
+
+#include <sstream>
+
 using namespace nidas::core;
 using namespace std;
 
@@ -58,8 +62,20 @@ void Bzip2FileSet::fromDOMElement(const xercesc::DOMElement* node)
             XDOMAttr attr((xercesc::DOMAttr*) pAttributes->item(i));
             // get attribute name
             const std::string& aname = attr.getName();
-            // const std::string& aval = attr.getValue();
-	    if (aname == "compress") {} // nothing yet
+            const std::string& aval = attr.getValue();
+	    if (aname == "threads" || aname == "level") {
+		istringstream ist(aval);
+		int val;
+		ist >> val;
+		if (ist.fail() || val < 0)
+		    throw n_u::InvalidParameterException(getName(),
+			aname, aval);
+		if (aname == "threads") {
+		    getBzip2FileSet()->setCompressThreads(val);
+		    getBzip2FileSet()->setUncompressThreads(val);
+		}
+		else getBzip2FileSet()->setBlockSize100k(val);
+	    }
 	}
     }
 }
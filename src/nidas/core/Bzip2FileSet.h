@@ -38,6 +38,11 @@ namespace nidas { namespace core {
 
 /**
  * A FileSet that support bzip2 compression/uncompression.
+ * Attributes of the \<fileset\> element:
+ * - threads: number of threads compressing output files in
+ *   blocks, or uncompressing input files, see
+ *   nidas::util::Bzip2FileSet::setCompressThreads().
+ * - level: bzip2 block size, 1-9, in units of 100 Kbytes.
  */
 class Bzip2FileSet: public FileSet {
 
@@ -66,6 +71,12 @@ protected:
     Bzip2FileSet(const Bzip2FileSet& x);
 
 private:
+
+    nidas::util::Bzip2FileSet* getBzip2FileSet()
+    {
+        return static_cast<nidas::util::Bzip2FileSet*>(_fset);
+    }
+
     /**
      * No assignment.
      */
@@ -35,6 +35,7 @@
 
 #include <sys/stat.h>
 
+#include <algorithm>
 #include <iomanip>
 
 using namespace nidas::core;
@@ -49,6 +50,12 @@ vector<string> CalFile::_allPaths;
 /* static */
 n_u::Mutex CalFile::_staticMutex;
 
+/* static */
+map<string, CalFile::CacheEntry> CalFile::_tableCache;
+
+/* static */
+n_u::Mutex CalFile::_cacheMutex;
+
 /* static */
 int CalFile::_reUsers = 0;
 
@@ -120,7 +127,7 @@ CalFile::CalFile():
     _includeTime(UTime::MIN),
     _timeAfterInclude(UTime::MIN),
     _timeFromInclude(UTime::MIN),
-    _include(0),_sensor(0),_mutex()
+    _include(0),_sensor(0),_table(),_next(0),_mutex()
 {
     _curline[0] = '\0';
     setTimeZone("GMT");
@@ -142,7 +149,7 @@ CalFile::CalFile(const CalFile& x): DOMable(),
     _timeAfterInclude(UTime::MIN),
     _timeFromInclude(UTime::MIN),
     _include(0),
-    _sensor(x._sensor),_mutex()
+    _sensor(x._sensor),_table(),_next(0),_mutex()
 {
     _curline[0] = '\0';
     setTimeZone(x.getTimeZone());
@@ -164,6 +171,7 @@ CalFile& CalFile::operator=(const CalFile& rhs)
         _nline = 0;
         _include = 0;
         _sensor = rhs._sensor;
+        _next = 0;
         setTimeZone(rhs.getTimeZone());
     }
     return *this;
@@ -270,7 +278,7 @@ void CalFile::setDateTimeFormat(const std::string& val)
 
 void CalFile::open()
 {
-    if (_fin.is_open()) _fin.close();
+    _table.reset();
 
     for (string::size_type ic = 0;;) {
 
@@ -292,16 +300,164 @@ void CalFile::open()
         ic = nc + 1;
     }
 
-    _fin.open(_currentFileName.c_str());
-    if (_fin.fail())
-        throw n_u::IOException(getPath() + ' ' + getFile(), "open", errno);
+    TimeSettings settings;
+    settings.timeZone = _timeZone;
+    settings.dateTimeFormat = _dateTimeFormat;
+    _table = getTable(_currentFileName, settings);
     ILOG(("CalFile: ") << _currentFileName);
     _eofState = false;
-    _curline[0] = '\0';
-    _curpos = 0;
+    _next = 0;
     _nextTime = UTime::MIN;
 }
 
+/* static */
+shared_ptr<const CalFile::Table>
+CalFile::getTable(const string& fileName, const TimeSettings& settings)
+{
+    struct stat filestat;
+    if (::stat(fileName.c_str(), &filestat) < 0)
+        throw n_u::IOException(fileName, "stat", errno);
+
+    string key = fileName + '\n' + settings.timeZone + '\n' +
+        settings.dateTimeFormat;
+    long long mtime = filestat.st_mtim.tv_sec * 1000000000LL +
+        filestat.st_mtim.tv_nsec;
+
+    n_u::Synchronized autoLock(_cacheMutex);
+    map<string, CacheEntry>::iterator ci = _tableCache.find(key);
+    if (ci != _tableCache.end()) {
+        const CacheEntry& entry = ci->second;
+        if (entry.device == filestat.st_dev &&
+            entry.inode == filestat.st_ino &&
+            entry.size == filestat.st_size && entry.mtime == mtime)
+            return entry.table;
+        ILOG(("CalFile: ") << fileName << " has changed, parsing it again");
+    }
+
+    CacheEntry entry;
+    entry.table = parseFile(fileName, settings);
+    entry.device = filestat.st_dev;
+    entry.inode = filestat.st_ino;
+    entry.size = filestat.st_size;
+    entry.mtime = mtime;
+    _tableCache[key] = entry;
+    return entry.table;
+}
+
+/* static */
+shared_ptr<const CalFile::Table>
+CalFile::parseFile(const string& fileName, const TimeSettings& settings)
+{
+    CalFile parser;
+    parser._currentFileName = fileName;
+    parser.setTimeSettings(settings);
+
+    parser._fin.open(fileName.c_str());
+    if (parser._fin.fail())
+        throw n_u::IOException(fileName, "open", errno);
+
+    shared_ptr<Table> table(new Table());
+    table->settings.push_back(settings);
+    TimeSettings current;
+
+    try {
+        for (;;) {
+            parser.readLine();
+
+            // readLine() applies any dateFormat and timeZone comments
+            current.timeZone = parser._timeZone;
+            current.dateTimeFormat = parser._dateTimeFormat;
+            if (!(current == table->settings.back()))
+                table->settings.push_back(current);
+
+            if (parser.eof()) break;
+
+            Record rec;
+            rec.nline = parser._nline;
+            rec.settings = table->settings.size() - 1;
+            rec.time = parser.parseTime();
+
+            // Everything past the time is taken as a calibration field.
+            // The original code parsed numbers first, so a field with
+            // "123.456#" would have been parsed as a coefficient followed
+            // by a comment, therefore it is not enough to first tokenize
+            // the record as space-separated strings.  Instead, first strip
+            // any comment characters and anything following.
+            char* text = parser._curline + parser._curpos;
+            char* pound = strchr(text, '#');
+            if (pound)
+                *pound = '\0';
+
+            if (!matchInclude(text, rec.include))
+            {
+                istringstream fin(text);
+                std::string field;
+                while (fin >> field)
+                    rec.fields.push_back(field);
+            }
+
+            if (!table->records.empty() &&
+                rec.time < table->records.back().time)
+                table->sorted = false;
+            table->records.push_back(rec);
+        }
+    }
+    catch (const n_u::ParseException& e) {
+        table->parseError.reset(new n_u::ParseException(e));
+    }
+    catch (const n_u::IOException& e) {
+        table->ioError.reset(new n_u::IOException(e));
+    }
+    table->nlines = parser._nline;
+
+    DLOG(("CalFile: parsed ") << fileName << ", " << table->records.size()
+         << " records");
+    return table;
+}
+
+/* static */
+void CalFile::clearCache()
+{
+    n_u::Synchronized autoLock(_cacheMutex);
+    _tableCache.clear();
+}
+
+/* static */
+unsigned int CalFile::getCacheSize()
+{
+    n_u::Synchronized autoLock(_cacheMutex);
+    return _tableCache.size();
+}
+
+void CalFile::setTimeSettings(const TimeSettings& settings)
+{
+    if (settings.timeZone != _timeZone)
+        setTimeZone(settings.timeZone);
+    if (settings.dateTimeFormat != _dateTimeFormat)
+        _dateTimeFormat = settings.dateTimeFormat;
+}
+
+void CalFile::nextRecord()
+{
+    if (!_table) open();
+
+    if (eof()) return;
+
+    if (_next >= _table->records.size())
+    {
+        if (_table->parseError) throw *_table->parseError;
+        if (_table->ioError) throw *_table->ioError;
+        _eofState = true;
+        _nline = _table->nlines;
+        setTimeSettings(_table->settings.back());
+        VLOG(("nextRecord: ") << getCurrentFileName() << " at eof");
+        return;
+    }
+    const Record& rec = _table->records[_next++];
+    _nline = rec.nline;
+    setTimeSettings(_table->settings[rec.settings]);
+}
+
 void CalFile::close() throw()
 {
     if (_include) {
@@ -310,6 +466,7 @@ void CalFile::close() throw()
         _include = 0;
     }
     if (_fin.is_open()) _fin.close();
+    _table.reset();
     _nline = 0;
     // We specifically do not reset these here because the file might be
     // closed after a call to readCF(), even though readCF() just read a
@@ -352,37 +509,43 @@ n_u::UTime CalFile::search(const n_u::UTime& tsearch)
 {
     n_u::Autolock autolock(_mutex);
 
-    if (!_fin.is_open()) open();
-
-    n_u::UTime prevTime(LONG_LONG_MAX);
-
-    istream::pos_type recpos = 0;
-    int nline = 0;
-
-    // First time, scan file, saving the file position of the
-    // record before the one with time > tsearch.
-    for (;;) {
-        istream::pos_type pos = _fin.tellg();
-        readLine();
-        if (eof()) break;
-        n_u::UTime t = parseTime();
-        if (t > tsearch) break;
-        if (t != prevTime) {
-            prevTime = t;
-            recpos = pos;
-            nline = _nline - 1;
-        }
-    }
+    if (!_table) open();
 
-    // reposition back to last record <= tsearch
-    _fin.clear();
-    _fin.seekg(recpos);
-    _nline = nline;
+    const vector<Record>& records = _table->records;
+    vector<Record>::const_iterator ri = records.begin() + _next;
+
+    // The first record after the current position with time > tsearch.
+    vector<Record>::const_iterator rend;
+    if (_table->sorted)
+        rend = std::upper_bound(ri, records.end(), tsearch,
+            [](const n_u::UTime& t, const Record& rec)
+            { return t < rec.time; });
+    else
+        rend = std::find_if(ri, records.end(),
+            [&tsearch](const Record& rec) { return rec.time > tsearch; });
+
+    // If the rest of the file is <= tsearch, then an error after
+    // the last record was reached.
+    if (rend == records.end()) {
+        if (_table->parseError) throw *_table->parseError;
+        if (_table->ioError) throw *_table->ioError;
+    }
+
+    // Position to the first of the records with the same time as the
+    // last record <= tsearch, or to the beginning of the file if there
+    // is no such record.
+    unsigned int irec = 0;
+    if (rend != ri) {
+        irec = (rend - records.begin()) - 1;
+        while (irec > _next && records[irec - 1].time == records[irec].time)
+            irec--;
+    }
+    _next = irec;
     _eofState = false;
 
-    readLine();
-    if (eof()) return prevTime;
-    _nextTime = parseTime();
+    nextRecord();
+    if (eof()) return n_u::UTime(LONG_LONG_MAX);
+    _nextTime = currentRecord().time;
     // cerr << "search of " << getCurrentFileName() << " done, _nextTime=" <<
     //     _nextTime.format(true,"%F %T") << endl;
     return _nextTime;
@@ -416,7 +579,7 @@ n_u::UTime CalFile::parseTime()
 
 n_u::UTime CalFile::readTime()
 { 
-    readLine();
+    nextRecord();
     if (eof())
     {
         close();
@@ -424,7 +587,7 @@ n_u::UTime CalFile::readTime()
     }
     else
     {
-        _nextTime = parseTime();
+        _nextTime = currentRecord().time;
     }
     return _nextTime;
 }
@@ -441,24 +604,24 @@ int CalFile::readCF(n_u::UTime& time, float* data, int ndata,
 }
 
 
-int
+/* static */
+bool
 CalFile::
-parseInclude()
+matchInclude(const char* text, std::string& includeName)
 {
     // first field, check if it is an include line
     int regstatus;
     regmatch_t pmatch[2];
     int nmatch = sizeof pmatch/ sizeof(regmatch_t);
-    string includeName;
     {
         n_u::Synchronized autoLock(_staticMutex);
         if (!_reCompiled)
             compileREs();
-        regstatus = ::regexec(&_includePreg, _curline + _curpos,
+        regstatus = ::regexec(&_includePreg, text,
                               nmatch, pmatch, 0);
         if ((regstatus == 0) && pmatch[1].rm_so >= 0)
         {
-            includeName = string(_curline + _curpos + pmatch[1].rm_so,
+            includeName = string(text + pmatch[1].rm_so,
                                  pmatch[1].rm_eo - pmatch[1].rm_so);
         }
         else if (regstatus != REG_NOMATCH)
@@ -469,12 +632,7 @@ parseInclude()
         }
     }
     /* found an "include" record */
-    if (regstatus == 0)
-    {
-        openInclude(includeName);
-        return 1;
-    }
-    return 0;
+    return regstatus == 0;
 }
 
 
@@ -560,40 +718,26 @@ int CalFile::readCFNoLock(n_u::UTime& time, float* data, int ndata,
     }
     time = _nextTime;
 
-    // At this point we are on a calfile record line, just past the
-    // timestamp, so everything past this point is taken as a calibration
-    // field.  The original code parsed numbers first, so a field with
-    // "123.456#" would have been parsed as a coefficient followed by a
-    // comment, therefore it is not enough to first tokenize the record as
-    // space-separated strings.  Instead, first strip any comment
-    // characters and anything following.
-
-    char* pound = strchr(_curline + _curpos, '#');
-    if (pound)
-        *pound = '\0';
+    // At this point we are on a calfile record, unless the file has
+    // no records, in which case it has been closed.
+    const Record* rec = _table ? &currentRecord() : 0;
 
     // Now check if this record is an include directive, and if so, recurse
     // into the include file looking for the next cal record.
-    if (parseInclude())
+    if (rec && !rec->include.empty())
     {
+        string includeName = rec->include;
+        openInclude(includeName);
         return readCFNoLock(time, data, ndata, fields_out);
     }
 
-    /* Finally, this looks like a regular cal record line which can
-     * be parsed into fields. */
-    istringstream fin(_curline + _curpos);
-    std::string ifield;
-    std::vector<std::string> fields;
-
-    while (fin >> ifield)
-    {
-        fields.push_back(ifield);
-    }
-    _currentFields = fields;
+    /* Finally, this is a regular cal record with fields. */
+    if (rec)
+        _currentFields = rec->fields;
     _currentTime = _nextTime;
 
     if (fields_out)
-        *fields_out = fields;
+        *fields_out = _currentFields;
 
     int id = getFields(0, ndata, data);
     readTime();
@@ -642,8 +786,10 @@ getFields(int begin, int end, float* data,
                 continue;
             }
             ostringstream ost;
-            ost << "invalid contents of field " << fi+1 << " in "
-                <<  '"' << string(_curline + _curpos) << '"';
+            ost << "invalid contents of field " << fi+1 << " in \"";
+            for (unsigned int i = 0; i < fields.size(); i++)
+                ost << (i > 0 ? " " : "") << fields[i];
+            ost << '"';
             throw n_u::ParseException(getCurrentFileName(),
                                       ost.str(), getLineNumber());
         }
@@ -673,8 +819,6 @@ getFloatField(int column, const std::vector<std::string>* fields)
 
 void CalFile::readLine()
 {
-    if (!_fin.is_open()) open();
-
     for(;;) {
 
         // eof() is used to indicate there is no line left to parse.  So
@@ -31,9 +31,12 @@
 #include <nidas/util/UTime.h>
 #include <nidas/util/IOException.h>
 #include <nidas/util/EOFException.h>
+#include <nidas/util/ParseException.h>
 #include <nidas/util/ThreadSupport.h>
 
 #include <vector>
+#include <map>
+#include <memory>
 #include <fstream>
 
 #include <regex.h>
@@ -123,6 +126,15 @@ class DSMSensor;
  *
  *  An included file can also contain "include" directives.
  *
+ *  Each file is parsed once into a table of its records, kept in
+ *  a cache shared by all CalFile instances in the process, including
+ *  the instances for included files, so that a file used by many
+ *  sensors, or included many times, is only read once.  Reading and
+ *  searching then step through or binary search the table.  A file is
+ *  parsed again if its modification time, size or inode changes.
+ *  The time zone and date format that a file begins with are part of
+ *  the key of the cache, since they can change how its times are parsed.
+ *
  *  The include directive is useful when sensors are swapped
  *  during a data acquisition period.  One can keep the
  *  sensor specific calibrations in separate files, and
@@ -221,6 +233,19 @@ public:
         return tmp;
     }
 
+    /**
+     * Remove all files from the cache of parsed files shared by the
+     * CalFile instances.  CalFiles which are open keep the records
+     * they are reading, and files are parsed again the next time they
+     * are opened.
+     */
+    static void clearCache();
+
+    /**
+     * Number of files in the cache of parsed files.
+     */
+    static unsigned int getCacheSize();
+
     /**
      * Return the full file path of the current file.
      */
@@ -255,6 +280,8 @@ public:
      * Open the file. It is not necessary to call open().
      * If the user has not done an open() it will
      * be done in the first readCF(), or search().
+     * The records of the file are taken from the cache, or
+     * the file is parsed and added to the cache.
      *
      * @throws nidas::util::IOException
      */
@@ -298,7 +325,9 @@ public:
 
     /** 
      * Search forward in a file, returning the time of the last record
-     * in the file with a time less than or equal to tsearch.
+     * in the file with a time less than or equal to tsearch.  If the
+     * records are in time order, as they should be, this is a binary
+     * search.
      * The time is available by calling nextTime().
      * The next call to readCF() will return that record.
      *
@@ -435,7 +464,8 @@ protected:
     nidas::util::UTime parseTime();
 
     /**
-     * Read forward to next non-comment line in CalFile.  Place result in
+     * Read forward to next non-comment line of the file being parsed
+     * by parseFile().  Place result in
      * _curline, and index of first non-space character in _curpos.  Set
      * _eofState=true if that is the case.  Also parses special comment
      * lines like below, using parseTimeComments():
@@ -458,13 +488,13 @@ protected:
     parseTimeComments();
 
     /**
-     * If the current calfile record line is an include directive, parse
-     * the include filename, open it, and return 1.  Otherwise return 0.
-     * It is up to the caller to recurse into the include file to read the
-     * next cal record.
+     * If @p text, the part of a record after the time, is an include
+     * directive, set @p name to the include filename and return true.
+     *
+     * @throws nidas::util::ParseException
      */
-    int
-    parseInclude();
+    static bool
+    matchInclude(const char* text, std::string& name);
 
     /**
      * @throws nidas::util::IOException,nidas::util::ParseException
@@ -483,14 +513,148 @@ protected:
 
 private:
 
+    /**
+     * The time zone and date format in effect at a point in a file.
+     */
+    struct TimeSettings
+    {
+        std::string timeZone;
+
+        std::string dateTimeFormat;
+
+        bool operator==(const TimeSettings& x) const
+        {
+            return timeZone == x.timeZone && dateTimeFormat == x.dateTimeFormat;
+        }
+    };
+
+    /**
+     * A record of a file: its time, and the rest of the line, with any
+     * comment removed, as an include directive or as fields.
+     */
+    struct Record
+    {
+        Record(): time(), nline(0), settings(0), include(), fields()
+        {}
+
+        nidas::util::UTime time;
+
+        /**
+         * Line number of the record in the file.
+         */
+        int nline;
+
+        /**
+         * Index in Table::settings of the time settings in effect
+         * at the record.
+         */
+        unsigned int settings;
+
+        /**
+         * Name of the included file, if this is an include directive.
+         */
+        std::string include;
+
+        std::vector<std::string> fields;
+    };
+
+    /**
+     * The parsed records of a file, which are not modified once
+     * the file has been parsed.
+     */
+    struct Table
+    {
+        Table(): records(), settings(), nlines(0), sorted(true),
+            parseError(), ioError()
+        {}
+
+        std::vector<Record> records;
+
+        /**
+         * Time settings of the file, the last being those in effect at
+         * the end of the file.
+         */
+        std::vector<TimeSettings> settings;
+
+        /**
+         * Number of lines in the file.
+         */
+        int nlines;
+
+        /**
+         * Are the record times non-decreasing?
+         */
+        bool sorted;
+
+        /**
+         * An error in the file after the last record, which is thrown
+         * when reading reaches it.
+         */
+        std::shared_ptr<const nidas::util::ParseException> parseError;
+
+        std::shared_ptr<const nidas::util::IOException> ioError;
+    };
+
+    /**
+     * A table in the cache, and the identity of the file when
+     * it was parsed.
+     */
+    struct CacheEntry
+    {
+        std::shared_ptr<const Table> table;
+
+        unsigned long long device;
+
+        unsigned long long inode;
+
+        long long size;
+
+        long long mtime;
+    };
+
+    /**
+     * Get the table of a file from the cache, or parse the file and
+     * add it to the cache.
+     *
+     * @throws nidas::util::IOException
+     **/
+    static std::shared_ptr<const Table>
+    getTable(const std::string& fileName, const TimeSettings& settings);
+
+    /**
+     * Parse a file into a Table, starting with the given time settings.
+     *
+     * @throws nidas::util::IOException
+     **/
+    static std::shared_ptr<const Table>
+    parseFile(const std::string& fileName, const TimeSettings& settings);
+
+    /**
+     * Advance to the next record of the table, and set the line
+     * number and time settings from it.  Set _eofState=true if there
+     * are no more records.
+     *
+     * @throws nidas::util::IOException
+     * @throws nidas::util::ParseException
+     **/
+    void nextRecord();
+
+    /**
+     * The record that nextRecord() advanced to.
+     */
+    const Record& currentRecord() const
+    {
+        return _table->records[_next - 1];
+    }
+
+    void setTimeSettings(const TimeSettings& settings);
+
     /** 
-     * Read lines, parsing special comment lines and skipping other
-     * comments or blank lines, until a record line is found.  Then parse
-     * and return the time from that record. On EOF, the returned time will
+     * Advance to the next record.  Then return the time from that
+     * record. On EOF, the returned time will
      * be a huge value, far off in the mega-distant future. Does not return
-     * an EOFException on EOF.  After parsing the time from a record,
-     * curline contains that record, and curpos points to the character
-     * after the datetime field.  Also sets _nextTime to the returned time.
+     * an EOFException on EOF.  After this, currentRecord() is
+     * the record.  Also sets _nextTime to the returned time.
      *
      * @throws nidas::util::IOException
      * @throws nidas::util::ParseException
@@ -518,6 +682,9 @@ private:
 
     std::string _dateTimeFormat;
 
+    /**
+     * Stream of the file being parsed, by parseFile().
+     */
     std::ifstream _fin;
 
     static const int INITIAL_CURLINE_LENGTH = 128;
@@ -556,6 +723,16 @@ private:
 
     const DSMSensor* _sensor;
 
+    /**
+     * Records of the open file.
+     */
+    std::shared_ptr<const Table> _table;
+
+    /**
+     * Index in _table of the record after currentRecord().
+     */
+    unsigned int _next;
+
     static nidas::util::Mutex _staticMutex;
 
     static int _reUsers;
@@ -577,6 +754,13 @@ private:
 
     static std::vector<std::string> _allPaths;
 
+    /**
+     * Parsed files, by file name and initial time settings.
+     */
+    static std::map<std::string, CacheEntry> _tableCache;
+
+    static nidas::util::Mutex _cacheMutex;
+
     nidas::util::Mutex _mutex;
 };
 
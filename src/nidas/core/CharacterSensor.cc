@@ -435,6 +435,19 @@ searchSampleScanners(const Sample* samp, SampleTag** stag_out) throw()
 bool
 CharacterSensor::
 process(const Sample* samp, list<const Sample*>& results)
+{
+    SampleT<float>* outs = scanSample(samp);
+    if (!outs)
+    {
+        return false;
+    }
+    results.push_back(outs);
+    return true;
+}
+
+SampleT<float>*
+CharacterSensor::
+scanSample(const Sample* samp)
 {
     // Try to scan the variables of a sample tag from the raw sensor
     // message.
@@ -442,7 +455,7 @@ process(const Sample* samp, list<const Sample*>& results)
     SampleT<float>* outs = searchSampleScanners(samp, &stag);
     if (!outs)
     {
-        return false;
+        return 0;
     }
 
     // Apply any time tag adjustments.
@@ -452,8 +465,7 @@ process(const Sample* samp, list<const Sample*>& results)
     // time is adjusted, since the calibrations are keyed by time.
     applyConversions(stag, outs);
 
-    results.push_back(outs);
-    return true;
+    return outs;
 }
 
 void
@@ -340,6 +340,16 @@ protected:
     void
     adjustTimeTag(SampleTag* stag, SampleT<float>* outs);
 
+    /**
+     * Scan a raw sample with searchSampleScanners(), then adjust the
+     * time tag and apply the variable conversions of the result, as
+     * done by process().  Returns the new Sample, or null if no scanner
+     * matched.  Subclasses which further process the parsed values
+     * can call this rather than process(), without a std::list.
+     **/
+    SampleT<float>*
+    scanSample(const Sample* samp);
+
     std::map<const SampleTag*, TimetagAdjuster*> _ttadjusters;
 
 private:
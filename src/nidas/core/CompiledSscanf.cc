@@ -0,0 +1,541 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "CompiledSscanf.h"
+
+#include <cfloat>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+
+using namespace nidas::core;
+using namespace std;
+
+namespace {
+
+/*
+ * The inline float conversion relies on double arithmetic being done
+ * in double precision, which is not the case with the x87 FPU.
+ */
+#if defined(FLT_EVAL_METHOD) && FLT_EVAL_METHOD == 0
+const bool EXACT_DOUBLE_ARITHMETIC = true;
+#else
+const bool EXACT_DOUBLE_ARITHMETIC = false;
+#endif
+
+/**
+ * Powers of ten which are exactly representable as doubles.
+ */
+const double POW10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+const int MAX_EXACT_POW10 = 22;
+
+/**
+ * The locale-independent isspace() of the "C" locale.
+ */
+inline bool isSpace(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+inline bool isAlnum(char c)
+{
+    return isDigit(c) || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+inline int digitValue(char c)
+{
+    if (isDigit(c)) return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return 99;
+}
+
+inline const char* skipSpace(const char* cp)
+{
+    while (isSpace(*cp)) cp++;
+    return cp;
+}
+
+/**
+ * Whether a double in the normal range of floats lies exactly half way
+ * between two floats, in which case converting it to float may round
+ * differently than converting the decimal string it came from.
+ */
+inline bool isFloatMidpoint(double d)
+{
+    uint64_t bits;
+    ::memcpy(&bits, &d, sizeof(bits));
+    // 29 bits of a double mantissa are dropped when rounding to float.
+    return (bits & 0x1fffffffULL) == 0x10000000ULL;
+}
+
+}
+
+CompiledSscanf::CompiledSscanf(): _ops(), _nfields(0), _compiled(false)
+{
+}
+
+bool CompiledSscanf::compile(const string& format)
+{
+    _ops.clear();
+    _nfields = 0;
+    _compiled = false;
+
+    const char* cp = format.c_str();
+    while (*cp) {
+        if (isSpace(*cp)) {
+            cp = skipSpace(cp);
+            _ops.push_back(Op());
+            _ops.back().type = SKIP_SPACE;
+            continue;
+        }
+        if (*cp != '%') {
+            if (_ops.empty() || _ops.back().type != LITERAL) {
+                _ops.push_back(Op());
+                _ops.back().type = LITERAL;
+            }
+            _ops.back().text += *cp++;
+            continue;
+        }
+
+        const char* spec = cp++;
+        if (*cp == '%') {
+            _ops.push_back(Op());
+            _ops.back().type = PERCENT;
+            cp++;
+            continue;
+        }
+
+        Op op;
+        if (*cp == '*') {
+            op.assign = false;
+            cp++;
+        }
+        if (isDigit(*cp)) {
+            for ( ; isDigit(*cp); cp++) {
+                if (op.width > 9999) return false;
+                op.width = op.width * 10 + (*cp - '0');
+            }
+            if (op.width == 0) return false;
+        }
+        if (*cp == 'h') {
+            op.size = SHORT;
+            cp++;
+        }
+        else if (*cp == 'l') {
+            op.size = LONG;
+            cp++;
+        }
+
+        switch (*cp++) {
+        case 'd':
+            op.type = NUMBER;
+            op.conv = DEC;
+            break;
+        case 'u':
+            op.type = NUMBER;
+            op.conv = UDEC;
+            break;
+        case 'o':
+            op.type = NUMBER;
+            op.conv = OCT;
+            break;
+        case 'x':
+            op.type = NUMBER;
+            op.conv = HEX;
+            break;
+        case 'f':
+        case 'g':
+            if (op.size == SHORT) return false;
+            op.type = NUMBER;
+            op.conv = (op.size == LONG ? DOUBLE : FLOAT);
+            break;
+        case 'c':
+            if (op.size != INT) return false;
+            op.type = CHARS;
+            if (op.width == 0) op.width = 1;
+            break;
+        case 's':
+            // Only suppressed strings and scan sets are supported, as by
+            // AsciiSscanf.
+            if (op.assign || op.size != INT) return false;
+            op.type = STRING;
+            break;
+        case '[':
+        {
+            if (op.assign || op.width || op.size != INT) return false;
+            op.type = CHARSET;
+            bool negate = (*cp == '^');
+            if (negate) cp++;
+            const char* first = cp;
+            if (*cp == ']') return false;
+            for ( ; *cp && *cp != ']'; cp++) {
+                if (*cp == '-' && cp != first && cp[1] != ']') {
+                    unsigned char c0 = cp[-1];
+                    unsigned char c1 = cp[1];
+                    if (c1 < c0) return false;
+                    for (unsigned int c = c0; c <= c1; c++) op.set.set(c);
+                    cp++;
+                }
+                else op.set.set((unsigned char)*cp);
+            }
+            if (*cp++ != ']') return false;
+            if (negate) op.set.flip();
+            op.set.reset(0);
+            break;
+        }
+        default:
+            return false;
+        }
+        if (op.type == NUMBER)
+            op.fallback = string(spec, cp - spec) + "%n";
+        if (op.assign) _nfields++;
+        _ops.push_back(op);
+    }
+    _compiled = true;
+    return true;
+}
+
+int CompiledSscanf::scan(const char* input, float* output, int nout) const
+{
+    const char* cp = input;
+    int n = 0;
+    if (nout <= 0) return 0;
+
+    vector<Op>::const_iterator oi = _ops.begin();
+    for ( ; oi != _ops.end(); ++oi) {
+        const Op& op = *oi;
+        switch (op.type) {
+        case SKIP_SPACE:
+            cp = skipSpace(cp);
+            break;
+        case LITERAL:
+            for (size_t i = 0; i < op.text.length(); i++, cp++)
+                if (*cp != op.text[i]) return n;
+            break;
+        case PERCENT:
+            cp = skipSpace(cp);
+            if (*cp != '%') return n;
+            cp++;
+            break;
+        case NUMBER:
+        {
+            cp = skipSpace(cp);
+            if (!*cp) return n;
+            size_t len = scanNumber(op, cp, output + n);
+            if (!len) return n;
+            cp += len;
+            if (op.assign && ++n == nout) return n;
+            break;
+        }
+        case CHARS:
+        {
+            // Like ::sscanf, take fewer than width characters if
+            // the input ends, but at least one.
+            int len = 0;
+            for ( ; len < op.width && cp[len]; len++);
+            if (!len) return n;
+            if (op.assign) {
+                const unsigned char* up = (const unsigned char*) cp;
+                // Same conversion as AsciiSscanf: the first character
+                // as an unsigned int, or the first two as a little-endian
+                // 16 bit value.
+                if (op.width == 1) output[n] = (float)up[0];
+                else output[n] = (float)((int)up[0] +
+                        (len > 1 ? (int)up[1] << 8 : 0));
+            }
+            cp += len;
+            if (op.assign && ++n == nout) return n;
+            break;
+        }
+        case STRING:
+        {
+            cp = skipSpace(cp);
+            const char* cp0 = cp;
+            const char* end = op.width ? cp + op.width : 0;
+            while (cp != end && *cp && !isSpace(*cp)) cp++;
+            if (cp == cp0) return n;
+            break;
+        }
+        case CHARSET:
+        {
+            const char* cp0 = cp;
+            while (op.set.test((unsigned char)*cp)) cp++;
+            if (cp == cp0) return n;
+            break;
+        }
+        }
+    }
+    return n;
+}
+
+size_t CompiledSscanf::scanNumber(const Op& op, const char* cp,
+        float* output) const
+{
+    size_t len;
+    if (op.conv == FLOAT || op.conv == DOUBLE)
+        len = parseFloat(op, cp, output);
+    else
+        len = parseInteger(op, cp, output);
+    if (!len) len = scanFallback(op, cp, output);
+    return len;
+}
+
+size_t CompiledSscanf::parseInteger(const Op& op, const char* cp,
+        float* output)
+{
+    // Limit the digits so that the value fits in a long, in which case
+    // ::sscanf stores the same value, truncated to the field size.
+    const int ldigits = numeric_limits<long>::digits;
+    unsigned int base;
+    int maxdigits;
+    switch (op.conv) {
+    case OCT:
+        base = 8;
+        maxdigits = ldigits / 3;
+        break;
+    case HEX:
+        base = 16;
+        maxdigits = ldigits / 4;
+        break;
+    default:
+        base = 10;
+        maxdigits = numeric_limits<long>::digits10;
+        break;
+    }
+
+    const char* end = op.width ? cp + op.width : 0;
+    const char* p = cp;
+    bool neg = false;
+    if (*p == '-' || *p == '+') {
+        neg = (*p++ == '-');
+        if (neg && op.conv == UDEC) return 0;
+    }
+    const char* digits = p;
+    unsigned long val = 0;
+    for ( ; p != end; p++) {
+        unsigned int d = digitValue(*p);
+        if (d >= base) break;
+        if (p - digits == maxdigits) return 0;
+        val = val * base + d;
+    }
+    if (p == digits) return 0;
+    // A letter or another digit would be taken by ::sscanf as part of
+    // the field, or would make it invalid, so leave those to ::sscanf.
+    if (p != end && isAlnum(*p)) return 0;
+
+    if (op.assign) {
+        long lval = neg ? -(long)val : (long)val;
+        if (op.conv == UDEC) {
+            switch (op.size) {
+            case SHORT:
+                *output = (float)(unsigned short)val;
+                break;
+            case INT:
+                *output = (float)(unsigned int)val;
+                break;
+            case LONG:
+                *output = (float)val;
+                break;
+            }
+        }
+        else {
+            switch (op.size) {
+            case SHORT:
+                *output = (float)(short)lval;
+                break;
+            case INT:
+                *output = (float)(int)lval;
+                break;
+            case LONG:
+                *output = (float)lval;
+                break;
+            }
+        }
+    }
+    return p - cp;
+}
+
+size_t CompiledSscanf::parseFloat(const Op& op, const char* cp,
+        float* output)
+{
+    if (!EXACT_DOUBLE_ARITHMETIC) return 0;
+
+    const char* end = op.width ? cp + op.width : 0;
+    const char* p = cp;
+    bool neg = false;
+    if (*p == '-' || *p == '+') neg = (*p++ == '-');
+
+    // Significant digits, without leading zeroes, and the power of ten
+    // to scale them by.
+    uint64_t mant = 0;
+    int ndigits = 0;
+    int exp10 = 0;
+    bool anydigits = false;
+
+    for ( ; p != end && isDigit(*p); p++) {
+        anydigits = true;
+        if (mant || *p != '0') {
+            if (ndigits++ == 19) return 0;
+            mant = mant * 10 + (*p - '0');
+        }
+    }
+    if (p != end && *p == '.') {
+        for (p++; p != end && isDigit(*p); p++) {
+            anydigits = true;
+            if (mant || *p != '0') {
+                if (ndigits++ == 19) return 0;
+                mant = mant * 10 + (*p - '0');
+            }
+            exp10--;
+        }
+    }
+    if (!anydigits) return 0;
+
+    if (p != end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool eneg = false;
+        if (q != end && (*q == '-' || *q == '+')) eneg = (*q++ == '-');
+        if (q == end || !isDigit(*q)) return 0;
+        int e = 0;
+        for ( ; q != end && isDigit(*q); q++) {
+            if (e > 9999) return 0;
+            e = e * 10 + (*q - '0');
+        }
+        exp10 += (eneg ? -e : e);
+        p = q;
+    }
+    if (p != end && (isAlnum(*p) || *p == '.')) return 0;
+
+    if (op.assign) {
+        // An exact integer multiplied or divided by an exact power
+        // of ten is rounded once, and so is the correctly rounded
+        // double that strtod() returns.
+        double dval;
+        if (mant == 0) dval = 0.0;
+        else if (mant <= (1ULL << 53) &&
+                exp10 >= -MAX_EXACT_POW10 && exp10 <= MAX_EXACT_POW10)
+            dval = (exp10 < 0 ? mant / POW10[-exp10] : mant * POW10[exp10]);
+        else return 0;
+        if (neg) dval = -dval;
+
+        // Rounding that double to float gives the correctly rounded
+        // float of strtof(), unless it is half way between two floats.
+        if (op.conv == FLOAT && isFloatMidpoint(dval)) return 0;
+        *output = (float)dval;
+    }
+    return p - cp;
+}
+
+size_t CompiledSscanf::scanFallback(const Op& op, const char* cp,
+        float* output)
+{
+    const char* fmt = op.fallback.c_str();
+    int nc = -1;
+    if (!op.assign) {
+        ::sscanf(cp, fmt, &nc);
+        return nc > 0 ? nc : 0;
+    }
+
+    int nconv = 0;
+    float val = 0.0;
+    switch (op.conv) {
+    case FLOAT:
+        nconv = ::sscanf(cp, fmt, &val, &nc);
+        break;
+    case DOUBLE:
+    {
+        double dval;
+        nconv = ::sscanf(cp, fmt, &dval, &nc);
+        val = (float)dval;
+        break;
+    }
+    case UDEC:
+        switch (op.size) {
+        case SHORT:
+        {
+            unsigned short uval;
+            nconv = ::sscanf(cp, fmt, &uval, &nc);
+            val = (float)uval;
+            break;
+        }
+        case INT:
+        {
+            unsigned int uval;
+            nconv = ::sscanf(cp, fmt, &uval, &nc);
+            val = (float)uval;
+            break;
+        }
+        case LONG:
+        {
+            unsigned long uval;
+            nconv = ::sscanf(cp, fmt, &uval, &nc);
+            val = (float)uval;
+            break;
+        }
+        }
+        break;
+    default:
+        // AsciiSscanf converts %d, %o and %x fields as signed values.
+        switch (op.size) {
+        case SHORT:
+        {
+            short ival;
+            nconv = ::sscanf(cp, fmt, &ival, &nc);
+            val = (float)ival;
+            break;
+        }
+        case INT:
+        {
+            int ival;
+            nconv = ::sscanf(cp, fmt, &ival, &nc);
+            val = (float)ival;
+            break;
+        }
+        case LONG:
+        {
+            long ival;
+            nconv = ::sscanf(cp, fmt, &ival, &nc);
+            val = (float)ival;
+            break;
+        }
+        }
+        break;
+    }
+    if (nconv != 1 || nc <= 0) return 0;
+    *output = val;
+    return nc;
+}
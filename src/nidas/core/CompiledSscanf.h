@@ -0,0 +1,153 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+#ifndef NIDAS_CORE_COMPILEDSSCANF_H
+#define NIDAS_CORE_COMPILEDSSCANF_H
+
+#include <bitset>
+#include <string>
+#include <vector>
+
+namespace nidas { namespace core {
+
+/**
+ * A sscanf format, compiled once into a sequence of operations which
+ * match literal characters and parse numeric fields directly, rather
+ * than interpreting the format on every call as ::sscanf does.
+ *
+ * The scan() method has the same results as ::sscanf with the format,
+ * including the number of fields converted when the input only partially
+ * matches.  Numbers with a simple decimal syntax, which is most of what
+ * sensors send, are parsed inline.  A float is only parsed inline when
+ * the result is exactly what strtof() or strtod() would return.
+ * Anything else in a field, such as "nan", hex floats, or more digits
+ * than can be converted exactly, is passed to ::sscanf with the
+ * conversion of that one field.
+ *
+ * compile() only accepts the conversions supported by AsciiSscanf:
+ * %f, %g, %lf, %lg, %d, %o, %x, %u with the h and l flags, %c,
+ * the suppression flag '*', field widths, and suppressed strings
+ * and scan sets, %*s and %*[^,].  Formats with anything else are left to
+ * ::sscanf.
+ */
+class CompiledSscanf
+{
+public:
+
+    CompiledSscanf();
+
+    /**
+     * Compile a format.  Returns false if the format has a conversion
+     * which is not supported, in which case isCompiled() is false.
+     */
+    bool compile(const std::string& format);
+
+    bool isCompiled() const { return _compiled; }
+
+    /**
+     * Number of conversions that are assigned, ie, not suppressed.
+     */
+    int getNumberOfFields() const { return _nfields; }
+
+    /**
+     * Scan input, storing up to nout values into output as floats,
+     * converted in the same way as AsciiSscanf::sscanf().  Returns
+     * the number of values stored.
+     */
+    int scan(const char* input, float* output, int nout) const;
+
+private:
+
+    enum optype { SKIP_SPACE, LITERAL, PERCENT, NUMBER, CHARS, STRING,
+        CHARSET };
+
+    enum convtype { DEC, UDEC, OCT, HEX, FLOAT, DOUBLE };
+
+    enum sizetype { SHORT, INT, LONG };
+
+    struct Op
+    {
+        Op(): type(SKIP_SPACE), conv(DEC), size(INT), assign(true),
+            width(0), text(), set(), fallback()
+        {}
+
+        enum optype type;
+
+        enum convtype conv;
+
+        enum sizetype size;
+
+        bool assign;
+
+        /**
+         * Maximum field width, 0 for no maximum.  For %c, the number
+         * of characters.
+         */
+        int width;
+
+        /**
+         * Characters to match for LITERAL.
+         */
+        std::string text;
+
+        /**
+         * Characters accepted by CHARSET.
+         */
+        std::bitset<256> set;
+
+        /**
+         * ::sscanf format of this one numeric field, followed by %n,
+         * for input that is not parsed inline.
+         */
+        std::string fallback;
+    };
+
+    /**
+     * Parse the numeric field at cp, returning the number of characters
+     * used, or 0 if the field does not match.  The value is stored in
+     * *output if op.assign.
+     */
+    size_t scanNumber(const Op& op, const char* cp, float* output) const;
+
+    /**
+     * Parse a number with a simple syntax inline.  Returns the number
+     * of characters used, or 0 if the number must be passed to ::sscanf.
+     */
+    static size_t parseInteger(const Op& op, const char* cp, float* output);
+
+    static size_t parseFloat(const Op& op, const char* cp, float* output);
+
+    static size_t scanFallback(const Op& op, const char* cp, float* output);
+
+    std::vector<Op> _ops;
+
+    int _nfields;
+
+    bool _compiled;
+};
+
+}}	// namespace nidas namespace core
+
+#endif
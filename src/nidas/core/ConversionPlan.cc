@@ -0,0 +1,306 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "ConversionPlan.h"
+#include "CalFile.h"
+#include "Site.h"
+#include "Variable.h"
+#include "VariableConverter.h"
+
+#include <algorithm>
+#include <typeinfo>
+
+using namespace nidas::core;
+using namespace std;
+
+namespace {
+
+/**
+ * Values are converted in blocks of this many, with loops of a constant
+ * length which the compiler can vectorize, and then any remaining
+ * values one at a time.
+ */
+const unsigned int BLOCK = 16;
+
+/**
+ * Apply a kernel to n values, in place.
+ */
+template<class K>
+inline void
+convertValues(const K& kernel, float* v, unsigned int n)
+{
+    unsigned int i = 0;
+    for ( ; i + BLOCK <= n; i += BLOCK) kernel.block(v + i);
+    for ( ; i < n; i++) v[i] = kernel.value(v[i]);
+}
+
+/**
+ * The checks of Variable::convert(): NAN if the raw value @p v is the
+ * missing value, or if the converted value @p r is outside the min/max
+ * limits, otherwise @p r.
+ */
+struct Limits
+{
+    float missing;
+    float vmin;
+    float vmax;
+
+    float operator()(float v, float r) const
+    {
+        r = (r < vmin || r > vmax) ? floatNAN : r;
+        return (v == missing) ? floatNAN : r;
+    }
+};
+
+/**
+ * The Site disables conversions: only the missing value is checked.
+ */
+struct MaskMissing
+{
+    float missing;
+
+    float value(float v) const
+    {
+        return (v == missing) ? floatNAN : v;
+    }
+
+    void block(float* v) const
+    {
+        for (unsigned int j = 0; j < BLOCK; j++) v[j] = value(v[j]);
+    }
+};
+
+/**
+ * No converter, only the limits.
+ */
+struct NoConversion
+{
+    Limits limits;
+
+    float value(float v) const
+    {
+        return limits(v, v);
+    }
+
+    void block(float* v) const
+    {
+        for (unsigned int j = 0; j < BLOCK; j++) v[j] = value(v[j]);
+    }
+};
+
+/**
+ * Linear::convert(), in double as it is called from Variable::convert().
+ */
+struct LinearConversion
+{
+    Limits limits;
+    double slope;
+    double intercept;
+
+    float value(float v) const
+    {
+        return limits(v, (float)(v * slope + intercept));
+    }
+
+    void block(float* v) const
+    {
+        for (unsigned int j = 0; j < BLOCK; j++) v[j] = value(v[j]);
+    }
+};
+
+/**
+ * Polynomial::eval(), with the same order of operations.  A block is
+ * evaluated with the loop over the coefficients outside the loop over
+ * the values.
+ */
+struct PolynomialConversion
+{
+    Limits limits;
+    const float* p;
+    unsigned int np;
+
+    float value(float v) const
+    {
+        double y = 0.0;
+        if (np > 0) {
+            for (unsigned int k = np - 1; k > 0; k--)
+                y = (y + p[k]) * v;
+            y += p[0];
+        }
+        return limits(v, (float) y);
+    }
+
+    void block(float* v) const
+    {
+        double y[BLOCK];
+        for (unsigned int j = 0; j < BLOCK; j++) y[j] = 0.0;
+        if (np > 0) {
+            for (unsigned int k = np - 1; k > 0; k--) {
+                double pk = p[k];
+                for (unsigned int j = 0; j < BLOCK; j++)
+                    y[j] = (y[j] + pk) * v[j];
+            }
+            double p0 = p[0];
+            for (unsigned int j = 0; j < BLOCK; j++) y[j] += p0;
+        }
+        for (unsigned int j = 0; j < BLOCK; j++)
+            v[j] = limits(v[j], (float) y[j]);
+    }
+};
+
+/**
+ * Any other converter, called for each value as in Variable::convert().
+ */
+void
+convertGeneric(VariableConverter* conv, dsm_time_t ttag,
+               float* v, unsigned int n, const Limits& limits)
+{
+    for (unsigned int i = 0; i < n; i++) {
+        float val = v[i];
+        if (val == limits.missing) {
+            val = floatNAN;
+        }
+        else {
+            val = conv->convert(ttag, val);
+            if (val < limits.vmin || val > limits.vmax) val = floatNAN;
+        }
+        v[i] = val;
+    }
+}
+
+}   // namespace
+
+ConversionPlan::ConversionPlan(): _ops()
+{
+}
+
+ConversionPlan::ConversionPlan(const ConversionPlan&): _ops()
+{
+}
+
+ConversionPlan& ConversionPlan::operator=(const ConversionPlan& rhs)
+{
+    if (&rhs != this) _ops.clear();
+    return *this;
+}
+
+bool ConversionPlan::matches(const vector<Variable*>& vars) const
+{
+    if (vars.size() != _ops.size()) return false;
+    for (unsigned int i = 0; i < vars.size(); i++) {
+        const Op& op = _ops[i];
+        Variable* var = vars[i];
+        if (op.var != var || op.length != var->getLength() ||
+            op.converter != var->getConverter()) return false;
+    }
+    return true;
+}
+
+void ConversionPlan::compile(const vector<Variable*>& vars)
+{
+    _ops.clear();
+    unsigned int offset = 0;
+    for (Variable* var : vars) {
+        Op op;
+        op.var = var;
+        op.converter = var->getConverter();
+        op.offset = offset;
+        op.length = var->getLength();
+        // Subclasses of Linear and Polynomial may override convert(),
+        // so only the classes themselves are compiled.
+        if (!op.converter)
+            op.kernel = IDENTITY;
+        else if (typeid(*op.converter) == typeid(Linear))
+            op.kernel = LINEAR;
+        else if (typeid(*op.converter) == typeid(Polynomial))
+            op.kernel = POLYNOMIAL;
+        else
+            op.kernel = GENERIC;
+        _ops.push_back(op);
+        offset += op.length;
+    }
+}
+
+unsigned int ConversionPlan::apply(const vector<Variable*>& vars,
+                                   dsm_time_t ttag, float* values,
+                                   unsigned int nvalues, float* results)
+{
+    if (!matches(vars)) compile(vars);
+    if (!results) results = values;
+
+    unsigned int nconv = 0;
+    for (const Op& op : _ops) {
+        if (op.offset >= nvalues) break;
+        unsigned int n = std::min(op.length, nvalues - op.offset);
+        // The kernels convert in place.
+        float* v = results + op.offset;
+        if (results != values)
+            std::copy(values + op.offset, values + op.offset + n, v);
+        nconv = op.offset + n;
+
+        const Variable* var = op.var;
+        const Site* site = var->getSite();
+        if (site && !site->getApplyVariableConversions()) {
+            convertValues(MaskMissing{var->getMissingValue()}, v, n);
+            continue;
+        }
+        Limits limits{var->getMissingValue(), var->getMinValue(),
+                      var->getMaxValue()};
+
+        if (op.kernel == LINEAR || op.kernel == POLYNOMIAL) {
+            // Read any new calibration records up to the sample time,
+            // which Linear and Polynomial::convert() do for each value.
+            CalFile* cf = op.converter->getCalFile();
+            if (cf && ttag >= cf->nextTime().toUsecs())
+                op.converter->readCalFile(ttag);
+        }
+
+        switch (op.kernel) {
+        case IDENTITY:
+            convertValues(NoConversion{limits}, v, n);
+            break;
+        case LINEAR:
+        {
+            const Linear* linear = static_cast<const Linear*>(op.converter);
+            convertValues(LinearConversion{limits, linear->getSlope(),
+                                           linear->getIntercept()}, v, n);
+            break;
+        }
+        case POLYNOMIAL:
+        {
+            const vector<float>& coefs =
+                static_cast<const Polynomial*>(op.converter)->getCoefficients();
+            convertValues(PolynomialConversion{limits, coefs.data(),
+                              (unsigned int) coefs.size()}, v, n);
+            break;
+        }
+        case GENERIC:
+            convertGeneric(op.converter, ttag, v, n, limits);
+            break;
+        }
+    }
+    return nconv;
+}
@@ -0,0 +1,125 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#ifndef NIDAS_CORE_CONVERSIONPLAN_H
+#define NIDAS_CORE_CONVERSIONPLAN_H
+
+#include "Sample.h"
+
+#include <vector>
+
+namespace nidas { namespace core {
+
+class Variable;
+class VariableConverter;
+
+/**
+ * The conversions of the Variables of a SampleTag, compiled into a flat
+ * array of operations, one per Variable, with the offset and length of
+ * the Variable's values in an output sample and the kind of conversion.
+ * apply() converts a whole output sample with a loop per Variable, rather
+ * than calling Variable::convert() and a virtual
+ * VariableConverter::convert() for every value.
+ *
+ * Linear and Polynomial conversions, and Variables without a converter,
+ * are applied with loops which the compiler can vectorize.  Any other
+ * VariableConverter is called for each value, as Variable::convert()
+ * does.  The coefficients, missing value and min/max limits are read
+ * from the Variable and its converter once per sample, after the
+ * converter's CalFile, if any, has been advanced to the sample time, so
+ * a new calibration record takes effect at the same sample as before.
+ *
+ * The plan is compiled on the first apply(), and compiled again if the
+ * Variables, their lengths or their converters have changed since.
+ */
+class ConversionPlan
+{
+public:
+
+    ConversionPlan();
+
+    /**
+     * The plan is not copied, since it refers to the Variables of
+     * one SampleTag.  A copy is compiled again on its first apply().
+     */
+    ConversionPlan(const ConversionPlan&);
+
+    ConversionPlan& operator=(const ConversionPlan&);
+
+    /**
+     * Apply the conversions of @p vars to the first @p nvalues of
+     * @p values, with the same results as calling Variable::convert()
+     * for each Variable in turn: values equal to a Variable's missing
+     * value become floatNAN, then, unless the Variable's Site disables
+     * conversions, the converter is applied and converted values outside
+     * the min/max limits become floatNAN.  The results are written to
+     * @p results, or back to @p values if @p results is null.  Values
+     * past @p nvalues are not converted, even if the Variables are
+     * longer.  Returns the number of values converted.
+     */
+    unsigned int apply(const std::vector<Variable*>& vars, dsm_time_t ttag,
+                       float* values, unsigned int nvalues,
+                       float* results = 0);
+
+    /**
+     * Number of operations, one per Variable, after the last apply().
+     */
+    unsigned int getNumOperations() const { return _ops.size(); }
+
+private:
+
+    enum kerneltype { IDENTITY, LINEAR, POLYNOMIAL, GENERIC };
+
+    struct Op
+    {
+        Variable* var;
+
+        /**
+         * The Variable's converter when the plan was compiled.
+         */
+        VariableConverter* converter;
+
+        unsigned int offset;
+
+        unsigned int length;
+
+        enum kerneltype kernel;
+    };
+
+    /**
+     * Is the plan compiled for these Variables, with their current
+     * lengths and converters?
+     */
+    bool matches(const std::vector<Variable*>& vars) const;
+
+    void compile(const std::vector<Variable*>& vars);
+
+    std::vector<Op> _ops;
+};
+
+}}	// namespace nidas namespace core
+
+#endif
@@ -75,6 +75,7 @@ DSMSensor::DSMSensor() :
     _calFiles(),_typeName(),
     _timeoutMsecs(0),
     _duplicateIdOK(false),
+    _asyncProcessing(false),
     _applyVariableConversions(),
     _driverTimeTagUsecs(USECS_PER_TMSEC),
     _nTimeouts(0),_lag(0),_station(-1)
@@ -461,12 +462,30 @@ Sample* DSMSensor::readSample()
 
 bool DSMSensor::receive(const Sample *samp)
 {
-    list<const Sample*> results;
-    process(samp,results);
-    _source.distribute(results);	// distribute does the freeReference
+    SampleSink results;
+    processInto(samp,results);
+    // distribute does the freeReference
+    _source.distribute(results.data(),results.size());
     return true;
 }
 
+bool DSMSensor::process(const Sample* samp, list<const Sample*>& results)
+{
+    SampleSink sink;
+    bool res = processInto(samp,sink);
+    results.insert(results.end(),sink.begin(),sink.end());
+    return res;
+}
+
+bool DSMSensor::processInto(const Sample* samp, SampleSink& results)
+{
+    list<const Sample*> lresults;
+    bool res = process(samp,lresults);
+    list<const Sample*>::const_iterator si = lresults.begin();
+    for ( ; si != lresults.end(); ++si) results.push_back(*si);
+    return res;
+}
+
 
 void
 DSMSensor::
@@ -494,32 +513,11 @@ void DSMSensor::applyConversions(SampleTag* stag, SampleT<float>* outs,
 {
     if (!stag || !outs)
         return;
-    float* fp = outs->getDataPtr();
-    const vector<Variable*>& vars = stag->getVariables();
-    for (unsigned int iv = 0; iv < vars.size(); iv++)
-    {
-        Variable* var = vars[iv];
-        float* start = fp;
-        fp = var->convert(outs->getTimeTag(), start, 0, results);
-        // Advance the results pointer as much as the values pointer.
-        if (results)
-        {
-            results += (fp - start);
-        }
-    }
+    stag->getConversionPlan().apply(stag->getVariables(), outs->getTimeTag(),
+        outs->getDataPtr(), outs->getDataLength(), results);
 }
 
 
-#ifdef IMPLEMENT_PROCESS
-/**
- * Default implementation of process discards data.
- */
-bool DSMSensor::process(const Sample* s, list<const Sample*>& result) throw()
-{
-    return false;
-}
-#endif
-
 bool DSMSensor::MyDictionary::getTokenValue(const string& token,string& value) const
 {
     if (token == "HEIGHT") {
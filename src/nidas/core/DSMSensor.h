@@ -29,6 +29,7 @@
 #include "SampleClient.h"
 #include "SampleSourceSupport.h"
 #include "SampleScanner.h"
+#include "SampleSink.h"
 #include "SampleTag.h"
 #include "IODevice.h"
 #include "DOMable.h"
@@ -754,7 +755,7 @@ public:
      * as a raw SampleClient of itself, using addRawSampleClient().
      * In post-processing, a DSMSensor typically receives
      * samples with its own sample id from a SampleSorter.
-     * receive() then applies further processing via the process()
+     * receive() then applies further processing via the processInto()
      * method.
      */
     bool receive(const Sample *s);
@@ -762,11 +763,31 @@ public:
     /**
      * Apply further necessary processing to a raw sample
      * from this DSMSensor. Return the resultant sample(s)
-     * in result.  The default implementation
-     * of process() simply puts the input Sample into result.
+     * in result.
+     *
+     * Every DSMSensor must implement this method, so that the
+     * defaults of process() and processInto() cannot call each other
+     * forever.  A DSMSensor which implements processInto() can
+     * implement this method by calling DSMSensor::process(), which
+     * calls processInto() and moves its results to the std::list.
      */
     virtual bool process(const Sample*,std::list<const Sample*>& result) = 0;
 
+    /**
+     * Same as process(), but the processed samples are added to
+     * a SampleSink, which unlike a std::list does not allocate memory
+     * for each sample.  receive() calls this method.
+     *
+     * This default implementation calls process(), for the sensors
+     * which have not been converted to processInto().  A DSMSensor
+     * which overrides processInto() must then implement process() by
+     * calling DSMSensor::process().  A subclass of a DSMSensor which
+     * implements processInto() must override processInto() rather
+     * than process(), otherwise its process() is not called by
+     * receive().
+     */
+    virtual bool processInto(const Sample*, SampleSink& result);
+
     void printStatusHeader(std::ostream& ostr);
     virtual void printStatus(std::ostream&);
     void printStatusTrailer(std::ostream& ostr);
@@ -881,6 +902,24 @@ public:
         _duplicateIdOK = val;
     }
 
+    /**
+     * Whether the processing of this sensor's raw samples is costly
+     * and bursty enough, as is the processing of the image records of
+     * optical array probes, that a SamplePipeline should call process()
+     * from its pool of asynchronous processing threads, if it has one,
+     * so that other sensors are not delayed.
+     * See SamplePipeline::setAsyncProcessThreads(). Default: false.
+     */
+    bool getAsyncProcessing() const
+    {
+        return _asyncProcessing;
+    }
+
+    void setAsyncProcessing(bool val)
+    {
+        _asyncProcessing = val;
+    }
+
     virtual bool getApplyVariableConversions() const
     {
         return _applyVariableConversions;
@@ -1058,8 +1097,11 @@ protected:
      * Perform variable conversions for the variables in @p stag whose
      * values and sample time have been set in @p outs.  This method can be
      * used by subclasses to apply any variable conversions associated with
-     * the variables in the given SampleTag, using a general algorithm
-     * which loops over each value in each variable.  The min/max value
+     * the variables in the given SampleTag, using the SampleTag's
+     * ConversionPlan, which has the same results as Variable::convert()
+     * for each variable, but converts each variable with a single loop
+     * where the converter allows it.  Only the first
+     * outs->getDataLength() values are converted.  The min/max value
      * limits of a variable are applied also, so if a variable value is
      * converted but lies outside the min/max range, the value is set to
      * floatNAN.  Typically this can be the last step applied to the output
@@ -1227,6 +1269,8 @@ private:
 
     bool _duplicateIdOK;
 
+    bool _asyncProcessing;
+
     bool _applyVariableConversions;
 
     int _driverTimeTagUsecs;
@@ -26,6 +26,7 @@
 
 #include "FileSet.h"
 #include "Bzip2FileSet.h"
+#include "ZstdFileSet.h"
 
 #include "DSMConfig.h"
 #include "Site.h"
@@ -39,18 +40,18 @@ using namespace std;
 namespace n_u = nidas::util;
 
 FileSet::FileSet():  _fset(new nidas::util::FileSet()),
-     _name("FileSet"),_requester(0),_mount(0) {}
+     _name("FileSet"),_requester(0),_mount(0),_indexSeek(false) {}
 
 FileSet::FileSet(n_u::FileSet* fset):
     _fset(fset),
-    _name("FileSet"),_requester(0),_mount(0)
+    _name("FileSet"),_requester(0),_mount(0),_indexSeek(false)
 {
 }
 
 /* Copy constructor. */
 FileSet::FileSet(const FileSet& x):
     	IOChannel(x),_fset(x._fset->clone()),
-        _name(x._name),_requester(0),_mount(0)
+        _name(x._name),_requester(0),_mount(0),_indexSeek(x._indexSeek)
 {
     if (x._mount) _mount = new FsMount(*x._mount);
 }
@@ -155,7 +156,9 @@ void FileSet::fromDOMElement(const xercesc::DOMElement* node)
 			aname, aval);
 		setFileLengthSecs(val);
 	    }
-	    else if (aname == "compress");
+	    // handled by the compressing subclasses
+	    else if (aname == "compress" || aname == "threads" ||
+                     aname == "level");
 	    else throw n_u::InvalidParameterException(getName(),
 			"unrecognized attribute", aname);
 	}
@@ -178,34 +181,59 @@ void FileSet::fromDOMElement(const xercesc::DOMElement* node)
     }
 }
 
+namespace {
+
+enum compression_t { UNCOMPRESSED, BZIP2, ZSTD };
+
+compression_t
+compressionOf(const string& filename)
+{
+    if (filename.find(".bz2") != string::npos) return BZIP2;
+    if (filename.find(".zst") != string::npos) return ZSTD;
+    return UNCOMPRESSED;
+}
+
+/**
+ * @throws nidas::util::InvalidParameterException
+ */
+FileSet*
+newFileSet(compression_t comp, const string& filename)
+{
+    const char* msg = "";
+    switch (comp) {
+    case BZIP2:
+#ifdef HAVE_BZLIB_H
+        return new nidas::core::Bzip2FileSet();
+#endif
+        msg = "bzip2 compression/uncompression not supported. If you want it, install bzip2-devel, and rebuild with scons --config=force";
+        break;
+    case ZSTD:
+#ifdef HAVE_ZSTD_H
+        return new nidas::core::ZstdFileSet();
+#endif
+        msg = "zstd compression/uncompression not supported. If you want it, install libzstd-devel, and rebuild with scons --config=force";
+        break;
+    default:
+        return new nidas::core::FileSet();
+    }
+    throw n_u::InvalidParameterException(filename,"open",msg);
+}
+
+}
+
 /* static */
 FileSet* FileSet::getFileSet(const list<string>& filenames)
 {
-    int bzFile = -1;
+    compression_t comp = UNCOMPRESSED;
     list<string>::const_iterator fi = filenames.begin();
     for ( ; fi != filenames.end(); ++fi) {
-        if (fi->find(".bz2") != string::npos) {
-            if (bzFile == 0)
-                throw n_u::InvalidParameterException(*fi,"open","cannot mix bzipped and non-bzipped files");
-#ifdef HAVE_BZLIB_H
-            bzFile = 1;
-#else
-            throw n_u::InvalidParameterException(*fi,"open","bzip2 compression/uncompression not supported. If you want it, install bzip2-devel, and rebuild with scons --config=force");
-#endif
-        }
-        else {
-            if (bzFile == 1)
-                throw n_u::InvalidParameterException(*fi,"open","cannot mix bzipped and non-bzipped files");
-            bzFile = 0;
-        }
+        compression_t fcomp = compressionOf(*fi);
+        if (fi != filenames.begin() && fcomp != comp)
+            throw n_u::InvalidParameterException(*fi,"open","cannot mix files with different compression");
+        comp = fcomp;
     }
-    FileSet* fset;
-#ifdef HAVE_BZLIB_H
-    if (bzFile == 1) fset = new Bzip2FileSet();
-    else fset = new FileSet();
-#else
-    fset = new FileSet();
-#endif
+    FileSet* fset = newFileSet(comp,
+        filenames.empty() ? string() : filenames.front());
 
     fi = filenames.begin();
     for ( ; fi != filenames.end(); ++fi)
@@ -218,20 +246,7 @@ FileSet* FileSet::getFileSet(const list<string>& filenames)
 FileSet* 
 FileSet::createFileSet(const std::string& filename)
 {
-    FileSet* fset = 0;
-    if (filename.find(".bz2") != string::npos)
-    {
-#ifdef HAVE_BZLIB_H
-        fset = new nidas::core::Bzip2FileSet();
-#else
-        throw n_u::InvalidParameterException(filename, "open",
-            "bzip2 compression/uncompression not available.");
-#endif
-    }
-    else
-    {
-        fset = new nidas::core::FileSet();
-    }
+    FileSet* fset = newFileSet(compressionOf(filename), filename);
     fset->setFileName(filename);
     return fset;
 }
@@ -136,6 +136,44 @@ public:
         return _fset->read(buf,len);
     }
 
+    bool canReadMapped() const
+    {
+        return _fset->canReadMapped();
+    }
+
+    /**
+     * @throws nidas::util::IOException
+     **/
+    size_t readMapped(const char*& ptr, size_t len)
+    {
+        return _fset->readMapped(ptr,len);
+    }
+
+    /**
+     * Position the current file at @p offset bytes from its start.
+     *
+     * @throws nidas::util::IOException
+     **/
+    void seek(long long offset)
+    {
+        _fset->seek(offset);
+    }
+
+    /**
+     * Whether a SampleInputStream reading this FileSet should use the
+     * SampleIndex of each file, if one exists, to skip samples before
+     * the start time of the FileSet.  Default: false.
+     */
+    void setIndexSeek(bool val)
+    {
+        _indexSeek = val;
+    }
+
+    bool getIndexSeek() const
+    {
+        return _indexSeek;
+    }
+
     /**
      * @throws nidas::util::IOException
      **/
@@ -247,17 +285,18 @@ public:
 
     /**
      * Convienence function to return a pointer to a nidas::core::FileSet,
-     * given a list of files. If one or more of the files have a .bz2 suffix,
-     * the FileSet returned will be a nidas::core::Bzip2FileSet. Note that
-     * a Bzip2FileSet cannot be used to read a non-compressed file, so
-     * one should not mix compressed and non-compressed files in the list.
+     * given a list of files. If the files have a .bz2 or .zst suffix,
+     * the FileSet returned will be a nidas::core::Bzip2FileSet or
+     * nidas::core::ZstdFileSet. Note that a compressed FileSet cannot
+     * be used to read a non-compressed file, or one with a different
+     * compression, so all files in the list must have the same suffix.
      *
      * @throws nidas::util::InvalidParameterException
      **/
     static FileSet* getFileSet(const std::list<std::string>& filenames);
 
     /**
-     * Return a new FileSet or Bzip2FileSet, depending on the suffix of the
+     * Return a new FileSet, Bzip2FileSet or ZstdFileSet, depending on the suffix of the
      * filename, and call setFileName() with the given @p filename.
      */
     static FileSet* createFileSet(const std::string& filename);
@@ -283,6 +322,8 @@ protected:
 
     FsMount* _mount;
 
+    bool _indexSeek;
+
 private:
     /**
      * No assignment.
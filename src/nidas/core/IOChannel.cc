@@ -24,7 +24,7 @@
  ********************************************************************
 */
 
-#include <nidas/Config.h>   // HAVE_BZLIB_H
+#include <nidas/Config.h>   // HAVE_BZLIB_H, HAVE_ZSTD_H
 
 #include "IOChannel.h"
 #include "Socket.h"
@@ -55,14 +55,21 @@ IOChannel* IOChannel::createIOChannel(const xercesc::DOMElement* node)
 	string classAttr = xnode.getAttributeValue("class");
 	string fileAttr = n_u::Process::expandEnvVars(xnode.getAttributeValue("file"));
 	if (classAttr.length() == 0) {
+            if (fileAttr.find(".bz2") != string::npos) {
 #ifdef HAVE_BZLIB_H
-            if (fileAttr.find(".bz2") != string::npos) classAttr = "Bzip2FileSet";
-            else classAttr = "FileSet";
+                classAttr = "Bzip2FileSet";
 #else
-            if (fileAttr.find(".bz2") != string::npos)
                 throw n_u::InvalidParameterException(elname,fileAttr,"bzip2 compression/uncompression not supported. If you want it, install bzip2-devel, and rebuild with scons --config=force");
-            else classAttr = "FileSet";
 #endif
+            }
+            else if (fileAttr.find(".zst") != string::npos) {
+#ifdef HAVE_ZSTD_H
+                classAttr = "ZstdFileSet";
+#else
+                throw n_u::InvalidParameterException(elname,fileAttr,"zstd compression/uncompression not supported. If you want it, install libzstd-devel, and rebuild with scons --config=force");
+#endif
+            }
+            else classAttr = "FileSet";
         }
     	domable = DOMObjectFactory::createObject(classAttr);
     }
@@ -87,3 +94,10 @@ IOChannel::createFile(dsm_time_t /*t*/, bool /*exact*/)
 void
 IOChannel::addSampleTag(const nidas::core::SampleTag*)
 {}
+
+
+size_t
+IOChannel::readMapped(const char*& /*ptr*/, size_t /*len*/)
+{
+    throw nidas::util::IOException(getName(), "readMapped", "not supported");
+}
@@ -175,6 +175,23 @@ public:
      */
     virtual size_t read(void* buf, size_t len) = 0;
 
+    /**
+     * Whether this IOChannel supports readMapped().
+     */
+    virtual bool canReadMapped() const { return false; }
+
+    /**
+     * Read without copying: set @p ptr to up to @p len bytes of data
+     * held by the IOChannel, such as in a memory map of a file, and
+     * return the number of bytes.  The data remain valid until the next
+     * read() or readMapped(), or until the IOChannel is closed.
+     * The default implementation throws an IOException, and should
+     * only be called if canReadMapped() is true.
+     *
+     * @throws nidas::util::IOException
+     */
+    virtual size_t readMapped(const char*& ptr, size_t len);
+
     /**
      * Physical write method which must be implemented in derived
      * classes. Returns the number of bytes written, which
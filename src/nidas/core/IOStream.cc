@@ -25,7 +25,9 @@
 */
 
 #include "IOStream.h"
+#include "Sample.h"
 
+#include <climits>
 #include <iostream>
 
 #include <nidas/util/Logger.h>
@@ -36,17 +38,31 @@ using namespace std;
 
 namespace n_u = nidas::util;
 
+#ifndef IOV_MAX
+#define IOV_MAX 1024
+#endif
+
+namespace {
+    /**
+     * Maximum length of a mapped read.
+     */
+    const size_t MAPPED_READ_LEN = 1024 * 1024;
+}
+
 IOStream::IOStream(IOChannel& iochan,size_t blen):
-    _iochannel(iochan),_buffer(0),_head(0),_tail(0),
+    _iochannel(iochan),_buffer(0),_rbuf(0),_head(0),_tail(0),
     _buflen(0),_halflen(0),_eob(0),
-    _newInput(true),_nbytesIn(0),_nbytesOut(0),
-    _nEAGAIN(0)
+    _newInput(true),_mapped(false),_nbytesIn(0),_nbytesOut(0),
+    _nEAGAIN(0),_gatherIov(),_gatherSamples(),_gatherLen(0),
+    _gatherMinLength(0),_nbytesCopied(0),_nbytesGathered(0)
 {
     reallocateBuffer(blen * 2);
 }
 
 IOStream::~IOStream()
 {
+    for (unsigned int i = 0; i < _gatherSamples.size(); i++)
+        if (_gatherSamples[i]) _gatherSamples[i]->freeReference();
     delete [] _buffer;
 }
 
@@ -71,6 +87,7 @@ void IOStream::reallocateBuffer(size_t len)
         _buflen = len;
         _head = _tail = _buffer;
     }
+    _rbuf = _buffer;
     _eob = _buffer + _buflen;
     _halflen = _buflen / 2;
     DLOG(("%s: halflen=%d",getName().c_str(),_halflen));
@@ -88,9 +105,16 @@ size_t IOStream::read()
     // Avoid blocking on more data if there's already some in the buffer.
     if (l > 0) return 0;
 
-    _head = _tail = _buffer;
-
-    l = _iochannel.read(_head,_eob-_head);
+    if (_mapped) {
+        const char* ptr = 0;
+        l = _iochannel.readMapped(ptr,MAPPED_READ_LEN);
+        _rbuf = l > 0 ? const_cast<char*>(ptr) : _buffer;
+        _head = _tail = _rbuf;
+    }
+    else {
+        _head = _tail = _rbuf = _buffer;
+        l = _iochannel.read(_head,_eob-_head);
+    }
     _head += l;
     if (_iochannel.isNewInput()) {
         _newInput = true;
@@ -174,7 +198,7 @@ size_t IOStream::readUntil(void* buf, size_t len,char term)
  */
 size_t IOStream::backup(size_t len) throw()
 {
-    size_t maxbackup = _tail - _buffer;
+    size_t maxbackup = _tail - _rbuf;
     if (len > maxbackup)
     {
         WLOG(("backup(") << len << "): capped at " << maxbackup << " bytes.");
@@ -193,7 +217,7 @@ size_t IOStream::backup(size_t len) throw()
 
 size_t IOStream::backup() throw()
 {
-    return backup(_tail - _buffer);
+    return backup(_tail - _rbuf);
 }
 
 size_t
@@ -213,6 +237,9 @@ size_t
 IOStream::
 write(const struct iovec*iov, int nbufs, bool flush)
 {
+    // Copied buffers must be written after those in the gather list.
+    if (!_gatherIov.empty()) return write(iov,nbufs,flush,0);
+
     size_t l;
     int ibuf;
 
@@ -298,15 +325,146 @@ write(const struct iovec*iov, int nbufs, bool flush)
 
     // Return zero when the user buffers could not be copied, which happens
     // when writes for the data currently in the buffer don't succeed.
-    return (nbufs > 0) ? 0 : tlen;
+    if (nbufs > 0) return 0;
+    _nbytesCopied += tlen;
+    return tlen;
+}
+
+/*
+ * Atomic write, gathering large sample buffers by reference.
+ */
+size_t
+IOStream::
+write(const struct iovec*iov, int nbufs, bool flush, const Sample* samp)
+{
+    if (_gatherMinLength == 0) samp = 0;
+    if (!samp && _gatherIov.empty()) return write(iov,nbufs,flush);
+
+    int ibuf;
+
+    /* total length of user buffers, and the length to be copied */
+    size_t tlen = 0;
+    size_t clen = 0;
+    for (ibuf = 0; ibuf < nbufs; ibuf++) {
+        size_t l = iov[ibuf].iov_len;
+        tlen += l;
+        if (!samp || l < _gatherMinLength) clen += l;
+    }
+
+    if (_gatherIov.empty()) {
+        // Data copied by write(iov, nbufs, flush) goes out first.
+        if (_head > _tail) {
+            struct iovec pending;
+            pending.iov_base = _tail;
+            pending.iov_len = _head - _tail;
+            _gatherIov.push_back(pending);
+            _gatherSamples.push_back(0);
+            _gatherLen = pending.iov_len;
+        }
+        else _head = _tail = _buffer;
+    }
+
+    // Copied entries in the gather list point into _buffer, so it cannot
+    // be shifted or expanded until the list has been written.  As with
+    // copied writes, don't hold more than _buflen bytes, unless a single
+    // large sample is written to an empty list.
+    if (!_gatherIov.empty() &&
+        (_gatherLen + tlen > _buflen || clen > (size_t)(_eob - _head))) {
+        flushGather();
+        if (!_gatherIov.empty() &&
+            (_gatherLen + tlen > _buflen || clen > (size_t)(_eob - _head)))
+            return 0;
+    }
+    if (_gatherIov.empty() && clen > _buflen) reallocateBuffer(clen);
+
+    for (ibuf = 0; ibuf < nbufs; ibuf++) {
+        size_t l = iov[ibuf].iov_len;
+        if (l == 0) continue;
+        if (samp && l >= _gatherMinLength) {
+            samp->holdReference();
+            _gatherIov.push_back(iov[ibuf]);
+            _gatherSamples.push_back(samp);
+            _nbytesGathered += l;
+        }
+        else {
+            memcpy(_head,iov[ibuf].iov_base,l);
+            // append to the previous entry if it ends at _head
+            if (!_gatherIov.empty() && !_gatherSamples.back() &&
+                (char*)_gatherIov.back().iov_base +
+                    _gatherIov.back().iov_len == _head)
+                _gatherIov.back().iov_len += l;
+            else {
+                struct iovec copied;
+                copied.iov_base = _head;
+                copied.iov_len = l;
+                _gatherIov.push_back(copied);
+                _gatherSamples.push_back(0);
+            }
+            _head += l;
+            _nbytesCopied += l;
+        }
+        _gatherLen += l;
+    }
+
+    if (flush || _gatherLen >= _halflen || _gatherIov.size() >= (size_t)IOV_MAX)
+        flushGather();
+    return tlen;
+}
+
+size_t IOStream::flushGather()
+{
+    size_t nout = 0;
+
+    while (!_gatherIov.empty()) {
+        int n = std::min(_gatherIov.size(), (size_t)IOV_MAX);
+        size_t l;
+        try {
+            l = _iochannel.write(&_gatherIov.front(), n);
+        }
+        catch (const n_u::IOException& ioe) {
+            if (ioe.getErrno() == EAGAIN || ioe.getErrno() == EWOULDBLOCK) {
+                l = 0;
+                if ((_nEAGAIN++ % 100) == 0) {
+                    WLOG(("%s: nEAGAIN=%d, gathered len=%d",
+                          getName().c_str(),_nEAGAIN,_gatherLen));
+                }
+            }
+            else throw ioe;
+        }
+        if (l == 0) break;
+        addNumOutputBytes(l);
+        nout += l;
+        _gatherLen -= l;
+
+        // Release the entries which were completely written,
+        // and advance into a partially written one.
+        size_t i = 0;
+        for ( ; i < _gatherIov.size() && l >= _gatherIov[i].iov_len; i++) {
+            l -= _gatherIov[i].iov_len;
+            if (_gatherSamples[i]) _gatherSamples[i]->freeReference();
+        }
+        if (l > 0) {
+            _gatherIov[i].iov_base = (char*)_gatherIov[i].iov_base + l;
+            _gatherIov[i].iov_len -= l;
+        }
+        _gatherIov.erase(_gatherIov.begin(), _gatherIov.begin() + i);
+        _gatherSamples.erase(_gatherSamples.begin(),
+                             _gatherSamples.begin() + i);
+    }
+    if (_gatherIov.empty()) _head = _tail = _buffer;
+    return nout;
 }
 
 void IOStream::flush()
 {
     size_t l;
 
-    /* number of bytes in buffer */
-    size_t wlen = _head - _tail;
+    for (int ntry = 0; !_gatherIov.empty() && ntry < 5; ntry++)
+        flushGather();
+
+    /* number of bytes in buffer, which are in the gather list if
+     * it is not empty. */
+    size_t wlen = _gatherIov.empty() ? _head - _tail : 0;
 
     for (int ntry = 0; wlen > 0 && ntry < 5; ntry++) {
         try {
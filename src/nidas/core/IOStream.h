@@ -30,10 +30,12 @@
 #include "IOChannel.h"
 
 #include <iostream>
+#include <vector>
 
 namespace nidas { namespace core {
 
 class IOStream;
+class Sample;
 
 /**
  * A base class for buffering data.
@@ -75,6 +77,21 @@ public:
      **/
     size_t read();
 
+    /**
+     * If the IOChannel supports it, read data in place from the
+     * IOChannel with IOChannel::readMapped(), rather than copying
+     * it into the buffer of this IOStream. Data is then copied
+     * only once, by read(buf, len) or readBuf(), from the IOChannel,
+     * for example from a memory map of a file.
+     * Has no effect if IOChannel::canReadMapped() is false.
+     */
+    void setMappedInput(bool val)
+    {
+        _mapped = val && _iochannel.canReadMapped();
+    }
+
+    bool getMappedInput() const { return _mapped; }
+
     /**
      * Copy available bytes from the internal buffer to buf, returning
      * the number of bytes copied, which may be less then
@@ -128,6 +145,17 @@ public:
      */
     size_t backup() throw();
 
+    /**
+     * Discard the data in the buffer, after the IOChannel has been
+     * positioned at @p offset bytes from the start of the current
+     * input, and set the number of bytes read to @p offset.
+     */
+    void discardInput(long long offset) throw()
+    {
+        _head = _tail = _rbuf = _buffer;
+        _nbytesIn = offset;
+    }
+
     /**
      * Read into the user buffer until a terminating character
      * is found or len-1 bytes have been read. The buffer is NULL
@@ -166,11 +194,37 @@ public:
      **/
     size_t write(const struct iovec* iov, int nbufs, bool flush);
 
+    /**
+     * Atomic write of buffers which belong to a Sample.  If the gather
+     * length has been set with setGatherMinLength(), buffers of at least
+     * that length are not copied.  Instead a reference is held on the
+     * Sample and the buffers are later written directly from it, together
+     * with any copied buffers, with one IOChannel::write() of an iovec
+     * array.  Shorter buffers, such as sample headers, are copied as
+     * with write(iov, nbufs, flush).
+     * @param samp Sample containing any buffers of iov which are not
+     *      copied.  If null, all buffers are copied.
+     * @return Same as write(iov, nbufs, flush).
+     *
+     * @throws nidas::util::IOException
+     **/
+    size_t write(const struct iovec* iov, int nbufs, bool flush,
+                 const Sample* samp);
+
     /**
      * @throws nidas::util::IOException
      **/
     size_t write(const void*buf,size_t len,bool flush);
 
+    /**
+     * Minimum length of a Sample buffer which is gathered by reference
+     * in write(iov, nbufs, flush, samp), rather than copied.
+     * 0, the default, disables gathering.
+     */
+    void setGatherMinLength(size_t val) { _gatherMinLength = val; }
+
+    size_t getGatherMinLength() const { return _gatherMinLength; }
+
     /**
      * Flush buffer to physical device.
      * This is not done automatically by the destructor - the user
@@ -223,6 +277,22 @@ public:
         _nbytesOut += val;
     }
 
+    /**
+     * Number of bytes which have been copied into the
+     * output buffer of this IOStream.
+     */
+    long long getNumCopiedBytes() const {
+        return _nbytesCopied;
+    }
+
+    /**
+     * Number of bytes which have been gathered from samples
+     * for output without copying.
+     */
+    long long getNumGatheredBytes() const {
+        return _nbytesGathered;
+    }
+
 protected:
 
     IOChannel& _iochannel;
@@ -230,9 +300,26 @@ protected:
     void reallocateBuffer(size_t len);
 
 private:
+
+    /**
+     * Write the gather list with as few IOChannel::write() calls
+     * as possible, stopping if a write does not succeed.  Sample
+     * references are freed as their buffers are written.
+     * @return Number of bytes written.
+     *
+     * @throws nidas::util::IOException
+     **/
+    size_t flushGather();
+
     /** data buffer */
     char *_buffer;
 
+    /**
+     * Start of the data of the last read, which is _buffer unless
+     * it was a mapped read.
+     */
+    char* _rbuf;
+
     /** where we insert bytes into the buffer */
     char* _head;
 
@@ -256,12 +343,37 @@ private:
      */
     bool _newInput;
 
+    bool _mapped;
+
     long long _nbytesIn;
 
     long long _nbytesOut;
 
     size_t _nEAGAIN;
 
+    /**
+     * Buffers waiting to be written, in order. Copied buffers
+     * point into _buffer, others into a Sample.
+     */
+    std::vector<struct iovec> _gatherIov;
+
+    /**
+     * The Sample of each entry in _gatherIov, on which a reference
+     * is held, or null for copied buffers.
+     */
+    std::vector<const Sample*> _gatherSamples;
+
+    /**
+     * Number of bytes in the gather list not yet written.
+     */
+    size_t _gatherLen;
+
+    size_t _gatherMinLength;
+
+    long long _nbytesCopied;
+
+    long long _nbytesGathered;
+
     /** No copying */
     IOStream(const IOStream&);
 
@@ -200,7 +200,7 @@ void NearestResampler::connect(SampleSource* source)
                     assert(vi != _outVarIndices.end());
                     unsigned int outIndex = vi->second;
 
-                    map<dsm_sample_id_t,vector<unsigned int> >::iterator mi;
+                    SampleIdMap<vector<unsigned int> >::iterator mi;
                     if ((mi = _inmap.find(sampid)) == _inmap.end()) {
                         vector<unsigned int> tmp;
                         tmp.push_back(vindex);
@@ -262,7 +262,7 @@ bool NearestResampler::receive(const Sample* samp) throw()
         GET_DSM_ID(sampid) << ',' << GET_SPS_ID(sampid) << ", len=" << samp->getDataLength() << endl;
 #endif
 
-    map<dsm_sample_id_t,vector<unsigned int> >::iterator mi;
+    SampleIdMap<vector<unsigned int> >::iterator mi;
 
     if ((mi = _inmap.find(sampid)) == _inmap.end()) return false;
     const vector<unsigned int>& invec = mi->second;
@@ -29,6 +29,7 @@
 
 #include "Resampler.h"
 #include "SampleTag.h"
+#include "SampleIdMap.h"
 
 #include <vector>
 
@@ -179,17 +180,17 @@ private:
      * For each input sample, first index of variable data values to be
      * read.
      */
-    std::map<dsm_sample_id_t,std::vector<unsigned int> > _inmap;
+    SampleIdMap<std::vector<unsigned int> > _inmap;
 
     /**
      * For each input sample, length of variables to read.
      */
-    std::map<dsm_sample_id_t,std::vector<unsigned int> > _lenmap;
+    SampleIdMap<std::vector<unsigned int> > _lenmap;
 
     /**
      * For each input sample, index into output sample of each variable.
      */
-    std::map<dsm_sample_id_t,std::vector<unsigned int> > _outmap;
+    SampleIdMap<std::vector<unsigned int> > _outmap;
 
     unsigned int _ndataValues;
 
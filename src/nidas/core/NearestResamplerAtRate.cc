@@ -186,7 +186,7 @@ void NearestResamplerAtRate::connect(SampleSource* source)
                     assert(vi != _outVarIndices.end());
                     unsigned int outIndex = vi->second;
 
-                    map<dsm_sample_id_t,vector<unsigned int> >::iterator mi;
+                    SampleIdMap<vector<unsigned int> >::iterator mi;
                     if ((mi = _inmap.find(sampid)) == _inmap.end()) {
                         vector<unsigned int> tmp;
                         tmp.push_back(vindex);
@@ -246,7 +246,7 @@ bool NearestResamplerAtRate::receive(const Sample* samp) throw()
 
     dsm_sample_id_t sampid = samp->getId();
 
-    map<dsm_sample_id_t,vector<unsigned int> >::iterator mi;
+    SampleIdMap<vector<unsigned int> >::iterator mi;
 
     if ((mi = _inmap.find(sampid)) == _inmap.end()) return false;
     const vector<unsigned int>& invec = mi->second;
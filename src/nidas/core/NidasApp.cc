@@ -1922,6 +1922,7 @@ setFileSetTimes(const UTime& start, const UTime& end, FileSet* fset)
             << xtime.format(true, "%Y %m %d %H:%M:%S"));
     }
     fset->setStartTime(xtime);
+    fset->setIndexSeek(true);
   }
   if (end.isSet())
   {
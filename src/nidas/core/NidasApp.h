@@ -755,6 +755,21 @@ public:
     NidasAppArg DatasetName;
     NidasAppArg Clipping;
     NidasAppArg SorterLength;
+    NidasAppArg ProcessThreads{"--process-threads", "<n>",
+        "Number of threads calling the process() methods of the sensors.\n"
+        "Each sensor is processed by one thread, and the processed samples\n"
+        "are sorted together.  0 processes all sensors in the thread\n"
+        "of the raw sample sorter.",
+        "0"};
+    NidasAppArg AsyncProcessThreads{"--async-threads", "<n>",
+        "Number of threads processing the sensors with bursty, costly\n"
+        "processing, such as the image records of optical array probes,\n"
+        "apart from the other sensors.  0 processes them with the others.",
+        "0"};
+    NidasAppArg MappedInput{"--mmap", "",
+        "Read uncompressed data files through a memory map, copying\n"
+        "sample data directly from the mapped file.  The files must not\n"
+        "be growing while they are read."};
     NidasAppArg Precision{"--precision", "ndigits",
                           "Number of digits in floating point data values.  "
                           "Default 0 means 5 for floats, 10 for doubles",
@@ -1215,6 +1230,12 @@ public:
                       const nidas::util::UTime& end,
                       nidas::core::SampleOutputBase* output);
 
+    /**
+     * Set the start and end times of the FileSet @p fset, expanded if
+     * Clipping is enabled.  If @p start is set, also enable
+     * FileSet::setIndexSeek(), so that inputs skip directly to the
+     * start time in files which have a SampleIndex.
+     */
     void
     setFileSetTimes(const nidas::util::UTime& start,
                     const nidas::util::UTime& end,
@@ -40,11 +40,6 @@ using namespace std;
 
 namespace n_u = nidas::util;
 
-#ifdef MUTEX_PROTECT_REF_COUNTS
-/* static */
-// n_u::Mutex Sample::refLock;
-#endif
-
 #ifndef PROTECT_NSAMPLES
 /* static */
 int Sample::_nsamps(0);
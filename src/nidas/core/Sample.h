@@ -37,6 +37,7 @@
 #include <nidas/util/MutexCount.h>
 #include <nidas/linux/types.h>
 
+#include <atomic>
 #include <initializer_list>
 
 #include "sample_type_traits.h"
@@ -82,18 +83,6 @@ typedef unsigned int dsm_sample_id_t;
 #define SET_SPS_ID(tid,val) (((tid) & 0xffff0000) | ((val) & 0xffff)) 
 #define SET_SHORT_ID(tid,val) (((tid) & 0xffff0000) | ((val) & 0xffff)) 
 
-/**
- * Whether to use mutexes to make sure the reference count
- * increments and decrement-and-test operations are atomic.
- */
-#define MUTEX_PROTECT_REF_COUNTS
-
-/**
- * The gcc buildin atomic operations are not supported on arm, and
- * one must use -march=i686 for them to work on 32 bit x86.
- */
-// #define USE_ATOMIC_REF_COUNT
-
 /**
  * The header fields of a Sample: a time_tag, a data length field,
  * and an identifier.
@@ -185,7 +174,7 @@ class Sample {
 public:
 
     Sample(sampleType t = CHAR_ST) :
-        _header(t),_refCount(1),_refLock()
+        _header(t),_refCount(1)
     {
         ++_nsamps;
     }
@@ -330,19 +319,23 @@ public:
      * cast of the this pointer to a const so that holdReference
      * can be used on a const Sample.  The SamplePool class
      * supports Sample reference counting.
+     *
+     * The increment is a relaxed atomic operation: a thread can only
+     * add a reference to a sample it already holds, so no ordering
+     * with respect to other memory accesses is required here.
      */
     void holdReference() const {
-#ifdef USE_ATOMIC_REF_COUNT
-        __sync_add_and_fetch(&_refCount,1);
-#else
-#ifdef MUTEX_PROTECT_REF_COUNTS
-	_refLock.lock();
-#endif
-        _refCount++;
-#ifdef MUTEX_PROTECT_REF_COUNTS
-	_refLock.unlock();
-#endif
-#endif
+        _refCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * Current value of the reference count, for debugging and tests.
+     * The value may be stale by the time it is used if other threads
+     * hold references to this sample.
+     */
+    int getReferenceCount() const
+    {
+        return _refCount.load(std::memory_order_relaxed);
     }
 
     /**
@@ -355,13 +348,12 @@ protected:
     SampleHeader _header;
 
     /**
-     * The reference count.
+     * The reference count.  This used to be protected by a
+     * nidas::util::Mutex in every sample, which took a pthread lock on
+     * every hold and free and added the size of the mutex to each
+     * sample.  An atomic counter needs neither.
      */
-    mutable int _refCount;
-
-#ifdef MUTEX_PROTECT_REF_COUNTS
-    mutable nidas::util::Mutex _refLock;
-#endif
+    mutable std::atomic<int> _refCount;
 
     /**
      * Global count of the number of samples in use by a process.
@@ -645,24 +637,14 @@ template <class DataT>
 void SampleT<DataT>::freeReference() const
 {
     // if refCount is 0, put it back in the Pool.
-#ifdef USE_ATOMIC_REF_COUNT
-    // GCC 4.X atomic operations
-    int rc = __sync_sub_and_fetch(&_refCount,1);
+    // The release half of acq_rel publishes this thread's writes to
+    // the sample before another thread can see the count reach zero,
+    // and the acquire half makes the writes of all the other holders
+    // visible to the thread which returns the sample to the pool.
+    int rc = _refCount.fetch_sub(1, std::memory_order_acq_rel) - 1;
     assert(rc >= 0);
     if (rc == 0)
 	SamplePool<SampleT<DataT> >::getInstance()->putSample(this);
-#else
-#ifdef MUTEX_PROTECT_REF_COUNTS
-    _refLock.lock();
-#endif
-    bool ref0 = --_refCount == 0;
-    assert(_refCount >= 0);
-#ifdef MUTEX_PROTECT_REF_COUNTS
-    _refLock.unlock();
-#endif
-    if (ref0)
-	SamplePool<SampleT<DataT> >::getInstance()->putSample(this);
-#endif
 }
 
 }}	// namespace nidas namespace core
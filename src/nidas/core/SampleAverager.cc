@@ -148,7 +148,7 @@ void SampleAverager::connect(SampleSource* source)
                     assert(vi != _outVarIndices.end());
                     unsigned int outIndex = vi->second;
 
-                    map<dsm_sample_id_t,vector<unsigned int> >::iterator mi;
+                    SampleIdMap<vector<unsigned int> >::iterator mi;
                     if ((mi = _inmap.find(sampid)) == _inmap.end()) {
                         vector<unsigned int> tmp;
                         tmp.push_back(vindex);
@@ -250,7 +250,7 @@ bool SampleAverager::receive(const Sample* samp) throw()
 
     dsm_sample_id_t id = samp->getId();
 
-    map<dsm_sample_id_t,vector<unsigned int> >::iterator mi;
+    SampleIdMap<vector<unsigned int> >::iterator mi;
 
     if ((mi = _inmap.find(id)) == _inmap.end()) return false;
     const vector<unsigned int>& invec = mi->second;
@@ -29,6 +29,7 @@
 
 #include "Resampler.h"
 #include "SampleTag.h"
+#include "SampleIdMap.h"
 
 namespace nidas { namespace core {
 
@@ -176,11 +177,11 @@ private:
      */
     std::map<Variable*,unsigned int> _outVarIndices;
 
-    std::map<dsm_sample_id_t,std::vector<unsigned int> > _inmap;
+    SampleIdMap<std::vector<unsigned int> > _inmap;
 
-    std::map<dsm_sample_id_t,std::vector<unsigned int> > _lenmap;
+    SampleIdMap<std::vector<unsigned int> > _lenmap;
 
-    std::map<dsm_sample_id_t,std::vector<unsigned int> > _outmap;
+    SampleIdMap<std::vector<unsigned int> > _outmap;
 
     unsigned int _ndataValues;
 
@@ -241,6 +241,15 @@ public:
         return 0;
     }
 
+    void setBucketSort(bool)
+    {
+    }
+
+    bool getBucketSort() const
+    {
+        return false;
+    }
+
 private:
 
     /**
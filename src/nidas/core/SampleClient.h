@@ -54,6 +54,28 @@ public:
    */
   virtual bool receive(const Sample *s) = 0;
 
+  /**
+   * Method called to pass a batch of samples to this client, such as
+   * the samples aged off from a SampleSorter.  The samples are in
+   * the order they would have been passed to receive().
+   * As with receive(), the client must do a holdReference() on any
+   * sample that it keeps after returning.
+   * This default implementation calls receive() on each sample.
+   * Clients which can handle a batch more efficiently than
+   * one sample at a time should override it.
+   * Returns false if receive() would have returned false for
+   * any of the samples.
+   *
+   * @throw()
+   */
+  virtual bool receiveBatch(const Sample* const* samps, size_t nsamps)
+  {
+      bool ok = true;
+      for (size_t i = 0; i < nsamps; i++)
+          ok = receive(samps[i]) && ok;
+      return ok;
+  }
+
   /**
    * Ask that this SampleClient send out any buffered Samples that it
    * may be holding.
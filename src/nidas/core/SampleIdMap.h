@@ -0,0 +1,238 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+#ifndef NIDAS_CORE_SAMPLEIDMAP_H
+#define NIDAS_CORE_SAMPLEIDMAP_H
+
+#include "Sample.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+namespace nidas { namespace core {
+
+/**
+ * A map of values by sample id, for the lookups done on every sample,
+ * such as finding the clients of a sample in
+ * SampleSourceSupport::distribute().
+ *
+ * The entries are kept in a vector sorted by id, so iteration is in
+ * the same order as a std::map<dsm_sample_id_t,T>, and an
+ * open-addressing hash table of entry indices, with linear probing,
+ * is searched by find().  A successful find() usually touches one slot
+ * of the table and then the entry, instead of the log2(n) tree nodes
+ * of a std::map, which are scattered around the heap.
+ *
+ * insert() and erase() are O(n), since they shift the entries and
+ * rebuild the hash table. This is intended for maps which are built
+ * when connecting a source and then searched for every sample. Like
+ * a std::vector, and unlike a std::map, insert() and erase()
+ * invalidate iterators and references to the entries. They only
+ * copy-construct entries, never assign them.
+ */
+template <typename T>
+class SampleIdMap
+{
+public:
+
+    typedef dsm_sample_id_t key_type;
+
+    typedef T mapped_type;
+
+    typedef std::pair<dsm_sample_id_t, T> value_type;
+
+    typedef typename std::vector<value_type>::iterator iterator;
+
+    typedef typename std::vector<value_type>::const_iterator const_iterator;
+
+    SampleIdMap(): _entries(), _slots(), _shift(32) {}
+
+    iterator begin() { return _entries.begin(); }
+
+    iterator end() { return _entries.end(); }
+
+    const_iterator begin() const { return _entries.begin(); }
+
+    const_iterator end() const { return _entries.end(); }
+
+    size_t size() const { return _entries.size(); }
+
+    bool empty() const { return _entries.empty(); }
+
+    void clear()
+    {
+        _entries.clear();
+        _slots.clear();
+        _shift = 32;
+    }
+
+    iterator find(dsm_sample_id_t id)
+    {
+        return _entries.begin() + findIndex(id);
+    }
+
+    const_iterator find(dsm_sample_id_t id) const
+    {
+        return _entries.begin() + findIndex(id);
+    }
+
+    size_t count(dsm_sample_id_t id) const
+    {
+        return findIndex(id) < _entries.size() ? 1 : 0;
+    }
+
+    /**
+     * Insert an entry if its id is not already in the map.
+     * Returns an iterator pointing to the entry with that id,
+     * and whether it was inserted.
+     */
+    std::pair<iterator, bool> insert(const value_type& val)
+    {
+        size_t i = findIndex(val.first);
+        if (i < _entries.size())
+            return std::make_pair(_entries.begin() + i, false);
+
+        if (_entries.empty() || _entries.back().first < val.first) {
+            _entries.push_back(val);
+            i = _entries.size() - 1;
+        }
+        else {
+            iterator pos = std::lower_bound(_entries.begin(), _entries.end(),
+                val, lessId);
+            i = pos - _entries.begin();
+            std::vector<value_type> tmp;
+            tmp.reserve(_entries.size() + 1);
+            tmp.insert(tmp.end(), _entries.begin(), pos);
+            tmp.push_back(val);
+            tmp.insert(tmp.end(), pos, _entries.end());
+            _entries.swap(tmp);
+        }
+        rehash();
+        return std::make_pair(_entries.begin() + i, true);
+    }
+
+    /**
+     * Return a reference to the value for an id, inserting a
+     * default constructed value if the id is not in the map.
+     */
+    T& operator[](dsm_sample_id_t id)
+    {
+        size_t i = findIndex(id);
+        if (i < _entries.size()) return _entries[i].second;
+        return insert(value_type(id, T())).first->second;
+    }
+
+    void erase(iterator pos)
+    {
+        std::vector<value_type> tmp;
+        tmp.reserve(_entries.size() - 1);
+        tmp.insert(tmp.end(), _entries.begin(), pos);
+        tmp.insert(tmp.end(), pos + 1, _entries.end());
+        _entries.swap(tmp);
+        rehash();
+    }
+
+    size_t erase(dsm_sample_id_t id)
+    {
+        size_t i = findIndex(id);
+        if (i == _entries.size()) return 0;
+        erase(_entries.begin() + i);
+        return 1;
+    }
+
+private:
+
+    /**
+     * A slot in the hash table.  The id is kept with the
+     * index so that probing past other ids does not read
+     * the entries.
+     */
+    struct Slot
+    {
+        dsm_sample_id_t id;
+        unsigned int index;
+    };
+
+    static const unsigned int EMPTY = ~0u;
+
+    static bool lessId(const value_type& a, const value_type& b)
+    {
+        return a.first < b.first;
+    }
+
+    /**
+     * Fibonacci hash of an id to a slot.  Sample ids of one
+     * DSM differ mostly in their low bits, which the
+     * multiplication spreads into the high bits that are kept.
+     */
+    size_t hash(dsm_sample_id_t id) const
+    {
+        return (unsigned int)(id * 2654435769u) >> _shift;
+    }
+
+    /**
+     * Index of the entry for id, or _entries.size() if not found.
+     */
+    size_t findIndex(dsm_sample_id_t id) const
+    {
+        if (_slots.empty()) return _entries.size();
+        size_t mask = _slots.size() - 1;
+        for (size_t h = hash(id); ; h = (h + 1) & mask) {
+            const Slot& slot = _slots[h];
+            if (slot.index == EMPTY) return _entries.size();
+            if (slot.id == id) return slot.index;
+        }
+    }
+
+    /**
+     * Rebuild the hash table, at most half full.
+     */
+    void rehash()
+    {
+        unsigned int bits = 3;
+        while ((1u << bits) < 2 * _entries.size()) bits++;
+        _shift = 32 - bits;
+        Slot empty = { 0, EMPTY };
+        _slots.assign((size_t)1 << bits, empty);
+        size_t mask = _slots.size() - 1;
+        for (size_t i = 0; i < _entries.size(); i++) {
+            size_t h = hash(_entries[i].first);
+            while (_slots[h].index != EMPTY) h = (h + 1) & mask;
+            _slots[h].id = _entries[i].first;
+            _slots[h].index = i;
+        }
+    }
+
+    std::vector<value_type> _entries;
+
+    std::vector<Slot> _slots;
+
+    unsigned int _shift;
+};
+
+}}	// namespace nidas namespace core
+
+#endif
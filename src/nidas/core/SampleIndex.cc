@@ -0,0 +1,131 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "SampleIndex.h"
+
+#include <nidas/util/IOException.h>
+#include <nidas/util/ParseException.h>
+#include <nidas/util/Logger.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <sstream>
+
+using namespace nidas::core;
+using namespace std;
+
+namespace n_u = nidas::util;
+
+namespace {
+    const char* const INDEX_VERSION_LINE = "# NIDAS sample index 1";
+}
+
+SampleIndex::SampleIndex(): _blocks()
+{
+}
+
+bool SampleIndex::read(const string& path)
+{
+    _blocks.clear();
+    ifstream in(path.c_str());
+    if (!in) {
+        if (errno == ENOENT) return false;
+        throw n_u::IOException(path, "open", errno);
+    }
+
+    string line;
+    if (!getline(in, line) || line != INDEX_VERSION_LINE)
+        throw n_u::ParseException(path + ": not a NIDAS sample index");
+
+    for (int nline = 2; getline(in, line); nline++) {
+        istringstream ist(line);
+        Block block;
+        ist >> block.offset >> block.maxTime;
+        if (ist.fail()) {
+            ostringstream ost;
+            ost << path << ": line " << nline << ": cannot parse: " << line;
+            throw n_u::ParseException(ost.str());
+        }
+        _blocks.push_back(block);
+    }
+    return true;
+}
+
+long long SampleIndex::findOffset(dsm_time_t tt) const
+{
+    if (_blocks.empty()) return -1;
+    for (unsigned int i = 0; i < _blocks.size(); i++)
+        if (_blocks[i].maxTime >= tt) return _blocks[i].offset;
+    return _blocks.back().offset;
+}
+
+SampleIndexWriter::SampleIndexWriter(const string& path, long long blockUsecs):
+    _path(path),_out(),_blockUsecs(std::max(blockUsecs, 1LL)),
+    _blockStart(0),_nsamples(0),_block()
+{
+    _out.open(path.c_str(), ios::out | ios::trunc);
+    if (!_out) throw n_u::IOException(path, "open", errno);
+    _out << INDEX_VERSION_LINE << '\n';
+    DLOG(("opened sample index ") << path);
+}
+
+SampleIndexWriter::~SampleIndexWriter()
+{
+    try {
+        close();
+    }
+    catch (const n_u::IOException& e) {
+        WLOG(("%s", e.what()));
+    }
+}
+
+void SampleIndexWriter::addSample(const Sample* samp, long long offset)
+{
+    dsm_time_t tt = samp->getTimeTag();
+    if (_nsamples > 0 && tt >= _blockStart + _blockUsecs)
+        writeBlock();
+    if (_nsamples == 0) {
+        _block.offset = offset;
+        _blockStart = tt;
+    }
+    _block.maxTime = std::max(_block.maxTime, tt);
+    _nsamples++;
+}
+
+void SampleIndexWriter::writeBlock()
+{
+    _out << _block.offset << ' ' << _block.maxTime << endl;
+    if (!_out) throw n_u::IOException(_path, "write", errno);
+    _block = SampleIndex::Block();
+    _nsamples = 0;
+}
+
+void SampleIndexWriter::close()
+{
+    if (!_out.is_open()) return;
+    if (_nsamples > 0) writeBlock();
+    _out.close();
+}
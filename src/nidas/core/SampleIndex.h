@@ -0,0 +1,179 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+#ifndef NIDAS_CORE_SAMPLEINDEX_H
+#define NIDAS_CORE_SAMPLEINDEX_H
+
+#include "Sample.h"
+
+#include <climits>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace nidas { namespace core {
+
+/**
+ * A sidecar index of a NIDAS archive file, which records where blocks of
+ * samples start in the file, and the latest sample time in each block.
+ * With it a reader can skip directly to the samples at or after a time,
+ * instead of reading the file from its beginning.
+ *
+ * The index of an archive file is a text file of the same name with an
+ * ".idx" suffix, containing a version line and one line per block:
+ * @code
+ * # NIDAS sample index 1
+ * offset maxtime
+ * @endcode
+ * where offset is the byte offset in the archive file of the first
+ * sample header of the block, and maxtime is in microseconds
+ * since 1970 Jan 1 00:00 UTC.
+ *
+ * Samples in a raw archive are not necessarily in time order, so each
+ * block records its maximum sample time.  All samples before the first
+ * block whose maximum time is at or after a time are earlier than that
+ * time.
+ */
+class SampleIndex
+{
+public:
+
+    struct Block
+    {
+        Block(): offset(0),maxTime(LONG_LONG_MIN)
+        {}
+
+        long long offset;
+
+        dsm_time_t maxTime;
+    };
+
+    SampleIndex();
+
+    /**
+     * Path of the index of an archive file.
+     */
+    static std::string indexPath(const std::string& datapath)
+    {
+        return datapath + ".idx";
+    }
+
+    /**
+     * Read an index file.
+     * @return false if the file does not exist.
+     *
+     * @throws nidas::util::IOException
+     * @throws nidas::util::ParseException
+     **/
+    bool read(const std::string& path);
+
+    const std::vector<Block>& getBlocks() const { return _blocks; }
+
+    /**
+     * Offset in the archive file of the first block which may contain
+     * samples with time tags at or after tt.  If there are none, the
+     * offset of the last block, or -1 if there are no blocks.
+     */
+    long long findOffset(dsm_time_t tt) const;
+
+private:
+
+    std::vector<Block> _blocks;
+};
+
+/**
+ * Writes the SampleIndex of an archive file as samples are written to it.
+ * A block is started when a sample time is at least the block length
+ * after the time of the first sample of the current block.  Each block
+ * is written to the index when it is complete.
+ */
+class SampleIndexWriter
+{
+public:
+
+    /**
+     * Create the index file.
+     * @param blockUsecs Time length of each block, in microseconds.
+     *
+     * @throws nidas::util::IOException
+     **/
+    SampleIndexWriter(const std::string& path, long long blockUsecs);
+
+    /**
+     * Write the current block and close the index, logging any error.
+     */
+    ~SampleIndexWriter();
+
+    const std::string& getPath() const { return _path; }
+
+    /**
+     * Add a sample, whose header starts at offset in the archive file.
+     *
+     * @throws nidas::util::IOException
+     **/
+    void addSample(const Sample* samp, long long offset);
+
+    /**
+     * Write the current block and close the index.
+     *
+     * @throws nidas::util::IOException
+     **/
+    void close();
+
+private:
+
+    /**
+     * @throws nidas::util::IOException
+     **/
+    void writeBlock();
+
+    std::string _path;
+
+    std::ofstream _out;
+
+    long long _blockUsecs;
+
+    /**
+     * Time of the first sample in the current block.
+     */
+    dsm_time_t _blockStart;
+
+    /**
+     * Number of samples in the current block.
+     */
+    size_t _nsamples;
+
+    SampleIndex::Block _block;
+
+    /** No copying. */
+    SampleIndexWriter(const SampleIndexWriter&) = delete;
+
+    /** No assignment. */
+    SampleIndexWriter& operator=(const SampleIndexWriter&) = delete;
+};
+
+}}	// namespace nidas namespace core
+
+#endif
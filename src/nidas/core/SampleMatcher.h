@@ -9,10 +9,9 @@
 #define NIDAS_CORE_SAMPLEMATCHER_H
 
 #include "SampleTag.h"
+#include "SampleIdMap.h"
 #include <nidas/util/UTime.h>
 
-#include <unordered_map>
-
 namespace nidas { namespace core {
 
 
@@ -302,7 +301,7 @@ private:
     match_range(dsm_sample_id_t id, dsm_time_t tt,
                 const std::string& filename, RangeMatcher** rm_out = nullptr);
 
-    using id_lookup_t = std::unordered_map<dsm_sample_id_t, bool> ;
+    using id_lookup_t = SampleIdMap<bool>;
     using range_matches_t = std::vector<RangeMatcher>;
 
     range_matches_t _ranges;
@@ -273,6 +273,13 @@ const Parameter* SampleOutputBase::getParameter(const string& name) const
     return pi->second;
 }
 
+void SampleOutputBase::setIndexInterval(float val)
+{
+    if (val != 0.0)
+        throw n_u::InvalidParameterException(getName(), "indexInterval",
+                                             "not supported");
+}
+
 void SampleOutputBase::createNextFile(dsm_time_t tt)
 {
     // The very first file we use an exact time in the name,
@@ -333,6 +340,15 @@ void SampleOutputBase::fromDOMElement(const xercesc::DOMElement* node)
 		    	aname,aval);
 		setLatency(val);
 	    }
+	    else if (aname == "indexInterval") {
+		istringstream ist(aval);
+		float val;
+		ist >> val;
+		if (ist.fail() || val < 0.0)
+		    throw n_u::InvalidParameterException(getName(),
+		    	aname,aval);
+		setIndexInterval(val);
+	    }
 	    else throw n_u::InvalidParameterException(
 	    	string("SampleOutputBase: unrecognized attribute: ") + aname);
 	}
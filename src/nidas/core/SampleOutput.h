@@ -324,6 +324,16 @@ public:
 
     float getLatency() const { return _latency; }
 
+    /**
+     * Write a SampleIndex alongside each output file, with blocks of
+     * samples spanning this many seconds.  0 disables the index.
+     * The base implementation only accepts 0, since outputs must
+     * support it by keeping track of the file offset of each sample.
+     *
+     * @throws nidas::util::InvalidParameterException
+     **/
+    virtual void setIndexInterval(float val);
+
     /**
      * The sample output can have a time window which clips the samples
      * outside the window.  Only samples at or after @p startTime and
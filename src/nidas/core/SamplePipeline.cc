@@ -27,6 +27,7 @@
 #include "SamplePipeline.h"
 #include "SampleBuffer.h"
 #include "SampleSorter.h"
+#include "SensorProcessorPool.h"
 #include "DSMSensor.h"
 
 #include <nidas/util/Logger.h>
@@ -41,6 +42,8 @@ SamplePipeline::SamplePipeline() :
 	_name("SamplePipeline"),
         _rawMutex(),_rawSorter(0),
 	_procMutex(),_procSorter(0),
+        _processors(0),_processThreads(0),
+        _asyncProcessors(0),_asyncProcessThreads(0),
         _sampleTags(),_dsmConfigs(),
         _realTime(false),
         _rawSorterLength(0.0),
@@ -50,8 +53,12 @@ SamplePipeline::SamplePipeline() :
         _heapBlock(false),
         _keepStats(false),
         _rawLateSampleCacheSize(0),
-        _procLateSampleCacheSize(0)
+        _procLateSampleCacheSize(0),
+        _sorterBucketSort(false)
 {
+    _sorterBucketSort =
+        n_u::Logger::getScheme().getParameterT("sample_sorter_bucket_sort",
+                                               _sorterBucketSort);
 }
 
 SamplePipeline::~SamplePipeline()
@@ -60,11 +67,22 @@ SamplePipeline::~SamplePipeline()
     delete _rawSorter;
     _rawMutex.unlock();
 
+    // The processor threads pass samples to _procSorter.
     _procMutex.lock();
-     delete _procSorter;
+    delete _processors;
+    delete _asyncProcessors;
+    delete _procSorter;
     _procMutex.unlock();
 }
 
+void SamplePipeline::flush() throw()
+{
+    if (_rawSorter) _rawSorter->flush();
+    if (_processors) _processors->flush();
+    if (_asyncProcessors) _asyncProcessors->flush();
+    if (_procSorter) _procSorter->flush();
+}
+
 void SamplePipeline::interrupt()
 {
     _rawMutex.lock();
@@ -72,6 +90,8 @@ void SamplePipeline::interrupt()
     _rawMutex.unlock();
 
     _procMutex.lock();
+    if (_processors) _processors->interrupt();
+    if (_asyncProcessors) _asyncProcessors->interrupt();
     if (_procSorter) _procSorter->interrupt();
     _procMutex.unlock();
 }
@@ -94,6 +114,14 @@ void SamplePipeline::join() throw()
     _rawMutex.unlock();
 
     _procMutex.lock();
+    if (_processors) {
+        _processors->interrupt();
+        _processors->join();
+    }
+    if (_asyncProcessors) {
+        _asyncProcessors->interrupt();
+        _asyncProcessors->join();
+    }
     if (_procSorter) {
         if (_procSorter->isRunning()) {
             _procSorter->interrupt();
@@ -117,6 +145,7 @@ void SamplePipeline::rawinit()
             _rawSorter = new SampleSorter(_name + "RawSorter",true);
             _rawSorter->setLengthSecs(getRawSorterLength());
             _rawSorter->setLateSampleCacheSize(getRawLateSampleCacheSize());
+            _rawSorter->setBucketSort(getSorterBucketSort());
         }
         else {
             _rawSorter = new SampleBuffer(_name + "RawBuffer",true);
@@ -145,6 +174,7 @@ void SamplePipeline::procinit()
             _procSorter = new SampleSorter(_name + "ProcSorter",false);
             _procSorter->setLengthSecs(getProcSorterLength());
             _procSorter->setLateSampleCacheSize(getProcLateSampleCacheSize());
+            _procSorter->setBucketSort(getSorterBucketSort());
         }
         else {
             _procSorter = new SampleBuffer(_name + "ProcBuffer",false);
@@ -163,6 +193,60 @@ void SamplePipeline::procinit()
         }
         _procSorter->start();
     }
+
+    if ((getProcessThreads() > 0 || getAsyncProcessThreads() > 0) &&
+            getProcSorterLength() <= 0) {
+        // Without a sorter the samples from the threads would
+        // leave the pipeline out of time order.
+        WLOG(("%s: processed sorter length is 0, "
+              "processing sensors in the raw sorter thread",
+              _name.c_str()));
+        return;
+    }
+
+    // Keep the threads within half the sorter length, leaving the
+    // other half for differences between raw and processed time-tags.
+    dsm_time_t maxLag =
+        (dsm_time_t)(getProcSorterLength() * USECS_PER_SEC / 2);
+
+    if (!_processors && getProcessThreads() > 0) {
+        _processors = new SensorProcessorPool(_name, getProcessThreads());
+        _processors->setMaxLag(maxLag);
+        ILOG(("%s: processing sensors in %u threads, max lag %.3f sec",
+              _name.c_str(), _processors->getNumThreads(),
+              (double)maxLag / USECS_PER_SEC));
+    }
+    if (!_asyncProcessors && getAsyncProcessThreads() > 0) {
+        // A burst of image records is bounded by how far behind it
+        // puts the thread, not by the number of records.
+        _asyncProcessors = new SensorProcessorPool(_name + "Async",
+                                                   getAsyncProcessThreads());
+        _asyncProcessors->setMaxLag(maxLag);
+        _asyncProcessors->setDropWhenFull(getRealTime());
+        ILOG(("%s: processing asynchronous sensors in %u threads, "
+              "max lag %.3f sec%s", _name.c_str(),
+              _asyncProcessors->getNumThreads(),
+              (double)maxLag / USECS_PER_SEC,
+              (getRealTime() ? ", dropping samples when behind" : "")));
+    }
+}
+
+SampleClient* SamplePipeline::getProcessClient(DSMSensor* sensor)
+{
+    n_u::Autolock autolock(_procMutex);
+    if (_asyncProcessors && sensor->getAsyncProcessing())
+        return _asyncProcessors->getClient(sensor);
+    if (_processors) return _processors->getClient(sensor);
+    return sensor;
+}
+
+SampleClient* SamplePipeline::findProcessClient(DSMSensor* sensor)
+{
+    n_u::Autolock autolock(_procMutex);
+    if (_asyncProcessors && sensor->getAsyncProcessing())
+        return _asyncProcessors->findClient(sensor);
+    if (_processors) return _processors->findClient(sensor);
+    return sensor;
 }
 
 void SamplePipeline::connect(SampleSource* src) throw()
@@ -278,7 +362,7 @@ void SamplePipeline::addSampleClient(SampleClient* client) throw()
             VLOG(("addSampleClient sensor=") << sensor->getName());
             sensor->addSampleClient(_procSorter);
             stag = sensor->getRawSampleTag();
-            _rawSorter->addSampleClientForTag(sensor,stag);
+            _rawSorter->addSampleClientForTag(getProcessClient(sensor),stag);
         }
     }
     _procSorter->addSampleClient(client);
@@ -307,8 +391,10 @@ void SamplePipeline::removeSampleClient(SampleClient* client) throw()
             if (sensor) {
                 sensor->removeSampleClient(_procSorter);
                 stag = sensor->getRawSampleTag();
+                SampleClient* pclient = findProcessClient(sensor);
+                if (!pclient) continue;
                 _rawMutex.lock();
-                if (_rawSorter) _rawSorter->removeSampleClientForTag(sensor,stag);
+                if (_rawSorter) _rawSorter->removeSampleClientForTag(pclient,stag);
                 _rawMutex.unlock();
             }
         }
@@ -329,7 +415,7 @@ void SamplePipeline::addSampleClientForTag(SampleClient* client,
         sensor->addSampleClient(_procSorter);
 
         stag = sensor->getRawSampleTag();
-        _rawSorter->addSampleClientForTag(sensor,stag);
+        _rawSorter->addSampleClientForTag(getProcessClient(sensor),stag);
     }
 }
 
@@ -356,9 +442,12 @@ void SamplePipeline::removeSampleClientForTag(SampleClient* client,
     if (_procSorter->getClientCount() == 0) {
         sensor->removeSampleClient(_procSorter);
         stag = sensor->getRawSampleTag();
-        _rawMutex.lock();
-        if (_rawSorter) _rawSorter->removeSampleClientForTag(sensor,stag);
-        _rawMutex.unlock();
+        SampleClient* pclient = findProcessClient(sensor);
+        if (pclient) {
+            _rawMutex.lock();
+            if (_rawSorter) _rawSorter->removeSampleClientForTag(pclient,stag);
+            _rawMutex.unlock();
+        }
     }
 }
 
@@ -35,6 +35,7 @@ namespace nidas { namespace core {
 class DSMConfig;
 class DSMSensor;
 class SampleTag;
+class SensorProcessorPool;
 
 /**
  * SamplePipeline sorts samples that are coming from one
@@ -71,6 +72,30 @@ class SampleTag;
  * time-tags than the input raw samples, therefore they need
  * to be sorted again.
  *
+ * By default the sensor process() methods are called from the
+ * rawSorter thread. If setProcessThreads() is set to a non-zero value,
+ * the sensors are partitioned across that number of threads of a
+ * SensorProcessorPool, whose processed samples are merged by procSorter:
+ *
+ * rawSorter -> pool thread -> sensor -> procSorter -> processedSampleClients
+ *
+ * Sensors whose DSMSensor::getAsyncProcessing() is true, such as the
+ * optical array probes which process image records, can be processed by
+ * a separate pool of setAsyncProcessThreads() threads, so that a burst
+ * of their data does not delay the processed samples of the other
+ * sensors.  Their processed samples keep the time-tags set by the
+ * sensor and are merged by procSorter in the same way.
+ *
+ * procSorter passes samples which arrive later than its length out of
+ * time order, so the pools need a procSorter length greater than 0,
+ * and their threads are kept within half that length of the raw samples
+ * being passed to them, with SensorProcessorPool::setMaxLag().  The
+ * other half is a margin for the difference between the time-tags of
+ * the raw and processed samples.  When a thread falls further behind,
+ * the rawSorter waits for it to catch up, except that a real-time
+ * pipeline drops, and counts, the raw samples for the asynchronous pool,
+ * rather than delay the other sensors.
+ *
  * Multiple threads can be passing samples to the sorters. Thread exclusion
  * is enforced when passing the samples to the SampleClient::receive() methods
  * from either sorter, so the SampleClient::receive() methods don't have to worry
@@ -158,11 +183,7 @@ public:
      * Purge samples from the SampleSorters in this pipeline.
      * This call will block, until both sorters are empty.
      */
-    void flush() throw()
-    {
-        if (_rawSorter) _rawSorter->flush();
-        if (_procSorter) _procSorter->flush();
-    }
+    void flush() throw();
 
     /**
      * Interrupt the SampleSorters in this pipeline.
@@ -374,12 +395,79 @@ public:
         return _procLateSampleCacheSize;
     }
 
+    /**
+     * Call the process() methods of the sensors from this number of
+     * threads, each sensor being assigned to one thread.  If 0, the
+     * sensors are processed in the thread of the raw sorter.
+     * Must be set before the pipeline is connected. Requires a
+     * setProcSorterLength() greater than 0, otherwise the pool is not
+     * created and a warning is logged. Default: 0.
+     */
+    void setProcessThreads(unsigned int val)
+    {
+        _processThreads = val;
+    }
+
+    unsigned int getProcessThreads() const
+    {
+        return _processThreads;
+    }
+
+    /**
+     * Call the process() methods of the sensors whose
+     * DSMSensor::getAsyncProcessing() is true from a separate pool
+     * of this number of threads.  If 0, those sensors are processed
+     * like the others.  Must be set before the pipeline is connected.
+     * Like setProcessThreads(), requires a setProcSorterLength() greater
+     * than 0.  Default: 0.
+     */
+    void setAsyncProcessThreads(unsigned int val)
+    {
+        _asyncProcessThreads = val;
+    }
+
+    unsigned int getAsyncProcessThreads() const
+    {
+        return _asyncProcessThreads;
+    }
+
+    /**
+     * Sort samples in the raw and processed SampleSorters with a
+     * BucketSampleSet rather than a std::multiset.  The sorted order
+     * is the same.  See SampleSorter::setBucketSort(). Default: false,
+     * unless the log parameter "sample_sorter_bucket_sort" is set to 1.
+     * Must be set before the sorters are started by connect().
+     */
+    void setSorterBucketSort(bool val)
+    {
+        _sorterBucketSort = val;
+    }
+
+    bool getSorterBucketSort() const
+    {
+        return _sorterBucketSort;
+    }
+
 private:
 
     void rawinit();
 
     void procinit();
 
+    /**
+     * The SampleClient of the raw sorter for the raw samples of a
+     * sensor: either the sensor, or a client which passes the samples
+     * to a thread of _asyncProcessors or _processors.
+     */
+    SampleClient* getProcessClient(DSMSensor* sensor);
+
+    /**
+     * Like getProcessClient(), but without assigning the sensor
+     * to a thread.  Returns null if the sensor has not been assigned
+     * to the thread pool which would process it.
+     */
+    SampleClient* findProcessClient(DSMSensor* sensor);
+
     std::string _name;
 
     nidas::util::Mutex _rawMutex;
@@ -390,6 +478,23 @@ private:
 
     SampleThread* _procSorter;
 
+    /**
+     * Pool of threads calling DSMSensor::process(), or null.
+     * Protected by _procMutex.
+     */
+    SensorProcessorPool* _processors;
+
+    unsigned int _processThreads;
+
+    /**
+     * Pool of threads calling DSMSensor::process() of the sensors
+     * whose getAsyncProcessing() is true, or null.
+     * Protected by _procMutex.
+     */
+    SensorProcessorPool* _asyncProcessors;
+
+    unsigned int _asyncProcessThreads;
+
     std::list<const SampleTag*> _sampleTags;
 
     std::list<const DSMConfig*> _dsmConfigs;
@@ -414,6 +519,8 @@ private:
 
     unsigned int _procLateSampleCacheSize;
 
+    bool _sorterBucketSort;
+
     /**
      * No copying.
      */
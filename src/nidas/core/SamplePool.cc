@@ -25,6 +25,7 @@
 */
 
 #include "SamplePool.h"
+#include <nidas/util/Thread.h>
 
 #include <algorithm>
 
@@ -33,6 +34,11 @@ using namespace std;
 
 namespace n_u = nidas::util;
 
+std::string nidas::core::samplePoolThreadName()
+{
+    return n_u::Thread::currentName();
+}
+
 /* static */
 SamplePools* SamplePools::_instance = 0;
 
@@ -31,14 +31,66 @@
 #include "SampleLengthException.h"
 #include <nidas/util/Logger.h>
 
+#include <atomic>
 #include <cassert>
 #include <cstring> // memcpy()
+#include <string>
 #include <vector>
 #include <list>
 #include <iostream>
 
 namespace nidas { namespace core {
 
+/**
+ * Statistics of the cache kept by one thread in front of a SamplePool.
+ * The counters are cumulative since the thread first used the pool.
+ */
+struct SamplePoolThreadStats
+{
+    SamplePoolThreadStats():
+        threadName(),ngets(0),nputs(0),nrefills(0),ndrains(0),ncached(0)
+    {}
+
+    /**
+     * Name of the thread owning the cache.
+     */
+    std::string threadName;
+
+    /**
+     * Number of samples handed out from the cache without locking
+     * the pool.
+     */
+    long long ngets;
+
+    /**
+     * Number of samples returned to the cache without locking
+     * the pool.
+     */
+    long long nputs;
+
+    /**
+     * Number of times the pool was locked because the cache had no
+     * sample of the requested size.
+     */
+    long long nrefills;
+
+    /**
+     * Number of times the pool was locked because the cache was full.
+     */
+    long long ndrains;
+
+    /**
+     * Number of samples currently in the cache.
+     */
+    int ncached;
+};
+
+/**
+ * Return the name of the calling thread, for the statistics of its
+ * sample caches.
+ */
+std::string samplePoolThreadName();
+
 class SamplePoolInterface
 {
 public:
@@ -48,6 +100,18 @@ public:
     virtual int getNMediumSamplesIn() const = 0;
     virtual int getNLargeSamplesIn() const = 0;
 
+    /**
+     * Number of samples sitting in the per-thread caches of this pool,
+     * which are neither in the pool nor in use.
+     */
+    virtual int getNSamplesCached() const = 0;
+
+    /**
+     * Get the statistics of the per-thread caches of this pool, one
+     * entry for each thread which has gotten or put a sample.
+     */
+    virtual std::vector<SamplePoolThreadStats> getThreadStats() const = 0;
+
     /**
      * SamplePool singletons for various types and sizes are created and added
      * to the SamplePools class through their getInstance() method.  Those
@@ -108,6 +172,13 @@ private:
  * samples segregated by size.  A SamplePool can used
  * as a singleton, and accessed from anywhere, via the
  * getInstance() static member function.
+ *
+ * Each thread keeps a small cache of samples of each size in front of
+ * the pool, so that most calls to getSample() and putSample() do not
+ * lock the pool.  When a cache is empty it is refilled from the pool,
+ * and when it is full half of it is drained back to the pool, both
+ * under one acquisition of the pool lock.  The samples in a cache are
+ * returned to the pool when the thread exits.
  */
 template <typename SampleType>
 class SamplePool : public SamplePoolInterface
@@ -145,16 +216,70 @@ public:
 
     int getNSamplesAlloc() const { return _nsamplesAlloc; }
 
-    int getNSamplesOut() const { return _nsamplesOut; }
-
     int getNSmallSamplesIn() const { return _nsmall; }
 
     int getNMediumSamplesIn() const { return _nmedium; }
 
     int getNLargeSamplesIn() const { return _nlarge; }
 
+    /**
+     * Number of samples held by users of the pool, not counting
+     * those in the pool or in a thread cache.
+     */
+    int getNSamplesOut() const override;
+
+    int getNSamplesCached() const override;
+
+    std::vector<SamplePoolThreadStats> getThreadStats() const override;
+
+    /**
+     * Maximum number of samples of each size kept in a thread's cache.
+     */
+    const static int THREAD_CACHE_SIZE = 32;
+
 private:
 
+    /**
+     * Samples cached by one thread, in front of the pool.  Only the
+     * owning thread changes the sample arrays. The counters are
+     * atomic only so that getThreadStats() can read them from
+     * another thread.
+     */
+    class ThreadCache
+    {
+    public:
+        ThreadCache();
+
+        /**
+         * Return the cached samples to the pool on thread exit.
+         */
+        ~ThreadCache();
+
+        void clear();
+
+        /**
+         * Pool this cache is registered with, null if none.
+         */
+        SamplePool* _pool;
+
+        SampleType* _samples[3][THREAD_CACHE_SIZE];
+
+        int _n[3];
+
+        std::atomic<int> _ncached;
+
+        std::atomic<long long> _ngets;
+        std::atomic<long long> _nputs;
+        std::atomic<long long> _nrefills;
+        std::atomic<long long> _ndrains;
+
+        std::string _threadName;
+
+    private:
+        ThreadCache(const ThreadCache&) = delete;
+        ThreadCache& operator=(const ThreadCache&) = delete;
+    };
+
     SamplePool();
 
     ~SamplePool();
@@ -163,6 +288,53 @@ private:
 
     static nidas::util::Mutex _instanceLock;
 
+    /**
+     * Register the calling thread's cache with this pool.
+     */
+    ThreadCache& getThreadCache();
+
+    /**
+     * Move all samples in a cache back to the pool and unregister it.
+     * _poolLock must be held.
+     */
+    void detachCache(ThreadCache* cache);
+
+    /**
+     * Add to a cache counter.  Only the owning thread changes the
+     * counters, so a relaxed load and store is sufficient.
+     */
+    template <typename T, typename V>
+    static void addCount(std::atomic<T>& count, V val)
+    {
+        count.store(count.load(std::memory_order_relaxed) + val,
+            std::memory_order_relaxed);
+    }
+
+    /**
+     * Index of the small, medium or large pool for a number of elements.
+     */
+    static int sizeClass(unsigned int len)
+    {
+        if (len < SMALL_SAMPLE_MAXSIZE) return 0;
+        if (len < MEDIUM_SAMPLE_MAXSIZE) return 1;
+        return 2;
+    }
+
+    /**
+     * Get a sample from the pool.  _poolLock must be held.
+     */
+    SampleType *getSampleLocked(unsigned int len);
+
+    /**
+     * Push a sample onto one of the pools.  _poolLock must be held.
+     */
+    void putSampleLocked(const SampleType *);
+
+    /**
+     * Prepare a sample taken from a pool or cache for a new user.
+     */
+    static void initSample(SampleType* sample, unsigned int len);
+
     SampleType *getSample(SampleType** vec,int *veclen, unsigned int len);
     void putSample(const SampleType *,SampleType*** vecp,int *veclen, int* nalloc);
 
@@ -174,7 +346,12 @@ private:
     int _mediumSize;
     int _largeSize;
 
-    nidas::util::Mutex _poolLock;
+    mutable nidas::util::Mutex _poolLock;
+
+    /**
+     * Registered thread caches.
+     */
+    std::list<ThreadCache*> _caches;
 
     /**
      * maximum number of elements in a small sample
@@ -201,6 +378,10 @@ public:
     int _nmedium;
     int _nlarge;
 
+    /**
+     * Number of samples outside of the pool, including those in
+     * thread caches.
+     */
     int _nsamplesOut;
 
     int _nsamplesAlloc;
@@ -215,6 +396,36 @@ template<class SampleType>
 template<class SampleType>
     nidas::util::Mutex SamplePool<SampleType>::_instanceLock = nidas::util::Mutex();
 
+template<class SampleType>
+SamplePool<SampleType>::ThreadCache::ThreadCache():
+    _pool(0),_samples(),_n(),_ncached(0),
+    _ngets(0),_nputs(0),_nrefills(0),_ndrains(0),_threadName()
+{
+}
+
+template<class SampleType>
+SamplePool<SampleType>::ThreadCache::~ThreadCache()
+{
+    // _instanceLock keeps the pool from being deleted while
+    // the samples are handed back.
+    nidas::util::Synchronized pooler(_instanceLock);
+    if (_pool) {
+        nidas::util::Synchronized locker(_pool->_poolLock);
+        _pool->detachCache(this);
+    }
+}
+
+template<class SampleType>
+void SamplePool<SampleType>::ThreadCache::clear()
+{
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < _n[c]; i++) delete _samples[c][i];
+        _n[c] = 0;
+    }
+    _ncached.store(0, std::memory_order_relaxed);
+    _pool = 0;
+}
+
 /* static */
 template<class SampleType>
 SamplePool<SampleType> *SamplePool<SampleType>::getInstance()
@@ -242,7 +453,7 @@ template<class SampleType>
     SamplePool<SampleType>::SamplePool():
         _smallSamples(0), _mediumSamples(0), _largeSamples(0),
         _smallSize(0), _mediumSize(0), _largeSize(0),
-        _poolLock(),
+        _poolLock(),_caches(),
         _nsmall(0),_nmedium(0),_nlarge(0),_nsamplesOut(0),_nsamplesAlloc(0)
 {
     // Initial size of pool of small samples around 16K bytes
@@ -267,6 +478,12 @@ template<class SampleType>
 
 template<class SampleType>
 SamplePool<SampleType>::~SamplePool() {
+    // The owning threads of any remaining caches should no longer be
+    // using this pool, so delete their samples here.
+    typename std::list<ThreadCache*>::iterator ci = _caches.begin();
+    for ( ; ci != _caches.end(); ++ci) (*ci)->clear();
+    _caches.clear();
+
     int i;
     for (i = 0; i < _nsmall; i++) delete _smallSamples[i];
     delete [] _smallSamples;
@@ -277,12 +494,152 @@ SamplePool<SampleType>::~SamplePool() {
     SamplePools::getInstance()->removePool(this);
 }
 
+template<class SampleType>
+typename SamplePool<SampleType>::ThreadCache&
+SamplePool<SampleType>::getThreadCache()
+{
+    // A function-local thread_local, since gcc does not handle
+    // thread_local static data members of class templates.
+    static thread_local ThreadCache cache;
+    if (cache._pool != this) {
+        nidas::util::Synchronized pooler(_poolLock);
+        cache._pool = this;
+        cache._threadName = samplePoolThreadName();
+        _caches.push_back(&cache);
+    }
+    return cache;
+}
+
+template<class SampleType>
+void SamplePool<SampleType>::detachCache(ThreadCache* cache)
+{
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < cache->_n[c]; i++)
+            putSampleLocked(cache->_samples[c][i]);
+        cache->_n[c] = 0;
+    }
+    cache->_ncached.store(0, std::memory_order_relaxed);
+    cache->_pool = 0;
+    _caches.remove(cache);
+}
+
+template<class SampleType>
+int SamplePool<SampleType>::getNSamplesOut() const
+{
+    nidas::util::Synchronized pooler(_poolLock);
+    int nout = _nsamplesOut;
+    typename std::list<ThreadCache*>::const_iterator ci = _caches.begin();
+    for ( ; ci != _caches.end(); ++ci)
+        nout -= (*ci)->_ncached.load(std::memory_order_relaxed);
+    return nout;
+}
+
+template<class SampleType>
+int SamplePool<SampleType>::getNSamplesCached() const
+{
+    nidas::util::Synchronized pooler(_poolLock);
+    int ncached = 0;
+    typename std::list<ThreadCache*>::const_iterator ci = _caches.begin();
+    for ( ; ci != _caches.end(); ++ci)
+        ncached += (*ci)->_ncached.load(std::memory_order_relaxed);
+    return ncached;
+}
+
+template<class SampleType>
+std::vector<SamplePoolThreadStats>
+SamplePool<SampleType>::getThreadStats() const
+{
+    nidas::util::Synchronized pooler(_poolLock);
+    std::vector<SamplePoolThreadStats> stats;
+    typename std::list<ThreadCache*>::const_iterator ci = _caches.begin();
+    for ( ; ci != _caches.end(); ++ci) {
+        const ThreadCache* cache = *ci;
+        SamplePoolThreadStats ts;
+        ts.threadName = cache->_threadName;
+        ts.ngets = cache->_ngets.load(std::memory_order_relaxed);
+        ts.nputs = cache->_nputs.load(std::memory_order_relaxed);
+        ts.nrefills = cache->_nrefills.load(std::memory_order_relaxed);
+        ts.ndrains = cache->_ndrains.load(std::memory_order_relaxed);
+        ts.ncached = cache->_ncached.load(std::memory_order_relaxed);
+        stats.push_back(ts);
+    }
+    return stats;
+}
+
 template<class SampleType>
 SampleType* SamplePool<SampleType>::getSample(unsigned int len)
 {
+    ThreadCache& cache = getThreadCache();
+    int c = sizeClass(len);
+    int n = cache._n[c];
+
+    if (n > 0) {
+        SampleType* sample = cache._samples[c][--n];
+        cache._n[c] = n;
+        initSample(sample, len);
+        addCount(cache._ncached, -1);
+        addCount(cache._ngets, 1);
+        return sample;
+    }
+
+    addCount(cache._nrefills, 1);
 
     nidas::util::Synchronized pooler(_poolLock);
 
+    SampleType* sample = getSampleLocked(len);
+
+    // Refill the cache with up to half its size from the matching pool,
+    // leaving samples for other threads if the pool is low.
+    SampleType** vec = (c == 0 ? _smallSamples :
+            (c == 1 ? _mediumSamples : _largeSamples));
+    int* np = (c == 0 ? &_nsmall : (c == 1 ? &_nmedium : &_nlarge));
+    int nrefill = std::min(*np / 2, THREAD_CACHE_SIZE / 2);
+    for (int i = 0; i < nrefill; i++)
+        cache._samples[c][i] = vec[--(*np)];
+    cache._n[c] = nrefill;
+    _nsamplesOut += nrefill;
+    addCount(cache._ncached, nrefill);
+    return sample;
+}
+
+template<class SampleType>
+void SamplePool<SampleType>::initSample(SampleType* sample, unsigned int len)
+{
+    if (sample->getAllocLength() < len) sample->allocateData(len);
+#ifndef NDEBUG
+    else if (sample->getAllocLength() > len) {
+        // If the sample has been previously allocated, and its length
+        // is at least one more than we need, set the one-past-the-end
+        // data value to a noticable value. Then if a buggy process method
+        // reads past the end of a sample, they'll get a value that should
+        // raise questions about the results, rather than something
+        // that might go unnoticed.
+
+        // valgrind won't complain in these situations unless one reads
+        // past the allocated size.
+
+        // For character data (sizeof(T) == 1), we'll use up to
+        // 4 '\x80's as the weird value.
+        // For larger sizes, we'll use floatNAN. This will convert to
+        // 0 for integer samples.
+
+        extern const float floatNAN;
+
+        if (sample->sizeofDataType() == 1) {
+            static const char weird[4] = { '\x80','\x80','\x80','\x80' };
+            int nb = std::min(4U,sample->getAllocLength()-len);
+            memcpy((char*)sample->getVoidDataPtr()+len,weird,nb);
+        }
+        else sample->setDataValue(len,floatNAN);  // NAN converted to the data type.
+    }
+#endif
+    sample->setDataLength(len);
+    sample->holdReference();
+}
+
+template<class SampleType>
+SampleType* SamplePool<SampleType>::getSampleLocked(unsigned int len)
+{
     // Shouldn't get back more than I've dealt out
     // If we do, that's an indication that reference counting
     // is screwed up.
@@ -320,37 +677,8 @@ SampleType* SamplePool<SampleType>::getSample(SampleType** vec,
 
     if (i >= 0) {
         sample = vec[i];
-        if (sample->getAllocLength() < len) sample->allocateData(len);
-#ifndef NDEBUG
-        else if (sample->getAllocLength() > len) {
-            // If the sample has been previously allocated, and its length
-            // is at least one more than we need, set the one-past-the-end
-            // data value to a noticable value. Then if a buggy process method
-            // reads past the end of a sample, they'll get a value that should
-            // raise questions about the results, rather than something
-            // that might go unnoticed.
-
-            // valgrind won't complain in these situations unless one reads
-            // past the allocated size.
-
-            // For character data (sizeof(T) == 1), we'll use up to
-            // 4 '\x80's as the weird value.
-            // For larger sizes, we'll use floatNAN. This will convert to
-            // 0 for integer samples.
-            
-            extern const float floatNAN;
-
-            if (sample->sizeofDataType() == 1) {
-                static const char weird[4] = { '\x80','\x80','\x80','\x80' };
-                int nb = std::min(4U,sample->getAllocLength()-len);
-                memcpy((char*)sample->getVoidDataPtr()+len,weird,nb);
-            }
-            else sample->setDataValue(len,floatNAN);  // NAN converted to the data type.
-        }
-#endif
-        sample->setDataLength(len);
+        initSample(sample, len);
         *n = i;
-        sample->holdReference();
         _nsamplesOut++;
         return sample;
     }
@@ -367,7 +695,29 @@ SampleType* SamplePool<SampleType>::getSample(SampleType** vec,
 template<class SampleType>
 void SamplePool<SampleType>::putSample(const SampleType *sample) {
 
-    nidas::util::Synchronized pooler(_poolLock);
+    ThreadCache& cache = getThreadCache();
+    int c = sizeClass(sample->getAllocLength());
+
+    if (cache._n[c] == THREAD_CACHE_SIZE) {
+        // Drain the older half of the cache back to the pool.
+        addCount(cache._ndrains, 1);
+        const int ndrain = THREAD_CACHE_SIZE / 2;
+
+        nidas::util::Synchronized pooler(_poolLock);
+        for (int i = 0; i < ndrain; i++)
+            putSampleLocked(cache._samples[c][i]);
+        ::memmove(cache._samples[c], cache._samples[c] + ndrain,
+            (THREAD_CACHE_SIZE - ndrain) * sizeof(SampleType*));
+        cache._n[c] -= ndrain;
+        addCount(cache._ncached, -ndrain);
+    }
+    cache._samples[c][cache._n[c]++] = (SampleType*) sample;
+    addCount(cache._ncached, 1);
+    addCount(cache._nputs, 1);
+}
+
+template<class SampleType>
+void SamplePool<SampleType>::putSampleLocked(const SampleType *sample) {
 
     assert(_nsamplesOut >= 0);
     assert(_nsamplesAlloc == _nsmall + _nmedium + _nlarge + _nsamplesOut);
@@ -464,17 +464,84 @@ void MessageStreamScanner::warnBackwardsStepTimeTag(
         n_u::UTime(badtt).format(true,"%Y %b %d %H:%M:%S.%3f").c_str()));
 }
 
+void MessageStreamScanner::adjustSampleLengthAlloc(unsigned int len)
+{
+    // adjust size of next sample to request, if it needs changing
+    if (len > _sampleLengthAlloc) {
+        _sampleLengthAlloc = std::min(len + 16,MAX_MESSAGE_STREAM_SAMPLE_SIZE);
+        _nsmallSamples = 0;
+    }
+    // check for 100 samples in a row less than _sampleLengthAlloc - 64
+    else if (_sampleLengthAlloc > 64 && len < _sampleLengthAlloc - 64) {
+        if (++_nsmallSamples > 100) {
+            _sampleLengthAlloc -= 64;
+            _nsmallSamples = 0;
+        }
+    }
+    else _nsmallSamples = 0;
+}
+
+int MessageStreamScanner::matchSeparatorEOM(char c, int cnt) const
+{
+    // if the character matches the current character
+    // in the end of message separator string.
+    if (c == _separator[cnt]) return cnt + 1;
+
+    // no match of current character to EOM string.
+    // check for match at beginning of separator string
+    //
+    // Also handle situation where there are repeated character
+    // sequences in the separator.  For example: a separator
+    // sequence of xxy, and the input is xxxy.  When you get
+    // a failure matching the third character, you shouldn't start
+    // completely over scanning for xxy starting at the third x,
+    // but should scan for xy starting at the third x.
+    // This also happens with a separator of xyxyz and an input of xyxyxyz.
+    // One can never tell what kind of separator sequence someone might think of...
+    if (cnt > 0) {
+        // initial character repeated
+        if (cnt > 1 && !memcmp(_separator,_separator+1,cnt-1) &&
+            c == _separator[cnt-1]);  // leave cnt as is
+        else {
+            // possible repeated sequence
+            int nrep = cnt / 2;   // length of seq
+            if (!(cnt % 2) && !memcmp(_separator,_separator+nrep,nrep) &&
+                c == _separator[cnt = nrep]) cnt++;
+            // start scan over
+            else if (c == _separator[cnt = 0]) cnt++;
+        }
+    }
+    return cnt;
+}
+
+const char* MessageStreamScanner::findSeparatorEOM(const char* cp,
+        const char* eob) const
+{
+    int cnt = 0;
+    while (cp < eob) {
+        if (cnt == 0) {
+            // skip to the next possible start of the separator
+            cp = (const char*) ::memchr(cp, _separator[0], eob - cp);
+            if (!cp) return 0;
+        }
+        cnt = matchSeparatorEOM(*cp++, cnt);
+        if (cnt == _separatorLen) return cp;
+    }
+    return 0;
+}
+
 Sample* MessageStreamScanner::nextSampleSepEOM(DSMSensor* sensor)
 {
     Sample* result = 0;
 
+    // extra space needed for null terminator
+    int nterm = getNullTerminate() ? 1 : 0;
+
     if (!_osamp) {
         // first call, or just sent out last sample
         // Wait to allocate next sample, and set its timetag when
         // we have characters.
         if (_buftail == _bufhead) return 0;
-	_osamp = getSample<char>(_sampleLengthAlloc);
-        _osamp->setId(sensor->getId());
         dsm_time_t ttag = _tfirstchar + _buftail * getUsecsPerByte();
 
         if (ttag <= _lastSampleTime) {
@@ -490,6 +557,36 @@ Sample* MessageStreamScanner::nextSampleSepEOM(DSMSensor* sensor)
             }
         }
         _lastSampleTime = ttag;
+
+        // If the whole message is in the buffer, copy it once
+        // into a sample that is large enough for it. Asking for at
+        // least _sampleLengthAlloc lets the pool hand back samples
+        // without reallocating their data.
+        const char* som = _buffer + _buftail;
+        const char* eob = _buffer + _bufhead;
+        if (eob - som >= (int)getMessageLength()) {
+            const char* eom = findSeparatorEOM(som + getMessageLength(), eob);
+            // eom is null if the separator is not in the buffer.
+            unsigned int len = 0;
+            if (eom) len = eom - som;
+            if (eom && len + nterm <= MAX_MESSAGE_STREAM_SAMPLE_SIZE) {
+                SampleT<char>* samp =
+                    getSample<char>(std::max(len + nterm,_sampleLengthAlloc));
+                samp->setId(sensor->getId());
+                samp->setTimeTag(ttag);
+                char* dp = samp->getDataPtr();
+                ::memcpy(dp,som,len);
+                if (nterm) dp[len] = '\0';
+                samp->setDataLength(len + nterm);
+                addSampleToStats(len + nterm);
+                adjustSampleLengthAlloc(len + nterm);
+                _buftail += len;
+                return samp;
+            }
+        }
+
+	_osamp = getSample<char>(_sampleLengthAlloc);
+        _osamp->setId(sensor->getId());
         _osamp->setTimeTag(ttag);
 	_outSampDataPtr = (char*) _osamp->getVoidDataPtr();
         _outSampLengthAlloc = _osamp->getAllocByteLength();
@@ -515,73 +612,44 @@ Sample* MessageStreamScanner::nextSampleSepEOM(DSMSensor* sensor)
         }
     }
 
-    // extra space needed for null terminator before processing next character
-    int nterm = getNullTerminate() ? 1 : 0;
-
-    // now loop through character by character, until we find the 
+    // now loop through the characters until we find the
     // separator string.
     while (_buftail < _bufhead) {
 
         if (_outSampRead + 1 + nterm > _outSampLengthAlloc &&
                 (result = requestBiggerSample(1 + nterm))) return result;
 
+        if (_separatorCnt == 0) {
+            // Copy the characters before the next possible start of
+            // the separator, as far as there is room in the sample.
+            const char* cp = _buffer + _buftail;
+            const char* sp = (const char*) ::memchr(cp, _separator[0],
+                    _bufhead - _buftail);
+            unsigned int nc = (sp ? sp : _buffer + _bufhead) - cp;
+            nc = std::min(nc, _outSampLengthAlloc - nterm - _outSampRead);
+            if (nc > 0) {
+                ::memcpy(_outSampDataPtr+_outSampRead,cp,nc);
+                _outSampRead += nc;
+                _buftail += nc;
+                continue;
+            }
+        }
+
         char c = _buffer[_buftail++];
         _outSampDataPtr[_outSampRead++] = c;
 
-        // if the character matches the current character
-        // in the end of message separator string.
-        if (c == _separator[_separatorCnt]) {
-            // character matched
-            if (++_separatorCnt == _separatorLen) {   // sample is ready
-                if (getNullTerminate())
-                    _outSampDataPtr[_outSampRead++] = '\0';
-                _osamp->setDataLength(_outSampRead);
-                addSampleToStats(_outSampRead);
-
-                result = _osamp;
-                _osamp = 0;
-
-                // adjust size of next sample to request, if it needs changing
-                if (_outSampRead > _sampleLengthAlloc) {
-                    _sampleLengthAlloc = std::min(_outSampRead + 16,MAX_MESSAGE_STREAM_SAMPLE_SIZE);
-                    _nsmallSamples = 0;
-                }
-                // check for 100 samples in a row less than _sampleLengthAlloc - 64
-                else if (_sampleLengthAlloc > 64 && _outSampRead < _sampleLengthAlloc - 64) {
-                    if (++_nsmallSamples > 100) {
-                        _sampleLengthAlloc -= 64;
-                        _nsmallSamples = 0;
-                    }
-                }
-                else _nsmallSamples = 0;
-                break;
-            }
-        }
-        else {
-            // no match of current character to EOM string.
-            // check for match at beginning of separator string
-            //
-            // Also handle situation where there are repeated character
-            // sequences in the separator.  For example: a separator
-            // sequence of xxy, and the input is xxxy.  When you get
-            // a failure matching the third character, you shouldn't start
-            // completely over scanning for xxy starting at the third x,
-            // but should scan for xy starting at the third x.
-            // This also happens with a separator of xyxyz and an input of xyxyxyz.
-            // One can never tell what kind of separator sequence someone might think of...
-            if (_separatorCnt > 0) {
-                // initial character repeated
-                if (_separatorCnt > 1 && !memcmp(_separator,_separator+1,_separatorCnt-1) &&
-                    c == _separator[_separatorCnt-1]);  // leave _separatorCnt as is
-                else {
-                    // possible repeated sequence
-                    int nrep = _separatorCnt / 2;   // length of seq
-                    if (!(_separatorCnt % 2) && !memcmp(_separator,_separator+nrep,nrep) &&
-                        c == _separator[_separatorCnt = nrep]) _separatorCnt++;
-                    // start scan over
-                    else if (c == _separator[_separatorCnt = 0]) _separatorCnt++;
-                }
-            }
+        if ((_separatorCnt = matchSeparatorEOM(c, _separatorCnt)) ==
+                _separatorLen) {   // sample is ready
+            if (getNullTerminate())
+                _outSampDataPtr[_outSampRead++] = '\0';
+            _osamp->setDataLength(_outSampRead);
+            addSampleToStats(_outSampRead);
+
+            result = _osamp;
+            _osamp = 0;
+
+            adjustSampleLengthAlloc(_outSampRead);
+            break;
         }
     }
     return result;
@@ -670,11 +738,28 @@ Sample* MessageStreamScanner::nextSampleSepBOM(DSMSensor* sensor)
     // At this point we are currently scanning
     // for the message separator at the beginning of the next message.
     for (;_buftail < _bufhead;) {
-        char c = _buffer[_buftail];
 
         if (_outSampRead + space > _outSampLengthAlloc &&
             (result = requestBiggerSample(space))) return result;
 
+        if (_separatorCnt == 0) {
+            // Copy the characters before the next possible start of
+            // the separator, as far as there is room in the sample.
+            const char* cp = _buffer + _buftail;
+            const char* sp = (const char*) ::memchr(cp, _separator[0],
+                    _bufhead - _buftail);
+            unsigned int nc = (sp ? sp : _buffer + _bufhead) - cp;
+            nc = std::min(nc, _outSampLengthAlloc - space - _outSampRead + 1);
+            if (nc > 0) {
+                ::memcpy(_outSampDataPtr+_outSampRead,cp,nc);
+                _outSampRead += nc;
+                _buftail += nc;
+                continue;
+            }
+        }
+
+        char c = _buffer[_buftail];
+
         if (c == _separator[_separatorCnt]) {
             // We now have a character match to the record separator.
             // increment the separator counter.
@@ -697,19 +782,7 @@ Sample* MessageStreamScanner::nextSampleSepBOM(DSMSensor* sensor)
                     addSampleToStats(_outSampRead);
                     result = _osamp;
 
-                    // adjust size of next sample to request, if it needs changing
-                    if (_outSampRead > _sampleLengthAlloc) {
-                        _sampleLengthAlloc = std::min(_outSampRead + 16,MAX_MESSAGE_STREAM_SAMPLE_SIZE);
-                        _nsmallSamples = 0;
-                    }
-                    // check for 100 samples in a row less than _sampleLengthAlloc - 64
-                    else if (_sampleLengthAlloc > 64 && _outSampRead < _sampleLengthAlloc - 64) {
-                        if (++_nsmallSamples > 100) {
-                            _sampleLengthAlloc -= 64;
-                            _nsmallSamples = 0;
-                        }
-                    }
-                    else _nsmallSamples = 0;
+                    adjustSampleLengthAlloc(_outSampRead);
 
                     _osamp = getSample<char>(_sampleLengthAlloc);
                     _osamp->setId(sensor->getId());
@@ -535,6 +535,26 @@ protected:
      */
     Sample* requestBiggerSample(unsigned int nc);
 
+    /**
+     * Adjust _sampleLengthAlloc, the size of the next sample to request,
+     * after a sample of len bytes has been scanned.
+     */
+    void adjustSampleLengthAlloc(unsigned int len);
+
+    /**
+     * Given that cnt characters of the end-of-message separator have
+     * been matched, return the number that are matched after
+     * character c.
+     */
+    int matchSeparatorEOM(char c, int cnt) const;
+
+    /**
+     * Search [cp,eob) for the end-of-message separator, using memchr()
+     * to skip to candidates for its first character. Return a pointer
+     * to the character after the separator, or null if it is not found.
+     */
+    const char* findSeparatorEOM(const char* cp, const char* eob) const;
+
 protected:
 
     dsm_time_t _tfirstchar;
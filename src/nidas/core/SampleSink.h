@@ -0,0 +1,113 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+#ifndef NIDAS_CORE_SAMPLESINK_H
+#define NIDAS_CORE_SAMPLESINK_H
+
+#include "Sample.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace nidas { namespace core {
+
+/**
+ * The output of DSMSensor::processInto(): an array of pointers to
+ * processed samples.  Room for the few samples that process methods
+ * typically create is kept within the SampleSink itself, so a
+ * SampleSink on the stack collects them without allocating memory,
+ * unlike a std::list, which allocates a node for each sample.
+ * If more are added, the array is moved to the heap.
+ */
+class SampleSink
+{
+public:
+
+    typedef const Sample* const* const_iterator;
+
+    SampleSink():
+        _local(),_samps(_local),_size(0),_capacity(LOCAL_CAPACITY),_heap()
+    {}
+
+    void push_back(const Sample* samp)
+    {
+        if (_size == _capacity) grow();
+        _samps[_size++] = samp;
+    }
+
+    size_t size() const { return _size; }
+
+    bool empty() const { return _size == 0; }
+
+    const Sample* operator[](size_t i) const { return _samps[i]; }
+
+    const Sample* front() const { return _samps[0]; }
+
+    const Sample* back() const { return _samps[_size - 1]; }
+
+    const_iterator begin() const { return _samps; }
+
+    const_iterator end() const { return _samps + _size; }
+
+    const Sample* const* data() const { return _samps; }
+
+    /**
+     * Remove the samples, without freeing their references.
+     */
+    void clear() { _size = 0; }
+
+private:
+
+    void grow()
+    {
+        std::vector<const Sample*> heap(_capacity * 2);
+        std::copy(_samps, _samps + _size, heap.begin());
+        _heap.swap(heap);
+        _samps = &_heap[0];
+        _capacity = _heap.size();
+    }
+
+    static const size_t LOCAL_CAPACITY = 16;
+
+    const Sample* _local[LOCAL_CAPACITY];
+
+    const Sample** _samps;
+
+    size_t _size;
+
+    size_t _capacity;
+
+    std::vector<const Sample*> _heap;
+
+    /** No copying. */
+    SampleSink(const SampleSink&) = delete;
+
+    /** No assignment. */
+    SampleSink& operator=(const SampleSink&) = delete;
+};
+
+}}	// namespace nidas namespace core
+
+#endif
@@ -83,7 +83,8 @@ using nidas::util::UTime;
 SampleSorter::SampleSorter(const std::string& name,bool raw) :
     SampleThread(name),_source(raw),
     _sorterLengthUsec(250*USECS_PER_MSEC),
-    _samples(),_sampleSetCond(),_flushCond(),
+    _samples(),_bucketSort(false),_buckets(),
+    _sampleSetCond(),_flushCond(),
     _heapMax(50 * 1000 * 1000),
     _heapSize(0),_heapBlock(false),_heapCond(),_heapExceeded(false),
     _discardedSamples(0),_realTimeFutureSamples(0),_earlySamples(0),
@@ -117,16 +118,16 @@ SampleSorter::~SampleSorter()
     // It is possible for another thread to pass samples to receive() even
     // though the sorter was interrupted, so just make sure they've been
     // released.
-    SortedSampleSet::const_iterator si;
-    if (_samples.size())
+    std::vector<const Sample*> samps;
+    extractAll(samps);
+    if (samps.size())
     {
-        DLOG(("SampleSorter: releasing ") << _samples.size() << " samples "
+        DLOG(("SampleSorter: releasing ") << samps.size() << " samples "
              << "received after sorter stopped.");
     }
-    for (si = _samples.begin(); si != _samples.end(); ++si) {
-        (*si)->freeReference();
+    for (unsigned int i = 0; i < samps.size(); i++) {
+        samps[i]->freeReference();
     }
-    _samples.clear();
 
     ILOG(("%s: maxSorterLength=%.3f sec, excess=%.3f sec,"
           " discarded=%d, early=%d",
@@ -188,20 +189,28 @@ int SampleSorter::run()
      */
 
     ILOG(("%s: sorterLength=%.3f sec, lateSampleCache=%d, "
-          "heapMax=%d, heapBlock=%d",
+          "heapMax=%d, heapBlock=%d, bucketSort=%d",
           getName().c_str(), (double)_sorterLengthUsec/USECS_PER_SEC,
-          _lateSampleCacheSize, _heapMax,_heapBlock));
+          _lateSampleCacheSize, _heapMax,_heapBlock,_bucketSort));
 
     static n_u::LogContext sslog(LOG_VERBOSE, "sample_sorter");
     static n_u::LogMessage ssmsg(&sslog);
     static SampleTracer st(LOG_VERBOSE);
     dsm_time_t tlast = 0;
+    std::vector<const Sample*> agedsamples;
 
     _sampleSetCond.lock();
 
+    // The bucket width only affects efficiency, so don't bother
+    // changing it if samples have already been received.
+    if (_bucketSort && _buckets.empty())
+        _buckets.setBucketUsec(std::max(
+            (long long)_sorterLengthUsec / BUCKETS_PER_SORTER_LENGTH,
+            (long long)USECS_PER_MSEC));
+
     while (! isInterrupted()) {
 
-        size_t nsamp = _samples.size();
+        size_t nsamp = size();
 
         if (nsamp <= _lateSampleCacheSize) {
             if (nsamp == 0) {
@@ -220,31 +229,15 @@ int SampleSorter::run()
             }
         }
 
-        SortedSampleSet::const_iterator rsb = _samples.begin();
-        SortedSampleSet::const_iterator rsi;
-        SortedSampleSet::const_reverse_iterator latest = _samples.rbegin();
-        SortedSampleSet::const_reverse_iterator late = latest;
         dsm_time_t ttlatest = 0;
+        if (!_doFlush) ttlatest = latestSample()->getTimeTag();
 
-        if (_doFlush) {
-            rsi = _samples.end();
-        }
-        else {
-            // back up over _lateSampleCacheSize number of latest samples before
-            // using a sample time to use for the age off.
-            for (unsigned int i = 0; i < _lateSampleCacheSize; i++) late++;
-
-            // age-off samples with timetags before this
-            dsm_time_t tt = (*late)->getTimeTag() - _sorterLengthUsec;
-            _dummy.setTimeTag(tt);
+        // grab and remove the aged samples
+        const Sample* late = 0;
+        agedsamples.clear();
+        extractAged(agedsamples, late);
 
-            // get iterator pointing at first sample not less than dummy
-            rsi = _samples.lower_bound(&_dummy);
-
-            ttlatest = (*latest)->getTimeTag();
-        }
-
-        if (rsi == rsb) { // no aged samples
+        if (agedsamples.empty()) { // no aged samples
             // If no aged samples, but we're at the heap limit,
             // then we need to extend the limit, because it isn't
             // big enough for the current data rate (bytes/second).
@@ -261,9 +254,6 @@ int SampleSorter::run()
             continue;
         }
 
-	// grab the samples before the iterator
-	std::vector<const Sample*> agedsamples(rsb,rsi);
-
 #ifdef TEST_CPU_TIME
         nsamp = agedsamples.size();
         smax = std::max(smax,nsamp);
@@ -279,7 +269,7 @@ int SampleSorter::run()
                 ssmsg << " being flushed";
             else
                 ssmsg << " aged off by sample at "
-                      << st.format_time((*late)->getTimeTag());
+                      << st.format_time(late->getTimeTag());
             ssmsg << ", from "
                   << st.format_time((*agedsamples.begin())->getTimeTag())
                   << " to "
@@ -287,9 +277,6 @@ int SampleSorter::run()
                   << endlog;
         }
 
-	// remove samples from sorted multiset
-	_samples.erase(rsb,rsi);
-
 	// free the lock
 	_sampleSetCond.unlock();
 
@@ -333,24 +320,24 @@ int SampleSorter::run()
             {
                 st.msg(s, "distribute ") << " from " << getName() << endlog;
             }
-            _source.distribute(s);
 	}
+        // One call per client for the whole slice of aged samples.
+        _source.distribute(&agedsamples[0], agedsamples.size());
 	heapDecrement(ssum);
 
 	_sampleSetCond.lock();
     }
 
     // warning if remaining samples
-    if (_samples.size() > 0)
-        WLOG(("SampleSorter (%s) run method exiting, _samples.size()=%zu",
-            (_source.getRawSampleSource() ? "raw" : "processed"),_samples.size()));
-
-    SortedSampleSet::const_iterator si;
-    for (si = _samples.begin(); si != _samples.end(); ++si) {
-	const Sample *s = *si;
-	s->freeReference();
+    if (size() > 0)
+        WLOG(("SampleSorter (%s) run method exiting, size()=%zu",
+            (_source.getRawSampleSource() ? "raw" : "processed"),size()));
+
+    agedsamples.clear();
+    extractAll(agedsamples);
+    for (unsigned int i = 0; i < agedsamples.size(); i++) {
+	agedsamples[i]->freeReference();
     }
-    _samples.clear();
     _flushed = true;
     _sampleSetCond.unlock();
 
@@ -361,6 +348,59 @@ int SampleSorter::run()
     return RUN_OK;
 }
 
+const Sample* SampleSorter::latestSample() const
+{
+    if (_bucketSort) return _buckets.latest();
+    if (_samples.empty()) return 0;
+    return *_samples.rbegin();
+}
+
+void SampleSorter::extractAged(std::vector<const Sample*>& aged,
+        const Sample*& late)
+{
+    late = 0;
+    if (_doFlush) {
+        extractAll(aged);
+        return;
+    }
+
+    // back up over _lateSampleCacheSize number of latest samples before
+    // using a sample time to use for the age off.
+    if (_bucketSort)
+        late = _buckets.nthLatest(_lateSampleCacheSize);
+    else {
+        SortedSampleSet::const_reverse_iterator ri = _samples.rbegin();
+        for (unsigned int i = 0; i < _lateSampleCacheSize; i++) ri++;
+        late = *ri;
+    }
+
+    // age-off samples with timetags before this
+    dsm_time_t tt = late->getTimeTag() - _sorterLengthUsec;
+
+    if (_bucketSort) {
+        _buckets.extractBefore(tt, aged);
+        return;
+    }
+
+    _dummy.setTimeTag(tt);
+
+    // get iterator pointing at first sample not less than dummy
+    SortedSampleSet::iterator rsb = _samples.begin();
+    SortedSampleSet::iterator rsi = _samples.lower_bound(&_dummy);
+    aged.insert(aged.end(), rsb, rsi);
+    _samples.erase(rsb, rsi);
+}
+
+void SampleSorter::extractAll(std::vector<const Sample*>& samps)
+{
+    if (_bucketSort) {
+        _buckets.extractAll(samps);
+        return;
+    }
+    samps.insert(samps.end(), _samples.begin(), _samples.end());
+    _samples.clear();
+}
+
 void SampleSorter::interrupt()
 {
     _sampleSetCond.lock();
@@ -454,12 +494,12 @@ void SampleSorter::flush() throw()
     // if the consumer thread is waiting, notify it that we don't 
     // want it to wait anymore, we want it to flush
     _sampleSetCond.signal();
-    int nsamples = _samples.size();
+    int nsamples = size();
     dsm_time_t timetag{0};
     dsm_sample_id_t sid{0};
     if (nsamples)
     {
-        const Sample* last = *_samples.rbegin();
+        const Sample* last = latestSample();
         timetag = last->getTimeTag();
         sid = last->getId();
     }
@@ -493,34 +533,40 @@ void SampleSorter::flush() throw()
              " SampleSorter interrupted, samples may not have drained.");
     }
 
-    if (!_samples.empty())
+    if (size() > 0)
         WLOG(((_source.getRawSampleSource() ? "raw" : "processed")) <<
-         " flush(): sample list not empty, size=" << _samples.size());
+         " flush(): sample list not empty, size=" << size());
     
     // may want to call flush on the SampleClients.
 
 }
 
+bool SampleSorter::futureSample(const Sample* s)
+{
+    if (!_realTime) return false;
+
+    dsm_time_t samptt = s->getTimeTag();
+    dsm_time_t systt = n_u::getSystemTime();
+    // On DSMs with samples which are timetagged by an IRIG, the IRIG clock
+    // can be off if it doesn't have a lock
+    if (samptt > systt + USECS_PER_SEC * 2) {
+        if (!(_realTimeFutureSamples++ % _discardWarningCount))
+            WLOG(("sample with timetag in future by %f secs. time: ",
+                  (float)(samptt - systt) / USECS_PER_SEC)
+                 << UTime(samptt).format(true,"%Y %b %d %H:%M:%S.%3f")
+                 << " id=" << GET_DSM_ID(s->getId()) << ','
+                 << GET_SPS_ID(s->getId())
+                 << " total future samples=" << _realTimeFutureSamples);
+        return true;
+    }
+    return false;
+}
+
 bool SampleSorter::receive(const Sample *s) throw()
 {
     unsigned int slen = s->getDataByteLength() + s->getHeaderLength();
 
-    if (_realTime) {
-        dsm_time_t samptt = s->getTimeTag();
-        dsm_time_t systt = n_u::getSystemTime();
-	// On DSMs with samples which are timetagged by an IRIG, the IRIG clock
-	// can be off if it doesn't have a lock
-        if (samptt > systt + USECS_PER_SEC * 2) {
-            if (!(_realTimeFutureSamples++ % _discardWarningCount))
-                WLOG(("sample with timetag in future by %f secs. time: ",
-                      (float)(samptt - systt) / USECS_PER_SEC)
-                     << UTime(samptt).format(true,"%Y %b %d %H:%M:%S.%3f")
-                     << " id=" << GET_DSM_ID(s->getId()) << ','
-                     << GET_SPS_ID(s->getId())
-                     << " total future samples=" << _realTimeFutureSamples);
-            return false;
-        }
-    }
+    if (futureSample(s)) return false;
 
     // Check if the heapSize will exceed heapMax
     _heapCond.lock();
@@ -561,49 +607,112 @@ bool SampleSorter::receive(const Sample *s) throw()
     }
     _heapCond.unlock();
 
+    insertSamples(&s, 1);
+    return true;
+}
+
+bool SampleSorter::receiveBatch(const Sample* const* samps, size_t nsamps)
+    throw()
+{
+    std::vector<const Sample*> accepted;
+    accepted.reserve(nsamps);
+    bool ok = true;
+
+    _heapCond.lock();
+    for (size_t i = 0; i < nsamps; i++) {
+        const Sample* s = samps[i];
+        if (futureSample(s)) {
+            ok = false;
+            continue;
+        }
+        unsigned int slen = s->getDataByteLength() + s->getHeaderLength();
+        if (!_heapBlock) {
+            // Real-time behaviour, discard samples rather than blocking
+            if (_heapSize + slen > _heapMax) {
+                _heapExceeded = true;
+                if (!(_discardedSamples++ % _discardWarningCount))
+                    WLOG(("%d discarded samples because "
+                          "heapSize(%d) + sampleSize(%d) is > than heapMax(%d)",
+                          _discardedSamples,_heapSize,slen,_heapMax));
+                ok = false;
+                continue;
+            }
+            _heapSize += slen;
+            _heapExceeded = false;
+        }
+        else {
+            _heapSize += slen;
+            if (_heapSize > _heapMax) {
+                // Hand the samples accepted so far to the consumer
+                // thread before waiting for it to reduce the heap,
+                // since it may have nothing else to age off.
+                _heapCond.unlock();
+                if (!accepted.empty())
+                    insertSamples(&accepted[0], accepted.size());
+                accepted.clear();
+                _heapCond.lock();
+                // See the deadlock note in receive().
+                while (_heapSize > _heapMax) {
+                    _heapExceeded = true;
+                    DLOG(("") << getName() << ": heap(" << _heapSize <<
+                        ") > max(" << _heapMax << "), waiting");
+                    _sampleSetCond.signal();
+                    _heapCond.wait();
+                }
+            }
+            _heapExceeded = false;
+        }
+        accepted.push_back(s);
+    }
+    _heapCond.unlock();
+
+    if (!accepted.empty())
+        insertSamples(&accepted[0], accepted.size());
+    return ok;
+}
+
+void SampleSorter::insertSamples(const Sample* const* samps, size_t nsamps)
+{
     _sampleSetCond.lock();
 
-    // If a sample arrives that is prior to the current sorter time window
-    // then it may not be sorted, depending on whether the consumer thread
-    // has caught up to this producer thread. We warn about this condition
-    // but do not discard samples.
+    for (size_t i = 0; i < nsamps; i++) {
+        const Sample* s = samps[i];
 
-    SortedSampleSet::const_reverse_iterator latest = _samples.rbegin();
-    if (latest != _samples.rend() &&
-        s->getTimeTag() < (*latest)->getTimeTag() - _sorterLengthUsec)
-    {
-        if (!(_earlySamples++ % _earlyWarningCount))
+        // If a sample arrives that is prior to the current sorter time window
+        // then it may not be sorted, depending on whether the consumer thread
+        // has caught up to this producer thread. We warn about this condition
+        // but do not discard samples.
+
+        const Sample* latest = latestSample();
+        if (latest &&
+            s->getTimeTag() < latest->getTimeTag() - _sorterLengthUsec)
         {
-            dsm_time_t wend = (*latest)->getTimeTag();
-            dsm_time_t wbegin = wend - _sorterLengthUsec;
-            WLOG(("Early sample (%d,%d) @ ", 
-                  s->getDSMId(), s->getSpSId())
-                 << SampleTracer::format_time(s->getTimeTag())
-                 << " (" << _earlySamples << " total)"
-                 << ": prior to sorter window ["
-                 << SampleTracer::format_time(wbegin) << ", "
-                 << SampleTracer::format_time(wend) << "]");
+            if (!(_earlySamples++ % _earlyWarningCount))
+            {
+                dsm_time_t wend = latest->getTimeTag();
+                dsm_time_t wbegin = wend - _sorterLengthUsec;
+                WLOG(("Early sample (%d,%d) @ ",
+                      s->getDSMId(), s->getSpSId())
+                     << SampleTracer::format_time(s->getTimeTag())
+                     << " (" << _earlySamples << " total)"
+                     << ": prior to sorter window ["
+                     << SampleTracer::format_time(wbegin) << ", "
+                     << SampleTracer::format_time(wend) << "]");
+            }
         }
-    }
 
-    // If the sorter has been interrupted or is not otherwise running, then
-    // this does not accept any more samples.  However, rather than
-    // increase thread contention by checking the thread in every call to
-    // receive(), the excess samples will instead be released in the
-    // destructor.
-    if (0 && (isInterrupted() || !isRunning()))
-    {
-        DLOG(("sorter has stopped, refusing to receive() sample ") << s);
-        _sampleSetCond.unlock();
-        return false;
+        // If the sorter has been interrupted or is not otherwise running,
+        // then this does not accept any more samples.  However, rather than
+        // increase thread contention by checking the thread in every call
+        // to receive(), the excess samples will instead be released in the
+        // destructor.
+        s->holdReference();
+        if (_bucketSort) _buckets.insert(s);
+        else _samples.insert(_samples.end(),s);
     }
-    s->holdReference();
-    _samples.insert(_samples.end(),s);
     _flushed = false;
     _sampleSetCond.signal();
     _sampleSetCond.unlock();
-
-    return true;
 }
 
 
@@ -613,6 +722,14 @@ void SampleSorter::setLengthSecs(float val)
 }
 
 
+void SampleSorter::setBucketSort(bool val)
+{
+    _sampleSetCond.lock();
+    assert(size() == 0);
+    _bucketSort = val;
+    _sampleSetCond.unlock();
+}
+
 float SampleSorter::getLengthSecs() const
 {
     return (double)_sorterLengthUsec / USECS_PER_SEC;
@@ -30,13 +30,14 @@
 #include "SampleThread.h"
 #include "SampleSourceSupport.h"
 #include "SortedSampleSet.h"
+#include "BucketSampleSet.h"
 
 namespace nidas { namespace core {
 
 /**
  * A SampleClient that sorts its received samples,
- * using an STL multiset, and then sends the
- * sorted samples onto its SampleClients.
+ * using an STL multiset, or optionally a BucketSampleSet,
+ * and then sends the sorted samples onto its SampleClients.
  * The time period of the sorting is specified with
  * setLengthSecs().
  * Samples whose time-tags are previous to the time-tag
@@ -167,6 +168,13 @@ public:
      */
     bool receive(const Sample *s) throw();
 
+    /**
+     * Implementation of SampleClient::receiveBatch().  The heap
+     * limits are applied to each sample as in receive(), but the
+     * samples are added to the sorter with one lock.
+     */
+    bool receiveBatch(const Sample* const* samps, size_t nsamps) throw();
+
     /**
      * Current number of samples in the sorter.
      * This method does not hold a lock to force exclusive
@@ -174,10 +182,23 @@ public:
      * instantaneous check and shouldn't be used by methods
      * in this class when exclusive access is required.
      */
-    size_t size() const { return _samples.size(); }
+    size_t size() const
+    {
+        return _bucketSort ? _buckets.size() : _samples.size();
+    }
 
     void setLengthSecs(float val);
 
+    /**
+     * Sort samples in a BucketSampleSet of time slices instead of a
+     * SortedSampleSet.  Either way the samples are distributed in the
+     * same order, but the bucket sort does not allocate a node for
+     * every sample.  Must be set before the thread is started.
+     */
+    void setBucketSort(bool val);
+
+    bool getBucketSort() const { return _bucketSort; }
+
     float getLengthSecs() const;
 
     /**
@@ -282,6 +303,40 @@ private:
 
     SortedSampleSet _samples;
 
+    /**
+     * Whether to use _buckets instead of _samples.
+     */
+    bool _bucketSort;
+
+    BucketSampleSet<> _buckets;
+
+    /**
+     * Time width of the buckets, as a fraction of the sorter length.
+     */
+    static const int BUCKETS_PER_SORTER_LENGTH = 8;
+
+    /**
+     * Latest sample in the sorter, or null if empty.
+     * _sampleSetCond must be locked.
+     */
+    const Sample* latestSample() const;
+
+    /**
+     * Remove the aged samples from the sorter, or all of them if
+     * flushing, appending them in time order to aged. _sampleSetCond
+     * must be locked, and the sorter must hold more than
+     * _lateSampleCacheSize samples unless flushing.
+     * @param late Set to the sample whose time tag was used for the
+     *   age-off, or null if flushing.
+     */
+    void extractAged(std::vector<const Sample*>& aged, const Sample*& late);
+
+    /**
+     * Remove all samples from the sorter. _sampleSetCond must be locked,
+     * or the sorter thread not running.
+     */
+    void extractAll(std::vector<const Sample*>& samps);
+
     /**
      * Utility function to decrement the heap size after writing
      * one or more samples. If the heapSize has has shrunk below
@@ -289,6 +344,18 @@ private:
      */
     void heapDecrement(size_t bytes);
 
+    /**
+     * If running in real-time, check whether the time tag of a sample
+     * is too far in the future, and if so warn and return true.
+     */
+    bool futureSample(const Sample* s);
+
+    /**
+     * Warn about early samples, hold a reference to the samples and
+     * add them to the sorter.
+     */
+    void insertSamples(const Sample* const* samps, size_t nsamps);
+
     nidas::util::Cond _sampleSetCond;
 
     nidas::util::Cond _flushCond;
@@ -29,26 +29,135 @@
 #include <nidas/util/ThreadSupport.h>
 
 #include <algorithm>
+#include <utility>
+#include <vector>
 
 using namespace nidas::core;
 using namespace std;
 namespace n_u = nidas::util;
 
 SampleSourceSupport::SampleSourceSupport(bool raw):
-    _tagsMutex(),_sampleTags(),_clients(),_clientsBySampleId(),
+    _tagsMutex(),_sampleTags(),
+    _snapshot(new ClientSnapshot()),_retired(),_readers(),_epoch(0),
+    _readersCond(),_nwaiting(0),
     _clientSet(),_clientMapLock(),_stats(),
     _raw(raw),_keepStats(false)
 {
+    _readers[0] = 0;
+    _readers[1] = 0;
 }
 
 SampleSourceSupport::SampleSourceSupport(const SampleSourceSupport& x):
     SampleSource(),
     _tagsMutex(),
     _sampleTags(x._sampleTags),
-    _clients(),_clientsBySampleId(),
+    _snapshot(new ClientSnapshot()),_retired(),_readers(),_epoch(0),
+    _readersCond(),_nwaiting(0),
     _clientSet(),_clientMapLock(),_stats(),
     _raw(x._raw),_keepStats(x._keepStats)
 {
+    _readers[0] = 0;
+    _readers[1] = 0;
+}
+
+SampleSourceSupport::~SampleSourceSupport()
+{
+    for (unsigned int i = 0; i < _retired.size(); i++)
+        delete _retired[i];
+    delete _snapshot.load();
+}
+
+namespace {
+    /**
+     * The SampleSourceSupports whose distribute() the current thread is in.
+     */
+    std::vector<const SampleSourceSupport*>& distributingSources()
+    {
+        static thread_local std::vector<const SampleSourceSupport*> sources;
+        return sources;
+    }
+}
+
+SampleSourceSupport::SnapshotReader::SnapshotReader(SampleSourceSupport& src):
+    _src(src),_epoch(0),_snapshot(0)
+{
+    // The epoch counter must be incremented before the snapshot is
+    // loaded, see waitForReaders().
+    _epoch = _src._epoch.load();
+    _src._readers[_epoch]++;
+    _snapshot = _src._snapshot.load();
+    distributingSources().push_back(&_src);
+}
+
+SampleSourceSupport::SnapshotReader::~SnapshotReader()
+{
+    distributingSources().pop_back();
+    // A writer increments _nwaiting before checking the counter,
+    // so either it sees this decrement, or this sees the writer.
+    if (--_src._readers[_epoch] == 0 && _src._nwaiting.load() > 0) {
+        n_u::Autolock autolock(_src._readersCond);
+        _src._readersCond.broadcast();
+    }
+}
+
+bool SampleSourceSupport::inDistribute() const
+{
+    const std::vector<const SampleSourceSupport*>& sources =
+        distributingSources();
+    return std::find(sources.begin(), sources.end(), this) != sources.end();
+}
+
+void SampleSourceSupport::waitForReaders()
+{
+    // A reader registers in the current epoch and then loads the
+    // snapshot.  A reader which loaded an old snapshot registered,
+    // perhaps late, in either epoch before the new snapshot was stored.
+    // So flip the epoch twice, each time waiting for the readers
+    // registered in the previous epoch, whose number can only decrease
+    // once new readers register in the other epoch.  The last reader
+    // of an epoch signals _readersCond, whose lock also keeps other
+    // writers from flipping the epoch meanwhile.
+    n_u::Autolock autolock(_readersCond);
+    _nwaiting++;
+    for (int i = 0; i < 2; i++) {
+        unsigned int old = _epoch.load();
+        _epoch.store(old ^ 1);
+        while (_readers[old].load() != 0) _readersCond.wait();
+    }
+    _nwaiting--;
+}
+
+void SampleSourceSupport::publishClients(ClientSnapshot* snap)
+{
+    _retired.push_back(_snapshot.exchange(snap));
+
+    // A reader of a retired snapshot registered before it was
+    // replaced, so if there are no readers now, none can be using it.
+    if (_readers[0].load() == 0 && _readers[1].load() == 0) {
+        for (unsigned int i = 0; i < _retired.size(); i++)
+            delete _retired[i];
+        _retired.clear();
+    }
+}
+
+void SampleSourceSupport::finishRemove()
+{
+    // If this thread is distributing samples from this source, it is
+    // itself a reader, and cannot wait. Old snapshots are then deleted
+    // by a later call, or the destructor.
+    if (inDistribute()) return;
+
+    std::vector<const ClientSnapshot*> retired;
+    {
+        n_u::Autolock autolock(_clientMapLock);
+        retired.swap(_retired);
+    }
+
+    // Wait even if another remove took the retired snapshots, since
+    // the one replaced by this remove may still be in use.
+    waitForReaders();
+    for (unsigned int i = 0; i < retired.size(); i++)
+        delete retired[i];
 }
 
 list<const SampleTag*> SampleSourceSupport::getSampleTags() const
@@ -79,58 +188,78 @@ SampleTagIterator SampleSourceSupport::getSampleTagIterator() const
 
 void SampleSourceSupport::addSampleClient(SampleClient* c) throw()
 {
-    _clients.add(c);
-    _clientMapLock.lock();
+    n_u::Autolock autolock(_clientMapLock);
+    ClientSnapshot* snap = new ClientSnapshot(*_snapshot.load());
+    // prevent being added twice
+    if (find(snap->clients.begin(), snap->clients.end(), c) ==
+            snap->clients.end())
+        snap->clients.push_back(c);
     _clientSet.insert(c);
-    _clientMapLock.unlock();
+    publishClients(snap);
 }
 
 void SampleSourceSupport::removeSampleClient(SampleClient* c) throw()
 {
-    _clientMapLock.lock();
-    map<dsm_sample_id_t,SampleClientList>::iterator ci =
-        _clientsBySampleId.begin();
-    for ( ; ci != _clientsBySampleId.end(); ++ci)
-        ci->second.remove(c);
-    _clientSet.erase(c);
-    _clientMapLock.unlock();
-
-    _clients.remove(c);
+    {
+        n_u::Autolock autolock(_clientMapLock);
+        ClientSnapshot* snap = new ClientSnapshot(*_snapshot.load());
+        SampleIdMap<vector<SampleClient*> >::iterator ci =
+            snap->clientsBySampleId.begin();
+        for ( ; ci != snap->clientsBySampleId.end(); ++ci) {
+            vector<SampleClient*>& clients = ci->second;
+            clients.erase(remove(clients.begin(), clients.end(), c),
+                clients.end());
+        }
+        snap->clients.erase(remove(snap->clients.begin(),
+                snap->clients.end(), c), snap->clients.end());
+        _clientSet.erase(c);
+        publishClients(snap);
+    }
+    finishRemove();
 }
 
 void SampleSourceSupport::addSampleClientForTag(SampleClient* client,
     const SampleTag* tag) throw()
 {
-    _clientMapLock.lock();
-
-    map<dsm_sample_id_t,SampleClientList>::iterator ci =
-        _clientsBySampleId.find(tag->getId());
-
-    if (ci == _clientsBySampleId.end()) {
-        SampleClientList clients;
-        clients.add(client);
-        _clientsBySampleId[tag->getId()] = clients;
-    }
-    else ci->second.add(client);
-
+    n_u::Autolock autolock(_clientMapLock);
+    ClientSnapshot* snap = new ClientSnapshot(*_snapshot.load());
+    vector<SampleClient*>& clients = snap->clientsBySampleId[tag->getId()];
+    if (find(clients.begin(), clients.end(), client) == clients.end())
+        clients.push_back(client);
     _clientSet.insert(client);
-
-    _clientMapLock.unlock();
+    publishClients(snap);
 }
 
 void SampleSourceSupport::removeSampleClientForTag(SampleClient* client,
     const SampleTag* tag) throw()
 {
-    _clientMapLock.lock();
-
-    map<dsm_sample_id_t,SampleClientList>::iterator ci =
-        _clientsBySampleId.find(tag->getId());
-    if (ci != _clientsBySampleId.end())
-        ci->second.remove(client);
-    _clientSet.erase(client);
-
-    _clientMapLock.unlock();
+    {
+        n_u::Autolock autolock(_clientMapLock);
+        ClientSnapshot* snap = new ClientSnapshot(*_snapshot.load());
+        SampleIdMap<vector<SampleClient*> >::iterator ci =
+            snap->clientsBySampleId.find(tag->getId());
+        if (ci != snap->clientsBySampleId.end()) {
+            vector<SampleClient*>& clients = ci->second;
+            clients.erase(remove(clients.begin(), clients.end(), client),
+                clients.end());
+            if (clients.empty()) snap->clientsBySampleId.erase(ci);
+        }
+        _clientSet.erase(client);
+        publishClients(snap);
+    }
+    finishRemove();
+}
 
+void SampleSourceSupport::removeAllSampleClients() throw()
+{
+    {
+        n_u::Autolock autolock(_clientMapLock);
+        ClientSnapshot* snap = new ClientSnapshot(*_snapshot.load());
+        snap->clients.clear();
+        _clientSet.clear();
+        publishClients(snap);
+    }
+    finishRemove();
 }
 
 int SampleSourceSupport::getClientCount() const throw()
@@ -140,41 +269,31 @@ int SampleSourceSupport::getClientCount() const throw()
 
 void SampleSourceSupport::distribute(const Sample* sample) throw()
 {
-    /* There is a multithreading issue at this point.
-     * If a SampleClient removes themselves from the list
-     * AND immediately delete's themselves, when the SampleSource
-     * is executing this method, right here between the above
-     * copy and the clients receive(), then things will crash.
-     *
-     * (I should keep this comment short to avoid this situation :)
-     *
-     * We don't want to keep the lock however, because
-     * perhaps the SampleClient may want to remove themselves
-     * within the receive() (if they get an IOException for example).
-     * That situation would cause a deadlock.
-     * To avoid this issue, SampleClients should either make
-     * sure the SampleSource isn't executing at the time of
-     * removeSampleClient or that there is a "long" time between
-     * removeSampleClient and their destruction.  Hmmm, needs 
-     * more thought.
+    /* The clients are read from a snapshot which is not changed while
+     * this SnapshotReader exists. Because removeSampleClient() waits for
+     * any reader of the snapshot it replaced, a SampleClient can be
+     * deleted once removeSampleClient() returns. No lock is held while
+     * calling receive(), so a client may remove itself within
+     * receive(), for example if it gets an IOException.
      */
+    {
+        SnapshotReader reader(*this);
+        const ClientSnapshot* snap = reader.get();
 
-   _clientMapLock.lock();
-    map<dsm_sample_id_t,SampleClientList>::const_iterator ci =
-        _clientsBySampleId.find(sample->getId());
-    if (ci != _clientsBySampleId.end()) {
-        SampleClientList tmp(ci->second);
-        _clientMapLock.unlock();
-        list<SampleClient*>::const_iterator li = tmp.begin();
-        for ( ; li != tmp.end(); ++li) (*li)->receive(sample);
-    }
-    else _clientMapLock.unlock();
+        if (!snap->clientsBySampleId.empty()) {
+            SampleIdMap<vector<SampleClient*> >::const_iterator ci =
+                snap->clientsBySampleId.find(sample->getId());
+            if (ci != snap->clientsBySampleId.end()) {
+                const vector<SampleClient*>& clients = ci->second;
+                for (unsigned int i = 0; i < clients.size(); i++)
+                    clients[i]->receive(sample);
+            }
+        }
 
-    // copy constructor does a lock
-    SampleClientList tmp(_clients);
-    list<SampleClient*>::const_iterator li = tmp.begin();
-    for ( ; li != tmp.end(); ++li)
-	(*li)->receive(sample);
+        const vector<SampleClient*>& clients = snap->clients;
+        for (unsigned int i = 0; i < clients.size(); i++)
+            clients[i]->receive(sample);
+    }
 
     if (getKeepStats()) {
         _stats.addNumSamples(1);
@@ -184,6 +303,68 @@ void SampleSourceSupport::distribute(const Sample* sample) throw()
     sample->freeReference();
 }
 
+void SampleSourceSupport::distribute(const Sample* const* samps,
+        size_t nsamps) throw()
+{
+    if (nsamps == 0) return;
+
+    {
+        SnapshotReader reader(*this);
+        const ClientSnapshot* snap = reader.get();
+
+        if (!snap->clientsBySampleId.empty()) {
+            // Gather the samples for the clients of each sample id.
+            typedef vector<pair<SampleClient*, vector<const Sample*> > >
+                batches_t;
+            batches_t batches;
+
+            SampleIdMap<vector<SampleClient*> >::const_iterator ci =
+                snap->clientsBySampleId.end();
+            for (size_t i = 0; i < nsamps; i++) {
+                const Sample* sample = samps[i];
+                // consecutive samples often have the same id
+                if (ci == snap->clientsBySampleId.end() ||
+                        ci->first != sample->getId())
+                    ci = snap->clientsBySampleId.find(sample->getId());
+                if (ci == snap->clientsBySampleId.end()) continue;
+
+                const vector<SampleClient*>& clients = ci->second;
+                for (unsigned int j = 0; j < clients.size(); j++) {
+                    batches_t::iterator bi = batches.begin();
+                    for ( ; bi != batches.end() && bi->first != clients[j];
+                            ++bi);
+                    if (bi == batches.end()) {
+                        batches.push_back(make_pair(clients[j],
+                                vector<const Sample*>()));
+                        bi = batches.end() - 1;
+                    }
+                    bi->second.push_back(sample);
+                }
+            }
+
+            batches_t::const_iterator bi = batches.begin();
+            for ( ; bi != batches.end(); ++bi)
+                bi->first->receiveBatch(&bi->second[0], bi->second.size());
+        }
+
+        const vector<SampleClient*>& clients = snap->clients;
+        for (unsigned int i = 0; i < clients.size(); i++)
+            clients[i]->receiveBatch(samps, nsamps);
+    }
+
+    if (getKeepStats()) {
+        size_t nbytes = 0;
+        for (size_t i = 0; i < nsamps; i++)
+            nbytes += samps[i]->getHeaderLength() +
+                samps[i]->getDataByteLength();
+        _stats.addNumSamples(nsamps);
+        _stats.addNumBytes(nbytes);
+        _stats.setLastTimeTag(samps[nsamps-1]->getTimeTag());
+    }
+    for (size_t i = 0; i < nsamps; i++)
+        samps[i]->freeReference();
+}
+
 void SampleSourceSupport::distribute(const std::list<const Sample*>& samples)
 	throw()
 {
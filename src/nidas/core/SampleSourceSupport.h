@@ -28,10 +28,16 @@
 #define NIDAS_CORE_SAMPLESOURCESUPPORT_H
 
 #include "SampleSource.h"
-#include "SampleClientList.h"
+#include "SampleClient.h"
+#include "SampleIdMap.h"
 
-#include <set>
+#include <nidas/util/ThreadSupport.h>
+
+#include <atomic>
+#include <list>
 #include <map>
+#include <set>
+#include <vector>
 
 namespace nidas { namespace core {
 
@@ -43,6 +49,19 @@ class SampleTag;
  * it will call the receive method of all its SampleClients.
  * SampleClients register/unregister with a SampleSource via
  * the addSampleClient/removeSampleClient methods.
+ *
+ * The clients are kept in an immutable snapshot, which is replaced
+ * rather than modified when a client is added or removed, in the manner
+ * of read-copy-update.  distribute() reads the current snapshot without
+ * locking or copying it.  After replacing a snapshot, the remove
+ * methods wait for any distribute() which may still be reading the old
+ * snapshot to finish, before deleting it.  So once removeSampleClient()
+ * returns, the removed client will not be called again and may be
+ * deleted, unless removeSampleClient() was called from within
+ * a distribute() of this SampleSourceSupport, typically by the client's
+ * receive() method.  The wait is done without holding any lock of this
+ * object, but a caller of the remove methods must not hold a lock which
+ * the receive() of a client of this source may take.
  */
 class SampleSourceSupport: public SampleSource {
 public:
@@ -55,7 +74,7 @@ public:
      */
     SampleSourceSupport(const SampleSourceSupport& x);
 
-    virtual ~SampleSourceSupport() {}
+    virtual ~SampleSourceSupport();
 
     SampleSource* getRawSampleSource()
     {
@@ -113,13 +132,7 @@ public:
     /**
      * Big cleanup.
      */
-    void removeAllSampleClients() throw()
-    {
-        _clients.removeAll();
-        _clientMapLock.lock();
-        _clientSet.clear();
-        _clientMapLock.unlock();
-    }
+    void removeAllSampleClients() throw();
 
     /**
      * Distribute a sample to my clients, calling the receive() method
@@ -141,6 +154,16 @@ public:
      */
     void distribute(const std::list<const Sample*>& samps) throw();
 
+    /**
+     * Distribute a batch of samples to my clients, with one call of
+     * SampleClient::receiveBatch() per client, passing each client
+     * the samples it would have received from distribute(s), in the
+     * same order.  The client lists are looked up once for the batch,
+     * rather than once per sample.
+     * Does a s->freeReference() on each sample in the batch.
+     */
+    void distribute(const Sample* const* samps, size_t nsamps) throw();
+
     /**
      * This implementation of SampleSource::flush() does nothing.
      */
@@ -168,17 +191,114 @@ private:
     std::list<const SampleTag*> _sampleTags;
 
     /**
-     * Current clients of all samples.
+     * An immutable set of clients.
+     */
+    struct ClientSnapshot
+    {
+        ClientSnapshot(): clients(),clientsBySampleId() {}
+
+        /**
+         * Clients of all samples.
+         */
+        std::vector<SampleClient*> clients;
+
+        /**
+         * Clients of specific samples.
+         */
+        SampleIdMap<std::vector<SampleClient*> > clientsBySampleId;
+    };
+
+    /**
+     * Marks a distribute() as reading the current ClientSnapshot,
+     * for the lifetime of this object.
      */
-    SampleClientList _clients;
+    class SnapshotReader
+    {
+    public:
+        SnapshotReader(SampleSourceSupport& src);
+
+        ~SnapshotReader();
+
+        const ClientSnapshot* get() const { return _snapshot; }
+
+    private:
+        SampleSourceSupport& _src;
+
+        unsigned int _epoch;
+
+        const ClientSnapshot* _snapshot;
+
+        /** No copying. */
+        SnapshotReader(const SnapshotReader&) = delete;
+
+        /** No assignment. */
+        SnapshotReader& operator=(const SnapshotReader&) = delete;
+    };
+
+    /**
+     * Replace the current snapshot with snap, retiring the old one,
+     * which is deleted now if no distribute() is in progress.
+     * _clientMapLock must be locked.
+     */
+    void publishClients(ClientSnapshot* snap);
 
     /**
-     * Current clients of specific samples.
+     * Called by the remove methods after publishClients(), with
+     * _clientMapLock unlocked: wait for the readers of the retired
+     * snapshots, and delete them.
      */
-    std::map<dsm_sample_id_t,SampleClientList> _clientsBySampleId;
+    void finishRemove();
+
+    /**
+     * Wait until every distribute() which started before this call
+     * has finished.
+     */
+    void waitForReaders();
+
+    /**
+     * Is the current thread in a distribute() of this object?
+     */
+    bool inDistribute() const;
+
+    /**
+     * The current clients.
+     */
+    std::atomic<const ClientSnapshot*> _snapshot;
+
+    /**
+     * Snapshots which have been replaced, but may still be read.
+     * Protected by _clientMapLock.
+     */
+    std::vector<const ClientSnapshot*> _retired;
+
+    /**
+     * Number of distribute() calls in progress which registered
+     * in each epoch.
+     */
+    std::atomic<int> _readers[2];
+
+    /**
+     * Index into _readers for new distribute() calls.
+     */
+    std::atomic<unsigned int> _epoch;
+
+    /**
+     * Signaled when the number of readers in an epoch drops to zero
+     * while a writer is waiting in waitForReaders().  Its lock
+     * serializes the writers which wait.
+     */
+    nidas::util::Cond _readersCond;
+
+    /**
+     * Number of writers waiting in waitForReaders().
+     */
+    std::atomic<int> _nwaiting;
 
     std::set<SampleClient*> _clientSet;
 
+    /**
+     * Serializes changes to the clients.
+     */
     nidas::util::Mutex _clientMapLock;
 
     SampleStats _stats;
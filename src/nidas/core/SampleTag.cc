@@ -50,7 +50,7 @@ SampleTag::SampleTag(const DSMSensor* sensor):
     _variables(),_variableNames(),
     _scanfFormat(),_promptString(), _promptOffset(0.0),
     _parameters(), _enabled(true),
-     _ttAdjustVal(-1.0)
+     _ttAdjustVal(-1.0), _conversionPlan()
 {
     if (_sensor)
     {
@@ -76,7 +76,7 @@ SampleTag::SampleTag(const SampleTag& x):
     _promptString(x._promptString),
     _promptOffset(x._promptOffset),
     _parameters(), _enabled(x._enabled),
-    _ttAdjustVal(x._ttAdjustVal)
+    _ttAdjustVal(x._ttAdjustVal), _conversionPlan()
 {
     for (auto var: x.getVariables()) {
         addVariable(new Variable(*var));
@@ -29,6 +29,7 @@
 #include "DOMable.h"
 #include "Sample.h"
 #include "NidsIterators.h"
+#include "ConversionPlan.h"
 
 #include <vector>
 #include <list>
@@ -299,6 +300,12 @@ public:
      */
     Variable& getVariable(int i) { return *_variables[i]; }
 
+    /**
+     * The compiled conversions of this SampleTag's Variables, used by
+     * DSMSensor::applyConversions().
+     */
+    ConversionPlan& getConversionPlan() { return _conversionPlan; }
+
     /**
      * Add a parameter to this SampleTag. SampleTag
      * will then own the pointer and will delete it
@@ -415,6 +422,8 @@ private:
      */
     float _ttAdjustVal;
 
+    ConversionPlan _conversionPlan;
+
 };
 
 }}	// namespace nidas namespace core
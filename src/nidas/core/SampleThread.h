@@ -128,6 +128,15 @@ public:
 
     virtual unsigned int getLateSampleCacheSize() const = 0;
 
+    /**
+     * Sort samples in time buckets rather than in a multiset.
+     * Ignored by threads which do not sort. Must be set before
+     * the thread is started.
+     */
+    virtual void setBucketSort(bool val) = 0;
+
+    virtual bool getBucketSort() const = 0;
+
 };
 
 }}	// namespace nidas namespace core
@@ -656,8 +656,20 @@ int SensorHandler::run()
                      pools.begin(); pi != pools.end(); ++pi) {
                     SamplePoolInterface *pool = *pi;
                     n_u::Logger::getInstance()->log(LOG_INFO,
-                        "pool nsamples alloc=%d, nsamples out=%d",
-                        pool->getNSamplesAlloc(), pool->getNSamplesOut());
+                        "pool nsamples alloc=%d, nsamples out=%d, "
+                        "nsamples cached=%d",
+                        pool->getNSamplesAlloc(), pool->getNSamplesOut(),
+                        pool->getNSamplesCached());
+                    vector<SamplePoolThreadStats> tstats =
+                        pool->getThreadStats();
+                    for (unsigned int i = 0; i < tstats.size(); i++) {
+                        const SamplePoolThreadStats& ts = tstats[i];
+                        n_u::Logger::getInstance()->log(LOG_INFO,
+                            "pool thread %s: cached=%d, gets=%lld, "
+                            "puts=%lld, refills=%lld, drains=%lld",
+                            ts.threadName.c_str(), ts.ncached, ts.ngets,
+                            ts.nputs, ts.nrefills, ts.ndrains);
+                    }
                 }
                 nsamplesAlloc = nsamp;
             }
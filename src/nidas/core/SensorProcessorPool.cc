@@ -0,0 +1,348 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "SensorProcessorPool.h"
+#include "DSMSensor.h"
+
+#include <nidas/util/Logger.h>
+
+#include <algorithm>
+#include <sstream>
+
+using namespace nidas::core;
+using namespace std;
+
+namespace n_u = nidas::util;
+
+SensorProcessorPool::SensorProcessorPool(const string& name,
+        unsigned int nthreads):
+    _name(name),_threads(),_clients(),_mutex()
+{
+    if (nthreads == 0) nthreads = 1;
+    for (unsigned int i = 0; i < nthreads; i++) {
+        ostringstream ost;
+        ost << _name << "Process" << i;
+        ProcessThread* thr = new ProcessThread(ost.str());
+        _threads.push_back(thr);
+        thr->start();
+    }
+}
+
+SensorProcessorPool::~SensorProcessorPool()
+{
+    interrupt();
+    join();
+    for (unsigned int i = 0; i < _threads.size(); i++) {
+        ProcessThread* thr = _threads[i];
+        ILOG(("%s: processed %zu samples, dropped %zu, waited for room "
+              "%zu times, max backlog %zu",
+              thr->getName().c_str(), thr->getNumProcessed(),
+              thr->getNumDropped(), thr->getNumWaits(),
+              thr->getMaxBacklog()));
+        delete thr;
+    }
+    map<SampleClient*, QueueClient*>::iterator ci = _clients.begin();
+    for ( ; ci != _clients.end(); ++ci) delete ci->second;
+}
+
+SampleClient* SensorProcessorPool::getClient(DSMSensor* sensor)
+{
+    return getClient(sensor, sensor->getName());
+}
+
+SampleClient* SensorProcessorPool::getClient(SampleClient* client,
+        const string& name)
+{
+    n_u::Autolock autolock(_mutex);
+    map<SampleClient*, QueueClient*>::iterator ci = _clients.find(client);
+    if (ci != _clients.end()) return ci->second;
+
+    // The thread with the fewest clients.
+    ProcessThread* thr = _threads[0];
+    for (unsigned int i = 1; i < _threads.size(); i++)
+        if (_threads[i]->_nclients < thr->_nclients) thr = _threads[i];
+    thr->_nclients++;
+
+    DLOG(("%s: %s assigned to %s", _name.c_str(),
+          name.c_str(), thr->getName().c_str()));
+
+    QueueClient* qclient = new QueueClient(client, thr);
+    _clients[client] = qclient;
+    return qclient;
+}
+
+SampleClient* SensorProcessorPool::findClient(SampleClient* client)
+{
+    n_u::Autolock autolock(_mutex);
+    map<SampleClient*, QueueClient*>::iterator ci = _clients.find(client);
+    if (ci != _clients.end()) return ci->second;
+    return 0;
+}
+
+void SensorProcessorPool::flush() throw()
+{
+    for (unsigned int i = 0; i < _threads.size(); i++)
+        _threads[i]->flush();
+}
+
+void SensorProcessorPool::interrupt()
+{
+    for (unsigned int i = 0; i < _threads.size(); i++)
+        _threads[i]->interrupt();
+}
+
+void SensorProcessorPool::join() throw()
+{
+    for (unsigned int i = 0; i < _threads.size(); i++) {
+        ProcessThread* thr = _threads[i];
+        if (thr->isJoined()) continue;
+        try {
+            thr->join();
+        }
+        catch(const n_u::Exception& e) {
+            WLOG(("%s: %s", thr->getName().c_str(), e.what()));
+        }
+    }
+}
+
+void SensorProcessorPool::setMaxQueueLength(size_t val)
+{
+    for (unsigned int i = 0; i < _threads.size(); i++)
+        _threads[i]->setMaxQueueLength(val);
+}
+
+void SensorProcessorPool::setMaxLag(dsm_time_t val)
+{
+    for (unsigned int i = 0; i < _threads.size(); i++)
+        _threads[i]->setMaxLag(val);
+}
+
+void SensorProcessorPool::setDropWhenFull(bool val)
+{
+    for (unsigned int i = 0; i < _threads.size(); i++)
+        _threads[i]->setDropWhenFull(val);
+}
+
+size_t SensorProcessorPool::getNumDropped() const
+{
+    size_t n = 0;
+    for (unsigned int i = 0; i < _threads.size(); i++)
+        n += _threads[i]->getNumDropped();
+    return n;
+}
+
+size_t SensorProcessorPool::getNumWaits() const
+{
+    size_t n = 0;
+    for (unsigned int i = 0; i < _threads.size(); i++)
+        n += _threads[i]->getNumWaits();
+    return n;
+}
+
+size_t SensorProcessorPool::getMaxBacklog() const
+{
+    size_t n = 0;
+    for (unsigned int i = 0; i < _threads.size(); i++)
+        n = std::max(n, _threads[i]->getMaxBacklog());
+    return n;
+}
+
+SensorProcessorPool::ProcessThread::ProcessThread(const string& name):
+    n_u::Thread(name),_nclients(0),_queue(),_busy(false),
+    _maxQueueLength(10000),_maxLag(0),_headTime(0),_nlagWaits(0),
+    _dropWhenFull(false),_nprocessed(0),
+    _ndropped(0),_nwaits(0),_maxBacklog(0),_queueCond()
+{
+}
+
+SensorProcessorPool::ProcessThread::~ProcessThread()
+{
+    _queueCond.lock();
+    freeQueued();
+    _queueCond.unlock();
+}
+
+void SensorProcessorPool::ProcessThread::setMaxQueueLength(size_t val)
+{
+    _queueCond.lock();
+    _maxQueueLength = std::max(val, (size_t)1);
+    _queueCond.broadcast();
+    _queueCond.unlock();
+}
+
+void SensorProcessorPool::ProcessThread::setMaxLag(dsm_time_t val)
+{
+    _queueCond.lock();
+    _maxLag = std::max(val, (dsm_time_t)0);
+    _queueCond.broadcast();
+    _queueCond.unlock();
+}
+
+void SensorProcessorPool::ProcessThread::setDropWhenFull(bool val)
+{
+    n_u::Autolock autolock(_queueCond);
+    _dropWhenFull = val;
+}
+
+size_t SensorProcessorPool::ProcessThread::getNumProcessed() const
+{
+    n_u::Autolock autolock(_queueCond);
+    return _nprocessed;
+}
+
+size_t SensorProcessorPool::ProcessThread::getNumDropped() const
+{
+    n_u::Autolock autolock(_queueCond);
+    return _ndropped;
+}
+
+size_t SensorProcessorPool::ProcessThread::getNumWaits() const
+{
+    n_u::Autolock autolock(_queueCond);
+    return _nwaits;
+}
+
+size_t SensorProcessorPool::ProcessThread::getMaxBacklog() const
+{
+    n_u::Autolock autolock(_queueCond);
+    return _maxBacklog;
+}
+
+bool SensorProcessorPool::ProcessThread::isBehind(dsm_time_t tt) const
+{
+    if (_maxLag <= 0) return false;
+    dsm_time_t head;
+    if (_busy) head = _headTime.load();
+    else if (!_queue.empty()) head = _queue.front().second->getTimeTag();
+    else return false;
+    return tt - head > _maxLag;
+}
+
+bool SensorProcessorPool::ProcessThread::enqueue(SampleClient* client,
+        const Sample* s)
+{
+    dsm_time_t tt = s->getTimeTag();
+    _queueCond.lock();
+    if ((_queue.size() >= _maxQueueLength || isBehind(tt)) &&
+            !isInterrupted()) {
+        if (_dropWhenFull) {
+            if (!(_ndropped++ % 100))
+                WLOG(("%s: %zu samples queued, %.3f sec behind, "
+                      "%zu dropped", getName().c_str(), _queue.size(),
+                      (double)(tt - (_busy ? _headTime.load() :
+                               _queue.front().second->getTimeTag())) /
+                      USECS_PER_SEC, _ndropped));
+            _queueCond.unlock();
+            return false;
+        }
+        _nwaits++;
+        _nlagWaits++;
+        while ((_queue.size() >= _maxQueueLength || isBehind(tt)) &&
+                !isInterrupted())
+            _queueCond.wait();
+        _nlagWaits--;
+    }
+    if (isInterrupted()) {
+        _queueCond.unlock();
+        return false;
+    }
+    s->holdReference();
+    _queue.push_back(make_pair(client, s));
+    _maxBacklog = std::max(_maxBacklog, _queue.size());
+    // run() only waits when the queue is empty.
+    if (_queue.size() == 1) _queueCond.broadcast();
+    _queueCond.unlock();
+    return true;
+}
+
+void SensorProcessorPool::ProcessThread::flush()
+{
+    _queueCond.lock();
+    while ((!_queue.empty() || _busy) && !isInterrupted())
+        _queueCond.wait();
+    _queueCond.unlock();
+}
+
+void SensorProcessorPool::ProcessThread::interrupt()
+{
+    _queueCond.lock();
+    Thread::interrupt();
+    _queueCond.broadcast();
+    _queueCond.unlock();
+}
+
+int SensorProcessorPool::ProcessThread::run()
+{
+    queue_t samples;
+
+    _queueCond.lock();
+    while (!isInterrupted()) {
+        if (_queue.empty()) {
+            // wake up any flush()
+            _busy = false;
+            _queueCond.broadcast();
+            _queueCond.wait();
+            continue;
+        }
+        samples.swap(_queue);
+        _busy = true;
+        _headTime = samples.front().second->getTimeTag();
+        // wake up any enqueue() waiting for room in the queue
+        _queueCond.broadcast();
+        _queueCond.unlock();
+
+        queue_t::const_iterator si = samples.begin();
+        for ( ; si != samples.end(); ++si) {
+            _headTime = si->second->getTimeTag();
+            if (_nlagWaits > 0) {
+                // wake up an enqueue() waiting for this thread
+                // to catch up.
+                _queueCond.lock();
+                _queueCond.broadcast();
+                _queueCond.unlock();
+            }
+            si->first->receive(si->second);
+            si->second->freeReference();
+        }
+
+        _queueCond.lock();
+        _nprocessed += samples.size();
+        samples.clear();
+    }
+    _busy = false;
+    freeQueued();
+    _queueCond.broadcast();
+    _queueCond.unlock();
+    return RUN_OK;
+}
+
+void SensorProcessorPool::ProcessThread::freeQueued()
+{
+    queue_t::const_iterator si = _queue.begin();
+    for ( ; si != _queue.end(); ++si)
+        si->second->freeReference();
+    _queue.clear();
+}
@@ -0,0 +1,333 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+#ifndef NIDAS_CORE_SENSORPROCESSORPOOL_H
+#define NIDAS_CORE_SENSORPROCESSORPOOL_H
+
+#include "SampleClient.h"
+#include "Sample.h"
+
+#include <nidas/util/Thread.h>
+#include <nidas/util/ThreadSupport.h>
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nidas { namespace core {
+
+class DSMSensor;
+
+/**
+ * A pool of threads which call DSMSensor::receive(), and so
+ * DSMSensor::process(), on raw samples.  Each DSMSensor is assigned to
+ * one thread of the pool, so that the process() method of a sensor is
+ * never called concurrently, and the raw samples of a sensor are
+ * processed in the order they are received.  The processed samples of
+ * all the threads are passed by the sensors to their SampleClients,
+ * typically the processed SampleSorter of a SamplePipeline, which
+ * restores their time order.
+ *
+ * A SampleSorter passes samples which arrive later than its length
+ * out of time order, so the sorter can only restore the order if no
+ * thread falls further behind than that.  setMaxLag() bounds, in time,
+ * how far the oldest unprocessed sample of a thread can be behind the
+ * latest sample received by the pool.  It should be less than the
+ * length of the sorter, with a margin for differences between the time
+ * tags of raw and processed samples.
+ *
+ * Without a pool, a SamplePipeline calls the process() method of every
+ * sensor from the thread of the raw SampleSorter, so one slow sensor
+ * delays all the others.
+ *
+ * Other SampleClients, such as the StatisticsCrunchers of a
+ * StatisticsProcessor, can be assigned to the pool in the same way
+ * with getClient(SampleClient*, const std::string&).
+ */
+class SensorProcessorPool
+{
+public:
+
+    /**
+     * Create and start nthreads threads.
+     */
+    SensorProcessorPool(const std::string& name, unsigned int nthreads);
+
+    /**
+     * Interrupt and join the threads, and free any samples that
+     * were not processed.
+     */
+    ~SensorProcessorPool();
+
+    /**
+     * Assign a sensor to a thread of the pool, if it has not already
+     * been assigned, and return the SampleClient which should receive
+     * the raw samples of the sensor in place of the sensor itself.
+     * Sensors are assigned to the thread with the fewest clients.
+     */
+    SampleClient* getClient(DSMSensor* sensor);
+
+    /**
+     * Assign a SampleClient to a thread of the pool, and return the
+     * SampleClient which should receive samples in its place.
+     * The receive() method of client is then only called from
+     * that thread.  name is used in log messages.
+     */
+    SampleClient* getClient(SampleClient* client, const std::string& name);
+
+    /**
+     * Return the SampleClient which was returned by getClient() for
+     * client, or null if client has not been assigned to the pool.
+     */
+    SampleClient* findClient(SampleClient* client);
+
+    /**
+     * Wait until all samples received by the pool have been
+     * processed.
+     */
+    void flush() throw();
+
+    void interrupt();
+
+    void join() throw();
+
+    unsigned int getNumThreads() const { return _threads.size(); }
+
+    /**
+     * Maximum number of samples waiting to be processed by a thread.
+     * If exceeded, the thread which is passing raw samples to the
+     * pool waits, or the sample is dropped if setDropWhenFull(true).
+     * Default: 10000.
+     */
+    void setMaxQueueLength(size_t val);
+
+    /**
+     * Maximum difference, in microseconds, between the time tag of a
+     * sample received by the pool and that of the oldest sample which
+     * its thread has not finished processing.  If exceeded, the
+     * receiving thread waits, or the sample is dropped if
+     * setDropWhenFull(true).  Default: 0, no limit.
+     */
+    void setMaxLag(dsm_time_t usecs);
+
+    /**
+     * If true, a sample received when the queue of its thread is full,
+     * or is behind by more than setMaxLag(), is dropped and counted,
+     * rather than the receiving thread waiting.  Real-time pipelines
+     * can use this so that a sensor which cannot keep up does not
+     * delay the other sensors.  Default: false.
+     */
+    void setDropWhenFull(bool val);
+
+    /**
+     * Number of samples dropped because the queue of their thread
+     * was full, or too far behind.
+     */
+    size_t getNumDropped() const;
+
+    /**
+     * Number of samples received when the queue of their thread was
+     * full, or too far behind, for which the receiving thread waited.
+     */
+    size_t getNumWaits() const;
+
+    /**
+     * Largest number of samples that have been waiting to be processed
+     * by one thread.
+     */
+    size_t getMaxBacklog() const;
+
+private:
+
+    /**
+     * A thread which calls SampleClient::receive() on queued samples.
+     */
+    class ProcessThread: public nidas::util::Thread
+    {
+    public:
+        ProcessThread(const std::string& name);
+
+        ~ProcessThread();
+
+        /**
+         * Queue a sample for a client, waiting if the queue is full
+         * or too far behind.  Returns false if the thread has been
+         * interrupted, or if the sample was dropped.
+         */
+        bool enqueue(SampleClient* client, const Sample* s);
+
+        /**
+         * Wait until the queue is empty and the thread is not
+         * processing samples.
+         */
+        void flush();
+
+        void interrupt();
+
+        int run();
+
+        void setMaxQueueLength(size_t val);
+
+        void setMaxLag(dsm_time_t val);
+
+        void setDropWhenFull(bool val);
+
+        /**
+         * Number of samples processed.
+         */
+        size_t getNumProcessed() const;
+
+        size_t getNumDropped() const;
+
+        size_t getNumWaits() const;
+
+        size_t getMaxBacklog() const;
+
+        /**
+         * Number of clients assigned to this thread.
+         */
+        unsigned int _nclients;
+
+    private:
+
+        /**
+         * Free queued samples. _queueCond must be locked.
+         */
+        void freeQueued();
+
+        /**
+         * Whether a sample with time tag tt is more than _maxLag
+         * after the oldest sample not yet processed.
+         * _queueCond must be locked.
+         */
+        bool isBehind(dsm_time_t tt) const;
+
+        typedef std::vector<std::pair<SampleClient*, const Sample*> > queue_t;
+
+        /**
+         * Samples waiting to be processed, in the order received.
+         */
+        queue_t _queue;
+
+        /**
+         * Whether run() is processing samples which it has taken
+         * from _queue.
+         */
+        bool _busy;
+
+        size_t _maxQueueLength;
+
+        dsm_time_t _maxLag;
+
+        /**
+         * Time tag of the sample being processed by run(), set when
+         * _busy, without locking _queueCond.
+         */
+        std::atomic<dsm_time_t> _headTime;
+
+        /**
+         * Number of threads in enqueue() waiting for run() to catch up,
+         * which run() wakes as _headTime advances.
+         */
+        std::atomic<int> _nlagWaits;
+
+        bool _dropWhenFull;
+
+        size_t _nprocessed;
+
+        size_t _ndropped;
+
+        size_t _nwaits;
+
+        size_t _maxBacklog;
+
+        /**
+         * Signaled when samples are added to an empty _queue, when run()
+         * takes samples from _queue or runs out of samples, and when
+         * the thread is interrupted.
+         */
+        mutable nidas::util::Cond _queueCond;
+
+        /** No copying. */
+        ProcessThread(const ProcessThread&) = delete;
+
+        /** No assignment. */
+        ProcessThread& operator=(const ProcessThread&) = delete;
+    };
+
+    /**
+     * The SampleClient for the samples of one client of the pool,
+     * such as the raw samples of a sensor, which queues them to the
+     * ProcessThread of the client.
+     */
+    class QueueClient: public SampleClient
+    {
+    public:
+        QueueClient(SampleClient* client, ProcessThread* thread):
+            _client(client),_thread(thread)
+        {}
+
+        bool receive(const Sample* s) throw()
+        {
+            return _thread->enqueue(_client, s);
+        }
+
+        void flush() throw()
+        {
+            _thread->flush();
+        }
+
+    private:
+        SampleClient* _client;
+
+        ProcessThread* _thread;
+
+        /** No copying. */
+        QueueClient(const QueueClient&) = delete;
+
+        /** No assignment. */
+        QueueClient& operator=(const QueueClient&) = delete;
+    };
+
+    std::string _name;
+
+    std::vector<ProcessThread*> _threads;
+
+    std::map<SampleClient*, QueueClient*> _clients;
+
+    nidas::util::Mutex _mutex;
+
+    /** No copying. */
+    SensorProcessorPool(const SensorProcessorPool&) = delete;
+
+    /** No assignment. */
+    SensorProcessorPool& operator=(const SensorProcessorPool&) = delete;
+};
+
+}}	// namespace nidas namespace core
+
+#endif
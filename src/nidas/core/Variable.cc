@@ -164,22 +164,12 @@ void Variable::setMinValue(float val)
     if (std::isnan(_plotRange[0])) _plotRange[0] = val;
 }
 
-float Variable::getMinValue() const
-{
-    return _minValue;
-}
-
 void Variable::setMaxValue(float val)
 {
     _maxValue = val;
     if (std::isnan(_plotRange[1])) _plotRange[1] = val;
 }
 
-float Variable::getMaxValue() const
-{
-    return _maxValue;
-}
-
 void Variable::setPlotRange(float minv,float maxv)
 {
     _plotRange[0] = minv;
@@ -341,11 +341,17 @@ public:
      */
     void setMinValue(float val);
 
-    float getMinValue() const;
+    float getMinValue() const
+    {
+        return _minValue;
+    }
 
     void setMaxValue(float val);
 
-    float getMaxValue() const;
+    float getMaxValue() const
+    {
+        return _maxValue;
+    }
 
     void setPlotRange(float minv,float maxv);
 
@@ -0,0 +1,80 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "ZstdFileSet.h"
+
+#ifdef HAVE_ZSTD_H
+
+#include <nidas/util/InvalidParameterException.h>
+
+#include <sstream>
+
+using namespace nidas::core;
+using namespace std;
+
+namespace n_u = nidas::util;
+
+ZstdFileSet::ZstdFileSet(): FileSet(new nidas::util::ZstdFileSet())
+{
+     _name = "ZstdFileSet";
+}
+
+/* Copy constructor. */
+ZstdFileSet::ZstdFileSet(const ZstdFileSet& x):
+    	FileSet(x)
+{
+}
+
+void ZstdFileSet::fromDOMElement(const xercesc::DOMElement* node)
+{
+    FileSet::fromDOMElement(node);
+
+    if(node->hasAttributes()) {
+	// get all the attributes of the node
+        xercesc::DOMNamedNodeMap *pAttributes = node->getAttributes();
+        int nSize = pAttributes->getLength();
+        for(int i=0;i<nSize;++i) {
+            XDOMAttr attr((xercesc::DOMAttr*) pAttributes->item(i));
+            // get attribute name
+            const std::string& aname = attr.getName();
+            const std::string& aval = attr.getValue();
+	    if (aname == "threads" || aname == "level") {
+		istringstream ist(aval);
+		int val;
+		ist >> val;
+		if (ist.fail() || val < 0)
+		    throw n_u::InvalidParameterException(getName(),
+			aname, aval);
+		if (aname == "threads") {
+		    getZstdFileSet()->setCompressThreads(val);
+		    getZstdFileSet()->setUncompressThreads(val);
+		}
+		else getZstdFileSet()->setCompressionLevel(val);
+	    }
+	}
+    }
+}
+#endif
@@ -30,7 +30,7 @@
 #include <nidas/util/Logger.h>
 #include <nidas/util/UTime.h>
 
-#include <iomanip>
+#include <cstring>
 
 using namespace std;
 using namespace nidas::dynld;
@@ -41,14 +41,18 @@ namespace n_r = nidas::dynld::raf;
 
 NIDAS_CREATOR_FUNCTION(AsciiOutput)
 
+namespace {
+const char* TIME_FORMAT = "%Y %m %d %H:%M:%S.%3f ";
+}
+
 AsciiOutput::AsciiOutput():
-    SampleOutputBase(),_ostr(),
+    SampleOutputBase(),_buf(),_timeFormat(TIME_FORMAT),_idFill(' '),
     _format(HEX),_prevTT(),_headerOut(false)
 {
 }
 
 AsciiOutput::AsciiOutput(IOChannel* ioc,SampleConnectionRequester* rqstr):
-    SampleOutputBase(ioc,rqstr),_ostr(),
+    SampleOutputBase(ioc,rqstr),_buf(),_timeFormat(TIME_FORMAT),_idFill(' '),
     _format(HEX),_prevTT(),_headerOut(false)
 {
     setName("AsciiOutput: " + getIOChannel()->getName());
@@ -59,7 +63,7 @@ AsciiOutput::AsciiOutput(IOChannel* ioc,SampleConnectionRequester* rqstr):
  */
 AsciiOutput::AsciiOutput(AsciiOutput& x,IOChannel* ioc):
     SampleOutputBase(x,ioc),
-    _ostr(),_format(x._format),
+    _buf(),_timeFormat(TIME_FORMAT),_idFill(' '),_format(x._format),
     _prevTT(),_headerOut(false)
 {
     setName("AsciiOutput: " + getIOChannel()->getName());
@@ -86,10 +90,9 @@ void AsciiOutput::connect(SampleSource* source)
 
 void AsciiOutput::printHeader()
 {
-    _ostr << "|- id --| |--- date time -------| deltaT    bytes" << endl;
-    getIOChannel()->write(_ostr.str().c_str(),_ostr.str().length());
-    _ostr.str("");
-    _ostr.clear();
+    static const char header[] =
+        "|- id --| |--- date time -------| deltaT    bytes\n";
+    getIOChannel()->write(header,sizeof(header)-1);
     _headerOut = true;
 }
 
@@ -131,22 +134,27 @@ bool AsciiOutput::receive(const Sample* samp)
     }
     else _prevTT[sampid] = tt;
 
-    n_u::UTime ut(tt);
-
-    _ostr << setw(3) << GET_DSM_ID(sampid) << ',' <<
-    	setw(5) << GET_SHORT_ID(sampid) << ' ' <<
-	ut.format(true,"%Y %m %d %H:%M:%S.%3f ") <<
-	setfill(' ') << setprecision(3) << setw(5) << ttdiff << ' ' <<
-	setw(7) << setfill(' ') << samp->getDataByteLength() << ' ';
+    _buf.clear();
+    _buf.appendUnsigned(GET_DSM_ID(sampid),3,_idFill);
+    _buf.append(',');
+    _buf.appendUnsigned(GET_SHORT_ID(sampid),5,_idFill);
+    _buf.append(' ');
+    _timeFormat.append(_buf,tt);
+    _buf.appendGeneral(ttdiff,3,5);
+    _buf.append(' ');
+    _buf.appendUnsigned(samp->getDataByteLength(),7);
+    _buf.append(' ');
 
     switch (samp->getType()) {
     case FLOAT_ST:
     case DOUBLE_ST:
 	{
-	_ostr << setprecision(7) << setfill(' ');
-	for (unsigned int i = 0; i < samp->getDataLength(); i++)
-	    _ostr << setw(10) << samp->getDataValue(i) << ' ';
-	_ostr << endl;
+	for (unsigned int i = 0; i < samp->getDataLength(); i++) {
+	    _buf.appendGeneral(samp->getDataValue(i),7,10);
+	    _buf.append(' ');
+	}
+	_buf.append('\n');
+	_idFill = ' ';
 	}
 	break;
     case CHAR_ST:
@@ -154,49 +162,57 @@ bool AsciiOutput::receive(const Sample* samp)
 	switch(_format) {
 	case ASCII:
 	    {
-	    string dstr((const char*)samp->getConstVoidDataPtr(),
+	    _buf.append((const char*)samp->getConstVoidDataPtr(),
 		    samp->getDataByteLength());
-	    _ostr << dstr << endl;
+	    _buf.append('\n');
 	    }
 	    break;
 	case HEX:
 	    {
 	    const unsigned char* cp =
 		    (const unsigned char*) samp->getConstVoidDataPtr();
-	    _ostr << setfill('0');
-	    for (unsigned int i = 0; i < samp->getDataByteLength(); i++)
-		_ostr << hex << setw(2) << (unsigned int)cp[i] << dec << ' ';
-	    _ostr << endl;
+	    for (unsigned int i = 0; i < samp->getDataByteLength(); i++) {
+		_buf.appendHex(cp[i],2,'0');
+		_buf.append(' ');
+	    }
+	    _buf.append('\n');
+	    _idFill = '0';
 	    }
 	    break;
 	case SIGNED_SHORT:
 	    {
 	    const short* sp =
 		    (const short*) samp->getConstVoidDataPtr();
-	    _ostr << setfill(' ');
-	    for (unsigned int i = 0; i < samp->getDataByteLength()/2; i++)
-		_ostr << setw(6) << sp[i] << ' ';
-	    _ostr << endl;
+	    for (unsigned int i = 0; i < samp->getDataByteLength()/2; i++) {
+		_buf.appendInt(sp[i],6);
+		_buf.append(' ');
+	    }
+	    _buf.append('\n');
+	    _idFill = ' ';
 	    }
 	    break;
 	case UNSIGNED_SHORT:
 	    {
 	    const unsigned short* sp =
 		    (const unsigned short*) samp->getConstVoidDataPtr();
-	    _ostr << setfill(' ');
-	    for (unsigned int i = 0; i < samp->getDataByteLength()/2; i++)
-		_ostr << setw(6) << sp[i] << ' ';
-	    _ostr << endl;
+	    for (unsigned int i = 0; i < samp->getDataByteLength()/2; i++) {
+		_buf.appendUnsigned(sp[i],6);
+		_buf.append(' ');
+	    }
+	    _buf.append('\n');
+	    _idFill = ' ';
 	    }
 	    break;
 	case FLOAT:
 	    {
 	    const float* fp =
 		    (const float*) samp->getConstVoidDataPtr();
-	    _ostr << setprecision(6) << setfill(' ');
-	    for (unsigned int i = 0; i < samp->getDataByteLength()/4; i++)
-		_ostr << setw(10) << fp[i] << ' ';
-	    _ostr << endl;
+	    for (unsigned int i = 0; i < samp->getDataByteLength()/4; i++) {
+		_buf.appendGeneral(fp[i],6,10);
+		_buf.append(' ');
+	    }
+	    _buf.append('\n');
+	    _idFill = ' ';
 	    }
 	    break;
 	case IRIG:
@@ -211,10 +227,14 @@ bool AsciiOutput::receive(const Sample* samp)
 	    n_u::UTime itt((dsm_time_t) tv.tv_sec * USECS_PER_SEC
 	    	+ tv.tv_usec);
 
-	    _ostr << itt.format(true,"%Y %m %d %H:%M:%S.%6f ") << 
-		' ' << setw(2) << setfill('0') << hex << (int)status << dec <<
-		'(' << n_r::IRIGSensor::statusString(status) << ')';
-	    _ostr << endl;
+	    _buf.append(itt.format(true,"%Y %m %d %H:%M:%S.%6f "));
+	    _buf.append(' ');
+	    _buf.appendHex(status,2,'0');
+	    _buf.append('(');
+	    _buf.append(n_r::IRIGSensor::statusString(status));
+	    _buf.append(')');
+	    _buf.append('\n');
+	    _idFill = '0';
 	    }
 	    break;
 	case DEFAULT:
@@ -224,10 +244,9 @@ bool AsciiOutput::receive(const Sample* samp)
     }
 
     try {
-	getIOChannel()->write(_ostr.str().c_str(),_ostr.str().length());
+	getIOChannel()->write(_buf.data(),_buf.size());
     }
     catch(const n_u::IOException& ioe) {
-        _ostr.str("");
 	n_u::Logger::getInstance()->log(LOG_ERR,
 	"%s: %s",getName().c_str(),ioe.what());
         // this disconnect may schedule this object to be deleted
@@ -236,8 +255,6 @@ bool AsciiOutput::receive(const Sample* samp)
 	disconnect();
 	return false;
     }
-    _ostr.str("");
-    _ostr.clear();
     return true;
 }
 
@@ -28,6 +28,8 @@
 #define NIDAS_DYNLD_ASCIIOUTPUT_H
 
 #include <nidas/core/SampleOutput.h>
+#include <nidas/util/FormatBuffer.h>
+#include <nidas/util/UTimeFormatter.h>
 
 #include <iostream>
 
@@ -96,7 +98,17 @@ protected:
 
 private:
 
-    std::ostringstream _ostr;
+    nidas::util::FormatBuffer _buf;
+
+    nidas::util::UTimeFormatter _timeFormat;
+
+    /**
+     * Fill character of the id fields.  Lines were once formatted
+     * with an ostream, whose fill was left at '0' by the HEX and IRIG
+     * formats and so carried over into the ids of the next line.
+     * That output is kept.
+     */
+    char _idFill;
 
     format_t _format;
 
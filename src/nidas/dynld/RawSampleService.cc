@@ -66,7 +66,8 @@ RawSampleService::RawSampleService():
     _nsampsLast(), _nbytesLast(),
     _rawSorterLength(0.25), _procSorterLength(1.0),
     _rawHeapMax(5000000), _procHeapMax(5000000),
-    _rawLateSampleCacheSize(0), _procLateSampleCacheSize(0)
+    _rawLateSampleCacheSize(0), _procLateSampleCacheSize(0),
+    _processThreads(0),_asyncProcessThreads(0)
 {
 }
 
@@ -93,6 +94,9 @@ void RawSampleService::schedule(bool optionalProcessing)
     _pipeline->setRawLateSampleCacheSize(getRawLateSampleCacheSize());
     _pipeline->setProcLateSampleCacheSize(getProcLateSampleCacheSize());
 
+    _pipeline->setProcessThreads(getProcessThreads());
+    _pipeline->setAsyncProcessThreads(getAsyncProcessThreads());
+
     _pipeline->setRawHeapMax(getRawHeapMax());
     _pipeline->setProcHeapMax(getProcHeapMax());
 
@@ -628,8 +632,32 @@ void RawSampleService::fromDOMElement(const xercesc::DOMElement* node)
                 if (aname[0] == 'r') setRawLateSampleCacheSize(val);
                 else setProcLateSampleCacheSize(val);
 	    }
+            else if (aname == "processThreads") {
+		int val;
+		istringstream ist(aval);
+		ist >> val;
+		if (ist.fail() || val < 0) throw n_u::InvalidParameterException(
+		    string("dsm") + ": " + getName(), aname,aval);
+                setProcessThreads(val);
+	    }
+            else if (aname == "asyncProcessThreads") {
+		int val;
+		istringstream ist(aval);
+		ist >> val;
+		if (ist.fail() || val < 0) throw n_u::InvalidParameterException(
+		    string("dsm") + ": " + getName(), aname,aval);
+                setAsyncProcessThreads(val);
+	    }
         }
     }
+    // The processed sorter merges the samples of the process threads.
+    if ((getProcessThreads() > 0 || getAsyncProcessThreads() > 0) &&
+            getProcSorterLength() <= 0)
+        throw n_u::InvalidParameterException(
+            string("dsm") + ": " + getName(),
+            (getProcessThreads() > 0 ? "processThreads" :
+             "asyncProcessThreads"),
+            "requires a procSorterLength greater than 0");
     list<SampleInput*>::iterator li = _inputs.begin();
     for ( ; li != _inputs.end(); ++li) {
         SampleInput* input = *li;
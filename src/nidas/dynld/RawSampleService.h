@@ -182,6 +182,32 @@ public:
         _procLateSampleCacheSize = val;
     }
 
+    /**
+     * See SamplePipeline::setProcessThreads(). Default: 0.
+     */
+    unsigned int getProcessThreads() const
+    {
+        return _processThreads;
+    }
+
+    void setProcessThreads(unsigned int val)
+    {
+        _processThreads = val;
+    }
+
+    /**
+     * See SamplePipeline::setAsyncProcessThreads(). Default: 0.
+     */
+    unsigned int getAsyncProcessThreads() const
+    {
+        return _asyncProcessThreads;
+    }
+
+    void setAsyncProcessThreads(unsigned int val)
+    {
+        _asyncProcessThreads = val;
+    }
+
 private:
 
     nidas::core::SamplePipeline* _pipeline;
@@ -236,6 +262,10 @@ private:
 
     unsigned int _procLateSampleCacheSize;
 
+    unsigned int _processThreads;
+
+    unsigned int _asyncProcessThreads;
+
     /**
      * Copying not supported.
      */
@@ -30,6 +30,8 @@
 #include <nidas/core/DSMService.h>
 #include <nidas/core/IOChannel.h>
 #include <nidas/core/IOStream.h>
+#include <nidas/core/FileSet.h>
+#include <nidas/core/SampleIndex.h>
 #include <nidas/util/Socket.h>
 
 #include <byteswap.h>
@@ -202,7 +204,9 @@ SampleInputStream::SampleInputStream(bool raw):
     _original(this),_raw(raw),
     _last_name(),
     _eofx("", ""),
-    _ateof(false)
+    _ateof(false),
+    _mappedInput(Logger::getScheme().getParameterT
+                 ("sample_input_stream_mmap", false))
 {
 }
 
@@ -221,10 +225,12 @@ SampleInputStream::SampleInputStream(IOChannel* iochannel, bool raw):
     _original(this),_raw(raw),
     _last_name(),
     _eofx("", ""),
-    _ateof(false)
+    _ateof(false),
+    _mappedInput(Logger::getScheme().getParameterT
+                 ("sample_input_stream_mmap", false))
 {
     setIOChannel(iochannel);
-    _iostream = new IOStream(*_iochan,_iochan->getBufferSize());
+    createIOStream();
 }
 
 /*
@@ -245,10 +251,11 @@ SampleInputStream::SampleInputStream(SampleInputStream& x,
     _original(&x),_raw(x._raw),
     _last_name(),
     _eofx("", ""),
-    _ateof(false)
+    _ateof(false),
+    _mappedInput(x._mappedInput)
 {
     setIOChannel(iochannel);
-    _iostream = new IOStream(*_iochan,_iochan->getBufferSize());
+    createIOStream();
 }
 
 /*
@@ -286,6 +293,18 @@ void SampleInputStream::setIOChannel(IOChannel* val)
     }
 }
 
+void SampleInputStream::createIOStream()
+{
+    _iostream = new IOStream(*_iochan,_iochan->getBufferSize());
+    _iostream->setMappedInput(_mappedInput);
+}
+
+void SampleInputStream::setMappedInput(bool val)
+{
+    _mappedInput = val;
+    if (_iostream) _iostream->setMappedInput(val);
+}
+
 void SampleInputStream::setNonBlocking(bool val)
 {
     if (_iochan) _iochan->setNonBlocking(val);
@@ -337,13 +356,13 @@ SampleInput* SampleInputStream::connected(IOChannel* ioc) throw()
         else {
             setIOChannel(ioc);
             delete _iostream;
-            _iostream = new IOStream(*_iochan,_iochan->getBufferSize());
+            createIOStream();
         }
     }
     else {
         setIOChannel(ioc);
         delete _iostream;
-        _iostream = new IOStream(*_iochan,_iochan->getBufferSize());
+        createIOStream();
         if (_service) _service->connect(this);
     }
     return this;
@@ -402,6 +421,7 @@ const DSMConfig* SampleInputStream::getDSMConfig() const
 
 void SampleInputStream::readInputHeader()
 {
+    if (_inputHeaderParsed) return;
     while (!_inputHeaderParsed)
     {
         // There shouldn't be any sample pending here, so it's safe to throw
@@ -422,6 +442,45 @@ void SampleInputStream::readInputHeader()
     }
     DLOG(CNAME << "input header parsed, offset is now "
          << _iostream->getNumInputBytes() << " bytes.");
+    seekWithIndex();
+}
+
+void SampleInputStream::seekWithIndex()
+{
+    FileSet* fset = dynamic_cast<FileSet*>(_iochan);
+    if (!fset || !fset->getIndexSeek()) return;
+
+    dsm_time_t start = fset->getStartTime().toUsecs();
+    string ipath = SampleIndex::indexPath(fset->getCurrentName());
+    SampleIndex index;
+    try {
+        if (!index.read(ipath)) return;
+    }
+    catch (const n_u::Exception& e) {
+        WLOG(("%s: %s, index not used", ipath.c_str(), e.what()));
+        return;
+    }
+
+    long long offset = index.findOffset(start);
+    long long pos = _iostream->getNumInputBytes();
+    if (offset <= pos) return;
+
+    size_t avail = _iostream->available();
+    if (avail > 0 && offset - pos <= (long long)avail) {
+        _iostream->skip(offset - pos);
+    }
+    else {
+        try {
+            fset->seek(offset);
+        }
+        catch (const n_u::IOException& e) {
+            WLOG(("%s: %s, index not used", ipath.c_str(), e.what()));
+            return;
+        }
+        _iostream->discardInput(offset);
+    }
+    ILOG(("%s: skipped to offset %lld of %s using index",
+          getName().c_str(), offset, fset->getCurrentName().c_str()));
 }
 
 bool SampleInputStream::parseInputHeader()
@@ -472,6 +472,19 @@ public:
 
     bool getExpectHeader() const { return _expectHeader; }
 
+    /**
+     * Read uncompressed files through a memory map, so that sample
+     * data is copied directly from the mapped pages into each Sample,
+     * rather than first being read into the IOStream buffer.
+     * See IOStream::setMappedInput().  Other inputs are read as usual.
+     * The default is the value of the log parameter
+     * "sample_input_stream_mmap", or false if it isn't set.
+     * Files must not be growing while they are read this way.
+     */
+    void setMappedInput(bool val);
+
+    bool getMappedInput() const { return _mappedInput; }
+
 protected:
 
     /**
@@ -629,6 +642,21 @@ private:
     nidas::util::EOFException _eofx;
     bool _ateof;
 
+    bool _mappedInput;
+
+    /**
+     * Create _iostream on _iochan.
+     */
+    void createIOStream();
+
+    /**
+     * If _iochan is a FileSet with getIndexSeek() enabled, and the
+     * current file has a SampleIndex, skip ahead to the first block
+     * of the file which may contain samples at or after the start
+     * time of the FileSet.  Called after an input header is parsed.
+     */
+    void seekWithIndex();
+
     /**
      * No regular copy.
      */
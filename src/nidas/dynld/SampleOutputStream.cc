@@ -26,6 +26,8 @@
 
 #include "SampleOutputStream.h"
 #include <nidas/core/StatusThread.h>
+#include <nidas/core/Bzip2FileSet.h>
+#include <nidas/core/ZstdFileSet.h>
 
 #include <nidas/util/Logger.h>
 
@@ -43,19 +45,25 @@ NIDAS_CREATOR_FUNCTION(SampleOutputStream)
 
 SampleOutputStream::SampleOutputStream():
     SampleOutputBase(),_iostream(0),
-    _maxUsecs(0),_lastFlushTT(0)
+    _maxUsecs(0),_lastFlushTT(0),_gatherMinLength(0),
+    _indexUsecs(0),_indexWriter(0),_fileOffset(0)
 {
     _maxUsecs = (int)(getLatency() * USECS_PER_SEC);
     _maxUsecs = std::max(_maxUsecs, int(USECS_PER_SEC / 50));
+    setGatherMinLength(n_u::Logger::getScheme().
+        getParameterT("sample_output_gather_min_length", 0));
 }
 
 SampleOutputStream::SampleOutputStream(IOChannel* i, SampleConnectionRequester* rqstr):
     SampleOutputBase(i,rqstr),_iostream(0),
-    _maxUsecs(0),_lastFlushTT(0)
+    _maxUsecs(0),_lastFlushTT(0),_gatherMinLength(0),
+    _indexUsecs(0),_indexWriter(0),_fileOffset(0)
 {
     _maxUsecs = (int)(getLatency() * USECS_PER_SEC);
     _maxUsecs = std::max(_maxUsecs, int(USECS_PER_SEC / 50));
-    _iostream = new IOStream(*getIOChannel(),getIOChannel()->getBufferSize());
+    setGatherMinLength(n_u::Logger::getScheme().
+        getParameterT("sample_output_gather_min_length", 0));
+    createIOStream();
     setName("SampleOutputStream: " + getIOChannel()->getName());
 }
 
@@ -65,17 +73,19 @@ SampleOutputStream::SampleOutputStream(IOChannel* i, SampleConnectionRequester*
 
 SampleOutputStream::SampleOutputStream(SampleOutputStream& x,IOChannel* ioc):
     SampleOutputBase(x,ioc),_iostream(0),
-    _maxUsecs(0),_lastFlushTT(0)
+    _maxUsecs(0),_lastFlushTT(0),_gatherMinLength(x._gatherMinLength),
+    _indexUsecs(x._indexUsecs),_indexWriter(0),_fileOffset(0)
 {
     _maxUsecs = (int)(getLatency() * USECS_PER_SEC);
     _maxUsecs = std::max(_maxUsecs, int(USECS_PER_SEC / 50));
-    _iostream = new IOStream(*getIOChannel(),getIOChannel()->getBufferSize());
+    createIOStream();
     setName("SampleOutputStream: " + getIOChannel()->getName());
 }
 
 SampleOutputStream::~SampleOutputStream()
 {
     VLOG(("~SampleOutputStream(), this=") << this);
+    closeIndex();
     delete _iostream;
 }
 
@@ -90,6 +100,7 @@ void SampleOutputStream::close()
     VLOG(("SampleOutputStream::close"));
     delete _iostream;
     _iostream = 0;
+    closeIndex();
     SampleOutputBase::close();
 }
 
@@ -102,6 +113,57 @@ void SampleOutputStream::setLatency(float val)
     _maxUsecs = usecs;
 }
 
+void SampleOutputStream::setGatherMinLength(size_t val)
+{
+    // On big-endian hosts the header is a byte-swapped local copy,
+    // which must always be copied.
+    if (val > 0 && val <= SampleHeader::getSizeOf())
+        val = SampleHeader::getSizeOf() + 1;
+    _gatherMinLength = val;
+    if (_iostream) _iostream->setGatherMinLength(val);
+}
+
+void SampleOutputStream::setIndexInterval(float val)
+{
+    if (val < 0.0)
+        throw n_u::InvalidParameterException(getName(),"indexInterval",
+                                             "negative");
+    _indexUsecs = (long long)(val * USECS_PER_SEC);
+}
+
+void SampleOutputStream::openIndex()
+{
+    closeIndex();
+    if (_indexUsecs <= 0) return;
+    FileSet* fset = dynamic_cast<FileSet*>(getIOChannel());
+    if (!fset) return;
+#ifdef HAVE_BZLIB_H
+    if (dynamic_cast<Bzip2FileSet*>(fset)) return;
+#endif
+#ifdef HAVE_ZSTD_H
+    if (dynamic_cast<ZstdFileSet*>(fset)) return;
+#endif
+    try {
+        _indexWriter = new SampleIndexWriter(
+            SampleIndex::indexPath(fset->getCurrentName()), _indexUsecs);
+    }
+    catch (const n_u::IOException& e) {
+        WLOG(("%s: %s", getName().c_str(), e.what()));
+    }
+}
+
+void SampleOutputStream::closeIndex()
+{
+    delete _indexWriter;
+    _indexWriter = 0;
+}
+
+void SampleOutputStream::createIOStream()
+{
+    _iostream = new IOStream(*getIOChannel(),getIOChannel()->getBufferSize());
+    _iostream->setGatherMinLength(_gatherMinLength);
+}
+
 SampleOutput* SampleOutputStream::connected(IOChannel* ioc) throw()
 {
     // If this is a new IOChannel, then SampleOutputBase::connected
@@ -109,11 +171,11 @@ SampleOutput* SampleOutputStream::connected(IOChannel* ioc) throw()
     // Otherwise we need to create the IOStream.
     if (ioc == getIOChannel()) {
         delete _iostream;
-        _iostream = new IOStream(*getIOChannel(),getIOChannel()->getBufferSize());
+        _iostream = 0;
+        createIOStream();
     }
     SampleOutput* so = SampleOutputBase::connected(ioc);
-    if (so == this && !_iostream)
-        _iostream = new IOStream(*getIOChannel(),getIOChannel()->getBufferSize());
+    if (so == this && !_iostream) createIOStream();
     return so;
 }
 
@@ -133,27 +195,41 @@ void SampleOutputStream::flush() throw()
 
 bool SampleOutputStream::receive(const Sample *samp) throw()
 {
-    VLOG(("SampleOutputStream::receive sample id=")
-         << samp->getDSMId() << ',' << samp->getSpSId());
+    return receiveBatch(&samp, 1);
+}
 
-    dsm_time_t tsamp = samp->getTimeTag();
+bool SampleOutputStream::receiveBatch(const Sample* const* samps,
+        size_t nsamps) throw()
+{
     bool streamFlush = false;
 
     try {
-        if (tsamp >= getNextFileTime()) {
-            if (_iostream) _iostream->flush();
-            createNextFile(tsamp);
-        }
-        if ((tsamp - _lastFlushTT) > _maxUsecs) {
-            _lastFlushTT = tsamp;
-            streamFlush = true;
-        }
+        for (size_t i = 0; i < nsamps; i++) {
+            const Sample* samp = samps[i];
+            VLOG(("SampleOutputStream::receive sample id=")
+                 << samp->getDSMId() << ',' << samp->getSpSId());
+
+            dsm_time_t tsamp = samp->getTimeTag();
+
+            if (tsamp >= getNextFileTime()) {
+                if (_iostream) _iostream->flush();
+                _fileOffset = 0;
+                createNextFile(tsamp);
+                openIndex();
+            }
+            if ((tsamp - _lastFlushTT) > _maxUsecs) {
+                _lastFlushTT = tsamp;
+                streamFlush = true;
+            }
 
-        bool success = write(samp,streamFlush) > 0;
-        if (!success) {
-            if (!(incrementDiscardedSamples() % 1000)) 
-                WLOG(("%s: %zd samples discarded due to output jambs",
-                      getName().c_str(), getNumDiscardedSamples()));
+            // Defer any flush to the last sample of the batch.
+            bool last = i == nsamps - 1;
+            bool success = write(samp, streamFlush && last) > 0;
+            if (!success) {
+                if (!(incrementDiscardedSamples() % 1000))
+                    WLOG(("%s: %zd samples discarded due to output jambs",
+                          getName().c_str(), getNumDiscardedSamples()));
+            }
         }
     }
     catch(const n_u::IOException& ioe) {
@@ -175,7 +251,9 @@ bool SampleOutputStream::receive(const Sample *samp) throw()
 size_t SampleOutputStream::write(const void* buf, size_t len, bool flush)
 {
     if (!_iostream) return 0;
-    return _iostream->write(buf,len,flush);
+    size_t l = _iostream->write(buf,len,flush);
+    _fileOffset += l;
+    return l;
 }
 
 size_t SampleOutputStream::write(const Sample* samp, bool streamFlush)
@@ -209,7 +287,20 @@ size_t SampleOutputStream::write(const Sample* samp, bool streamFlush)
     {
         lp.log() << "wrote " << nsamps << " samples";
     }
-    size_t l = _iostream->write(iov,2,streamFlush);
+    size_t l = _iostream->write(iov,2,streamFlush,samp);
+    if (l > 0) {
+        if (_indexWriter) {
+            try {
+                _indexWriter->addSample(samp, _fileOffset);
+            }
+            catch (const n_u::IOException& e) {
+                WLOG(("%s: %s, index discontinued",
+                      getName().c_str(), e.what()));
+                closeIndex();
+            }
+        }
+        _fileOffset += l;
+    }
     return l;
 }
 
@@ -29,6 +29,7 @@
 
 
 #include <nidas/core/SampleOutput.h>
+#include <nidas/core/SampleIndex.h>
 
 namespace nidas { namespace dynld {
 
@@ -73,6 +74,12 @@ public:
 
     bool receive(const Sample *s) throw();
 
+    /**
+     * Write a batch of samples.  A physical write due to the latency
+     * is done at most once per batch, after the last sample.
+     */
+    bool receiveBatch(const Sample* const* samps, size_t nsamps) throw();
+
     void flush() throw();
 
     /**
@@ -107,6 +114,31 @@ public:
      **/
     void setLatency(float val);
 
+    /**
+     * Sample data of at least this many bytes is not copied into the
+     * buffer of the IOStream, but is written from the sample with
+     * a gathering write. See IOStream::setGatherMinLength().
+     * This reduces copying for streams of large samples, such as
+     * images.  The default is the value of the log parameter
+     * "sample_output_gather_min_length", or 0 if it isn't set,
+     * which disables gathering.
+     */
+    void setGatherMinLength(size_t val);
+
+    size_t getGatherMinLength() const { return _gatherMinLength; }
+
+    /**
+     * Write a SampleIndex of each file of a FileSet output, with
+     * blocks of samples spanning val seconds, so that readers can
+     * seek to a time.  0, the default, disables the index.
+     * Compressed files are not indexed.
+     *
+     * @throws nidas::util::InvalidParameterException
+     **/
+    void setIndexInterval(float val);
+
+    float getIndexInterval() const { return _indexUsecs / (float)USECS_PER_SEC; }
+
 protected:
 
     SampleOutputStream* clone(IOChannel* iochannel);
@@ -135,6 +167,33 @@ private:
      */
     dsm_time_t _lastFlushTT;
 
+    size_t _gatherMinLength;
+
+    long long _indexUsecs;
+
+    /**
+     * Index of the current output file, or null.
+     */
+    nidas::core::SampleIndexWriter* _indexWriter;
+
+    /**
+     * Number of bytes written to the current output file.
+     */
+    long long _fileOffset;
+
+    /**
+     * Create _iostream on the current IOChannel.
+     */
+    void createIOStream();
+
+    /**
+     * Start the index of a new output file, closing the
+     * index of the previous file.
+     */
+    void openIndex();
+
+    void closeIndex();
+
     /**
      * No copy.
      */
@@ -55,6 +55,23 @@ bool stats_log_variable(const Variable* variable)
         variable->getName().find(log_variable_name) != string::npos;
 }
 
+namespace {
+
+/**
+ * Add x * y[i] to sums[i], for i < n.  The arrays are contiguous,
+ * so the compiler can vectorize the loop.  Each sum is added to in
+ * the same order as before the arrays were contiguous, so the
+ * results are the same.
+ */
+inline void
+addProducts(double x, const double* y, unsigned int n, double* sums)
+{
+    for (unsigned int i = 0; i < n; i++)
+        sums[i] += x * y[i];
+}
+
+}
+
 
 StatisticsCruncher::StatisticsCruncher(StatisticsProcessor* proc,
                                        const SampleTag* stag,
@@ -74,12 +91,12 @@ StatisticsCruncher::StatisticsCruncher(StatisticsProcessor* proc,
 	_countsName(cntsName),
 	_numpoints(_countsName.length() > 0),_periodUsecs(0),
 	_crossTerms(false),
-	_resampler(0),
+	_resampler(0),_inputClient(0),
 	_statsType(stype),_splitVarNames(),
         _leadCommon(),_commonSuffix(),_outSample(),_nOutVar(0),
 	_outlen(0),
 	_tout(LONG_LONG_MIN),_sampleMap(),
-	_xMin(0),_xMax(0),_xSum(0),_xySum(0),_xyzSum(0),_x4Sum(0),
+	_xMin(0),_xMax(0),_inputValues(),_xSum(0),_xySum(0),_xyzSum(0),_x4Sum(0),
 	_nSamples(0),_triComb(0),
 	_nsum(0),_ncov(0),_ntri(0),_n1mom(0),_n2mom(0),_n3mom (0),_n4mom(0),_ntot(0),
         _higherMoments(himom),
@@ -141,7 +158,7 @@ StatisticsCruncher::StatisticsCruncher(StatisticsProcessor* proc,
 
 StatisticsCruncher::~StatisticsCruncher()
 {
-    map<dsm_sample_id_t,sampleInfo >::iterator vmi;
+    SampleIdMap<sampleInfo>::iterator vmi;
     for (vmi = _sampleMap.begin(); vmi != _sampleMap.end(); ++vmi) {
 	struct sampleInfo& sinfo = vmi->second;
 	vector<unsigned int*>& vindices = sinfo.varIndices;
@@ -316,7 +333,7 @@ void StatisticsCruncher::connect(SampleSource* source)
 void StatisticsCruncher::disconnect(SampleSource* source) throw()
 {
     if (_resampler) _resampler->disconnect(source);
-    else source->removeSampleClient(this);
+    else source->removeSampleClient(getInputClient());
 }
 
 void StatisticsCruncher::attach(SampleSource* source)
@@ -338,7 +355,7 @@ void StatisticsCruncher::attach(SampleSource* source)
 	const SampleTag* intag = *inti;
 	dsm_sample_id_t id = intag->getId();
 
-	map<dsm_sample_id_t,sampleInfo >::iterator vmi =
+	SampleIdMap<sampleInfo>::iterator vmi =
 	    _sampleMap.find(id);
 
 	if (vmi != _sampleMap.end()) {
@@ -429,6 +446,7 @@ void StatisticsCruncher::attach(SampleSource* source)
                             assert(varIndices.size() == rv);
                         }
 			varIndices.push_back(idxs);
+			sptr->inputIndices.push_back(vindex);
 		    }
 
 		    VLOG(("") << "StatisticsCruncher::attach, reqVariables[" <<
@@ -465,7 +483,7 @@ void StatisticsCruncher::attach(SampleSource* source)
 	        assert(varIndices.size() == _reqVariables.size());
 	    }
             VLOG(("") << "addSampleClientForTag, intag=" << intag->getDSMId() << ',' << intag->getSpSId() << '(' << hex << intag->getSpSId() << dec << ')');
-            source->addSampleClientForTag(this,intag);
+            source->addSampleClientForTag(getInputClient(),intag);
 	}
     }
     if (nmatches < _ninvars) {
@@ -1343,6 +1361,8 @@ void StatisticsCruncher::initStats()
     delete [] _x4Sum;
     _x4Sum = 0;
     if (_n4mom > 0) _x4Sum = new double[_n4mom];
+
+    _inputValues.assign(_ninvars, 0.);
 }
 
 void StatisticsCruncher::zeroStats()
@@ -1365,14 +1385,44 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
 
     dsm_sample_id_t id = samp->getId();
 
-    map<dsm_sample_id_t,sampleInfo >::iterator vmi =
+    SampleIdMap<sampleInfo>::iterator vmi =
     	_sampleMap.find(id);
     if (vmi == _sampleMap.end()) {
         WLOG(("unrecognized sample, id=") << samp->getDSMId() << ',' << samp->getSpSId() <<
             " sampleMap.size()=" << _sampleMap.size());
         return false;	// unrecognized sample
     }
+    return accumulate(samp, vmi->second);
+}
 
+bool StatisticsCruncher::receiveBatch(const Sample* const* samps,
+        size_t nsamps) throw()
+{
+    SampleIdMap<sampleInfo>::iterator vmi = _sampleMap.end();
+    bool ok = true;
+
+    for (size_t i = 0; i < nsamps; i++) {
+        const Sample* samp = samps[i];
+        assert(samp->getType() == FLOAT_ST || samp->getType() == DOUBLE_ST);
+
+        dsm_sample_id_t id = samp->getId();
+        if (vmi == _sampleMap.end() || vmi->first != id) {
+            vmi = _sampleMap.find(id);
+            if (vmi == _sampleMap.end()) {
+                WLOG(("unrecognized sample, id=") << samp->getDSMId() << ',' << samp->getSpSId() <<
+                    " sampleMap.size()=" << _sampleMap.size());
+                ok = false;
+                continue;
+            }
+        }
+        ok = accumulate(samp, vmi->second) && ok;
+    }
+    return ok;
+}
+
+bool StatisticsCruncher::accumulate(const Sample* samp,
+        const sampleInfo& sinfo)
+{
     dsm_time_t tt = samp->getTimeTag();
     while (tt > _tout) {
         if (tt > _endTime.toUsecs()) return false;
@@ -1395,26 +1445,28 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
     }
     if (tt < _tout - _periodUsecs) return false;
 
-    struct sampleInfo& sinfo = vmi->second;
     const vector<unsigned int*>& vindices = sinfo.varIndices;
 
     unsigned int nvarsin = vindices.size();
     unsigned int nvsamp = samp->getDataLength();
 
-    unsigned int i,j,k;
-    unsigned int vi,vj,vk,vo;
+    unsigned int i,j,n;
+    unsigned int vi,vo;
     double *xySump,*xyzSump;
     double x;
     double xy;
 
+    // Inputs of the cross term statistics, in the order of the
+    // requested variables.
+    const double* xin = 0;
+    if (_crossTerms) xin = gatherInputs(samp, sinfo);
+
     unsigned int nonNANs = 0;
     if (sinfo.weightsIndex < nvsamp)
     	nonNANs = (unsigned int)samp->getDataValue(sinfo.weightsIndex);
     else if (_crossTerms) {
-	for (i = 0; i < nvarsin; i++) {
-	    vi = vindices[i][0];
-	    if(vi < nvsamp && !std::isnan(samp->getDataValue(vi))) nonNANs++;
-	}
+	for (i = 0; i < nvarsin; i++)
+	    if (!std::isnan(xin[i])) nonNANs++;
     }
 
     static LogContext lp(LOG_VERBOSE);
@@ -1465,10 +1517,8 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
 	return true;
     case STATS_WINDDIR:
         {
-            vi = vindices[0][0];
-            double u = samp->getDataValue(vi);
-            vi = vindices[1][0];
-            double v = samp->getDataValue(vi);
+            double u = xin[0];
+            double v = xin[1];
             if (!std::isnan(u) && !std::isnan(v)) {
                 _xSum[0] += u;
                 _xSum[1] += v;
@@ -1491,17 +1541,11 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
 	// cross term product, all input data is present and non-NAN
 	xySump = _xySum[0];
 	for (i = 0; i < nvarsin; i++) {
-	    vi = vindices[i][0];
-            assert(vi < nvsamp);
-	    // crossterms, so: vindices[i][1] == i;
-	    x = samp->getDataValue(vi);
+	    x = xin[i];
 	    _xSum[i] += x;
-	    for (j = i; j < nvarsin; j++) {
-		vj = vindices[j][0];
-                assert(vj < nvsamp);
-		xy = x * samp->getDataValue(vj);
-		*xySump++ += xy;
-	    }
+	    n = nvarsin - i;
+	    addProducts(x, xin + i, n, xySump);
+	    xySump += n;
             if (_higherMoments) {
                 _xyzSum[i] += (xy = x * x * x);
                 _x4Sum[i] += xy * x;
@@ -1514,26 +1558,18 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
 	// cross term product, all input data is present and non-NAN
 	xySump = _xySum[0];
 	for (i = 0; i < 3; i++) {
-	    vi = vindices[i][0];
-            assert(vi < nvsamp);
-	    // crossterms, so: vindices[i][1] == i;
-	    x = samp->getDataValue(vi);
+	    x = xin[i];
 	    _xSum[i] += x;
-	    for (j = i; j < nvarsin; j++) {
-		vj = vindices[j][0];
-                assert(vj < nvsamp);
-		xy = x * samp->getDataValue(vj);
-		*xySump++ += xy;
-	    }
+	    n = nvarsin - i;
+	    addProducts(x, xin + i, n, xySump);
+	    xySump += n;
             if (_higherMoments) {
                 _xyzSum[i] += (xy = x * x * x);
                 _x4Sum[i] += xy * x;
             }
 	}
 	for (; i < nvarsin; i++) {	// scalar means and variances
-	    vi = vindices[i][0];
-            assert(vi < nvsamp);
-	    x = samp->getDataValue(vi);
+	    x = xin[i];
 	    _xSum[i] += x;
 	    *xySump++ += (xy = x * x);
             if (_higherMoments) {
@@ -1548,48 +1584,31 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
 	// cross term product, all input data is present and non-NAN
 	xySump = _xySum[0];	
 	for (i = 0; i < 3; i++) {
-	    vi = vindices[i][0];
-            assert(vi < nvsamp);
-	    // crossterms, so: vindices[i][1] == i;
-	    x = samp->getDataValue(vi);
+	    x = xin[i];
 	    _xSum[i] += x;
-	    for (j = i; j < nvarsin; j++) {
-		vj = vindices[j][0];
-                assert(vj < nvsamp);
-		xy = x * samp->getDataValue(vj);
-		*xySump++ += xy;
-	    }
+	    n = nvarsin - i;
+	    addProducts(x, xin + i, n, xySump);
+	    xySump += n;
             if (_higherMoments) {
                 _xyzSum[i] += (xy = x * x * x);
                 _x4Sum[i] += xy * x;
             }
 	}
-	for (; i < nvarsin; i++) {	// scalar means
-	    vi = vindices[i][0];
-            assert(vi < nvsamp);
-	    _xSum[i] += samp->getDataValue(vi);
-	}
+	for (; i < nvarsin; i++)	// scalar means
+	    _xSum[i] += xin[i];
 	_nSamples[0]++;		// only need one nSamples
 	break;
     case STATS_SFLUX:	
 	// first term is scaler
 	// cross term product, all input data is present and non-NAN
-	xySump = _xySum[0];		// no wind:wind terms
-	i = 0;
-	vi = vindices[i][0];
-        assert(vi < nvsamp);
-	// crossterms, so: vindices[i][1] == i;
-	x = samp->getDataValue(vi);
-	for (j = i; j < nvarsin; j++) {
-	    vj = vindices[j][0];
-            assert(vj < nvsamp);
-	    _xSum[j] += samp->getDataValue(vj);
-	    xy = x * samp->getDataValue(vj);
-	    *xySump++ += xy;
-	}
+	// no wind:wind terms
+	x = xin[0];
+	for (j = 0; j < nvarsin; j++)
+	    _xSum[j] += xin[j];
+	addProducts(x, xin, nvarsin, _xySum[0]);
         if (_higherMoments) {
-            _xyzSum[i] += (xy = x * x * x);
-            _x4Sum[i] += xy * x;
+            _xyzSum[0] += (xy = x * x * x);
+            _x4Sum[0] += xy * x;
         }
 	_nSamples[0]++;		// only need one nSamples
 	break;
@@ -1597,23 +1616,16 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
 	// cross term product, all input data is present and non-NAN
 	xySump = _xySum[0];
 	xyzSump = _xyzSum;
-	for (i=0; i < nvarsin; i++) {	// no scalar:scalar cross terms
-	    vi = vindices[i][0];
-            assert(vi < nvsamp);
-	    // crossterms, so: vindices[i][1] == i;
-	    x = samp->getDataValue(vi);
+	for (i=0; i < nvarsin; i++) {
+	    x = xin[i];
 	    _xSum[i] += x;
 	    for (j = i; j < nvarsin; j++) {
-		vj = vindices[j][0];
-                assert(vj < nvsamp);
-		xy = x * samp->getDataValue(vj);
+		xy = x * xin[j];
 		*xySump++ += xy;
-		for (k=j; k < nvarsin; k++) {
-		    vk = vindices[k][0];
-                    assert(vk < nvsamp);
-		    *xyzSump++ += xy * samp->getDataValue(vk);
-		    if (_higherMoments && k == i) _x4Sum[i] += xy * x * x;
-		}
+		n = nvarsin - j;
+		addProducts(xy, xin + j, n, xyzSump);
+		xyzSump += n;
+		if (_higherMoments && j == i) _x4Sum[i] += xy * x * x;
 	    }
 	}
 	_nSamples[0]++;		// only need one nSamples
@@ -1623,31 +1635,16 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
 	xySump = _xySum[0];
 	xyzSump = _xyzSum;
 	for (i = 0; i < nvarsin; i++) {
-	    vi = vindices[i][0];
-            assert(vi < nvsamp);
-	    // crossterms, so: vindices[i][1] == i;
-	    x = samp->getDataValue(vi);
+	    x = xin[i];
 	    _xSum[i] += x;
-	    for (j = i; j < nvarsin; j++) {
-		vj = vindices[j][0];
-                assert(vj < nvsamp);
-		xy = x * samp->getDataValue(vj);
-		*xySump++ += xy;
-	    }
+	    n = nvarsin - i;
+	    addProducts(x, xin + i, n, xySump);
+	    xySump += n;
 	    if (_higherMoments) _x4Sum[i] += x * x * x * x;
 	}
-	for (unsigned int n = 0; n < _ntri; n++) {
-	    i = _triComb[n][0];
-	    j = _triComb[n][1];
-	    k = _triComb[n][2];
-	    vi = vindices[i][0];
-            assert(vi < nvsamp);
-	    vj = vindices[j][0];
-            assert(vj < nvsamp);
-	    vk = vindices[k][0];
-            assert(vk < nvsamp);
-	    *xyzSump++ += samp->getDataValue(vi) *
-	    	samp->getDataValue(vj) * samp->getDataValue(vk);
+	for (n = 0; n < _ntri; n++) {
+	    const unsigned int* comb = _triComb[n];
+	    *xyzSump++ += xin[comb[0]] * xin[comb[1]] * xin[comb[2]];
 	}
 	_nSamples[0]++;		// only need one nSamples
 	break;
@@ -1657,6 +1654,39 @@ bool StatisticsCruncher::receive(const Sample* samp) throw()
     return true;
 }
 
+const double* StatisticsCruncher::gatherInputs(const Sample* samp,
+        const sampleInfo& sinfo)
+{
+    const vector<unsigned int>& indices = sinfo.inputIndices;
+    unsigned int nvarsin = indices.size();
+    unsigned int nvsamp = samp->getDataLength();
+    double* xin = &_inputValues[0];
+
+    // Read the data array directly, rather than with a virtual
+    // getDataValue() call for each value.
+    if (samp->getType() == FLOAT_ST) {
+        const float* fp = (const float*) samp->getConstVoidDataPtr();
+        for (unsigned int i = 0; i < nvarsin; i++) {
+            unsigned int vi = indices[i];
+            xin[i] = (vi < nvsamp ? fp[vi] : doubleNAN);
+        }
+    }
+    else if (samp->getType() == DOUBLE_ST) {
+        const double* dp = (const double*) samp->getConstVoidDataPtr();
+        for (unsigned int i = 0; i < nvarsin; i++) {
+            unsigned int vi = indices[i];
+            xin[i] = (vi < nvsamp ? dp[vi] : doubleNAN);
+        }
+    }
+    else {
+        for (unsigned int i = 0; i < nvarsin; i++) {
+            unsigned int vi = indices[i];
+            xin[i] = (vi < nvsamp ? samp->getDataValue(vi) : doubleNAN);
+        }
+    }
+    return xin;
+}
+
 void StatisticsCruncher::computeStats()
 {
     double *xyzSump;
@@ -31,6 +31,7 @@
 #include <nidas/core/SampleClient.h>
 #include <nidas/core/SamplePipeline.h>
 #include <nidas/core/NearestResampler.h>
+#include <nidas/core/SampleIdMap.h>
 #include <nidas/util/UTime.h>
 
 #include <vector>
@@ -132,6 +133,12 @@ public:
 
     bool receive(const Sample *s) throw();
 
+    /**
+     * Accumulate a batch of samples, looking up the variables of a
+     * sample only when its id differs from the previous sample.
+     */
+    bool receiveBatch(const Sample* const* samps, size_t nsamps) throw();
+
     /**
      * Connect a SamplePipeline to the cruncher.
      *
@@ -141,6 +148,25 @@ public:
 
     void disconnect(SampleSource* source) throw();
 
+    /**
+     * Set the SampleClient which is added to the input SampleSource
+     * in place of this cruncher, for example the client of a
+     * SensorProcessorPool which queues the input samples to another
+     * thread.  That client must pass the samples on to receive().
+     * If a NearestResampler is needed to combine the input samples,
+     * it still runs on the thread of the SampleSource, and the client
+     * receives its output. Must be called before connect().
+     */
+    void setInputClient(SampleClient* val)
+    {
+        _inputClient = val;
+    }
+
+    SampleClient* getInputClient()
+    {
+        return _inputClient ? _inputClient : this;
+    }
+
     /**
      * Connect a SamplePipeline to the cruncher.
      */
@@ -309,6 +335,8 @@ private:
 
     NearestResampler* _resampler;
 
+    SampleClient* _inputClient;
+
     /**
      * Types of statistics I can generate.
      */
@@ -339,20 +367,49 @@ private:
     dsm_time_t _tout;
 
     struct sampleInfo {
-        sampleInfo(): weightsIndex(0),varIndices() {}
+        sampleInfo(): weightsIndex(0),varIndices(),inputIndices() {}
         unsigned int weightsIndex;
 	std::vector<unsigned int*> varIndices;
+        /**
+         * Input index of each variable, varIndices[i][0], for
+         * gathering the inputs of cross term statistics.
+         */
+        std::vector<unsigned int> inputIndices;
     };
 
-    std::map<dsm_sample_id_t,sampleInfo > _sampleMap;
+    SampleIdMap<sampleInfo> _sampleMap;
+
+    /**
+     * Add a sample to the statistics, given its sampleInfo.
+     */
+    bool accumulate(const Sample* samp, const sampleInfo& sinfo);
+
+    /**
+     * Copy the input variables of a sample into _inputValues, in the
+     * order of the requested variables, with NaN for any that are not
+     * in the sample.  Used for the cross term statistics, so that the
+     * products are computed from contiguous values.
+     */
+    const double* gatherInputs(const Sample* samp, const sampleInfo& sinfo);
 
     float* _xMin;
 
     float* _xMax;
 
+    /**
+     * Values of the input variables of the current sample,
+     * see gatherInputs().
+     */
+    std::vector<double> _inputValues;
+
     // statistics sums.
     double* _xSum;
 
+    /**
+     * Second moment sums.  _xySum[0] is a contiguous array of all the
+     * sums, in the order they are accumulated: the upper triangle of
+     * the products, row by row.  See initStats().
+     */
     double** _xySum;
     double* _xyzSum;
     double* _x4Sum;
@@ -26,6 +26,8 @@
 
 #include "StatisticsProcessor.h"
 #include <nidas/core/SampleOutputRequestThread.h>
+#include <nidas/core/SensorProcessorPool.h>
+#include <nidas/core/SampleSorter.h>
 #include <nidas/core/Project.h>
 #include <nidas/core/Variable.h>
 #include <nidas/core/Site.h>
@@ -48,13 +50,17 @@ StatisticsProcessor::StatisticsProcessor():
     _cruncherListMutex(),_connectedSources(),_connectedOutputs(),
     _crunchers(),_infoBySampleId(),
     _startTime(LONG_LONG_MIN),_endTime(LONG_LONG_MAX),_statsPeriod(0.0),
-    _fillGaps(false),_cntsNames()
+    _fillGaps(false),_cntsNames(),
+    _processThreads(0),_maxQueueLength(10000),
+    _processors(0),_outputSorter(0)
 {
     setName("StatisticsProcessor");
 }
 
 StatisticsProcessor::~StatisticsProcessor()
 {
+    if (_processors) _processors->flush();
+
     std::set<SampleOutput*>::const_iterator oi = _connectedOutputs.begin();
     for ( ; oi != _connectedOutputs.end(); ++oi) {
         SampleOutput* output = *oi;
@@ -68,6 +74,11 @@ StatisticsProcessor::~StatisticsProcessor()
         }
         _cruncherListMutex.unlock();
 
+        if (_outputSorter) {
+            _outputSorter->flush();
+            _outputSorter->removeSampleClient(output);
+        }
+
         output->flush();
         try {
             output->close();
@@ -81,6 +92,12 @@ StatisticsProcessor::~StatisticsProcessor()
         SampleOutput* orig = output->getOriginal();
         if (orig != output) delete output;
     }
+
+    // The pool threads pass samples to the crunchers, and the
+    // crunchers to _outputSorter.
+    delete _processors;
+    delete _outputSorter;
+
     list<StatisticsCruncher*>::const_iterator ci;
     for (ci = _crunchers.begin(); ci != _crunchers.end(); ++ci) {
         StatisticsCruncher* cruncher = *ci;
@@ -90,6 +107,8 @@ StatisticsProcessor::~StatisticsProcessor()
 
 void StatisticsProcessor::flush() throw()
 {
+    if (_processors) _processors->flush();
+
     std::set<SampleOutput*>::const_iterator oi = _connectedOutputs.begin();
     for ( ; oi != _connectedOutputs.end(); ++oi) {
         SampleOutput* output = *oi;
@@ -102,6 +121,7 @@ void StatisticsProcessor::flush() throw()
         }
         _cruncherListMutex.unlock();
 
+        if (_outputSorter) _outputSorter->flush();
         output->flush();
     }
 }
@@ -300,6 +320,29 @@ void StatisticsProcessor::connectSource(SampleSource* source)
     source = source->getProcessedSampleSource();
     assert(source);
 
+    if (_processThreads > 0 && !_processors) {
+        _processors = new SensorProcessorPool(getName(), _processThreads);
+        _processors->setMaxQueueLength(_maxQueueLength);
+
+        // A cruncher emits the statistics of a period, time tagged at
+        // the middle of the period, when it receives the first sample
+        // of the next period. The output of a cruncher on a thread
+        // which is maxLag behind can then be maxLag plus a period
+        // older than the latest output of the other threads. Bound
+        // the lag of the threads in time and size the output sorter
+        // from that bound, with a second of margin.
+        float maxLag = std::max(_statsPeriod, 1.0f);
+        _processors->setMaxLag((dsm_time_t)(maxLag * USECS_PER_SEC));
+
+        _outputSorter = new SampleSorter(getName() + "OutputSorter", false);
+        _outputSorter->setLengthSecs(maxLag + _statsPeriod + 1.0f);
+        _outputSorter->setHeapBlock(true);
+        _outputSorter->setRealTime(false);
+        _outputSorter->start();
+        ILOG(("%s: running statistics on %u threads",
+              getName().c_str(), _processors->getNumThreads()));
+    }
+
     // In order to improve support for the ISFS Wisard motes, where
     // the same variable can appear in more than one sample 
     // (for example if a sensor's input is moved between motes), this code
@@ -410,6 +453,14 @@ void StatisticsProcessor::connectSource(SampleSource* source)
                         _crunchers.push_back(cruncher);
                         _cruncherListMutex.unlock();
                         crunchersByOutputId[newtag.getId()] = cruncher;
+                        if (_processors) {
+                            ostringstream ost;
+                            ost << "stats sample " << newtag.getDSMId()
+                                << ',' << newtag.getSpSId();
+                            cruncher->setInputClient(
+                                _processors->getClient(cruncher, ost.str()));
+                            cruncher->addSampleClient(_outputSorter);
+                        }
                         cruncher->connect(source);
 
                         list<const SampleTag*> tags = cruncher->getSampleTags();
@@ -482,8 +533,15 @@ void StatisticsProcessor::disconnectSource(SampleSource* source) throw()
     for (ci = _crunchers.begin(); ci != _crunchers.end(); ++ci) {
         StatisticsCruncher* cruncher = *ci;
 	cruncher->disconnect(source);
+    }
+    // finish the samples queued for the crunchers before
+    // sending out their last statistics.
+    if (_processors) _processors->flush();
+    for (ci = _crunchers.begin(); ci != _crunchers.end(); ++ci) {
+        StatisticsCruncher* cruncher = *ci;
 	cruncher->flush();
     }
+    if (_outputSorter) _outputSorter->flush();
     _connectedSources.erase(source);
     _cruncherListMutex.unlock();
 }
@@ -495,10 +553,13 @@ void StatisticsProcessor::connect(SampleOutput* output) throw()
 #ifdef DEBUG
     cerr << "StatisticsProcessor::connect, output=" << output->getName() << endl;
 #endif
-    list<StatisticsCruncher*>::const_iterator ci;
-    for (ci = _crunchers.begin(); ci != _crunchers.end(); ++ci) {
-        StatisticsCruncher* cruncher = *ci;
-	cruncher->addSampleClient(output);
+    if (_outputSorter) _outputSorter->addSampleClient(output);
+    else {
+        list<StatisticsCruncher*>::const_iterator ci;
+        for (ci = _crunchers.begin(); ci != _crunchers.end(); ++ci) {
+            StatisticsCruncher* cruncher = *ci;
+            cruncher->addSampleClient(output);
+        }
     }
     _connectedOutputs.insert(output);
     _cruncherListMutex.unlock();
@@ -521,6 +582,7 @@ void StatisticsProcessor::disconnect(SampleOutput* output) throw()
         // a deadlock on _cruncherListMutex here.
 	cruncher->removeSampleClient(output);
     }
+    if (_outputSorter) _outputSorter->removeSampleClient(output);
     _cruncherListMutex.unlock();
     _connectedOutputs.erase(output);
 
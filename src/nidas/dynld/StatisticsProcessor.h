@@ -31,6 +31,11 @@
 #include "StatisticsCruncher.h"
 #include <nidas/util/UTime.h>
 
+namespace nidas { namespace core {
+class SensorProcessorPool;
+class SampleSorter;
+}}
+
 namespace nidas { namespace dynld {
 
 using namespace nidas::core;
@@ -150,6 +155,39 @@ public:
      */
     std::string getUniqueCountsName(const std::string& val);
 
+    /**
+     * Number of threads which run the StatisticsCrunchers.  If zero,
+     * the default, the crunchers are run by the thread which passes
+     * samples to this processor. Otherwise each cruncher is assigned
+     * to one thread of a SensorProcessorPool, which queues its input
+     * samples, and the output samples of the crunchers are merged
+     * back into time order by a SampleSorter before being passed to
+     * the SampleOutputs.  A thread is not allowed to fall more than
+     * one statistics period (at least one second) behind the others,
+     * and the length of the SampleSorter is derived from that bound
+     * and the period, so that it always restores the time order.
+     * Must be set before connectSource().
+     */
+    void setProcessThreads(unsigned int val)
+    {
+        _processThreads = val;
+    }
+
+    unsigned int getProcessThreads() const
+    {
+        return _processThreads;
+    }
+
+    /**
+     * Set the maximum number of input samples queued for each
+     * thread when getProcessThreads() is non-zero.
+     * Default: 10000.
+     */
+    void setMaxQueueLength(size_t val)
+    {
+        _maxQueueLength = val;
+    }
+
 protected:
 
     /**
@@ -194,6 +232,21 @@ private:
      */
     std::set<std::string> _cntsNames;
 
+    unsigned int _processThreads;
+
+    size_t _maxQueueLength;
+
+    /**
+     * Threads which run the crunchers, if _processThreads > 0.
+     */
+    SensorProcessorPool* _processors;
+
+    /**
+     * Restores the time order of the cruncher output samples
+     * when they are generated by more than one thread.
+     */
+    SampleSorter* _outputSorter;
+
     /**
      * Copy not supported
      */
@@ -210,8 +210,7 @@ namespace {
 }
 
 
-bool ATIK_Sonic::process(const Sample* samp,
-	std::list<const Sample*>& results)
+bool ATIK_Sonic::processInto(const Sample* samp, SampleSink& results)
 {
 
     float uvwt[4];
@@ -221,12 +220,9 @@ bool ATIK_Sonic::process(const Sample* samp,
     dsm_time_t timetag;
 
     if (getScanfers().size() > 0) {
-        std::list<const Sample*> parseResults;
-        SerialSensor::process(samp,parseResults);
-        if (parseResults.empty()) return false;
-
         // result from base class parsing of ASCII
-        const Sample* psamp = parseResults.front();
+        const Sample* psamp = scanSample(samp);
+        if (!psamp) return false;
 
         // base class runs ttadjust on the time tag
         timetag = psamp->getTimeTag();
@@ -48,7 +48,14 @@ public:
 
     void checkSampleTags();
 
-    bool process(const nidas::core::Sample* samp,std::list<const nidas::core::Sample*>& results);
+    bool processInto(const nidas::core::Sample* samp,
+        nidas::core::SampleSink& results);
+
+    bool process(const nidas::core::Sample* samp,
+        std::list<const nidas::core::Sample*>& results)
+    {
+        return nidas::core::DSMSensor::process(samp, results);
+    }
 
     /**
      * Apply the path shadow correction and described in the comments
@@ -583,8 +583,7 @@ float CSAT3_Sonic::correctTcForPathCurvature(float tc, float, float, float)
     return tc;
 }
 
-bool CSAT3_Sonic::process(const Sample* samp,
-        std::list<const Sample*>& results)
+bool CSAT3_Sonic::processInto(const Sample* samp, SampleSink& results)
 {
     size_t inlen = samp->getDataByteLength();
     if (inlen < _windInLen) return false;	// not enough data
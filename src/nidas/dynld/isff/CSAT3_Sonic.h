@@ -73,7 +73,13 @@ public:
     float correctTcForPathCurvature(float tc,
             float u, float v, float w);
 
-    bool process(const Sample* samp,std::list<const Sample*>& results);
+    bool processInto(const Sample* samp, SampleSink& results);
+
+    bool process(const nidas::core::Sample* samp,
+        std::list<const nidas::core::Sample*>& results)
+    {
+        return nidas::core::DSMSensor::process(samp, results);
+    }
 
     void parseParameters();
 
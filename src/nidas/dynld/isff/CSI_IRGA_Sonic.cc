@@ -454,8 +454,7 @@ std::vector<float> fields_to_floats(CSI_IRGA_Fields& fields)
 }
 
 
-bool CSI_IRGA_Sonic::process(const Sample* samp,
-	std::list<const Sample*>& results)
+bool CSI_IRGA_Sonic::processInto(const Sample* samp, SampleSink& results)
 {
     if (_stats.nmessages == 0)
     {
@@ -595,14 +594,10 @@ bool CSI_IRGA_Sonic::process(const Sample* samp,
         }
     }
     else {
-        std::list<const Sample*> parseResults;
-
-        SerialSensor::process(samp,parseResults);
-
-        if (parseResults.empty()) return false;
-
         // result from base class parsing of ASCII
-        psamp = parseResults.front();
+        psamp = scanSample(samp);
+
+        if (!psamp) return false;
 
         // base class has adjusted time tag for latency jitter
         wsamptime = psamp->getTimeTag() - _timeDelay;
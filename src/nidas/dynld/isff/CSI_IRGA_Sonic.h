@@ -164,7 +164,13 @@ public:
 
     void checkSampleTags();
 
-    bool process(const Sample* samp,std::list<const Sample*>& results);
+    bool processInto(const Sample* samp, SampleSink& results);
+
+    bool process(const nidas::core::Sample* samp,
+        std::list<const nidas::core::Sample*>& results)
+    {
+        return nidas::core::DSMSensor::process(samp, results);
+    }
 
     virtual void updateAttributes() override;
 
@@ -710,17 +710,12 @@ Wind3D::addWindDiagnostic(nidas::core::SampleT<float>* outsamp, bool diagOK,
 
 
 
-bool Wind3D::process(const Sample* samp,
-	std::list<const Sample*>& results)
+bool Wind3D::processInto(const Sample* samp, SampleSink& results)
 {
-    std::list<const Sample*> parseResults;
-
-    SerialSensor::process(samp,parseResults);
-
-    if (parseResults.empty()) return false;
-
     // result from base class parsing of ASCII
-    const Sample* psamp = parseResults.front();
+    const Sample* psamp = scanSample(samp);
+
+    if (!psamp) return false;
 
     unsigned int nParsedVals = psamp->getDataLength();
     const float* pdata = (const float*) psamp->getConstVoidDataPtr();
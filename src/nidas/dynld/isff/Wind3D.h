@@ -64,8 +64,14 @@ public:
      * u,v,w,tc parsed from an ASCII sample. Applies despiking,
      * orientation corrections, bias, tilts and horizontal rotations, as configured.
      */
-    bool process(const nidas::core::Sample* samp, 
-        std::list<const nidas::core::Sample*>& results);
+    bool processInto(const nidas::core::Sample* samp,
+        nidas::core::SampleSink& results);
+
+    bool process(const nidas::core::Sample* samp,
+        std::list<const nidas::core::Sample*>& results)
+    {
+        return nidas::core::DSMSensor::process(samp, results);
+    }
 
     void setBias(int i, double val);
 
@@ -354,7 +354,7 @@ SampleTag* WisardMote::createSampleTag(SampInfo& sinfo,int mote, int stype)
     return newtag;
 }
 
-bool WisardMote::process(const Sample * samp, list<const Sample *>&results)
+bool WisardMote::processInto(const Sample * samp, SampleSink& results)
 {
     if (_processorSensor != this) return false;
 
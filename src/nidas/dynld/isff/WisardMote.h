@@ -129,8 +129,13 @@ public:
 
     virtual ~ WisardMote();
 
-    bool process(const Sample* insamp,
-                 std::list<const Sample*>& results);
+    bool processInto(const Sample* insamp, SampleSink& results);
+
+    bool process(const nidas::core::Sample* samp,
+        std::list<const nidas::core::Sample*>& results)
+    {
+        return nidas::core::DSMSensor::process(samp, results);
+    }
 
     void validate();
 
@@ -375,7 +375,7 @@ void DSMAnalogSensor::printStatus(std::ostream& ostr) throw()
     }
 }
 
-bool DSMAnalogSensor::processTemperature(const Sample* insamp, list<const Sample*>& result) throw()
+bool DSMAnalogSensor::processTemperature(const Sample* insamp, SampleSink& result) throw()
 {
     // number of data values in this raw sample. Should be two, an id and the temperature
     if (insamp->getDataByteLength() / sizeof(short) != 2) return false;
@@ -398,7 +398,7 @@ bool DSMAnalogSensor::processTemperature(const Sample* insamp, list<const Sample
     return true;
 }
 
-bool DSMAnalogSensor::process(const Sample* insamp,list<const Sample*>& results) throw()
+bool DSMAnalogSensor::processInto(const Sample* insamp, SampleSink& results) throw()
 {
 
 // #define DEBUG
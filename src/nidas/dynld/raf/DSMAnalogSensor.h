@@ -98,8 +98,13 @@ public:
      * A2D data buffer into individual samples and convert the
      * counts to voltage.
      */
-    bool process(const Sample*,std::list<const Sample*>& result)
-        throw();
+    bool processInto(const Sample*, SampleSink& result) throw();
+
+    bool process(const Sample* samp, std::list<const Sample*>& results)
+        throw()
+    {
+        return DSMSensor::process(samp, results);
+    }
 
     /**
      * @throws nidas::util::InvalidParameterException
@@ -153,7 +158,7 @@ protected:
 
     A2DConverter* _finalConverter;
 
-    bool processTemperature(const Sample*, std::list<const Sample*>& result) throw();
+    bool processTemperature(const Sample*, SampleSink& result) throw();
 
     /**
      * Read a filter file containing coefficients for an Analog Devices
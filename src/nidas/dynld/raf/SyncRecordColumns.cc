@@ -0,0 +1,362 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "SyncRecordColumns.h"
+#include "SyncRecordSource.h"
+
+#include <nidas/core/Sample.h>
+#include <nidas/util/EndianConverter.h>
+
+#include <cstring>
+#include <limits>
+#include <sstream>
+
+using namespace nidas::core;
+using namespace nidas::dynld::raf;
+using namespace std;
+
+namespace n_u = nidas::util;
+
+namespace {
+const char COLUMNS_MAGIC[4] = { 'N', 'S', 'R', 'C' };
+const uint32_t COLUMNS_VERSION = 1;
+
+inline bool
+hostIsLittleEndian()
+{
+    static const bool little = n_u::EndianConverter::getHostEndianness() ==
+        n_u::EndianConverter::EC_LITTLE_ENDIAN;
+    return little;
+}
+}
+
+SyncRecordColumns::SyncRecordColumns():
+    _columns(), _runs(), _numValues(0), _float32(false)
+{
+}
+
+void SyncRecordColumns::clear()
+{
+    _columns.clear();
+    _runs.clear();
+    _numValues = 0;
+}
+
+void SyncRecordColumns::addRun(unsigned int src, unsigned int dst,
+                               unsigned int len)
+{
+    if (!_runs.empty()) {
+        Run& last = _runs.back();
+        if (last.src + last.len == src && last.dst + last.len == dst) {
+            last.len += len;
+            return;
+        }
+    }
+    Run run = { src, dst, len };
+    _runs.push_back(run);
+}
+
+void SyncRecordColumns::addColumn(const string& name, unsigned int srcOffset,
+                                  unsigned int length,
+                                  unsigned int srcLagOffset, float rate)
+{
+    Column col;
+    col.name = name;
+    col.srcOffset = srcOffset;
+    col.srcLagOffset = srcLagOffset;
+    col.length = length;
+    col.rate = rate;
+    col.lagOffset = _numValues;
+    col.offset = _numValues + 1;
+    _columns.push_back(col);
+
+    addRun(srcLagOffset, col.lagOffset, 1);
+    addRun(srcOffset, col.offset, length);
+    _numValues += length + 1;
+}
+
+const SyncRecordColumns::Column*
+SyncRecordColumns::getColumn(const string& name) const
+{
+    for (unsigned int i = 0; i < _columns.size(); i++)
+        if (_columns[i].name == name) return &_columns[i];
+    return 0;
+}
+
+string SyncRecordColumns::encodeHeader() const
+{
+    const n_u::EndianConverter* cvtr =
+        n_u::EndianConverter::getConverter(
+            n_u::EndianConverter::getHostEndianness(),
+            n_u::EndianConverter::EC_LITTLE_ENDIAN);
+
+    size_t len = sizeof(COLUMNS_MAGIC) + 4 * sizeof(uint32_t);
+    for (unsigned int i = 0; i < _columns.size(); i++)
+        len += 2 * sizeof(uint32_t) + sizeof(float) + sizeof(uint16_t) +
+            _columns[i].name.length();
+
+    string head(len, '\0');
+    char* cp = &head[0];
+
+    memcpy(cp, COLUMNS_MAGIC, sizeof(COLUMNS_MAGIC));
+    cp += sizeof(COLUMNS_MAGIC);
+    cvtr->uint32Copy(COLUMNS_VERSION, cp);
+    cp += sizeof(uint32_t);
+    cvtr->uint32Copy(getValueSize(), cp);
+    cp += sizeof(uint32_t);
+    cvtr->uint32Copy(_numValues, cp);
+    cp += sizeof(uint32_t);
+    cvtr->uint32Copy(_columns.size(), cp);
+    cp += sizeof(uint32_t);
+
+    for (unsigned int i = 0; i < _columns.size(); i++) {
+        const Column& col = _columns[i];
+        cvtr->uint32Copy(col.offset, cp);
+        cp += sizeof(uint32_t);
+        cvtr->uint32Copy(col.length, cp);
+        cp += sizeof(uint32_t);
+        cvtr->floatCopy(col.rate, cp);
+        cp += sizeof(float);
+        cvtr->uint16Copy(col.name.length(), cp);
+        cp += sizeof(uint16_t);
+        memcpy(cp, col.name.c_str(), col.name.length());
+        cp += col.name.length();
+    }
+    return head;
+}
+
+void SyncRecordColumns::decodeHeader(const void* buf, size_t len)
+{
+    const n_u::EndianConverter* cvtr =
+        n_u::EndianConverter::getConverter(
+            n_u::EndianConverter::EC_LITTLE_ENDIAN);
+
+    const char* cp = (const char*) buf;
+    const char* eob = cp + len;
+
+    if (len < sizeof(COLUMNS_MAGIC) + 4 * sizeof(uint32_t) ||
+        memcmp(cp, COLUMNS_MAGIC, sizeof(COLUMNS_MAGIC)))
+        throw n_u::ParseException("sync record columns header",
+                                  "bad magic or short header");
+    cp += sizeof(COLUMNS_MAGIC);
+
+    uint32_t version = cvtr->uint32Value(cp);
+    cp += sizeof(uint32_t);
+    if (version != COLUMNS_VERSION) {
+        ostringstream ost;
+        ost << "unsupported version " << version;
+        throw n_u::ParseException("sync record columns header", ost.str());
+    }
+    uint32_t valueSize = cvtr->uint32Value(cp);
+    cp += sizeof(uint32_t);
+    if (valueSize != 4 && valueSize != 8) {
+        ostringstream ost;
+        ost << "invalid value size " << valueSize;
+        throw n_u::ParseException("sync record columns header", ost.str());
+    }
+    uint32_t numValues = cvtr->uint32Value(cp);
+    cp += sizeof(uint32_t);
+    uint32_t ncols = cvtr->uint32Value(cp);
+    cp += sizeof(uint32_t);
+
+    clear();
+    _float32 = valueSize == 4;
+
+    for (uint32_t i = 0; i < ncols; i++) {
+        if (eob - cp < (int)(2 * sizeof(uint32_t) + sizeof(float) +
+                             sizeof(uint16_t)))
+            throw n_u::ParseException("sync record columns header",
+                                      "truncated column");
+        Column col;
+        col.offset = cvtr->uint32Value(cp);
+        cp += sizeof(uint32_t);
+        col.length = cvtr->uint32Value(cp);
+        cp += sizeof(uint32_t);
+        col.rate = cvtr->floatValue(cp);
+        cp += sizeof(float);
+        uint16_t nlen = cvtr->uint16Value(cp);
+        cp += sizeof(uint16_t);
+        // col.offset + col.length could overflow
+        if (eob - cp < nlen || col.offset == 0 ||
+            col.length > numValues || col.offset > numValues - col.length)
+            throw n_u::ParseException("sync record columns header",
+                                      "invalid column");
+        col.name = string(cp, nlen);
+        cp += nlen;
+        col.lagOffset = col.offset - 1;
+        _columns.push_back(col);
+    }
+    _numValues = numValues;
+}
+
+void SyncRecordColumns::encodeRecord(const double* rec, size_t reclen,
+                                     void* block) const
+{
+    static const double dnan = std::numeric_limits<double>::quiet_NaN();
+
+    if (hostIsLittleEndian()) {
+        if (!_float32) {
+            double* dp = (double*) block;
+            for (unsigned int i = 0; i < _runs.size(); i++) {
+                const Run& run = _runs[i];
+                if (run.src + run.len <= reclen)
+                    memcpy(dp + run.dst, rec + run.src,
+                           run.len * sizeof(double));
+                else {
+                    for (unsigned int j = 0; j < run.len; j++)
+                        dp[run.dst + j] = run.src + j < reclen ?
+                            rec[run.src + j] : dnan;
+                }
+            }
+        }
+        else {
+            float* fp = (float*) block;
+            for (unsigned int i = 0; i < _runs.size(); i++) {
+                const Run& run = _runs[i];
+                for (unsigned int j = 0; j < run.len; j++)
+                    fp[run.dst + j] = run.src + j < reclen ?
+                        (float) rec[run.src + j] : (float) dnan;
+            }
+        }
+        return;
+    }
+
+    const n_u::EndianConverter* cvtr =
+        n_u::EndianConverter::getConverter(
+            n_u::EndianConverter::getHostEndianness(),
+            n_u::EndianConverter::EC_LITTLE_ENDIAN);
+    char* cp = (char*) block;
+    unsigned int vsize = getValueSize();
+    for (unsigned int i = 0; i < _runs.size(); i++) {
+        const Run& run = _runs[i];
+        for (unsigned int j = 0; j < run.len; j++) {
+            double val = run.src + j < reclen ? rec[run.src + j] : dnan;
+            if (_float32) cvtr->floatCopy((float)val, cp + (run.dst + j) * vsize);
+            else cvtr->doubleCopy(val, cp + (run.dst + j) * vsize);
+        }
+    }
+}
+
+void SyncRecordColumns::decodeRecord(const void* block, double* values) const
+{
+    if (hostIsLittleEndian()) {
+        if (!_float32)
+            memcpy(values, block, _numValues * sizeof(double));
+        else {
+            const float* fp = (const float*) block;
+            for (unsigned int i = 0; i < _numValues; i++)
+                values[i] = fp[i];
+        }
+        return;
+    }
+
+    const n_u::EndianConverter* cvtr =
+        n_u::EndianConverter::getConverter(
+            n_u::EndianConverter::EC_LITTLE_ENDIAN);
+    const char* cp = (const char*) block;
+    if (!_float32) {
+        for (unsigned int i = 0; i < _numValues; i++)
+            values[i] = cvtr->doubleValue(cp + i * sizeof(double));
+    }
+    else {
+        for (unsigned int i = 0; i < _numValues; i++)
+            values[i] = cvtr->floatValue(cp + i * sizeof(float));
+    }
+}
+
+string
+SyncRecordColumns::formatSubscription(const vector<string>& names,
+                                      bool float32)
+{
+    string line = float32 ? "columns float32" : "columns float64";
+    for (unsigned int i = 0; i < names.size(); i++)
+        line += ' ' + names[i];
+    return line + '\n';
+}
+
+void
+SyncRecordColumns::parseSubscription(const string& line,
+                                     vector<string>& names, bool& float32)
+{
+    istringstream ist(line);
+    string word;
+    ist >> word;
+    if (word != "columns")
+        throw n_u::ParseException("sync record subscription",
+                                  string("expected \"columns\", got \"") +
+                                  word + "\"");
+    word.clear();
+    ist >> word;
+    if (word == "float32") float32 = true;
+    else if (word == "float64") float32 = false;
+    else
+        throw n_u::ParseException("sync record subscription",
+                                  string("expected float32 or float64, got \"") +
+                                  word + "\"");
+    names.clear();
+    while (ist >> word) names.push_back(word);
+}
+
+SyncRecordColumnsFilter::SyncRecordColumnsFilter(
+    const SyncRecordColumns& columns, SampleClient* client):
+    _columns(columns), _client(client)
+{
+}
+
+bool SyncRecordColumnsFilter::receive(const Sample* samp) throw()
+{
+    dsm_sample_id_t id = samp->getId();
+
+    if (id == SYNC_RECORD_ID) {
+        SampleT<char>* block = getSample<char>(_columns.getBlockLength());
+        block->setTimeTag(samp->getTimeTag());
+        block->setId(SYNC_RECORD_COLUMNS_ID);
+        _columns.encodeRecord((const double*) samp->getConstVoidDataPtr(),
+                              samp->getDataLength(), block->getDataPtr());
+        bool res = _client->receive(block);
+        block->freeReference();
+        return res;
+    }
+
+    if (id == SYNC_RECORD_HEADER_ID) {
+        // The layout goes ahead of the text header, so that a reader
+        // has it once the text header arrives.
+        string head = _columns.encodeHeader();
+        SampleT<char>* hsamp = getSample<char>(head.length());
+        hsamp->setTimeTag(samp->getTimeTag());
+        hsamp->setId(SYNC_RECORD_COLUMNS_HEADER_ID);
+        memcpy(hsamp->getDataPtr(), head.c_str(), head.length());
+        bool res = _client->receive(hsamp);
+        hsamp->freeReference();
+        if (!res) return false;
+    }
+    return _client->receive(samp);
+}
+
+void SyncRecordColumnsFilter::flush() throw()
+{
+    _client->flush();
+}
@@ -0,0 +1,244 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#ifndef NIDAS_DYNLD_RAF_SYNCRECORDCOLUMNS_H
+#define NIDAS_DYNLD_RAF_SYNCRECORDCOLUMNS_H
+
+#include <nidas/core/SampleClient.h>
+#include <nidas/util/ParseException.h>
+
+#include <string>
+#include <vector>
+
+namespace nidas { namespace dynld { namespace raf {
+
+/**
+ * Layout of a columnar, fixed-format binary sync record.
+ *
+ * A SYNC_RECORD_ID sample is a ragged array of doubles whose layout
+ * is only described by the text header, which every reader has to
+ * parse.  A columnar block holds a selected subset of the sync
+ * record variables, each as a column of
+ *
+ *      lag, value[0], value[1], ... value[length-1]
+ *
+ * where lag is the time offset of the variable's sample group within
+ * the second and length is nSlots * varLength.  The values are
+ * little-endian doubles, or floats if setFloat32(true).  The column
+ * offsets are sent once in a binary header, after which a reader
+ * can index a block directly, without parsing anything per record.
+ *
+ * SyncRecordSource::getColumns() builds the layout on the server side
+ * from the sync record offsets, SyncRecordColumnsFilter converts sync
+ * records to blocks, and SyncRecordReader decodes them.
+ */
+class SyncRecordColumns
+{
+public:
+
+    struct Column
+    {
+        Column(): name(), srcOffset(0), srcLagOffset(0), length(0),
+            rate(0.0), offset(0), lagOffset(0)
+        {}
+
+        /**
+         * Variable name, as in the sync record text header.
+         */
+        std::string name;
+
+        /**
+         * Index of the first value of the variable in the sync record.
+         */
+        unsigned int srcOffset;
+
+        /**
+         * Index of the time offset of the variable's sample group
+         * in the sync record.
+         */
+        unsigned int srcLagOffset;
+
+        /**
+         * Number of values of the variable in a second.
+         */
+        unsigned int length;
+
+        float rate;
+
+        /**
+         * Index of the first value of the variable in a block.
+         */
+        unsigned int offset;
+
+        /**
+         * Index of the time offset of the variable in a block,
+         * which is always offset - 1.
+         */
+        unsigned int lagOffset;
+    };
+
+    SyncRecordColumns();
+
+    /**
+     * Append a column for a variable whose values start at
+     * @p srcOffset in the sync record.
+     */
+    void addColumn(const std::string& name, unsigned int srcOffset,
+                   unsigned int length, unsigned int srcLagOffset, float rate);
+
+    void setFloat32(bool val) { _float32 = val; }
+
+    bool getFloat32() const { return _float32; }
+
+    /**
+     * Size of a value in a block, 4 or 8.
+     */
+    unsigned int getValueSize() const { return _float32 ? 4 : 8; }
+
+    /**
+     * Number of values in a block, including the lag values.
+     */
+    unsigned int getNumValues() const { return _numValues; }
+
+    /**
+     * Length of a block in bytes.
+     */
+    size_t getBlockLength() const { return _numValues * getValueSize(); }
+
+    const std::vector<Column>& getColumns() const { return _columns; }
+
+    /**
+     * Return a pointer to a column, or NULL if @p name is not in
+     * the layout.
+     */
+    const Column* getColumn(const std::string& name) const;
+
+    void clear();
+
+    /**
+     * Encode the layout into a binary header.  The header does not
+     * contain the sync record offsets, just what a reader needs to
+     * index the blocks.
+     */
+    std::string encodeHeader() const;
+
+    /**
+     * Decode a header created by encodeHeader(), replacing the
+     * current layout.
+     *
+     * @throws nidas::util::ParseException
+     */
+    void decodeHeader(const void* buf, size_t len);
+
+    /**
+     * Fill a block of getBlockLength() bytes from a sync record
+     * of @p reclen doubles.  Values beyond the end of the sync
+     * record are set to NaN.
+     */
+    void encodeRecord(const double* rec, size_t reclen, void* block) const;
+
+    /**
+     * Convert a block to getNumValues() doubles in host order.
+     */
+    void decodeRecord(const void* block, double* values) const;
+
+    /**
+     * Format the request that a client of SyncServer sends to select
+     * columns: "columns float32|float64 name ...\n".
+     * If @p names is empty, all variables are selected.
+     */
+    static std::string
+    formatSubscription(const std::vector<std::string>& names, bool float32);
+
+    /**
+     * Parse a subscription line created by formatSubscription().
+     *
+     * @throws nidas::util::ParseException
+     */
+    static void
+    parseSubscription(const std::string& line,
+                      std::vector<std::string>& names, bool& float32);
+
+private:
+
+    /**
+     * A contiguous run of values copied from the sync record
+     * into a block.  Columns which are adjacent in both are merged
+     * into one run.
+     */
+    struct Run
+    {
+        unsigned int src;
+        unsigned int dst;
+        unsigned int len;
+    };
+
+    void addRun(unsigned int src, unsigned int dst, unsigned int len);
+
+    std::vector<Column> _columns;
+
+    std::vector<Run> _runs;
+
+    unsigned int _numValues;
+
+    bool _float32;
+};
+
+/**
+ * SampleClient which converts the sync records it receives into
+ * SYNC_RECORD_COLUMNS_ID blocks for one downstream client.
+ * Before passing on a text header sample, it sends a
+ * SYNC_RECORD_COLUMNS_HEADER_ID sample describing the block layout.
+ * Other samples are passed through.
+ */
+class SyncRecordColumnsFilter: public nidas::core::SampleClient
+{
+public:
+
+    SyncRecordColumnsFilter(const SyncRecordColumns& columns,
+                            nidas::core::SampleClient* client);
+
+    bool receive(const nidas::core::Sample* samp) throw();
+
+    void flush() throw();
+
+    nidas::core::SampleClient* getClient() const { return _client; }
+
+    const SyncRecordColumns& getColumns() const { return _columns; }
+
+private:
+
+    SyncRecordColumns _columns;
+
+    nidas::core::SampleClient* _client;
+
+    SyncRecordColumnsFilter(const SyncRecordColumnsFilter&) = delete;
+    SyncRecordColumnsFilter& operator=(const SyncRecordColumnsFilter&) = delete;
+};
+
+}}}	// namespace nidas namespace dynld namespace raf
+
+#endif
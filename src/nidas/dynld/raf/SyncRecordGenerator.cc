@@ -25,6 +25,7 @@
 */
 
 #include "SyncRecordGenerator.h"
+#include "SyncRecordColumns.h"
 
 #include <nidas/core/SampleOutputRequestThread.h>
 #include <nidas/core/Version.h>
@@ -46,6 +47,7 @@ NIDAS_CREATOR_FUNCTION_NS(raf,SyncRecordGenerator);
 SyncRecordGenerator::SyncRecordGenerator():
     SampleIOProcessor(true),
     _connectionMutex(),_connectedSources(),_connectedOutputs(),
+    _columnFilters(),_oldColumnFilters(),
     _syncRecSource(),
     _numInputSampsLast(0),_numOutputSampsLast(0),
     _numInputBytesLast(0),_numOutputBytesLast(0)
@@ -59,7 +61,13 @@ SyncRecordGenerator::~SyncRecordGenerator()
     set<SampleOutput*>::const_iterator oi = _connectedOutputs.begin();
     for ( ; oi != _connectedOutputs.end(); ++oi) {
         SampleOutput* output = *oi;
-        _syncRecSource.removeSampleClient(output);
+        map<SampleOutput*, SyncRecordColumnsFilter*>::iterator fi =
+            _columnFilters.find(output);
+        if (fi != _columnFilters.end()) {
+            _syncRecSource.removeSampleClient(fi->second);
+            _oldColumnFilters.push_back(fi->second);
+        }
+        else _syncRecSource.removeSampleClient(output);
         output->flush();
         try {
             output->close();
@@ -74,6 +82,9 @@ SyncRecordGenerator::~SyncRecordGenerator()
 
         if (output != orig) delete output;
     }
+    list<SyncRecordColumnsFilter*>::const_iterator fi =
+        _oldColumnFilters.begin();
+    for ( ; fi != _oldColumnFilters.end(); ++fi) delete *fi;
     _connectionMutex.unlock();
 }
 
@@ -124,6 +135,29 @@ void SyncRecordGenerator::connect(SampleOutput* output) throw()
     _connectionMutex.unlock();
 }
 
+void SyncRecordGenerator::connectColumns(SampleOutput* output,
+                                         const vector<string>& names,
+                                         bool float32) throw()
+{
+    SyncRecordColumns columns;
+    _syncRecSource.getColumns(names, columns);
+    columns.setFloat32(float32);
+
+    ILOG(("SyncRecordGenerator: connect columns from %s, %u variables, "
+          "%u %s values per record",
+          output->getName().c_str(), (unsigned int)columns.getColumns().size(),
+          columns.getNumValues(), (float32 ? "float32" : "float64")));
+
+    _connectionMutex.lock();
+    SyncRecordColumnsFilter* filter =
+        new SyncRecordColumnsFilter(columns, output);
+    _columnFilters[output] = filter;
+    _syncRecSource.addSampleClient(filter);
+    output->setHeaderSource(this);
+    _connectedOutputs.insert(output);
+    _connectionMutex.unlock();
+}
+
 void SyncRecordGenerator::disconnect(SampleOutput* output) throw()
 {
 
@@ -131,7 +165,14 @@ void SyncRecordGenerator::disconnect(SampleOutput* output) throw()
 
    _connectionMutex.lock();
     output->setHeaderSource(0);
-    _syncRecSource.removeSampleClient(output);
+    map<SampleOutput*, SyncRecordColumnsFilter*>::iterator fi =
+        _columnFilters.find(output);
+    if (fi != _columnFilters.end()) {
+        _syncRecSource.removeSampleClient(fi->second);
+        _oldColumnFilters.push_back(fi->second);
+        _columnFilters.erase(fi);
+    }
+    else _syncRecSource.removeSampleClient(output);
     _connectedOutputs.erase(output);
     _connectionMutex.unlock();
 
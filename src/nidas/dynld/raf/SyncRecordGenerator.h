@@ -30,10 +30,14 @@
 #include <nidas/core/SampleIOProcessor.h>
 #include "SyncRecordSource.h"
 
+#include <map>
+
 namespace nidas { namespace dynld { namespace raf {
 
 using namespace nidas::core;
 
+class SyncRecordColumnsFilter;
+
 class SyncRecordGenerator: public SampleIOProcessor, public HeaderSource
 {
 public:
@@ -65,6 +69,17 @@ public:
      */
     void disconnect(SampleOutput* output) throw();
 
+    /**
+     * Connect an output which receives columnar blocks of the
+     * variables in @p names, instead of full sync records.
+     * An empty @p names selects all variables.  See SyncRecordColumns.
+     * Must be called after connectSource(), once the sync record
+     * layout is known.
+     */
+    void connectColumns(SampleOutput* output,
+                        const std::vector<std::string>& names,
+                        bool float32) throw();
+
     /**
      * Method called to write a header to an SampleOutput.
      *
@@ -151,6 +166,19 @@ private:
 
     std::set<SampleOutput*> _connectedOutputs;
 
+    /**
+     * Filters between _syncRecSource and the outputs connected
+     * with connectColumns().
+     */
+    std::map<SampleOutput*, SyncRecordColumnsFilter*> _columnFilters;
+
+    /**
+     * Filters of disconnected outputs.  An output usually disconnects
+     * from within its receive(), called by the filter, so they are
+     * not deleted until the destructor.
+     */
+    std::list<SyncRecordColumnsFilter*> _oldColumnFilters;
+
     SyncRecordSource _syncRecSource;
 
     size_t _numInputSampsLast;
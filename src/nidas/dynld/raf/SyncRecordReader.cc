@@ -30,6 +30,7 @@
 #include <nidas/util/EOFException.h>
 #include <nidas/util/Logger.h>
 
+#include <algorithm>
 #include <limits>
 
 using namespace nidas::core;
@@ -69,11 +70,34 @@ SyncRecordReader::SyncRecordReader(IOChannel*iochan):
     numDataValues(0),projectName(),aircraftName(),flightName(),
     softwareVersion(), startTime(0),_debug(false),
     _header(), _qcond(), _eoq(false),_syncRecords(),
-    _sampleStreamConfigName()
+    _sampleStreamConfigName(), _columns(), _columnar(false), _blockValues()
 {
     init();
 }
 
+SyncRecordReader::SyncRecordReader(IOChannel*iochan,
+                                   const vector<string>& columns,
+                                   bool float32):
+    inputStream(new SampleInputStream(iochan)),
+    syncServer(0),_read_sync_server(false),
+    headException(0),
+    sampleTags(),variables(),variableMap(),
+    numDataValues(0),projectName(),aircraftName(),flightName(),
+    softwareVersion(), startTime(0),_debug(false),
+    _header(), _qcond(), _eoq(false),_syncRecords(),
+    _sampleStreamConfigName(), _columns(), _columnar(false), _blockValues()
+{
+    string line = SyncRecordColumns::formatSubscription(columns, float32);
+    try {
+        iochan->write(line.c_str(), line.length());
+    }
+    catch(const n_u::IOException& e) {
+        headException = new SyncRecHeaderException(e.what());
+        return;
+    }
+    init();
+}
+
 
 SyncRecordReader::SyncRecordReader(SyncServer* ss):
     inputStream(0),
@@ -83,7 +107,7 @@ SyncRecordReader::SyncRecordReader(SyncServer* ss):
     numDataValues(0),projectName(),aircraftName(),flightName(),
     softwareVersion(), startTime(0),_debug(false),
     _header(), _qcond(), _eoq(false), _syncRecords(),
-    _sampleStreamConfigName()
+    _sampleStreamConfigName(), _columns(), _columnar(false), _blockValues()
 {
     // We have two possible implementations using the SyncServer: let the
     // SyncServer run in its own thread to keep pushing samples down the
@@ -142,7 +166,22 @@ init()
                     ("EOF before header sample received");
                 break;
             }
-	    if (samp->getId() == SYNC_RECORD_HEADER_ID)
+	    if (samp->getId() == SYNC_RECORD_COLUMNS_HEADER_ID)
+            {
+                // The column layout precedes the text header.
+                try {
+                    _columns.decodeHeader(samp->getConstVoidDataPtr(),
+                                          samp->getDataByteLength());
+                    _columnar = true;
+                }
+                catch(const n_u::ParseException& e) {
+                    headException = new SyncRecHeaderException(e.what());
+                    samp->freeReference();
+                    break;
+                }
+                samp->freeReference();
+	    }
+	    else if (samp->getId() == SYNC_RECORD_HEADER_ID)
             {
                 if (_debug)
 		    cerr << "received SYNC_RECORD_HEADER_ID" << endl;
@@ -485,6 +524,15 @@ void SyncRecordReader::scanHeader(const Sample* samp)
 	    stag->addVariable(var);
 	    var->setSyncRecOffset(offset);
 	    var->setLagOffset(lagoffset);
+            if (_columnar) {
+                // records are blocks of columns, index those instead
+                const SyncRecordColumns::Column* col =
+                    _columns.getColumn(vname);
+                if (col) {
+                    var->setSyncRecOffset(col->offset);
+                    var->setLagOffset(col->lagOffset);
+                }
+            }
 	    int ndata = var->getLength() * (int)ceil(rate);
 	    offset += ndata;
 	    groupSize += ndata;
@@ -513,6 +561,16 @@ void SyncRecordReader::scanHeader(const Sample* samp)
 	}
     }
 
+    if (_columnar) {
+        // only the subscribed variables are in the blocks
+        for (vli = newvars.begin(); vli != newvars.end(); ) {
+            if (!_columns.getColumn((*vli)->getName()))
+                vli = newvars.erase(vli);
+            else ++vli;
+        }
+        offset = _columns.getNumValues();
+    }
+
     variables = newvars;
 
     // make the variableMap for quick lookup.
@@ -611,6 +669,26 @@ size_t SyncRecordReader::read(dsm_time_t* tt,double* dest,size_t len)
                 samp->freeReference();
                 return len;
             }
+            else if (samp->getId() == SYNC_RECORD_COLUMNS_ID && _columnar &&
+                     samp->getDataByteLength() == _columns.getBlockLength())
+            {
+                *tt = samp->getTimeTag();
+                if (len >= numDataValues)
+                {
+                    len = numDataValues;
+                    _columns.decodeRecord(samp->getConstVoidDataPtr(), dest);
+                }
+                else
+                {
+                    _blockValues.resize(numDataValues);
+                    _columns.decodeRecord(samp->getConstVoidDataPtr(),
+                                          &_blockValues.front());
+                    std::copy(_blockValues.begin(), _blockValues.begin() + len,
+                              dest);
+                }
+                samp->freeReference();
+                return len;
+            }
             else
             {
                 samp->freeReference();
@@ -32,6 +32,7 @@
 #include <nidas/dynld/SampleInputStream.h>
 #include <nidas/core/SampleTag.h>
 #include "SyncRecordVariable.h"
+#include "SyncRecordColumns.h"
 #include "SyncServer.h"
 
 #include <nidas/util/ThreadSupport.h>
@@ -93,6 +94,18 @@ public:
      */
     SyncRecordReader(IOChannel* iochan);
 
+    /**
+     * Constructor of a SyncRecordReader to a connected IOChannel
+     * of a SyncServer which reads subscriptions, see
+     * SyncServer::setSubscribe().  The reader asks for columnar
+     * blocks of the variables in @p columns, or all variables if it
+     * is empty, with float32 or float64 values.  getVariables() then
+     * returns only the subscribed variables, and their offsets
+     * index the records returned by read().
+     */
+    SyncRecordReader(IOChannel* iochan,
+                     const std::vector<std::string>& columns, bool float32);
+
     /**
      * Constructor for a SyncRecordReader connected directly as a
      * SampleClient of a SyncServer instance.
@@ -243,6 +256,16 @@ private:
 
     std::string _sampleStreamConfigName;
 
+    /**
+     * Layout of the SYNC_RECORD_COLUMNS_ID blocks, if a
+     * SYNC_RECORD_COLUMNS_HEADER_ID sample was received.
+     */
+    SyncRecordColumns _columns;
+
+    bool _columnar;
+
+    std::vector<double> _blockValues;
+
     /** No copying. */
     SyncRecordReader(const SyncRecordReader&);
 
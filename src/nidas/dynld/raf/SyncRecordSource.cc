@@ -26,6 +26,7 @@
 
 #include "SyncRecordSource.h"
 #include "Aircraft.h"
+#include "SyncRecordColumns.h"
 #include <nidas/core/SampleInput.h>
 #include <nidas/core/Project.h>
 #include <nidas/core/DSMSensor.h>
@@ -263,7 +264,7 @@ SyncRecordSource::~SyncRecordSource()
     // log the discarded, overWritten and, if LOG_SKIPS is defined,
     // the skipped samples for each sample id
     set<dsm_sample_id_t> logIds;
-    map<dsm_sample_id_t,SyncInfo>::const_iterator si = _syncInfo.begin();
+    SampleIdMap<SyncInfo>::const_iterator si = _syncInfo.begin();
 
     for ( ; si != _syncInfo.end(); ++si) {
         if (si->second.discarded + si->second.noverWritten > 0)
@@ -277,7 +278,7 @@ SyncRecordSource::~SyncRecordSource()
     set<dsm_sample_id_t>::const_iterator li = logIds.begin();
     for ( ; li != logIds.end(); ++li) {
         dsm_sample_id_t id = *li;
-        map<dsm_sample_id_t, SyncInfo>::const_iterator si =
+        SampleIdMap<SyncInfo>::const_iterator si =
             _syncInfo.find(id); //  we know it will be found
         const SyncInfo& sinfo = si->second;
 #ifdef LOG_SKIPS
@@ -384,7 +385,7 @@ init()
 
         if (rate <= 0.0) continue;
 
-        map<dsm_sample_id_t, SyncInfo>::iterator si =
+        SampleIdMap<SyncInfo>::iterator si =
             _syncInfo.find(id);
         if (si == _syncInfo.end()) {
             /* This should be the only place a SyncInfo copy constructor
@@ -414,7 +415,7 @@ init()
     }
 
     int index = 0;
-    map<dsm_sample_id_t, SyncInfo>::iterator si = _syncInfo.begin();
+    SampleIdMap<SyncInfo>::iterator si = _syncInfo.begin();
 
     for ( ; si != _syncInfo.end(); ++si) {
         SyncInfo& sinfo = si->second;
@@ -542,7 +543,7 @@ void SyncRecordSource::createHeader(ostream& ost) throw()
     // write list of variable names for each rate.
     // There will likely be more than one list for a given rate.
     ost << "rates {" << endl;
-    std::map<dsm_sample_id_t, SyncInfo>::const_iterator si = _syncInfo.begin();
+    SampleIdMap<SyncInfo>::const_iterator si = _syncInfo.begin();
 
     //
     for ( ; si != _syncInfo.end(); ++si) {
@@ -624,6 +625,34 @@ void SyncRecordSource::sendSyncHeader() throw()
     _source.distribute(headerRec);
 }
 
+void SyncRecordSource::getColumns(const vector<string>& names,
+                                  SyncRecordColumns& columns) const
+{
+    set<string> wanted(names.begin(), names.end());
+    set<string> found;
+
+    columns.clear();
+    SampleIdMap<SyncInfo>::const_iterator si = _syncInfo.begin();
+    for ( ; si != _syncInfo.end(); ++si) {
+        const SyncInfo& sinfo = si->second;
+        list<const Variable*>::const_iterator vi = sinfo.variables.begin();
+        for (size_t i = 0; vi != sinfo.variables.end(); ++vi, i++) {
+            string varname = (*vi)->getName();
+            replace_util(varname,' ','_');
+            if (!wanted.empty() && !wanted.count(varname)) continue;
+            columns.addColumn(varname, sinfo.varSRIndex[i],
+                              sinfo.varLengths[i] * sinfo.nSlots,
+                              sinfo.sampleSRIndex, sinfo.rate);
+            found.insert(varname);
+        }
+    }
+    set<string>::const_iterator ni = wanted.begin();
+    for ( ; ni != wanted.end(); ++ni) {
+        if (!found.count(*ni))
+            WLOG(("sync record column %s: no such variable", ni->c_str()));
+    }
+}
+
 void SyncRecordSource::flush() throw()
 {
     DLOG(("SyncRecordSource::flush()"));
@@ -691,7 +720,7 @@ int SyncRecordSource::advanceRecord(dsm_time_t timetag)
     _current = nextRecordIndex(_current);
     if (!_syncRecord[_current]) allocateRecord(_current,timetag);
 
-    map<dsm_sample_id_t, SyncInfo>::iterator si = _syncInfo.begin();
+    SampleIdMap<SyncInfo>::iterator si = _syncInfo.begin();
     for ( ; si != _syncInfo.end(); ++si) {
         si->second.advanceRecord(last);
     }
@@ -1056,7 +1085,7 @@ bool SyncRecordSource::receive(const Sample* samp) throw()
     dsm_time_t tt = samp->getTimeTag();
     dsm_sample_id_t sampleId = samp->getId();
 
-    map<dsm_sample_id_t, SyncInfo>::iterator si =
+    SampleIdMap<SyncInfo>::iterator si =
         _syncInfo.find(sampleId);
     if (si == _syncInfo.end()) return false;
     SyncInfo& sinfo = si->second;
@@ -29,10 +29,18 @@
 
 #include <nidas/core/Resampler.h>
 #include <nidas/core/SampleTag.h>
+#include <nidas/core/SampleIdMap.h>
 
 #define SYNC_RECORD_ID 3
 #define SYNC_RECORD_HEADER_ID 2
 
+/**
+ * Ids of the binary column layout header and of the columnar blocks
+ * of sync records, see SyncRecordColumns.
+ */
+#define SYNC_RECORD_COLUMNS_HEADER_ID 4
+#define SYNC_RECORD_COLUMNS_ID 5
+
 namespace nidas {
 
 namespace util {
@@ -52,6 +60,8 @@ class Aircraft;
 
 class SyncInfo;
 
+class SyncRecordColumns;
+
 class SyncRecordSource: public Resampler
 {
     /**
@@ -302,6 +312,17 @@ public:
      **/
     void sendSyncHeader() throw();
 
+    /**
+     * Fill @p columns with the layout of a columnar block containing
+     * the variables in @p names, in sync record order. The names are
+     * as in the sync record header, with spaces replaced by
+     * underscores.  An empty list selects all variables.  Names which
+     * are not in the sync record are logged and skipped.  The layout
+     * is only valid after init().
+     */
+    void getColumns(const std::vector<std::string>& names,
+                    SyncRecordColumns& columns) const;
+
     bool receive(const Sample*) throw();
 
     // static const int NSYNCREC = 2;
@@ -395,13 +416,13 @@ private:
      *      SyncInfo& sinfo = _syncInfo[id];
      * which would need the no-arg constructor if the element is not found.
      * Instead, do:
-     *      map<dsm_sample_id_t, SyncInfo>::iterator si = _syncInfo.find(id);
+     *      SampleIdMap<SyncInfo>::iterator si = _syncInfo.find(id);
      *      if (si != _syncInfo.end()) {
      *          SyncInfo& sinfo = si->second;  // use reference to avoid copy
      *          ...
      *      }
      */
-    std::map<dsm_sample_id_t, SyncInfo> _syncInfo;
+    SampleIdMap<SyncInfo> _syncInfo;
 
     /**
      * List of all variables in the sync record.
@@ -25,6 +25,7 @@
 */
 
 #include "SyncServer.h"
+#include "SyncRecordColumns.h"
 
 #include <ctime>
 
@@ -36,6 +37,7 @@
 #include <nidas/core/Project.h>
 #include <nidas/util/Process.h>
 #include <nidas/util/Logger.h>
+#include <nidas/util/EOFException.h>
 
 #include <set>
 #include <map>
@@ -63,6 +65,8 @@ SyncServer::SyncServer():
     _sorterLengthSecs(SORTER_LENGTH_SECS),
     _rawSorterLengthSecs(RAW_SORTER_LENGTH_SECS),
     _sampleClient(0),
+    _columnar(false), _columnNames(), _columnsFloat32(false),
+    _subscribe(false),
     _stop_signal(0),
     _firstSample(0),
     _startTime(0),
@@ -339,6 +343,7 @@ init()
             servSock->close();
             delete servSock;
         }
+        if (_subscribe) readSubscription(ioc);
 
         // The SyncServer is a SampleConnectionRequester client of the
         // output stream, so it will be notified when the output is closed
@@ -349,7 +354,10 @@ init()
         // don't try to reconnect. On an error in the output socket
         // writes will cease, but this process will keep reading samples.
         output.setReconnectDelaySecs(-1);
-        _syncGen.connect(&output);
+        if (_columnar)
+            _syncGen.connectColumns(&output, _columnNames, _columnsFloat32);
+        else
+            _syncGen.connect(&output);
     }
     else
     {
@@ -358,6 +366,29 @@ init()
     DLOG(("SyncServer::init() finished."));
 }
 
+void
+SyncServer::
+readSubscription(IOChannel* ioc)
+{
+    // Read a byte at a time, so nothing beyond the line is consumed.
+    string line;
+    for (;;) {
+        char c;
+        if (ioc->read(&c, 1) == 0)
+            throw n_u::EOFException(ioc->getName(), "read subscription");
+        if (c == '\n') break;
+        line += c;
+        if (line.length() > 65536)
+            throw n_u::ParseException("sync record subscription",
+                                      "line too long");
+    }
+    SyncRecordColumns::parseSubscription(line, _columnNames, _columnsFloat32);
+    _columnar = true;
+    ILOG(("SyncServer: ") << ioc->getName() << " subscribed to "
+         << _columnNames.size() << " variables (0=all), "
+         << (_columnsFloat32 ? "float32" : "float64"));
+}
+
 
 void
 SyncServer::
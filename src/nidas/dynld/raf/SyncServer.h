@@ -144,6 +144,30 @@ public:
         _sampleClient = client;
     }
 
+    /**
+     * Send columnar blocks of the variables in @p names to the socket
+     * client, instead of full sync records.  An empty @p names selects
+     * all variables.  See SyncRecordColumns.
+     */
+    void
+    setColumns(const std::vector<std::string>& names, bool float32)
+    {
+        _columnar = true;
+        _columnNames = names;
+        _columnsFloat32 = float32;
+    }
+
+    /**
+     * If true, read a subscription line from the socket client once it
+     * connects, and send it the columns it asks for.  See
+     * SyncRecordColumns::formatSubscription().
+     */
+    void
+    setSubscribe(bool val)
+    {
+        _subscribe = val;
+    }
+
     void
     setDataFileNames(const std::list<std::string>& dataFileNames)
     {
@@ -205,6 +229,13 @@ private:
     void
     handleSample(nidas::core::Sample* sample);
 
+    /**
+     * @throws nidas::util::IOException
+     * @throws nidas::util::ParseException
+     **/
+    void
+    readSubscription(IOChannel* ioc);
+
     SamplePipeline _pipeline;
     SyncRecordGenerator _syncGen;
 
@@ -223,6 +254,14 @@ private:
 
     SampleClient* _sampleClient;
 
+    bool _columnar;
+
+    std::vector<std::string> _columnNames;
+
+    bool _columnsFloat32;
+
+    bool _subscribe;
+
     StopSignal* _stop_signal;
 
     nidas::core::Sample* _firstSample;
@@ -36,6 +36,8 @@
 #include <sstream>
 #include <iomanip>
 
+#include <endian.h>
+
 using namespace std;
 using namespace nidas::dynld::raf;
 
@@ -193,71 +195,179 @@ void TwoD_Processing::createSamples(dsm_time_t nextTimeTag,list < const Sample *
 }
 
 /*---------------------------------------------------------------------------*/
-void TwoD_Processing::processParticleSlice(const unsigned char * data)
+namespace {
+
+/*
+ * Word-at-a-time access to the slices.  Note that 2D data is inverted.
+ * So a '1' means no shadowing of the diode, '0' means shadowing and a
+ * particle.  The words are complemented here, and read big-endian so
+ * that the first diode of the slice is the most significant bit.
+ */
+inline uint32_t shadowWord(const unsigned char* cp, uint32_t)
 {
-    int nBytes = NumberOfDiodes() / 8;
+    uint32_t w;
+    ::memcpy(&w, cp, sizeof(w));
+    return ~be32toh(w);
+}
 
-    /* Note that 2D data is inverted.  So a '1' means no shadowing of the diode.
-     * '0' means shadowing and a particle.  Perform complement here.
-     */
-    unsigned char slice[nBytes];
-    for (int i = 0; i < nBytes; ++i)
-        slice[i] = ~(data[i]);
+inline uint64_t shadowWord(const unsigned char* cp, uint64_t)
+{
+    uint64_t w;
+    ::memcpy(&w, cp, sizeof(w));
+    return ~be64toh(w);
+}
 
-    _particle.width++;
+inline unsigned int popCount(uint32_t w) { return __builtin_popcount(w); }
+inline unsigned int popCount(uint64_t w) { return __builtin_popcountll(w); }
 
-    if ((slice[0] & 0x80)) { // touched edge
-        _particle.edgeTouch |= 0x0F;
-    }
+// Leading and trailing zeros of non-zero words.
+inline unsigned int leadingZeros(uint32_t w) { return __builtin_clz(w); }
+inline unsigned int leadingZeros(uint64_t w) { return __builtin_clzll(w); }
+inline unsigned int trailingZeros(uint32_t w) { return __builtin_ctz(w); }
+inline unsigned int trailingZeros(uint64_t w) { return __builtin_ctzll(w); }
 
-    if ((slice[nBytes-1] & 0x01)) { // touched edge
-        _particle.edgeTouch |= 0xF0;
-    }
+/**
+ * Accumulate the area, height and edge touches of nSlices slices of
+ * NWORDS words of type W each.
+ */
+template <typename W, unsigned int NWORDS>
+void sliceStats(const unsigned char* cp, unsigned int nSlices,
+    unsigned int& area, unsigned int& height, unsigned char& edgeTouch)
+{
+    const unsigned int wordBits = sizeof(W) * 8;
+    const unsigned int nDiodes = NWORDS * wordBits;
 
-    // Compute area = number of bits set in particle
-    for (int i = 0; i < nBytes; ++i)
+    for (unsigned int n = 0; n < nSlices; ++n, cp += NWORDS * sizeof(W))
     {
-        unsigned char c = slice[i];
-        for (; c; _particle.area++)
-            c &= c - 1; // clear the least significant bit set
+        W w[NWORDS];
+        unsigned int a = 0;
+        for (unsigned int i = 0; i < NWORDS; ++i)
+        {
+            w[i] = shadowWord(cp + i * sizeof(W), W());
+            a += popCount(w[i]);
+        }
+        if (a == 0)     // no shadowed diodes
+            continue;
+        area += a;
+
+        if (w[0] >> (wordBits - 1))     // touched edge
+            edgeTouch |= 0x0F;
+        if (w[NWORDS-1] & 0x01)         // touched edge
+            edgeTouch |= 0xF0;
+
+        // number of bits between first and last set bit, inclusive
+        unsigned int i = 0, lead = 0;
+        for ( ; w[i] == 0; ++i)
+            lead += wordBits;
+        lead += leadingZeros(w[i]);
+
+        unsigned int j = NWORDS - 1, trail = 0;
+        for ( ; w[j] == 0; --j)
+            trail += wordBits;
+        trail += trailingZeros(w[j]);
+
+        height = std::max(nDiodes - lead - trail, height);
     }
+}
 
-    // number of bits between first and last set bit, inclusive
-    int h = NumberOfDiodes();
-    for (int i = 0; i < nBytes; ++i)
+/**
+ * Byte at a time version of sliceStats(), for other numbers of diodes.
+ */
+void sliceStatsBytes(const unsigned char* cp, unsigned int nSlices,
+    int nBytes, unsigned int& area, unsigned int& height,
+    unsigned char& edgeTouch)
+{
+    for (unsigned int n = 0; n < nSlices; ++n, cp += nBytes)
     {
-        if (slice[i] == 0)
+        unsigned char slice[nBytes];
+        for (int i = 0; i < nBytes; ++i)
+            slice[i] = ~(cp[i]);
+
+        if ((slice[0] & 0x80)) { // touched edge
+            edgeTouch |= 0x0F;
+        }
+
+        if ((slice[nBytes-1] & 0x01)) { // touched edge
+            edgeTouch |= 0xF0;
+        }
+
+        // Compute area = number of bits set in particle
+        for (int i = 0; i < nBytes; ++i)
         {
-            h -= 8;
-            continue;
+            unsigned char c = slice[i];
+            for (; c; area++)
+                c &= c - 1; // clear the least significant bit set
         }
-        int r = 7;
-        unsigned char v = slice[i];
-        while (v >>= 1)
-            r--;
-        h -= r;
-        break;
-    }
-    for (int i = nBytes-1; i >= 0; --i)
-    {
-        if (slice[i] == 0)
+
+        // number of bits between first and last set bit, inclusive
+        int h = nBytes * 8;
+        for (int i = 0; i < nBytes; ++i)
         {
-            h -= 8;
-            continue;
+            if (slice[i] == 0)
+            {
+                h -= 8;
+                continue;
+            }
+            int r = 7;
+            unsigned char v = slice[i];
+            while (v >>= 1)
+                r--;
+            h -= r;
+            break;
         }
-        int r = 0;
-        unsigned char v = slice[i];
-        while ((v & 0x01) == 0)
+        for (int i = nBytes-1; i >= 0; --i)
         {
-            r++;
-            v >>= 1;
+            if (slice[i] == 0)
+            {
+                h -= 8;
+                continue;
+            }
+            int r = 0;
+            unsigned char v = slice[i];
+            while ((v & 0x01) == 0)
+            {
+                r++;
+                v >>= 1;
+            }
+            h -= r;
+            break;
         }
-        h -= r;
-        break;
+
+        if (h > 0)
+            height = std::max((unsigned)h, height);
     }
+}
 
-    if (h > 0)
-        _particle.height = std::max((unsigned)h, _particle.height);
+}   // namespace
+
+void TwoD_Processing::processParticleSlice(const unsigned char * data)
+{
+    processParticleSlices(data, 1);
+}
+
+void TwoD_Processing::processParticleSlices(const unsigned char * slices,
+    unsigned int nSlices)
+{
+    _particle.width += nSlices;
+
+    switch (NumberOfDiodes()) {
+    case 32:
+        sliceStats<uint32_t, 1>(slices, nSlices, _particle.area,
+            _particle.height, _particle.edgeTouch);
+        break;
+    case 64:
+        sliceStats<uint64_t, 1>(slices, nSlices, _particle.area,
+            _particle.height, _particle.edgeTouch);
+        break;
+    case 128:
+        sliceStats<uint64_t, 2>(slices, nSlices, _particle.area,
+            _particle.height, _particle.edgeTouch);
+        break;
+    default:
+        sliceStatsBytes(slices, nSlices, NumberOfDiodes() / 8,
+            _particle.area, _particle.height, _particle.edgeTouch);
+        break;
+    }
 }
 
 /*---------------------------------------------------------------------------*/
@@ -119,6 +119,18 @@ public:
      */
     virtual void processParticleSlice(const unsigned char * slice);
 
+    /**
+     * Process consecutive slices of the current particle, with the same
+     * result as calling processParticleSlice() on each of them.  Slices
+     * of 32, 64 or 128 diodes are analyzed a word at a time, with
+     * population and leading/trailing zero counts, instead of a byte
+     * at a time.
+     * @param slices is a pointer to the first slice, in big-endian and
+     * uncomplemented.  Each slice is NumberOfDiodes() / 8 bytes.
+     * @param nSlices is the number of slices.
+     */
+    void processParticleSlices(const unsigned char * slices, unsigned int nSlices);
+
     /**
      * Look at particle stats/info and decide whether to accept or reject.
      * @param p is the particle information.
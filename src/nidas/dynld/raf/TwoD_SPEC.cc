@@ -56,7 +56,8 @@ TwoD_SPEC::TwoD_SPEC(std::string name)
       _prevParticleID(0), _timingWordMask(0x00000000ffffffffULL),
       _freq(0), _timingWordSize(2), _timingWordMSWFirst(true)
 {
-
+    // Image records can be processed off the raw sorter thread.
+    setAsyncProcessing(true);
 }
 
 TwoD_SPEC::~TwoD_SPEC()
@@ -223,10 +224,7 @@ if (nSlices > 575) WLOG( ("") <<_name << " - nSlices = " << nSlices << "  !!!");
                 continue;
 
             // nSlices-1, since timing word is being counted.
-            for (size_t k = 0; k < nSlices-1; ++k)
-            {
-                _processor->processParticleSlice(&_uncompressedParticle[k*16]);
-            }
+            _processor->processParticleSlices(_uncompressedParticle, nSlices-1);
 
             // Get time.  Type32 stores the timing word most-significant-word-first;
             // Type48 stores it least-significant-word-first.
@@ -57,6 +57,8 @@ const n_u::EndianConverter * TwoD_USB::littleEndian =
 TwoD_USB::TwoD_USB(std::string name) : _name(name), _processor(0), _tasRate(1), _tasOutOfRange(0), _sorID(0), _trueAirSpeed(0)
 {
     setDefaultMode(O_RDWR);
+    // Image records can be processed off the raw sorter thread.
+    setAsyncProcessing(true);
 }
 
 TwoD_USB::~TwoD_USB()
@@ -0,0 +1,511 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "BlockCodec.h"
+#include "Thread.h"
+#include "ThreadSupport.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+#include <vector>
+
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+using namespace nidas::util;
+using namespace std;
+
+namespace nidas { namespace util {
+
+/**
+ * A block of input to a BlockCodec, and the result.
+ */
+struct CodecBlock
+{
+    CodecBlock(bool comp):
+        data(),result(),compress(comp),done(false),
+        status(BlockCodec::COMPLETE),error()
+    {
+    }
+
+    std::string data;
+
+    std::string result;
+
+    bool compress;
+
+    bool done;
+
+    BlockCodec::status status;
+
+    /**
+     * Message of an IOException from the codec.
+     */
+    std::string error;
+};
+
+/**
+ * Threads which take CodecBlocks from a queue and compress
+ * or uncompress them.
+ */
+class BlockCodecPool
+{
+public:
+
+    BlockCodecPool(const BlockCodec& codec, unsigned int nthreads,
+                   const string& name);
+
+    ~BlockCodecPool();
+
+    /**
+     * Queue a block. With no threads, process it now.
+     */
+    void submit(CodecBlock* blk);
+
+    bool isDone(const CodecBlock* blk) const;
+
+    void wait(const CodecBlock* blk);
+
+    /**
+     * Remove a block from the queue, or wait for it if it
+     * is being processed, so that it can be deleted.
+     */
+    void retract(CodecBlock* blk);
+
+    unsigned int getNumThreads() const { return _threads.size(); }
+
+    static void process(const BlockCodec& codec, CodecBlock* blk);
+
+private:
+
+    class Worker: public Thread
+    {
+    public:
+        Worker(BlockCodecPool& pool, const string& name):
+            Thread(name),_pool(pool)
+        {
+        }
+        int run();
+    private:
+        BlockCodecPool& _pool;
+    };
+
+    const BlockCodec& _codec;
+
+    std::deque<CodecBlock*> _pending;
+
+    std::vector<Worker*> _threads;
+
+    bool _quit;
+
+    /**
+     * Signaled when a block is queued, and when one is done.
+     */
+    mutable Cond _cond;
+
+    BlockCodecPool(const BlockCodecPool&) = delete;
+    BlockCodecPool& operator=(const BlockCodecPool&) = delete;
+};
+
+}}	// namespace nidas namespace util
+
+BlockCodecPool::BlockCodecPool(const BlockCodec& codec,
+        unsigned int nthreads, const string& name):
+    _codec(codec),_pending(),_threads(),_quit(false),_cond()
+{
+    for (unsigned int i = 0; i < nthreads; i++) {
+        ostringstream ost;
+        ost << name << i;
+        Worker* thr = new Worker(*this, ost.str());
+        _threads.push_back(thr);
+        thr->start();
+    }
+}
+
+BlockCodecPool::~BlockCodecPool()
+{
+    _cond.lock();
+    _quit = true;
+    _cond.broadcast();
+    _cond.unlock();
+
+    for (unsigned int i = 0; i < _threads.size(); i++) {
+        Worker* thr = _threads[i];
+        try {
+            thr->join();
+        }
+        catch(const Exception& e) {
+            WLOG(("%s: %s", thr->getName().c_str(), e.what()));
+        }
+        delete thr;
+    }
+}
+
+void BlockCodecPool::process(const BlockCodec& codec, CodecBlock* blk)
+{
+    try {
+        if (blk->compress)
+            codec.compress(blk->data.data(), blk->data.size(), blk->result);
+        else {
+            blk->result.clear();
+            blk->status = codec.decompress(blk->data.data(),
+                                           blk->data.size(), blk->result);
+        }
+    }
+    catch (const IOException& e) {
+        blk->error = e.what();
+    }
+}
+
+void BlockCodecPool::submit(CodecBlock* blk)
+{
+    if (_threads.empty()) {
+        process(_codec, blk);
+        blk->done = true;
+        return;
+    }
+    _cond.lock();
+    _pending.push_back(blk);
+    _cond.broadcast();
+    _cond.unlock();
+}
+
+bool BlockCodecPool::isDone(const CodecBlock* blk) const
+{
+    Autolock autolock(_cond);
+    return blk->done;
+}
+
+void BlockCodecPool::wait(const CodecBlock* blk)
+{
+    _cond.lock();
+    while (!blk->done) _cond.wait();
+    _cond.unlock();
+}
+
+void BlockCodecPool::retract(CodecBlock* blk)
+{
+    _cond.lock();
+    std::deque<CodecBlock*>::iterator bi =
+        std::find(_pending.begin(), _pending.end(), blk);
+    if (bi != _pending.end()) _pending.erase(bi);
+    else while (!blk->done) _cond.wait();
+    _cond.unlock();
+}
+
+int BlockCodecPool::Worker::run()
+{
+    Cond& cond = _pool._cond;
+    cond.lock();
+    while (!_pool._quit) {
+        if (_pool._pending.empty()) {
+            cond.wait();
+            continue;
+        }
+        CodecBlock* blk = _pool._pending.front();
+        _pool._pending.pop_front();
+        cond.unlock();
+
+        process(_pool._codec, blk);
+
+        cond.lock();
+        blk->done = true;
+        cond.broadcast();
+    }
+    cond.unlock();
+    return RUN_OK;
+}
+
+BlockCompressor::BlockCompressor(const BlockCodec& codec,
+        unsigned int nthreads, size_t blockSize):
+    _codec(codec),
+    _pool(new BlockCodecPool(codec, nthreads,
+                             string(codec.getName()) + "Compress")),
+    _blockSize(blockSize > 0 ? blockSize : codec.getBlockSize()),
+    _maxQueued(2 * nthreads),_fd(-1),_name(),_current(0),_blocks()
+{
+}
+
+BlockCompressor::~BlockCompressor()
+{
+    discard();
+    delete _pool;
+}
+
+unsigned int BlockCompressor::getNumThreads() const
+{
+    return _pool->getNumThreads();
+}
+
+void BlockCompressor::open(int fd, const string& name)
+{
+    discard();
+    _fd = fd;
+    _name = name;
+}
+
+void BlockCompressor::discard()
+{
+    for (unsigned int i = 0; i < _blocks.size(); i++) {
+        _pool->retract(_blocks[i]);
+        delete _blocks[i];
+    }
+    _blocks.clear();
+    delete _current;
+    _current = 0;
+}
+
+void BlockCompressor::write(const void* buf, size_t len)
+{
+    const char* cp = (const char*) buf;
+    while (len > 0) {
+        if (!_current) {
+            _current = new CodecBlock(true);
+            _current->data.reserve(_blockSize);
+        }
+        size_t n = std::min(len, _blockSize - _current->data.size());
+        _current->data.append(cp, n);
+        cp += n;
+        len -= n;
+        if (_current->data.size() >= _blockSize) {
+            submit();
+            writeBlocks(_maxQueued);
+        }
+    }
+}
+
+void BlockCompressor::submit()
+{
+    CodecBlock* blk = _current;
+    _current = 0;
+    _blocks.push_back(blk);
+    _pool->submit(blk);
+}
+
+void BlockCompressor::close()
+{
+    if (_current && !_current->data.empty()) submit();
+    writeBlocks(0);
+    delete _current;
+    _current = 0;
+    _fd = -1;
+}
+
+void BlockCompressor::writeBlocks(size_t maxQueued)
+{
+    while (!_blocks.empty()) {
+        CodecBlock* head = _blocks.front();
+        if (_blocks.size() > maxQueued) _pool->wait(head);
+        else if (!_pool->isDone(head)) break;
+
+        _blocks.pop_front();
+        std::unique_ptr<CodecBlock> blk(head);
+        if (!blk->error.empty())
+            throw IOException(_name, string(_codec.getName()) + " compress",
+                              blk->error);
+        writeFully(blk->result);
+    }
+}
+
+void BlockCompressor::writeFully(const string& data)
+{
+    const char* cp = data.data();
+    size_t len = data.size();
+    while (len > 0) {
+        ssize_t res = ::write(_fd, cp, len);
+        if (res < 0) {
+            if (errno == EINTR) continue;
+            throw IOException(_name, "write", errno);
+        }
+        cp += res;
+        len -= res;
+    }
+}
+
+BlockDecompressor::BlockDecompressor(const BlockCodec& codec,
+        unsigned int nthreads):
+    _codec(codec),
+    _pool(new BlockCodecPool(codec, nthreads,
+                             string(codec.getName()) + "Uncompress")),
+    _maxQueued(std::max(2 * nthreads, 1U)),_readLen(1024 * 1024),
+    _fd(-1),_name(),_eof(false),_in(),_inpos(0),_blocks(),
+    _out(),_outpos(0)
+{
+}
+
+BlockDecompressor::~BlockDecompressor()
+{
+    close();
+    delete _pool;
+}
+
+unsigned int BlockDecompressor::getNumThreads() const
+{
+    return _pool->getNumThreads();
+}
+
+void BlockDecompressor::open(int fd, const string& name)
+{
+    close();
+    _fd = fd;
+    _name = name;
+}
+
+void BlockDecompressor::close()
+{
+    for (unsigned int i = 0; i < _blocks.size(); i++) {
+        _pool->retract(_blocks[i]);
+        delete _blocks[i];
+    }
+    _blocks.clear();
+    _fd = -1;
+    _eof = false;
+    _in.clear();
+    _inpos = 0;
+    _out.clear();
+    _outpos = 0;
+}
+
+/* static */
+bool BlockDecompressor::isSplittable(const BlockCodec& codec, int fd,
+        size_t probeLen)
+{
+    string buf(probeLen, '\0');
+    size_t len = 0;
+    while (len < probeLen) {
+        ssize_t res = ::pread(fd, &buf[len], probeLen - len, len);
+        if (res < 0) {
+            if (errno == EINTR) continue;
+            return false;
+        }
+        if (res == 0) return true;      // whole file fits
+        len += res;
+    }
+    return codec.findStreamLength(buf.data(), len) > 0;
+}
+
+void BlockDecompressor::fill()
+{
+    while (_blocks.size() < _maxQueued) {
+        size_t avail = _in.size() - _inpos;
+        size_t len = 0;
+        if (avail > 0) len = _codec.findStreamLength(_in.data() + _inpos, avail);
+        if (len == 0) {
+            if (_eof) {
+                if (avail == 0) break;
+                len = avail;
+            }
+            else {
+                // Discard submitted input and read more.
+                _in.erase(0, _inpos);
+                _inpos = 0;
+                size_t old = _in.size();
+                _in.resize(old + _readLen);
+                ssize_t res = ::read(_fd, &_in[old], _readLen);
+                if (res < 0) {
+                    int ierr = errno;
+                    _in.resize(old);
+                    if (ierr == EINTR) continue;
+                    throw IOException(_name, "read", ierr);
+                }
+                _in.resize(old + res);
+                if (res == 0) _eof = true;
+                continue;
+            }
+        }
+        CodecBlock* blk = new CodecBlock(false);
+        blk->data.assign(_in, _inpos, len);
+        _inpos += len;
+        _blocks.push_back(blk);
+        _pool->submit(blk);
+    }
+}
+
+bool BlockDecompressor::nextBlock()
+{
+    fill();
+    if (_blocks.empty()) return false;
+
+    std::unique_ptr<CodecBlock> blk(_blocks.front());
+    _blocks.pop_front();
+    _pool->wait(blk.get());
+
+    const string task = string(_codec.getName()) + " uncompress";
+    if (!blk->error.empty())
+        throw IOException(_name, task, blk->error);
+
+    while (blk->status == BlockCodec::TRUNCATED) {
+        // The block did not end at a stream boundary. Append the
+        // input of the next block and uncompress them together.
+        fill();
+        if (_blocks.empty()) {
+            WLOG(("%s: %s: unexpected EOF while uncompressing",
+                  _name.c_str(), _codec.getName()));
+            break;
+        }
+        std::unique_ptr<CodecBlock> next(_blocks.front());
+        _blocks.pop_front();
+        _pool->retract(next.get());
+        blk->data.append(next->data);
+        blk->result.clear();
+        try {
+            blk->status = _codec.decompress(blk->data.data(),
+                                            blk->data.size(), blk->result);
+        }
+        catch (const IOException& e) {
+            throw IOException(_name, task, e.what());
+        }
+    }
+    if (blk->status == BlockCodec::TRAILING) {
+        // Stop at the last complete stream.
+        WLOG(("%s: %s: ignoring trailing data after the last stream",
+              _name.c_str(), _codec.getName()));
+        for (unsigned int i = 0; i < _blocks.size(); i++) {
+            _pool->retract(_blocks[i]);
+            delete _blocks[i];
+        }
+        _blocks.clear();
+        _in.clear();
+        _inpos = 0;
+        _eof = true;
+    }
+    _out.swap(blk->result);
+    _outpos = 0;
+    return true;
+}
+
+size_t BlockDecompressor::read(void* buf, size_t len)
+{
+    while (_outpos >= _out.size())
+        if (!nextBlock()) return 0;
+    len = std::min(len, _out.size() - _outpos);
+    ::memcpy(buf, _out.data() + _outpos, len);
+    _outpos += len;
+    return len;
+}
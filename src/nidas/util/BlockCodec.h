@@ -0,0 +1,292 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#ifndef NIDAS_UTIL_BLOCKCODEC_H
+#define NIDAS_UTIL_BLOCKCODEC_H
+
+#include "IOException.h"
+
+#include <string>
+#include <deque>
+
+namespace nidas { namespace util {
+
+/**
+ * Compression of data in independent blocks.  Each compressed block
+ * is a complete stream of the compression format, a bzip2 stream or
+ * a zstd frame, so that blocks can be compressed and uncompressed
+ * concurrently, and a concatenation of compressed blocks is a valid
+ * compressed file, readable by the usual command line tools.
+ *
+ * The methods are const and must be safe to call from several
+ * threads at once.
+ */
+class BlockCodec
+{
+public:
+
+    virtual ~BlockCodec() {}
+
+    /**
+     * Name of the compression, for messages.
+     */
+    virtual const char* getName() const = 0;
+
+    /**
+     * Default number of uncompressed bytes in a block.
+     */
+    virtual size_t getBlockSize() const = 0;
+
+    /**
+     * Compress @p len bytes at @p in to one complete stream,
+     * replacing the contents of @p out.
+     *
+     * @throws IOException
+     */
+    virtual void compress(const char* in, size_t len, std::string& out) const = 0;
+
+    enum status { COMPLETE, TRUNCATED, TRAILING };
+
+    /**
+     * Uncompress the one or more complete streams in the @p len bytes
+     * at @p in, appending the result to @p out.  Return TRUNCATED if
+     * the input ends within a stream.  Return TRAILING if a complete
+     * stream is followed by data which is not the start of another,
+     * such as zero padding, which like bunzip2 the readers ignore,
+     * treating it as the end of the file.
+     *
+     * @throws IOException on bad compressed data.
+     */
+    virtual status decompress(const char* in, size_t len, std::string& out) const = 0;
+
+    /**
+     * Return the length of the first stream in the @p len bytes at
+     * @p buf, or 0 if its end is not within @p len bytes.
+     * Formats whose stream boundaries can only be found by searching
+     * for a magic number may return a boundary which is not one,
+     * in which case decompress() of the first piece returns TRUNCATED.
+     */
+    virtual size_t findStreamLength(const char* buf, size_t len) const = 0;
+
+};
+
+class BlockCodecPool;
+
+struct CodecBlock;
+
+/**
+ * Compress data written to a file descriptor in blocks, on a pool of
+ * threads, writing the compressed blocks to the file in order.
+ * With zero threads the blocks are compressed by the writing thread.
+ */
+class BlockCompressor
+{
+public:
+
+    /**
+     * @param blockSize: uncompressed bytes per block. If 0, use
+     *  BlockCodec::getBlockSize().
+     */
+    BlockCompressor(const BlockCodec& codec, unsigned int nthreads,
+        size_t blockSize = 0);
+
+    /**
+     * Blocks which have not been written with close() are discarded.
+     */
+    ~BlockCompressor();
+
+    /**
+     * Write compressed blocks to @p fd. @p name is used in exceptions.
+     */
+    void open(int fd, const std::string& name);
+
+    /**
+     * Buffer data, submitting full blocks for compression and writing
+     * any compressed blocks which are ready. Waits when the pool is
+     * behind by more than two blocks per thread.
+     *
+     * @throws IOException
+     */
+    void write(const void* buf, size_t len);
+
+    /**
+     * Compress the partial block, and write all blocks to the file.
+     * Does not close the file descriptor.
+     *
+     * @throws IOException
+     */
+    void close();
+
+    unsigned int getNumThreads() const;
+
+private:
+
+    void submit();
+
+    /**
+     * Write the completed blocks at the head of the queue, waiting
+     * for blocks to complete if more than @p maxQueued are queued.
+     *
+     * @throws IOException
+     */
+    void writeBlocks(size_t maxQueued);
+
+    /**
+     * @throws IOException
+     */
+    void writeFully(const std::string& data);
+
+    void discard();
+
+    const BlockCodec& _codec;
+
+    BlockCodecPool* _pool;
+
+    size_t _blockSize;
+
+    size_t _maxQueued;
+
+    int _fd;
+
+    std::string _name;
+
+    /**
+     * Block being filled by write().
+     */
+    CodecBlock* _current;
+
+    /**
+     * Submitted blocks, in file order.
+     */
+    std::deque<CodecBlock*> _blocks;
+
+    BlockCompressor(const BlockCompressor&) = delete;
+    BlockCompressor& operator=(const BlockCompressor&) = delete;
+};
+
+/**
+ * Read a file of concatenated compressed streams from a file descriptor,
+ * uncompressing the streams on a pool of threads.  The input is
+ * split where BlockCodec::findStreamLength() finds the end of a stream,
+ * so the speedup depends on the file consisting of many streams,
+ * as written by BlockCompressor.  A file which is one large stream is
+ * uncompressed by one thread, with all of it buffered in memory:
+ * use isSplittable() to check a file before reading it this way.
+ */
+class BlockDecompressor
+{
+public:
+
+    BlockDecompressor(const BlockCodec& codec, unsigned int nthreads);
+
+    ~BlockDecompressor();
+
+    /**
+     * Read compressed data from @p fd, which should be positioned at
+     * the beginning of a stream. @p name is used in messages.
+     */
+    void open(int fd, const std::string& name);
+
+    /**
+     * Return uncompressed data, 0 at the end of file.
+     *
+     * @throws IOException
+     */
+    size_t read(void* buf, size_t len);
+
+    /**
+     * Discard buffered blocks. Does not close the file descriptor.
+     */
+    void close();
+
+    unsigned int getNumThreads() const;
+
+    /**
+     * Whether the first stream of the file @p fd ends within
+     * @p probeLen bytes, or the whole file is shorter than that,
+     * so that the file can be read without buffering an unbounded
+     * amount of it. Reads with pread(), not changing the file offset.
+     * Returns false on a read error, or if @p fd does not support pread().
+     */
+    static bool isSplittable(const BlockCodec& codec, int fd,
+        size_t probeLen = 4 * 1024 * 1024);
+
+private:
+
+    /**
+     * Read input and submit blocks until the queue is full
+     * or the end of the input is reached.
+     *
+     * @throws IOException
+     */
+    void fill();
+
+    /**
+     * Replace _out with the contents of the next block.
+     * Return false at the end of the input.
+     *
+     * @throws IOException
+     */
+    bool nextBlock();
+
+    const BlockCodec& _codec;
+
+    BlockCodecPool* _pool;
+
+    size_t _maxQueued;
+
+    size_t _readLen;
+
+    int _fd;
+
+    std::string _name;
+
+    bool _eof;
+
+    /**
+     * Compressed input which has not been submitted,
+     * starting at _inpos.
+     */
+    std::string _in;
+
+    size_t _inpos;
+
+    std::deque<CodecBlock*> _blocks;
+
+    /**
+     * Uncompressed data being returned by read(), from _outpos.
+     */
+    std::string _out;
+
+    size_t _outpos;
+
+    BlockDecompressor(const BlockDecompressor&) = delete;
+    BlockDecompressor& operator=(const BlockDecompressor&) = delete;
+};
+
+}}	// namespace nidas namespace util
+
+#endif
@@ -30,16 +30,114 @@
 #ifdef HAVE_BZLIB_H
 
 #include "EOFException.h"
+#include "InvalidParameterException.h"
 #include "Logger.h"
 
 #include <assert.h>
+#include <string.h>
 
 using namespace nidas::util;
 using namespace std;
 
 
+namespace {
+
+/**
+ * Whether buf starts with the header of a bzip2 stream, "BZh" and
+ * the block size.
+ */
+bool isStreamStart(const char* buf, size_t len)
+{
+    return len >= 4 && buf[0] == 'B' && buf[1] == 'Z' && buf[2] == 'h' &&
+        buf[3] >= '1' && buf[3] <= '9';
+}
+
+}
+
+void Bzip2Codec::compress(const char* in, size_t len, string& out) const
+{
+    // bzip2 documents this as the worst case size of the output.
+    unsigned int destLen = len + len / 100 + 600;
+    out.resize(destLen);
+    int res = BZ2_bzBuffToBuffCompress(&out[0], &destLen,
+            const_cast<char*>(in), len, _blockSize100k, 0, 0);
+    switch(res) {
+    case BZ_OK:
+        break;
+    case BZ_MEM_ERROR:
+        throw IOException("bzip2", "BZ2_bzBuffToBuffCompress", ENOMEM);
+    default:
+        throw IOException("bzip2", "BZ2_bzBuffToBuffCompress",
+                          "bad parameters");
+    }
+    out.resize(destLen);
+}
+
+BlockCodec::status
+Bzip2Codec::decompress(const char* in, size_t len, string& out) const
+{
+    size_t pos = 0;
+    while (pos < len) {
+        if (pos > 0 && !isStreamStart(in + pos, len - pos)) return TRAILING;
+        bz_stream strm;
+        ::memset(&strm, 0, sizeof(strm));
+        int res = BZ2_bzDecompressInit(&strm, 0, _small);
+        if (res == BZ_MEM_ERROR)
+            throw IOException("bzip2", "BZ2_bzDecompressInit", ENOMEM);
+        if (res != BZ_OK)
+            throw IOException("bzip2", "BZ2_bzDecompressInit",
+                              "bad parameters");
+        strm.next_in = const_cast<char*>(in + pos);
+        strm.avail_in = len - pos;
+        do {
+            size_t old = out.size();
+            size_t room = std::max(4 * (size_t)strm.avail_in, (size_t)65536);
+            out.resize(old + room);
+            strm.next_out = &out[old];
+            strm.avail_out = room;
+            res = BZ2_bzDecompress(&strm);
+            out.resize(old + room - strm.avail_out);
+        } while (res == BZ_OK && (strm.avail_in > 0 || strm.avail_out == 0));
+        pos = len - strm.avail_in;
+        BZ2_bzDecompressEnd(&strm);
+
+        switch(res) {
+        case BZ_STREAM_END:
+            break;
+        case BZ_OK:
+            return TRUNCATED;
+        case BZ_MEM_ERROR:
+            throw IOException("bzip2", "BZ2_bzDecompress", ENOMEM);
+        default:
+            throw IOException("bzip2", "BZ2_bzDecompress",
+                              "bad compressed data");
+        }
+    }
+    return COMPLETE;
+}
+
+size_t Bzip2Codec::findStreamLength(const char* buf, size_t len) const
+{
+    // "BZh", block size, then the 48 bit block magic number, pi.
+    static const char magic[] = { 0x31, 0x41, 0x59, 0x26, 0x53, 0x59 };
+    const size_t hlen = 10;
+
+    for (size_t i = 1; i + hlen <= len; i++) {
+        const char* cp = (const char*) ::memchr(buf + i, 'B', len - hlen - i + 1);
+        if (!cp) break;
+        i = cp - buf;
+        if (cp[1] == 'Z' && cp[2] == 'h' && cp[3] >= '1' && cp[3] <= '9' &&
+            ::memcmp(cp + 4, magic, sizeof(magic)) == 0) return i;
+    }
+    return 0;
+}
+
 Bzip2FileSet::Bzip2FileSet() : FileSet(), _fp(0),_bzfp(0),_blockSize100k(1),
-    _small(0),_openedForWriting(false)
+    _small(0),_openedForWriting(false),_codec(_blockSize100k, _small),
+    _compressThreads(0),
+    _uncompressThreads(Logger::getScheme().getParameterT
+                       ("fileset_uncompress_threads", 0)),
+    _compressor(0),_decompressor(0),_blockMode(false),_unused()
 {
 }
 
@@ -47,7 +145,10 @@ Bzip2FileSet::Bzip2FileSet() : FileSet(), _fp(0),_bzfp(0),_blockSize100k(1),
 Bzip2FileSet::Bzip2FileSet(const Bzip2FileSet& x):
     FileSet(x), _fp(0),_bzfp(0),
     _blockSize100k(x._blockSize100k),_small(x._small),
-    _openedForWriting(false)
+    _openedForWriting(false),_codec(_blockSize100k, _small),
+    _compressThreads(x._compressThreads),
+    _uncompressThreads(x._uncompressThreads),
+    _compressor(0),_decompressor(0),_blockMode(false),_unused()
 {
 }
 
@@ -60,6 +161,13 @@ Bzip2FileSet& Bzip2FileSet::operator=(const Bzip2FileSet& rhs)
         _blockSize100k = rhs._blockSize100k;
         _small = rhs._small;
         _openedForWriting = false;
+        _codec = Bzip2Codec(_blockSize100k, _small);
+        _compressThreads = rhs._compressThreads;
+        _uncompressThreads = rhs._uncompressThreads;
+        delete _compressor;
+        _compressor = 0;
+        delete _decompressor;
+        _decompressor = 0;
     }
     return *this;
 }
@@ -76,12 +184,37 @@ Bzip2FileSet::~Bzip2FileSet()
         closeFile();
     }
     catch(const IOException& e) {}
+    delete _compressor;
+    delete _decompressor;
+}
+
+void Bzip2FileSet::setBlockSize100k(int val)
+{
+    if (val < 1 || val > 9)
+        throw InvalidParameterException("Bzip2FileSet", "blockSize100k",
+                                        "must be between 1 and 9");
+    _blockSize100k = val;
+    _codec = Bzip2Codec(_blockSize100k, _small);
+    // a new compressor will be created for the next file
+    delete _compressor;
+    _compressor = 0;
 }
 
 void Bzip2FileSet::openFileForWriting(const std::string& filename)
 {
     int bzerror;
     FileSet::openFileForWriting(filename);
+    if (_compressThreads > 0) {
+        if (!_compressor ||
+            _compressor->getNumThreads() != _compressThreads) {
+            delete _compressor;
+            _compressor = new BlockCompressor(_codec, _compressThreads);
+        }
+        _compressor->open(getFd(), filename);
+        _blockMode = true;
+        _openedForWriting = true;
+        return;
+    }
     if ((_fp = ::fdopen(getFd(),"w")) == NULL) {
         _lastErrno = errno; // queried by status method
         closeFile();
@@ -125,6 +258,20 @@ void Bzip2FileSet::openNextFile()
 {
     do {
         FileSet::openNextFile();
+        _openedForWriting = false;
+        if (getFd() != 0 && _uncompressThreads > 0 &&
+            BlockDecompressor::isSplittable(_codec, getFd()))
+        {
+            if (!_decompressor ||
+                _decompressor->getNumThreads() != _uncompressThreads) {
+                delete _decompressor;
+                _decompressor = new BlockDecompressor(_codec,
+                                                      _uncompressThreads);
+            }
+            _decompressor->open(getFd(), getCurrentName());
+            _blockMode = true;
+            return;
+        }
         if (getFd() == 0)
         {
             _fp = stdin;  // read from stdin
@@ -183,6 +330,20 @@ void Bzip2FileSet::openNextFile()
 
 void Bzip2FileSet::closeFile()
 {
+    if (_blockMode) {
+        _blockMode = false;
+        if (_openedForWriting) {
+            try {
+                _compressor->close();
+            }
+            catch (const IOException& e) {
+                _lastErrno = e.getErrno();  // queried by status method
+                FileSet::closeFile();
+                throw;
+            }
+        }
+        else _decompressor->close();
+    }
     if (_bzfp != NULL) {
         BZFILE* bzfp = _bzfp;
         _bzfp = 0;
@@ -226,6 +387,38 @@ void Bzip2FileSet::closeFile()
     FileSet::closeFile();
 }
 
+bool Bzip2FileSet::nextStream()
+{
+    int bzerror;
+    void* unused;
+    int nunused;
+    BZ2_bzReadGetUnused(&bzerror, _bzfp, &unused, &nunused);
+    if (bzerror != BZ_OK)
+        throw IOException(getCurrentName(), "BZ2_bzReadGetUnused",
+                          "bad sequence");
+    _unused.assign((char*)unused, (char*)unused + nunused);
+
+    int c;
+    while (_unused.size() < 4 && (c = ::getc(_fp)) != EOF)
+        _unused.push_back(c);
+    if (_unused.empty()) return false;
+
+    if (!isStreamStart(&_unused[0], _unused.size())) {
+        // Like bunzip2, ignore data which is not another stream.
+        WLOG(("") << getCurrentName()
+             << ": ignoring trailing data after the last bzip2 stream");
+        return false;
+    }
+
+    BZ2_bzReadClose(&bzerror, _bzfp);
+    _bzfp = BZ2_bzReadOpen(&bzerror, _fp, 0, _small,
+                           &_unused[0], _unused.size());
+    if (!_bzfp)
+        throw IOException(getCurrentName(), "BZ2_bzReadOpen",
+                          "cannot open next stream");
+    return true;
+}
+
 size_t Bzip2FileSet::read(void* buf, size_t count)
 {
     _newFile = false;
@@ -233,13 +426,22 @@ size_t Bzip2FileSet::read(void* buf, size_t count)
 
     int res = 0;
     try {
+        if (_blockMode) {
+            res = _decompressor->read(buf, count);
+            if (res == 0) closeFile();	// next read will open next file
+            return res;
+        }
         int bzerror;
         res = BZ2_bzRead(&bzerror, _bzfp, buf, count);
         switch(bzerror) {
         case BZ_OK:
             break;
         case BZ_STREAM_END:
-            closeFile();	// next read will open next file
+            // A file written by a BlockCompressor is a series of
+            // streams. If this is the last, next read will open
+            // next file.
+            if (!nextStream()) closeFile();
+            else if (res == 0) return read(buf, count);
             break;
         case BZ_PARAM_ERROR:
             throw IOException(getCurrentName(), "BZ2_bzRead",
@@ -278,6 +480,16 @@ size_t Bzip2FileSet::read(void* buf, size_t count)
 
 size_t Bzip2FileSet::write(const void* buf, size_t count)
 {
+    if (_blockMode) {
+        try {
+            _compressor->write(buf, count);
+        }
+        catch (const IOException& e) {
+            _lastErrno = e.getErrno(); // queried by status method
+            throw;
+        }
+        return count;
+    }
     int bzerror;
     BZ2_bzWrite(&bzerror,_bzfp,(void*) buf,count);
     switch(bzerror) {
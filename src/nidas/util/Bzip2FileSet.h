@@ -34,11 +34,55 @@
 #define _FILE_OFFSET_BITS 64
 
 #include "FileSet.h"
+#include "BlockCodec.h"
 
 #include <bzlib.h>
 
+#include <vector>
+
 namespace nidas { namespace util {
 
+/**
+ * BlockCodec for bzip2, compressing each block to a bzip2 stream.
+ */
+class Bzip2Codec: public BlockCodec
+{
+public:
+
+    /**
+     * @param blockSize100k: bzip2 block size, 1-9.
+     * @param small: if non-zero, uncompress using less memory,
+     *  at the expense of speed.
+     */
+    Bzip2Codec(int blockSize100k = 9, int small = 0):
+        _blockSize100k(blockSize100k),_small(small)
+    {
+    }
+
+    const char* getName() const { return "bzip2"; }
+
+    /**
+     * One bzip2 block of input.
+     */
+    size_t getBlockSize() const { return _blockSize100k * 100000; }
+
+    void compress(const char* in, size_t len, std::string& out) const;
+
+    status decompress(const char* in, size_t len, std::string& out) const;
+
+    /**
+     * Search for the magic number of a stream header, "BZh",
+     * the block size, and the magic number of the first block.
+     */
+    size_t findStreamLength(const char* buf, size_t len) const;
+
+private:
+
+    int _blockSize100k;
+
+    int _small;
+};
+
 /**
  * A nidas::util::FileSet, supporting bzip2 compression and uncompression
  * as files are written or read.
@@ -92,6 +136,16 @@ namespace nidas { namespace util {
  *  embedded system.  The gzip result was only about 7% larger than bzip2
  *  (a 54% reduction in size versus a 63% reduction in size for bzip2),
  *  but took 40% of the cpu time of bzip2.
+ *
+ * If setCompressThreads() is non-zero, files are written by a
+ * BlockCompressor, as a series of bzip2 streams compressed by a
+ * pool of threads. bunzip2 reads such files, as does this class,
+ * but earlier versions of this class stop reading at the end of
+ * the first stream. Files consisting of more than one stream, as
+ * long as the first is less than 4 Mbytes, are read with a
+ * BlockDecompressor if setUncompressThreads() is non-zero.
+ * Data after the last stream which is not the start of another is
+ * ignored with a warning, as bunzip2 does.
  */
 class Bzip2FileSet: public FileSet {
 public:
@@ -150,6 +204,21 @@ public:
      **/
     size_t read(void* buf, size_t count);
 
+    /**
+     * Compressed files cannot be mapped.
+     */
+    bool canReadMapped() const { return false; }
+
+    /**
+     * Compressed files cannot be positioned.
+     *
+     * @throws IOException
+     **/
+    void seek(long long)
+    {
+        throw IOException(getCurrentName(),"seek","not supported on compressed file");
+    }
+
     /**
      * Write to current file.
      *
@@ -162,8 +231,45 @@ public:
      **/
     size_t write(const struct iovec* iov, int iovcnt);
 
+    /**
+     * bzip2 block size, 1 to 9, in units of 100 Kbytes, for files
+     * opened after this call. The default is 1.
+     */
+    void setBlockSize100k(int val);
+
+    int getBlockSize100k() const { return _blockSize100k; }
+
+    /**
+     * Number of threads compressing blocks of output files.
+     * 0, the default, compresses the file as one stream in the
+     * writing thread.
+     */
+    void setCompressThreads(unsigned int val) { _compressThreads = val; }
+
+    unsigned int getCompressThreads() const { return _compressThreads; }
+
+    /**
+     * Number of threads uncompressing the streams of input files.
+     * 0 reads files in the calling thread. The default is 0, or the
+     * value of the log parameter "fileset_uncompress_threads".
+     * A BlockDecompressor buffers several streams per thread, so
+     * this is best enabled where memory is not a concern, for
+     * files written with setCompressThreads().
+     */
+    void setUncompressThreads(unsigned int val) { _uncompressThreads = val; }
+
+    unsigned int getUncompressThreads() const { return _uncompressThreads; }
+
 private:
 
+    /**
+     * At the end of a bzip2 stream, start reading the next one if
+     * the file continues. Return false at the end of the file.
+     *
+     * @throws IOException
+     */
+    bool nextStream();
+
     FILE* _fp;
 
     BZFILE* _bzfp;
@@ -174,6 +280,24 @@ private:
 
     bool _openedForWriting;
 
+    Bzip2Codec _codec;
+
+    unsigned int _compressThreads;
+
+    unsigned int _uncompressThreads;
+
+    BlockCompressor* _compressor;
+
+    BlockDecompressor* _decompressor;
+
+    /**
+     * Whether the current file is read or written by _decompressor
+     * or _compressor.
+     */
+    bool _blockMode;
+
+    std::vector<char> _unused;
+
 };
 
 }}	// namespace nidas namespace util
@@ -40,12 +40,17 @@ using namespace std;
 #include <locale>
 #include <vector>
 
+#include <algorithm>
+
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
 #include <regex.h>
 #include <cstdlib>  // for llabs()
+#include <cstring>
+#include <stdint.h>
 
 const char FileSet::pathSeparator = '/';	// this is unix, afterall
 
@@ -55,7 +60,8 @@ FileSet::FileSet() :
     _dir(),_filename(),_currname(),_fullpath(),
     _startTime((time_t)0),_endTime((time_t)0),
     _fileset(),_fileiter(_fileset.begin()),
-    _initialized(false),_fileLength(LONG_LONG_MAX)
+    _initialized(false),_fileLength(LONG_LONG_MAX),
+    _map(0),_mapLen(0),_mapPos(0),_mapKept(0),_readBuf()
 {
 }
 
@@ -67,7 +73,8 @@ FileSet::FileSet(const FileSet& x):
     _startTime(x._startTime),_endTime(x._endTime),
     _fileset(x._fileset),_fileiter(_fileset.begin()),
     _initialized(x._initialized),
-    _fileLength(x._fileLength)
+    _fileLength(x._fileLength),
+    _map(0),_mapLen(0),_mapPos(0),_mapKept(0),_readBuf()
 {
 }
 
@@ -121,6 +128,7 @@ void FileSet::setFileName(const std::string& val)
 
 void FileSet::closeFile()
 {
+    unmapFile();
     if (_fd >= 0) {
         /*
          * Note that we don't do an fsync or fdatasync here before closing.
@@ -289,6 +297,14 @@ size_t FileSet::read(void* buf, size_t count)
 {
     _newFile = false;
     if (_fd < 0) openNextFile();		// throws EOFException
+    if (_map) {
+        // file was opened by readMapped()
+        size_t len = std::min(count, _mapLen - _mapPos);
+        if (len == 0) closeFile();
+        else ::memcpy(buf,_map + _mapPos,len);
+        _mapPos += len;
+        return len;
+    }
     ssize_t res = ::read(_fd,buf,count);
     if (res <= 0) {
         if (res == 0) {
@@ -381,6 +397,97 @@ void FileSet::initialize()
 }
 
 
+size_t FileSet::readMapped(const char*& ptr, size_t count)
+{
+    _newFile = false;
+    if (_fd < 0) {
+        openNextFile();		// throws EOFException
+        mapFile();
+    }
+
+    if (!_map) {
+        if (_readBuf.size() < count) _readBuf.resize(count);
+        ssize_t res = ::read(_fd,&_readBuf[0],count);
+        if (res <= 0) {
+            if (res == 0) {
+                closeFile();	// next read will open next file
+                return res;
+            }
+            throw IOException(_currname,"read",errno);
+        }
+        ptr = &_readBuf[0];
+        return res;
+    }
+
+    size_t len = std::min(count, _mapLen - _mapPos);
+    if (len == 0) {
+        closeFile();
+        return len;
+    }
+    ptr = _map + _mapPos;
+
+    static const size_t pagesize = ::sysconf(_SC_PAGESIZE);
+
+    // Release the pages before ptr, which the caller is done with,
+    // so that reading a large file does not fill memory.
+    size_t keep = _mapPos / pagesize * pagesize;
+    if (keep > _mapKept) {
+        ::madvise(_map + _mapKept, keep - _mapKept, MADV_DONTNEED);
+        _mapKept = keep;
+    }
+    _mapPos += len;
+
+    // Start reading the next block.
+    size_t ahead = _mapPos / pagesize * pagesize;
+    if (ahead < _mapLen)
+        ::madvise(_map + ahead, std::min(count, _mapLen - ahead),
+            MADV_WILLNEED);
+    return len;
+}
+
+void FileSet::seek(long long offset)
+{
+    if (_map) {
+        _mapPos = std::min((size_t)std::max(offset, 0LL), _mapLen);
+        return;
+    }
+    if (::lseek(_fd,offset,SEEK_SET) < 0)
+        throw IOException(_currname,"seek",errno);
+}
+
+void FileSet::mapFile()
+{
+    struct stat statbuf;
+    if (::fstat(_fd,&statbuf) < 0 || !S_ISREG(statbuf.st_mode) ||
+        statbuf.st_size == 0) return;
+
+    // Data appended to the file after this point will not be read,
+    // so this is not suitable for files which are still being written.
+    if ((unsigned long long)statbuf.st_size > SIZE_MAX / 2) return;
+    size_t len = statbuf.st_size;
+
+    void* map = ::mmap(0,len,PROT_READ,MAP_PRIVATE,_fd,0);
+    if (map == MAP_FAILED) {
+        WLOG(("%s: mmap: %s, reading instead",
+              _currname.c_str(), ::strerror(errno)));
+        return;
+    }
+    ::madvise(map,len,MADV_SEQUENTIAL);
+    _map = (char*) map;
+    _mapLen = len;
+    _mapPos = 0;
+    _mapKept = 0;
+}
+
+void FileSet::unmapFile()
+{
+    if (_map) {
+        ::munmap(_map,_mapLen);
+        _map = 0;
+        _mapLen = _mapPos = _mapKept = 0;
+    }
+}
+
 void FileSet::openNextFile()
 {
     DLOG(("") << "openNextFile()");
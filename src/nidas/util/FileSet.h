@@ -33,6 +33,7 @@
 #include <list>
 #include <set>
 #include <string>
+#include <vector>
 #include <locale>
 #include <ctime>
 #include <limits.h>
@@ -184,6 +185,34 @@ public:
      **/
     virtual size_t read(void* buf, size_t count);
 
+    /**
+     * Whether readMapped() can be used on this FileSet.
+     */
+    virtual bool canReadMapped() const { return true; }
+
+    /**
+     * Read from the current file without copying. The file is mapped
+     * into memory when it is opened, with sequential readahead,
+     * and @p ptr is set to the next data in the map, up to
+     * @p count bytes.  The data remain valid until the next read()
+     * or readMapped(), or until the file is closed. Pages before
+     * the returned data are released. Files which cannot be
+     * mapped, such as stdin, are read into an internal buffer.
+     * Returns 0 at the end of a file, like read().
+     *
+     * @throws IOException
+     **/
+    virtual size_t readMapped(const char*& ptr, size_t count);
+
+    /**
+     * Position the current file at @p offset bytes from its start,
+     * for read() or readMapped().  Any data returned by a previous
+     * readMapped() is no longer valid.
+     *
+     * @throws IOException
+     **/
+    virtual void seek(long long offset);
+
     /**
      * Write to current file.
      *
@@ -294,6 +323,14 @@ private:
 
     void initialize();
 
+    /**
+     * Map the file which has just been opened for reading, if it is
+     * a regular file.
+     */
+    void mapFile();
+
+    void unmapFile();
+
     std::string _dir;
 
     std::string _filename;
@@ -318,6 +355,28 @@ private:
      */
     long long _fileLength;
 
+    /**
+     * Memory map of the current file for readMapped(), or null.
+     */
+    char* _map;
+
+    size_t _mapLen;
+
+    /**
+     * Offset in _map of the next data to be returned.
+     */
+    size_t _mapPos;
+
+    /**
+     * Offset in _map of the pages which have not been released.
+     */
+    size_t _mapKept;
+
+    /**
+     * readMapped() buffer for files which cannot be mapped.
+     */
+    std::vector<char> _readBuf;
+
 };
 
 }}	// namespace nidas namespace util
@@ -0,0 +1,94 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "FormatBuffer.h"
+
+#include <cstdio>
+
+using namespace nidas::util;
+
+void FormatBuffer::appendUnsigned(unsigned long long val, int width,
+                                  char fill)
+{
+    char tmp[24];
+    char* cp = tmp + sizeof(tmp);
+    do {
+        *--cp = '0' + (char)(val % 10);
+        val /= 10;
+    } while (val);
+    size_t len = tmp + sizeof(tmp) - cp;
+    pad(len, width, fill);
+    _buf.append(cp, len);
+}
+
+void FormatBuffer::appendInt(long long val, int width, char fill)
+{
+    if (val >= 0) {
+        appendUnsigned(val, width, fill);
+        return;
+    }
+    unsigned long long uval = -(unsigned long long)val;
+    char tmp[24];
+    char* cp = tmp + sizeof(tmp);
+    do {
+        *--cp = '0' + (char)(uval % 10);
+        uval /= 10;
+    } while (uval);
+    *--cp = '-';
+    size_t len = tmp + sizeof(tmp) - cp;
+    pad(len, width, fill);
+    _buf.append(cp, len);
+}
+
+void FormatBuffer::appendHex(unsigned long long val, int width, char fill)
+{
+    static const char digits[] = "0123456789abcdef";
+    char tmp[24];
+    char* cp = tmp + sizeof(tmp);
+    do {
+        *--cp = digits[val & 0xf];
+        val >>= 4;
+    } while (val);
+    size_t len = tmp + sizeof(tmp) - cp;
+    pad(len, width, fill);
+    _buf.append(cp, len);
+}
+
+void FormatBuffer::appendGeneral(double val, int precision, int width)
+{
+    // ostream formats a double with the default floatfield using
+    // %.*g, which is what we do too, minus the stream overhead.
+    char tmp[64];
+    int len = ::snprintf(tmp, sizeof(tmp), "%*.*g", width, precision, val);
+    if (len < 0) return;
+    if ((size_t)len < sizeof(tmp)) {
+        _buf.append(tmp, len);
+        return;
+    }
+    std::string big(len + 1, '\0');
+    ::snprintf(&big[0], big.size(), "%*.*g", width, precision, val);
+    _buf.append(big.c_str(), len);
+}
@@ -0,0 +1,134 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#ifndef NIDAS_UTIL_FORMATBUFFER_H
+#define NIDAS_UTIL_FORMATBUFFER_H
+
+#include <string>
+
+namespace nidas { namespace util {
+
+/**
+ * A character buffer for building lines of formatted text without
+ * std::ostream manipulators.  The append methods produce the same
+ * characters as the equivalent ostream insertions with the default
+ * (right) adjustment, so a line built here is byte-identical to one
+ * written with setw(), setfill() and setprecision(), for example
+ *
+ *      ostr << setw(10) << setprecision(5) << x;
+ *      buf.appendGeneral(x, 5, 10);
+ *
+ * clear() keeps the allocated space, so a buffer reused for every
+ * line does not allocate once it has grown to the longest line.
+ */
+class FormatBuffer
+{
+public:
+
+    FormatBuffer(): _buf()
+    {
+        _buf.reserve(4096);
+    }
+
+    void clear() { _buf.clear(); }
+
+    const char* data() const { return _buf.data(); }
+
+    size_t size() const { return _buf.size(); }
+
+    bool empty() const { return _buf.empty(); }
+
+    const std::string& str() const { return _buf; }
+
+    void append(char c) { _buf.push_back(c); }
+
+    void append(const char* str, size_t len) { _buf.append(str, len); }
+
+    void append(const std::string& str) { _buf.append(str); }
+
+    /**
+     * Append @p str, padded on the left with @p fill to @p width,
+     * like ostr << setw(width) << str.
+     */
+    void append(const std::string& str, int width, char fill = ' ')
+    {
+        pad(str.length(), width, fill);
+        _buf.append(str);
+    }
+
+    /**
+     * Pad the text appended since position @p start on the left with
+     * @p fill, so that it is at least @p width long.  For text whose
+     * length is not known until it has been appended.
+     */
+    void justify(size_t start, int width, char fill = ' ')
+    {
+        size_t len = _buf.size() - start;
+        if (width > 0 && len < (size_t)width)
+            _buf.insert(start, width - len, fill);
+    }
+
+    /**
+     * Append @p n copies of @p c.
+     */
+    void fill(size_t n, char c) { _buf.append(n, c); }
+
+    /**
+     * Like ostr << setw(width) << setfill(fill) << val.
+     */
+    void appendUnsigned(unsigned long long val, int width = 0,
+                        char fill = ' ');
+
+    /**
+     * Like ostr << setw(width) << setfill(fill) << val.  As with
+     * ostream, the fill goes before the sign.
+     */
+    void appendInt(long long val, int width = 0, char fill = ' ');
+
+    /**
+     * Like ostr << hex << setw(width) << setfill(fill) << val.
+     */
+    void appendHex(unsigned long long val, int width = 0, char fill = '0');
+
+    /**
+     * Like ostr << setprecision(precision) << setw(width) << val,
+     * with the default floatfield, which is printf's %g.
+     */
+    void appendGeneral(double val, int precision, int width = 0);
+
+private:
+
+    void pad(size_t len, int width, char c)
+    {
+        if (width > 0 && len < (size_t)width) _buf.append(width - len, c);
+    }
+
+    std::string _buf;
+};
+
+}}	// namespace nidas namespace util
+
+#endif
@@ -0,0 +1,145 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "UTimeFormatter.h"
+#include "FormatBuffer.h"
+#include "UTime.h"
+
+#include <climits>
+
+using namespace nidas::util;
+using namespace std;
+
+UTimeFormatter::UTimeFormatter(const string& fmt, bool utc):
+    _fmt(fmt), _utc(utc), _split(false), _pieces(), _fractions(),
+    _second(LLONG_MIN), _formatted()
+{
+    compile();
+}
+
+void UTimeFormatter::setFormat(const string& fmt, bool utc)
+{
+    _fmt = fmt;
+    _utc = utc;
+    compile();
+}
+
+void UTimeFormatter::compile()
+{
+    _pieces.clear();
+    _fractions.clear();
+    _formatted.clear();
+    _second = LLONG_MIN;
+    _split = true;
+
+    // Split the format at the %f and %nf specifiers, scanning it the
+    // same way as UTime::format().
+    string piece;
+    string::size_type i0, i1;
+    string::size_type flen = _fmt.length();
+
+    for (i0 = 0; (i1 = _fmt.find('%', i0)) != string::npos; i0 = i1) {
+        piece.append(_fmt.substr(i0, i1 - i0));
+        i1++;
+        int n = -1;
+        if (flen > i1) {
+            if (_fmt[i1] == 'f') {
+                i1++;
+                n = 3;
+            }
+            else if (flen > i1 + 1 && ::isdigit(_fmt[i1]) &&
+                     _fmt[i1+1] == 'f') {
+                n = std::min(_fmt[i1] - '0', 6);
+                i1 += 2;
+            }
+            else if (_fmt[i1] == 's') {
+                // formatted with localtime by UTime::format()
+                _split = false;
+            }
+        }
+        if (n < 0) {
+            piece.push_back('%');
+            continue;
+        }
+        _pieces.push_back(piece);
+        _fractions.push_back(n);
+        piece.clear();
+    }
+    if (i0 < flen) piece.append(_fmt.substr(i0));
+    _pieces.push_back(piece);
+
+    // A piece which ends in an unpaired '%' would combine with the
+    // fraction digits in the strftime format.
+    for (unsigned int i = 0; _split && i < _pieces.size(); i++) {
+        const string& p = _pieces[i];
+        string::size_type np = 0;
+        for (string::size_type j = p.length(); j > 0 && p[j-1] == '%'; j--)
+            np++;
+        if (np % 2) _split = false;
+    }
+}
+
+void UTimeFormatter::update(long long second)
+{
+    _formatted.resize(_pieces.size());
+    UTime ut(second);
+    for (unsigned int i = 0; i < _pieces.size(); i++) {
+        // UTime::format() of an empty format would not call strftime
+        if (_pieces[i].empty()) _formatted[i].clear();
+        else _formatted[i] = ut.format(_utc, _pieces[i]);
+    }
+    _second = second;
+}
+
+void UTimeFormatter::append(FormatBuffer& buf, long long usecs)
+{
+    UTime ut(usecs);
+    if (!_split || ut.isMin() || ut.isMax()) {
+        buf.append(ut.format(_utc, _fmt));
+        return;
+    }
+
+    long long second = ut.earlier(USECS_PER_SEC).toUsecs();
+    if (second != _second) update(second);
+
+    long long frac = usecs - second;
+    buf.append(_formatted[0]);
+    for (unsigned int i = 0; i < _fractions.size(); i++) {
+        long long divisor = 100000;
+        for (int j = 0; j < _fractions[i]; j++) {
+            buf.append((char)('0' + ((frac / divisor) % 10)));
+            divisor /= 10;
+        }
+        buf.append(_formatted[i+1]);
+    }
+}
+
+string UTimeFormatter::format(long long usecs)
+{
+    FormatBuffer buf;
+    append(buf, usecs);
+    return buf.str();
+}
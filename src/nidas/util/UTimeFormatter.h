@@ -0,0 +1,104 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#ifndef NIDAS_UTIL_UTIMEFORMATTER_H
+#define NIDAS_UTIL_UTIMEFORMATTER_H
+
+#include <string>
+#include <vector>
+
+namespace nidas { namespace util {
+
+class FormatBuffer;
+
+/**
+ * Formats times the same as UTime::format(utc, fmt), for a fixed
+ * format, caching the formatted text of the current second.
+ *
+ * UTime::format() parses the format and calls strftime on every call.
+ * When printing many samples per second, everything but the fractional
+ * seconds (%f, %nf) is the same from one call to the next, so
+ * UTimeFormatter formats the parts of the format between the fraction
+ * specifiers once per second, and only writes the fraction digits for
+ * each call.  Formats which cannot be split, for example with %s,
+ * are passed to UTime::format() every time.
+ */
+class UTimeFormatter
+{
+public:
+
+    UTimeFormatter(const std::string& fmt, bool utc = true);
+
+    void setFormat(const std::string& fmt, bool utc = true);
+
+    const std::string& getFormat() const { return _fmt; }
+
+    /**
+     * Append the time of @p usecs, microseconds since 1970,
+     * formatted as UTime(usecs).format(utc, fmt).
+     */
+    void append(FormatBuffer& buf, long long usecs);
+
+    std::string format(long long usecs);
+
+private:
+
+    void compile();
+
+    void update(long long second);
+
+    std::string _fmt;
+
+    bool _utc;
+
+    /**
+     * False if the format is passed to UTime::format() on every call.
+     */
+    bool _split;
+
+    /**
+     * The pieces of the format between the fractional second
+     * specifiers, one more than _fractions.
+     */
+    std::vector<std::string> _pieces;
+
+    /**
+     * Number of digits of each fractional second specifier.
+     */
+    std::vector<int> _fractions;
+
+    /**
+     * Time of the second whose pieces are in _formatted,
+     * in microseconds.
+     */
+    long long _second;
+
+    std::vector<std::string> _formatted;
+};
+
+}}	// namespace nidas namespace util
+
+#endif
@@ -0,0 +1,291 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include "ZstdFileSet.h"
+
+#ifdef HAVE_ZSTD_H
+
+#include "EOFException.h"
+#include "InvalidParameterException.h"
+#include "Logger.h"
+
+#include <algorithm>
+#include <memory>
+#include <sstream>
+
+#include <unistd.h>
+#include <errno.h>
+
+using namespace nidas::util;
+using namespace std;
+
+namespace {
+    struct DCtxDeleter
+    {
+        void operator()(ZSTD_DCtx* dctx) const { ZSTD_freeDCtx(dctx); }
+    };
+}
+
+void ZstdCodec::compress(const char* in, size_t len, string& out) const
+{
+    out.resize(ZSTD_compressBound(len));
+    size_t res = ZSTD_compress(&out[0], out.size(), in, len, _level);
+    if (ZSTD_isError(res))
+        throw IOException("zstd", "ZSTD_compress", ZSTD_getErrorName(res));
+    out.resize(res);
+}
+
+BlockCodec::status
+ZstdCodec::decompress(const char* in, size_t len, string& out) const
+{
+    std::unique_ptr<ZSTD_DCtx, DCtxDeleter> dctx(ZSTD_createDCtx());
+    if (!dctx)
+        throw IOException("zstd", "ZSTD_createDCtx", ENOMEM);
+
+    ZSTD_inBuffer input = { in, len, 0 };
+    size_t res = 0;
+    bool full;
+    do {
+        size_t old = out.size();
+        size_t room = std::max(4 * (len - input.pos), ZSTD_DStreamOutSize());
+        out.resize(old + room);
+        ZSTD_outBuffer output = { &out[old], room, 0 };
+        // Continues with the next frame after the end of one.
+        res = ZSTD_decompressStream(dctx.get(), &output, &input);
+        out.resize(old + output.pos);
+        if (ZSTD_isError(res))
+            throw IOException("zstd", "ZSTD_decompressStream",
+                              ZSTD_getErrorName(res));
+        full = output.pos == room;
+    } while (input.pos < input.size || full);
+
+    return res == 0 ? COMPLETE : TRUNCATED;
+}
+
+size_t ZstdCodec::findStreamLength(const char* buf, size_t len) const
+{
+    size_t res = ZSTD_findFrameCompressedSize(buf, len);
+    if (ZSTD_isError(res) || res > len) return 0;
+    return res;
+}
+
+ZstdFileSet::ZstdFileSet(): FileSet(),_level(3),_codec(_level),
+    _compressThreads(0),
+    _uncompressThreads(Logger::getScheme().getParameterT
+                       ("fileset_uncompress_threads", 0)),
+    _compressor(0),_decompressor(0),_openedForWriting(false),
+    _blockMode(false),_dctx(0),_inbuf(),_input(),_frameRemaining(0)
+{
+}
+
+/* Copy constructor. */
+ZstdFileSet::ZstdFileSet(const ZstdFileSet& x):
+    FileSet(x),_level(x._level),_codec(_level),
+    _compressThreads(x._compressThreads),
+    _uncompressThreads(x._uncompressThreads),
+    _compressor(0),_decompressor(0),_openedForWriting(false),
+    _blockMode(false),_dctx(0),_inbuf(),_input(),_frameRemaining(0)
+{
+}
+
+/* Assignment operator. */
+ZstdFileSet& ZstdFileSet::operator=(const ZstdFileSet& rhs)
+{
+    if (&rhs != this) {
+        closeFile();
+        (*(FileSet*)this) = rhs;
+        _level = rhs._level;
+        _codec = ZstdCodec(_level);
+        _compressThreads = rhs._compressThreads;
+        _uncompressThreads = rhs._uncompressThreads;
+        delete _compressor;
+        _compressor = 0;
+        delete _decompressor;
+        _decompressor = 0;
+    }
+    return *this;
+}
+
+ZstdFileSet* ZstdFileSet::clone() const
+{
+    return new ZstdFileSet(*this);
+}
+
+ZstdFileSet::~ZstdFileSet()
+{
+    try {
+        closeFile();
+    }
+    catch(const IOException& e) {}
+    delete _compressor;
+    delete _decompressor;
+    if (_dctx) ZSTD_freeDCtx(_dctx);
+}
+
+void ZstdFileSet::setCompressionLevel(int val)
+{
+    if (val < 1 || val > ZSTD_maxCLevel()) {
+        ostringstream ost;
+        ost << "must be between 1 and " << ZSTD_maxCLevel();
+        throw InvalidParameterException("ZstdFileSet", "level", ost.str());
+    }
+    _level = val;
+    _codec = ZstdCodec(_level);
+    delete _compressor;
+    _compressor = 0;
+}
+
+void ZstdFileSet::openFileForWriting(const std::string& filename)
+{
+    FileSet::openFileForWriting(filename);
+    if (!_compressor || _compressor->getNumThreads() != _compressThreads) {
+        delete _compressor;
+        _compressor = new BlockCompressor(_codec, _compressThreads);
+    }
+    _compressor->open(getFd(), filename);
+    _openedForWriting = true;
+}
+
+void ZstdFileSet::openNextFile()
+{
+    FileSet::openNextFile();        // throws EOFException
+    _openedForWriting = false;
+
+    if (getFd() != 0 && _uncompressThreads > 0 &&
+        BlockDecompressor::isSplittable(_codec, getFd()))
+    {
+        if (!_decompressor ||
+            _decompressor->getNumThreads() != _uncompressThreads) {
+            delete _decompressor;
+            _decompressor = new BlockDecompressor(_codec, _uncompressThreads);
+        }
+        _decompressor->open(getFd(), getCurrentName());
+        _blockMode = true;
+        return;
+    }
+
+    if (!_dctx && !(_dctx = ZSTD_createDCtx())) {
+        closeFile();
+        throw IOException(getCurrentName(), "ZSTD_createDCtx", ENOMEM);
+    }
+    ZSTD_DCtx_reset(_dctx, ZSTD_reset_session_only);
+    _inbuf.resize(ZSTD_DStreamInSize());
+    _input.src = &_inbuf[0];
+    _input.size = 0;
+    _input.pos = 0;
+    _frameRemaining = 0;
+}
+
+void ZstdFileSet::closeFile()
+{
+    if (getFd() >= 0) {
+        if (_openedForWriting) {
+            _openedForWriting = false;
+            try {
+                _compressor->close();
+            }
+            catch (const IOException& e) {
+                _lastErrno = e.getErrno();  // queried by status method
+                FileSet::closeFile();
+                throw;
+            }
+        }
+        else if (_blockMode) _decompressor->close();
+        _blockMode = false;
+    }
+    FileSet::closeFile();
+}
+
+size_t ZstdFileSet::read(void* buf, size_t count)
+{
+    _newFile = false;
+    if (getFd() < 0) openNextFile();		// throws EOFException
+
+    try {
+        if (_blockMode) {
+            size_t res = _decompressor->read(buf, count);
+            if (res == 0) closeFile();	// next read will open next file
+            return res;
+        }
+        for (;;) {
+            if (_input.pos == _input.size) {
+                ssize_t res = ::read(getFd(), &_inbuf[0], _inbuf.size());
+                if (res < 0) {
+                    if (errno == EINTR) continue;
+                    throw IOException(getCurrentName(), "read", errno);
+                }
+                if (res == 0) {
+                    if (_frameRemaining != 0)
+                        WLOG(("") << getCurrentName()
+                             << ": zstd: unexpected EOF while uncompressing");
+                    closeFile();	// next read will open next file
+                    return 0;
+                }
+                _input.size = res;
+                _input.pos = 0;
+            }
+            ZSTD_outBuffer output = { buf, count, 0 };
+            size_t res = ZSTD_decompressStream(_dctx, &output, &_input);
+            if (ZSTD_isError(res))
+                throw IOException(getCurrentName(), "ZSTD_decompressStream",
+                                  ZSTD_getErrorName(res));
+            _frameRemaining = res;
+            if (output.pos > 0) return output.pos;
+        }
+    }
+    catch (const IOException& ioe)
+    {
+        if (!_keepopening)
+            throw ioe;
+        ELOG(("") << ioe.what() << "; keep going to next file...");
+        // next read will open next file
+        closeFile();
+    }
+    return 0;
+}
+
+size_t ZstdFileSet::write(const void* buf, size_t count)
+{
+    try {
+        _compressor->write(buf, count);
+    }
+    catch (const IOException& e) {
+        _lastErrno = e.getErrno(); // queried by status method
+        throw;
+    }
+    return count;
+}
+
+size_t ZstdFileSet::write(const struct iovec* iov, int iovcnt)
+{
+    size_t res = 0;
+    for (int i = 0; i < iovcnt; i++) {
+        res += write(iov[i].iov_base,iov[i].iov_len);
+    }
+    return res;
+}
+
+#endif
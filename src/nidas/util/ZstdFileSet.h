@@ -0,0 +1,218 @@
+// -*- mode: C++; indent-tabs-mode: nil; c-basic-offset: 4; tab-width: 4; -*-
+// vim: set shiftwidth=4 softtabstop=4 expandtab:
+/*
+ ********************************************************************
+ ** NIDAS: NCAR In-situ Data Acquistion Software
+ **
+ ** 2026, Copyright University Corporation for Atmospheric Research
+ **
+ ** This program is free software; you can redistribute it and/or modify
+ ** it under the terms of the GNU General Public License as published by
+ ** the Free Software Foundation; either version 2 of the License, or
+ ** (at your option) any later version.
+ **
+ ** This program is distributed in the hope that it will be useful,
+ ** but WITHOUT ANY WARRANTY; without even the implied warranty of
+ ** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ ** GNU General Public License for more details.
+ **
+ ** The LICENSE.txt file accompanying this software contains
+ ** a copy of the GNU General Public License. If it is not found,
+ ** write to the Free Software Foundation, Inc.,
+ ** 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ **
+ ********************************************************************
+*/
+
+#include <nidas/Config.h>
+
+#ifdef HAVE_ZSTD_H
+
+#ifndef NIDAS_UTIL_ZSTDFILESET_H
+#define NIDAS_UTIL_ZSTDFILESET_H
+
+#define _FILE_OFFSET_BITS 64
+
+#include "FileSet.h"
+#include "BlockCodec.h"
+
+#include <zstd.h>
+
+#include <vector>
+
+namespace nidas { namespace util {
+
+/**
+ * BlockCodec for zstd, compressing each block to a zstd frame.
+ */
+class ZstdCodec: public BlockCodec
+{
+public:
+
+    ZstdCodec(int level = 3): _level(level)
+    {
+    }
+
+    const char* getName() const { return "zstd"; }
+
+    size_t getBlockSize() const { return 1024 * 1024; }
+
+    void compress(const char* in, size_t len, std::string& out) const;
+
+    status decompress(const char* in, size_t len, std::string& out) const;
+
+    /**
+     * zstd frames can be measured exactly, with
+     * ZSTD_findFrameCompressedSize().
+     */
+    size_t findStreamLength(const char* buf, size_t len) const;
+
+private:
+
+    int _level;
+};
+
+/**
+ * A nidas::util::FileSet, supporting zstd compression and uncompression
+ * as files are written or read.  zstd typically compresses several
+ * times faster than bzip2, and uncompresses much faster, at a somewhat
+ * lower compression ratio.
+ *
+ * Files are written by a BlockCompressor as a series of zstd frames,
+ * each compressing 1 Mbyte of data, using setCompressThreads() threads.
+ * Files whose first frame is less than 4 Mbytes are read with a
+ * BlockDecompressor, otherwise, as for files written by the zstd
+ * command, as one stream in the calling thread.
+ */
+class ZstdFileSet: public FileSet {
+public:
+
+    ZstdFileSet();
+
+    /**
+     * Copy constructor. Only permissable before it is opened.
+     */
+    ZstdFileSet(const ZstdFileSet& x);
+
+    /**
+     * Assignment operator. Only permissable before it is opened.
+     */
+    ZstdFileSet& operator=(const ZstdFileSet& x);
+
+    ZstdFileSet* clone() const;
+
+    ~ZstdFileSet();
+
+    /**
+     * @throws IOException
+     **/
+    void closeFile();
+
+    /**
+     * @throws IOException
+     **/
+    void openFileForWriting(const std::string& filename);
+
+    /**
+     * @throws IOException
+     **/
+    void openNextFile();
+
+    /**
+     * @throws IOException
+     **/
+    size_t read(void* buf, size_t count);
+
+    /**
+     * Compressed files cannot be mapped.
+     */
+    bool canReadMapped() const { return false; }
+
+    /**
+     * Compressed files cannot be positioned.
+     *
+     * @throws IOException
+     **/
+    void seek(long long)
+    {
+        throw IOException(getCurrentName(),"seek","not supported on compressed file");
+    }
+
+    /**
+     * @throws IOException
+     **/
+    size_t write(const void* buf, size_t count);
+
+    /**
+     * @throws IOException
+     **/
+    size_t write(const struct iovec* iov, int iovcnt);
+
+    /**
+     * zstd compression level, from 1 to ZSTD_maxCLevel(), for files
+     * opened after this call. The default is 3.
+     *
+     * @throws InvalidParameterException
+     */
+    void setCompressionLevel(int val);
+
+    int getCompressionLevel() const { return _level; }
+
+    /**
+     * Number of threads compressing blocks of output files.
+     * 0, the default, compresses them in the writing thread.
+     */
+    void setCompressThreads(unsigned int val) { _compressThreads = val; }
+
+    unsigned int getCompressThreads() const { return _compressThreads; }
+
+    /**
+     * Number of threads uncompressing the frames of input files.
+     * 0 reads files in the calling thread. The default is 0, or the
+     * value of the log parameter "fileset_uncompress_threads".
+     */
+    void setUncompressThreads(unsigned int val) { _uncompressThreads = val; }
+
+    unsigned int getUncompressThreads() const { return _uncompressThreads; }
+
+private:
+
+    int _level;
+
+    ZstdCodec _codec;
+
+    unsigned int _compressThreads;
+
+    unsigned int _uncompressThreads;
+
+    BlockCompressor* _compressor;
+
+    BlockDecompressor* _decompressor;
+
+    bool _openedForWriting;
+
+    /**
+     * Whether the current input file is read by _decompressor.
+     */
+    bool _blockMode;
+
+    /**
+     * Context for reading a file as one stream.
+     */
+    ZSTD_DCtx* _dctx;
+
+    std::vector<char> _inbuf;
+
+    ZSTD_inBuffer _input;
+
+    /**
+     * Last return of ZSTD_decompressStream(), 0 at the end of a frame.
+     */
+    size_t _frameRemaining;
+
+};
+
+}}	// namespace nidas namespace util
+
+#endif
+#endif
@@ -32,12 +32,16 @@
 using boost::unit_test_framework::test_suite;
 
 #include <nidas/util/UTime.h>
+#include <nidas/util/UTimeFormatter.h>
+#include <nidas/util/FormatBuffer.h>
 #include <nidas/util/Logger.h>
 
 using nidas::util::LogConfig;
 using nidas::util::LogScheme;
 
+#include <iomanip>
 #include <iostream>
+#include <sstream>
 
 #include <cstdio>
 #include <time.h>
@@ -424,3 +428,67 @@ BOOST_AUTO_TEST_CASE(test_dsm_time_constants)
     when = when + period * USECS_PER_SEC; // add an hour
     BOOST_TEST(when == UTime::parse(true, "2019-11-07T17:10:55.001"));
 }
+
+
+BOOST_AUTO_TEST_CASE(test_utime_formatter)
+{
+    // UTimeFormatter must match UTime::format() exactly, whether it
+    // uses its cached second or not.
+    const char* formats[] = {
+        "%Y %m %d %H:%M:%S.%4f",
+        "%Y-%m-%dT%H:%M:%S.%4f",
+        "%Y %m %d %H:%M:%S.%3f ",
+        "%H:%M:%S.%f",
+        "%S.%6f %2f|%1f",
+        "%Y%m%d %H%M%S",
+        "%4f",
+        "100%% %S.%2f",
+        "%s.%3f",
+    };
+    UTime t0 = UTime::parse(true, "2026-10-17T23:59:58.250");
+    for (const char* fmt : formats)
+    {
+        UTimeFormatter tfmt(fmt);
+        FormatBuffer buf;
+        for (long long dt = -3000000; dt < 3000000; dt += 123457)
+        {
+            UTime ut = t0 + dt;
+            buf.clear();
+            tfmt.append(buf, ut.toUsecs());
+            BOOST_TEST(buf.str() == ut.format(true, fmt));
+        }
+        // before 1970 and across a day boundary
+        UTime neg = UTime::parse(true, "1969-12-31T23:59:59.999");
+        BOOST_TEST(tfmt.format(neg.toUsecs()) == neg.format(true, fmt));
+        UTime next(neg.toUsecs() + 2000);
+        BOOST_TEST(tfmt.format(next.toUsecs()) == next.format(true, fmt));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_format_buffer)
+{
+    FormatBuffer buf;
+    buf.appendUnsigned(42, 5);
+    buf.append(',');
+    buf.appendInt(-42, 5, '0');
+    buf.append(',');
+    buf.appendHex(0xa, 2);
+    buf.append(',');
+    buf.appendGeneral(3.14159265, 4, 10);
+    buf.append(',');
+    buf.appendGeneral(-0.0001234567, 5);
+    buf.append(',');
+    buf.append(string("ab"), 4);
+    size_t start = buf.size();
+    buf.append('x');
+    buf.justify(start, 3, '.');
+
+    std::ostringstream ostr;
+    ostr << setw(5) << 42 << ',' << setw(5) << setfill('0') << -42 << ','
+         << setw(2) << hex << 0xa << dec << setfill(' ') << ','
+         << setprecision(4) << setw(10) << 3.14159265 << ','
+         << setprecision(5) << -0.0001234567 << ','
+         << setw(4) << "ab" << setw(3) << setfill('.') << "x";
+    BOOST_TEST(buf.str() == ostr.str());
+}
@@ -5,6 +5,7 @@ using boost::unit_test_framework::test_suite;
 
 #include <nidas/core/CalFile.h>
 #include <cmath> // isnan
+#include <unistd.h>
 
 using namespace nidas::util;
 using namespace nidas::core;
@@ -181,3 +182,85 @@ BOOST_AUTO_TEST_CASE(test_calfile_na)
   BOOST_CHECK_EQUAL(fields[2], "extra");
 }
 
+
+
+void
+write_cache_calfile(const std::string& path, float offset)
+{
+  std::ofstream of(path.c_str(), std::ios_base::binary);
+  of << "2020 01 01 00:00:00 " << offset << " 1.0\n"
+     << "2020 01 02 00:00:00 " << offset + 1 << " 1.0\n"
+     << "2020 01 02 00:00:00 " << offset + 2 << " 1.0\n"
+     << "2020 01 03 00:00:00 " << offset + 3 << " 1.0\n";
+  of.close();
+}
+
+
+BOOST_AUTO_TEST_CASE(test_calfile_cache)
+{
+  write_cache_calfile("cache_test.dat", 0);
+  CalFile::clearCache();
+
+  CalFile cfa;
+  cfa.setPath(".");
+  cfa.setFile("cache_test.dat");
+  CalFile cfb(cfa);
+
+  UTime when;
+  float data[2];
+
+  BOOST_CHECK_EQUAL(cfa.readCF(when, data, 2), 2);
+  BOOST_CHECK_EQUAL(data[0], 0.0);
+  BOOST_CHECK_EQUAL(cfb.readCF(when, data, 2), 2);
+  BOOST_CHECK_EQUAL(data[0], 0.0);
+  // Both read the same parsed file.
+  BOOST_CHECK_EQUAL(CalFile::getCacheSize(), 1);
+
+  // A changed file is parsed again when it is next opened, while a
+  // CalFile which has it open continues with the records it has.
+  write_cache_calfile("cache_test.dat", 100);
+  CalFile cfc(cfa);
+  BOOST_CHECK_EQUAL(cfc.readCF(when, data, 2), 2);
+  BOOST_CHECK_EQUAL(data[0], 100.0);
+  BOOST_CHECK_EQUAL(CalFile::getCacheSize(), 1);
+
+  BOOST_CHECK_EQUAL(cfa.readCF(when, data, 2), 2);
+  BOOST_CHECK_EQUAL(data[0], 1.0);
+
+  CalFile::clearCache();
+  BOOST_CHECK_EQUAL(CalFile::getCacheSize(), 0);
+  BOOST_CHECK_EQUAL(cfb.readCF(when, data, 2), 2);
+  BOOST_CHECK_EQUAL(data[0], 1.0);
+  ::unlink("cache_test.dat");
+}
+
+
+BOOST_AUTO_TEST_CASE(test_calfile_search)
+{
+  write_cache_calfile("search_test.dat", 0);
+
+  CalFile cfile;
+  cfile.setPath(".");
+  cfile.setFile("search_test.dat");
+
+  UTime when;
+  float data[2];
+
+  // The first of the records with the time of the last record <= tsearch.
+  UTime tsearch = UTime::parse(true, "2020 01 02 12:00:00");
+  BOOST_CHECK(cfile.search(tsearch) == UTime::parse(true, "2020 01 02 00:00:00"));
+  BOOST_CHECK_EQUAL(cfile.readCF(when, data, 2), 2);
+  BOOST_CHECK_EQUAL(data[0], 1.0);
+  BOOST_CHECK_EQUAL(cfile.getLineNumber(), 3);
+  BOOST_CHECK_EQUAL(cfile.readCF(when, data, 2), 2);
+  BOOST_CHECK_EQUAL(data[0], 2.0);
+
+  // Past the end, positioned at the last record.
+  cfile.close();
+  tsearch = UTime::parse(true, "2021 01 01 00:00:00");
+  BOOST_CHECK(cfile.search(tsearch) == UTime::parse(true, "2020 01 03 00:00:00"));
+  BOOST_CHECK_EQUAL(cfile.readCF(when, data, 2), 2);
+  BOOST_CHECK_EQUAL(data[0], 3.0);
+  BOOST_CHECK(cfile.eof());
+  ::unlink("search_test.dat");
+}
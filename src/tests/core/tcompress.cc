@@ -0,0 +1,222 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+using boost::unit_test_framework::test_suite;
+
+#include <nidas/Config.h>
+#include <nidas/util/Bzip2FileSet.h>
+#include <nidas/util/ZstdFileSet.h>
+#include <nidas/util/EOFException.h>
+
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace nidas::util;
+using namespace std;
+
+namespace {
+
+string
+testData(size_t len)
+{
+    ostringstream ost;
+    unsigned int x = 1;
+    while ((size_t)ost.tellp() < len) {
+        x = x * 1103515245 + 12345;
+        ost << "2026 10 17 12:00:" << (x >> 16) % 60 << ' '
+            << (x >> 8) % 1000 << ' ' << 1.0 / (1 + (x % 97)) << '\n';
+    }
+    return ost.str();
+}
+
+void
+writeFile(FileSet& fset, const string& path, const string& data)
+{
+    fset.setFileName(path);
+    fset.createFile(UTime(), true);
+    // irregular write sizes, as from SampleOutputStream
+    for (size_t i = 0; i < data.size(); ) {
+        size_t n = std::min(data.size() - i, (size_t)(1 + i % 4093));
+        fset.write(data.data() + i, n);
+        i += n;
+    }
+    fset.closeFile();
+}
+
+string
+readFile(FileSet& fset, const string& path)
+{
+    fset.addFileName(path);
+    string res;
+    char buf[8192];
+    try {
+        for (;;) {
+            size_t n = fset.read(buf, sizeof(buf));
+            res.append(buf, n);
+        }
+    }
+    catch (const EOFException&) {}
+    return res;
+}
+
+}
+
+#ifdef HAVE_BZLIB_H
+
+BOOST_AUTO_TEST_CASE(test_bzip2_codec)
+{
+    Bzip2Codec codec(1);
+    string data = testData(250000);
+    string c1, c2;
+    codec.compress(data.data(), 150000, c1);
+    codec.compress(data.data() + 150000, data.size() - 150000, c2);
+
+    BOOST_CHECK_EQUAL(codec.findStreamLength(c1.data(), c1.size()), 0u);
+    string both = c1 + c2;
+    BOOST_CHECK_EQUAL(codec.findStreamLength(both.data(), both.size()),
+                      c1.size());
+
+    string out;
+    BOOST_CHECK(codec.decompress(both.data(), both.size(), out) ==
+                BlockCodec::COMPLETE);
+    BOOST_CHECK(out == data);
+
+    out.clear();
+    BOOST_CHECK(codec.decompress(c1.data(), c1.size() - 10, out) ==
+                BlockCodec::TRUNCATED);
+
+    string bad = c1;
+    bad[bad.size() / 2] ^= 0x55;
+    out.clear();
+    BOOST_CHECK_THROW(codec.decompress(bad.data(), bad.size(), out),
+                      IOException);
+}
+
+BOOST_AUTO_TEST_CASE(test_bzip2_fileset_threads)
+{
+    char tmpl[] = "/tmp/tcompressXXXXXX";
+    BOOST_REQUIRE(::mkdtemp(tmpl));
+    string dir(tmpl);
+    string data = testData(3000000);
+
+    Bzip2FileSet wpar;
+    wpar.setCompressThreads(4);
+    writeFile(wpar, dir + "/par.bz2", data);
+
+    Bzip2FileSet wser;
+    wser.setCompressThreads(0);
+    writeFile(wser, dir + "/ser.bz2", data);
+
+    int fd = ::open((dir + "/par.bz2").c_str(), O_RDONLY);
+    BOOST_REQUIRE(fd >= 0);
+    BOOST_CHECK(BlockDecompressor::isSplittable(Bzip2Codec(), fd));
+    ::close(fd);
+
+    const char* names[] = { "/par.bz2", "/ser.bz2" };
+    for (int i = 0; i < 2; i++) {
+        for (unsigned int nthreads = 0; nthreads < 4; nthreads += 3) {
+            Bzip2FileSet rset;
+            rset.setUncompressThreads(nthreads);
+            BOOST_TEST_MESSAGE(names[i] << ", threads=" << nthreads);
+            BOOST_CHECK(readFile(rset, dir + names[i]) == data);
+        }
+    }
+
+    ::unlink((dir + "/par.bz2").c_str());
+    ::unlink((dir + "/ser.bz2").c_str());
+    ::rmdir(dir.c_str());
+}
+
+BOOST_AUTO_TEST_CASE(test_bzip2_trailing_data)
+{
+    Bzip2Codec codec(1);
+    string data = testData(250000);
+    string c1;
+    codec.compress(data.data(), data.size(), c1);
+
+    string padded = c1 + string(1000, '\0');
+    string out;
+    BOOST_CHECK(codec.decompress(padded.data(), padded.size(), out) ==
+                BlockCodec::TRAILING);
+    BOOST_CHECK(out == data);
+
+    char tmpl[] = "/tmp/tcompressXXXXXX";
+    BOOST_REQUIRE(::mkdtemp(tmpl));
+    string dir(tmpl);
+    data = testData(3000000);
+
+    Bzip2FileSet wpar;
+    wpar.setCompressThreads(4);
+    writeFile(wpar, dir + "/par.bz2", data);
+
+    Bzip2FileSet wser;
+    wser.setCompressThreads(0);
+    writeFile(wser, dir + "/ser.bz2", data);
+
+    // zero padding, text, and a truncated stream header
+    const string trailers[] = { string(4096, '\0'), "garbage\n", "BZ" };
+    const char* names[] = { "/par.bz2", "/ser.bz2" };
+    for (int i = 0; i < 2; i++) {
+        string path = dir + names[i];
+        for (const string& trailer : trailers) {
+            string tpath = path + ".trail";
+            {
+                ifstream in(path.c_str(), ios::binary);
+                ofstream tout(tpath.c_str(), ios::binary);
+                tout << in.rdbuf() << trailer;
+            }
+            for (unsigned int nthreads = 0; nthreads < 4; nthreads += 3) {
+                Bzip2FileSet rset;
+                rset.setUncompressThreads(nthreads);
+                BOOST_TEST_MESSAGE(names[i] << ", trailer length=" <<
+                    trailer.size() << ", threads=" << nthreads);
+                BOOST_CHECK(readFile(rset, tpath) == data);
+            }
+            ::unlink(tpath.c_str());
+        }
+        ::unlink(path.c_str());
+    }
+    ::rmdir(dir.c_str());
+}
+
+#endif
+
+#ifdef HAVE_ZSTD_H
+
+BOOST_AUTO_TEST_CASE(test_zstd_fileset_threads)
+{
+    char tmpl[] = "/tmp/tcompressXXXXXX";
+    BOOST_REQUIRE(::mkdtemp(tmpl));
+    string dir(tmpl);
+    string path = dir + "/data.zst";
+    string data = testData(5000000);
+
+    ZstdFileSet wset;
+    wset.setCompressThreads(3);
+    writeFile(wset, path, data);
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    BOOST_REQUIRE(fd >= 0);
+    ZstdCodec codec;
+    BOOST_CHECK(BlockDecompressor::isSplittable(codec, fd, 1024 * 1024));
+    ::close(fd);
+
+    for (unsigned int nthreads = 0; nthreads < 4; nthreads += 3) {
+        ZstdFileSet rset;
+        rset.setUncompressThreads(nthreads);
+        BOOST_CHECK(readFile(rset, path) == data);
+    }
+
+    string c1;
+    codec.compress(data.data(), 1000, c1);
+    string out;
+    BOOST_CHECK(codec.decompress(c1.data(), c1.size() - 1, out) ==
+                BlockCodec::TRUNCATED);
+
+    ::unlink(path.c_str());
+    ::rmdir(dir.c_str());
+}
+
+#endif
@@ -0,0 +1,128 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+using boost::unit_test_framework::test_suite;
+
+#include <nidas/core/SensorProcessorPool.h>
+#include <nidas/core/Sample.h>
+
+#include <atomic>
+#include <unistd.h>
+
+using namespace nidas::core;
+
+namespace {
+
+/**
+ * Client which is slower than the thread passing it samples, and
+ * records how far behind the latest sample passed to the pool it is.
+ */
+class SlowClient: public SampleClient
+{
+public:
+    SlowClient(const std::atomic<dsm_time_t>& latest):
+        _latest(latest),nreceived(0),maxBehind(0)
+    {}
+
+    bool receive(const Sample* samp) throw()
+    {
+        maxBehind = std::max(maxBehind, _latest - samp->getTimeTag());
+        ::usleep(500);
+        nreceived++;
+        return true;
+    }
+
+    void flush() throw() {}
+
+private:
+    const std::atomic<dsm_time_t>& _latest;
+
+public:
+    int nreceived;
+
+    dsm_time_t maxBehind;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_max_lag)
+{
+    const int nsamples = 500;
+    const dsm_time_t dt = 10000;        // 100 Hz
+    const dsm_time_t maxLag = 100000;
+
+    std::atomic<dsm_time_t> latest(0);
+    SlowClient client(latest);
+    {
+        SensorProcessorPool pool("test", 1);
+        pool.setMaxLag(maxLag);
+        SampleClient* qclient = pool.getClient(&client, "slow");
+
+        for (int i = 0; i < nsamples; i++) {
+            SampleT<float>* samp = getSample<float>(1);
+            samp->setTimeTag(i * dt);
+            BOOST_CHECK(qclient->receive(samp));
+            samp->freeReference();
+            latest = i * dt;
+        }
+        pool.flush();
+
+        // The pool waited for the client rather than queueing
+        // all the samples.
+        BOOST_CHECK_GT(pool.getNumWaits(), 0u);
+        BOOST_CHECK_EQUAL(pool.getNumDropped(), 0u);
+        BOOST_CHECK_LE(pool.getMaxBacklog(), (size_t)(maxLag / dt + 1));
+    }
+    BOOST_CHECK_EQUAL(client.nreceived, nsamples);
+    BOOST_CHECK_LE(client.maxBehind, maxLag);
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_drop_behind)
+{
+    const int nsamples = 500;
+    const dsm_time_t dt = 10000;
+    const dsm_time_t maxLag = 100000;
+
+    std::atomic<dsm_time_t> latest(0);
+    SlowClient client(latest);
+    size_t ndropped;
+    {
+        SensorProcessorPool pool("test", 1);
+        pool.setMaxLag(maxLag);
+        pool.setDropWhenFull(true);
+        SampleClient* qclient = pool.getClient(&client, "slow");
+
+        int nqueued = 0;
+        for (int i = 0; i < nsamples; i++) {
+            SampleT<float>* samp = getSample<float>(1);
+            samp->setTimeTag(i * dt);
+            if (qclient->receive(samp)) nqueued++;
+            samp->freeReference();
+            latest = i * dt;
+        }
+        pool.flush();
+
+        // Rather than wait, the pool dropped the samples that would
+        // put the thread too far behind.
+        ndropped = pool.getNumDropped();
+        BOOST_CHECK_GT(ndropped, 0u);
+        BOOST_CHECK_EQUAL(pool.getNumWaits(), 0u);
+        BOOST_CHECK_EQUAL(nqueued + (int)ndropped, nsamples);
+    }
+    BOOST_CHECK_EQUAL(client.nreceived + (int)ndropped, nsamples);
+}
+
+BOOST_AUTO_TEST_CASE(test_pool_find_client)
+{
+    std::atomic<dsm_time_t> latest(0);
+    SlowClient client(latest);
+    SlowClient other(latest);
+
+    SensorProcessorPool pool("test", 2);
+    BOOST_CHECK(!pool.findClient(&client));
+    SampleClient* qclient = pool.getClient(&client, "slow");
+    BOOST_CHECK_EQUAL(pool.findClient(&client), qclient);
+    BOOST_CHECK_EQUAL(pool.getClient(&client, "slow"), qclient);
+    // Looking up a client does not assign it to a thread.
+    BOOST_CHECK(!pool.findClient(&other));
+    BOOST_CHECK(pool.getClient(&other, "other") != qclient);
+}
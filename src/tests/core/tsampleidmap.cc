@@ -0,0 +1,109 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+using boost::unit_test_framework::test_suite;
+
+#include <nidas/core/SampleIdMap.h>
+
+#include <cstdlib>
+#include <map>
+#include <vector>
+
+using namespace nidas::core;
+
+
+namespace {
+
+void
+check_same(const SampleIdMap<int>& idmap,
+           const std::map<dsm_sample_id_t, int>& ref)
+{
+  BOOST_REQUIRE_EQUAL(idmap.size(), ref.size());
+  BOOST_CHECK_EQUAL(idmap.empty(), ref.empty());
+
+  // same entries, in the same order
+  SampleIdMap<int>::const_iterator ii = idmap.begin();
+  std::map<dsm_sample_id_t, int>::const_iterator ri = ref.begin();
+  for ( ; ri != ref.end(); ++ii, ++ri) {
+    BOOST_CHECK_EQUAL(ii->first, ri->first);
+    BOOST_CHECK_EQUAL(ii->second, ri->second);
+    SampleIdMap<int>::const_iterator fi = idmap.find(ri->first);
+    BOOST_REQUIRE(fi != idmap.end());
+    BOOST_CHECK_EQUAL(fi->second, ri->second);
+  }
+}
+
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sample_id_map_basic)
+{
+  SampleIdMap<int> idmap;
+  BOOST_CHECK(idmap.empty());
+  BOOST_CHECK(idmap.find(0) == idmap.end());
+
+  dsm_sample_id_t id1 = 0, id2 = 0;
+  id1 = SET_DSM_ID(id1, 4);
+  id1 = SET_SPS_ID(id1, 101);
+  id2 = SET_DSM_ID(id2, 4);
+  id2 = SET_SPS_ID(id2, 100);
+
+  idmap[id1] = 1;
+  BOOST_CHECK(idmap.insert(std::make_pair(id2, 2)).second);
+  BOOST_CHECK(!idmap.insert(std::make_pair(id2, 3)).second);
+  BOOST_CHECK_EQUAL(idmap.size(), 2);
+  BOOST_CHECK_EQUAL(idmap.count(id1), 1);
+  BOOST_CHECK_EQUAL(idmap.find(id2)->second, 2);
+
+  // iterated in id order
+  BOOST_CHECK_EQUAL(idmap.begin()->first, id2);
+
+  BOOST_CHECK_EQUAL(idmap.erase(id2), 1);
+  BOOST_CHECK_EQUAL(idmap.erase(id2), 0);
+  BOOST_CHECK(idmap.find(id2) == idmap.end());
+  BOOST_CHECK_EQUAL(idmap.find(id1)->second, 1);
+
+  idmap.clear();
+  BOOST_CHECK(idmap.empty());
+  BOOST_CHECK(idmap.find(id1) == idmap.end());
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sample_id_map_random)
+{
+  // Compare against a std::map over random inserts and erases of ids
+  // from a few DSMs, including ids which collide in the hash table.
+  SampleIdMap<int> idmap;
+  std::map<dsm_sample_id_t, int> ref;
+  srandom(42);
+
+  for (int i = 0; i < 5000; i++) {
+    dsm_sample_id_t id = 0;
+    id = SET_DSM_ID(id, random() % 8);
+    id = SET_SPS_ID(id, random() % 300);
+    switch (random() % 4) {
+    case 0:
+      idmap.erase(id);
+      ref.erase(id);
+      break;
+    case 1:
+      idmap.insert(std::make_pair(id, i));
+      ref.insert(std::make_pair(id, i));
+      break;
+    default:
+      idmap[id] = i;
+      ref[id] = i;
+      break;
+    }
+    if (i % 500 == 0)
+      check_same(idmap, ref);
+  }
+  check_same(idmap, ref);
+
+  // lookups of ids which are not in the map
+  for (int i = 0; i < 1000; i++) {
+    dsm_sample_id_t id = 0;
+    id = SET_DSM_ID(id, 8 + random() % 8);
+    id = SET_SPS_ID(id, random() % 300);
+    BOOST_CHECK(idmap.find(id) == idmap.end());
+  }
+}
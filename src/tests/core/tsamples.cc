@@ -4,12 +4,25 @@
 using boost::unit_test_framework::test_suite;
 
 #include <nidas/core/Sample.h>
+#include <nidas/core/BucketSampleSet.h>
+#include <nidas/core/SampleSourceSupport.h>
+#include <nidas/core/SampleIndex.h>
+#include <nidas/core/SampleSink.h>
+#include <nidas/util/Thread.h>
 
+#include <atomic>
+#include <cstdlib>
 #include <limits>
 #include <sstream>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
 
 using namespace nidas::core;
 
+namespace n_u = nidas::util;
+
 
 template <typename T>
 void check_sample_type(sampleType expectedType)
@@ -110,3 +123,483 @@ BOOST_AUTO_TEST_CASE(test_sample_header)
                        sizeof(dsm_sample_id_t));
     BOOST_CHECK_EQUAL(sizeof(SampleHeader), 16);
 }
+
+
+class RefCountLoop: public n_u::Thread
+{
+public:
+    RefCountLoop(const Sample* samp, int niter):
+        n_u::Thread("RefCountLoop"), _samp(samp), _niter(niter)
+    {}
+
+    int run() override
+    {
+        for (int i = 0; i < _niter; ++i)
+            _samp->holdReference();
+        for (int i = 0; i < _niter; ++i)
+            _samp->freeReference();
+        return RUN_OK;
+    }
+
+private:
+    const Sample* _samp;
+    int _niter;
+
+    RefCountLoop(const RefCountLoop&) = delete;
+    RefCountLoop& operator=(const RefCountLoop&) = delete;
+};
+
+
+BOOST_AUTO_TEST_CASE(test_sample_refcount)
+{
+    SamplePool<SampleT<float> >* pool = SamplePool<SampleT<float> >::getInstance();
+    int nout = pool->getNSamplesOut();
+
+    SampleT<float>* samp = getSample<float>(4);
+    BOOST_CHECK_EQUAL(samp->getReferenceCount(), 1);
+    BOOST_CHECK_EQUAL(pool->getNSamplesOut(), nout + 1);
+
+    // Concurrent holds and frees must balance without losing counts,
+    // and the sample must not go back to the pool while the original
+    // reference is still held.
+    std::vector<n_u::Thread*> threads;
+    for (int i = 0; i < 8; ++i)
+        threads.push_back(new RefCountLoop(samp, 10000));
+    for (auto thr : threads)
+        thr->start();
+    for (auto thr : threads) {
+        thr->join();
+        delete thr;
+    }
+    BOOST_CHECK_EQUAL(samp->getReferenceCount(), 1);
+    BOOST_CHECK_EQUAL(pool->getNSamplesOut(), nout + 1);
+
+    samp->freeReference();
+    BOOST_CHECK_EQUAL(pool->getNSamplesOut(), nout);
+}
+
+
+class PoolLoop: public n_u::Thread
+{
+public:
+    PoolLoop(int niter):
+        n_u::Thread("PoolLoop"), _niter(niter)
+    {}
+
+    int run() override
+    {
+        std::vector<SampleT<float>*> samps;
+        for (int i = 0; i < _niter; ++i) {
+            for (int j = 0; j < 50; ++j)
+                samps.push_back(getSample<float>(j % 2 ? 10 : 100));
+            for (auto samp : samps)
+                samp->freeReference();
+            samps.clear();
+        }
+        return RUN_OK;
+    }
+
+private:
+    int _niter;
+};
+
+
+BOOST_AUTO_TEST_CASE(test_sample_pool_thread_cache)
+{
+    SamplePool<SampleT<float> >* pool = SamplePool<SampleT<float> >::getInstance();
+    int nout = pool->getNSamplesOut();
+
+    // A sample put back by this thread is handed out again from the
+    // thread cache.
+    SampleT<float>* samp = getSample<float>(4);
+    samp->freeReference();
+    SampleT<float>* samp2 = getSample<float>(4);
+    BOOST_CHECK_EQUAL(samp, samp2);
+    samp2->freeReference();
+    BOOST_CHECK_EQUAL(pool->getNSamplesOut(), nout);
+
+    std::vector<n_u::Thread*> threads;
+    for (int i = 0; i < 4; ++i)
+        threads.push_back(new PoolLoop(100));
+    for (auto thr : threads)
+        thr->start();
+    for (auto thr : threads) {
+        thr->join();
+        delete thr;
+    }
+
+    // The caches of the exited threads have been drained back to the
+    // pool and unregistered, leaving only this thread's cache.
+    BOOST_CHECK_EQUAL(pool->getNSamplesOut(), nout);
+    std::vector<SamplePoolThreadStats> stats = pool->getThreadStats();
+    BOOST_REQUIRE_EQUAL(stats.size(), 1);
+    BOOST_CHECK_EQUAL(pool->getNSamplesCached(), stats[0].ncached);
+    BOOST_CHECK(stats[0].nputs > 0);
+    BOOST_CHECK_EQUAL(pool->getNSamplesAlloc(),
+                      pool->getNSmallSamplesIn() + pool->getNMediumSamplesIn() +
+                      pool->getNLargeSamplesIn() + pool->getNSamplesCached() +
+                      pool->getNSamplesOut());
+}
+
+
+/*
+ * Insert samples with jittered, often equal time tags into a
+ * BucketSampleSet and a std::multiset, taking samples out of both along
+ * the way a SampleSorter does, and check that they come out in
+ * the same order.
+ */
+template <typename Compare>
+void check_bucket_order(long long bucketUsec)
+{
+    BucketSampleSet<Compare> buckets(bucketUsec);
+    std::multiset<const Sample*, Compare> mset;
+    std::vector<SampleT<float>*> samps;
+    std::vector<const Sample*> bout;
+    std::vector<const Sample*> mout;
+
+    ::srand(bucketUsec);
+    dsm_time_t tnow = 1000000;
+    for (int i = 0; i < 5000; ++i) {
+        tnow += ::rand() % 50;
+        SampleT<float>* samp = getSample<float>(1);
+        // early, late and equal time tags, with duplicate ids and data
+        samp->setTimeTag(tnow - (::rand() % 4 ? 0 : ::rand() % 1500));
+        samp->setId(::rand() % 3);
+        samp->getDataPtr()[0] = ::rand() % 2;
+        samps.push_back(samp);
+        buckets.insert(samp);
+        mset.insert(mset.end(), samp);
+
+        BOOST_REQUIRE_EQUAL(buckets.size(), mset.size());
+        BOOST_CHECK_EQUAL(buckets.latest(), *mset.rbegin());
+        if (i % 10) continue;
+
+        size_t nlate = std::min(mset.size() - 1, (size_t)5);
+        typename std::multiset<const Sample*, Compare>::reverse_iterator
+            ri = mset.rbegin();
+        std::advance(ri, nlate);
+        BOOST_CHECK_EQUAL(buckets.nthLatest(nlate), *ri);
+
+        dsm_time_t tt = (*ri)->getTimeTag() - 1000;
+        buckets.extractBefore(tt, bout);
+        for ( ; !mset.empty() && (*mset.begin())->getTimeTag() < tt; )
+        {
+            mout.push_back(*mset.begin());
+            mset.erase(mset.begin());
+        }
+    }
+    buckets.extractAll(bout);
+    mout.insert(mout.end(), mset.begin(), mset.end());
+
+    BOOST_CHECK(buckets.empty());
+    BOOST_CHECK(buckets.latest() == 0);
+    BOOST_REQUIRE_EQUAL(bout.size(), samps.size());
+    BOOST_CHECK(bout == mout);
+
+    for (auto samp : samps)
+        samp->freeReference();
+}
+
+
+BOOST_AUTO_TEST_CASE(test_bucket_sample_set)
+{
+    check_bucket_order<SampleTimetagComparator>(100);
+    check_bucket_order<SampleTimetagComparator>(1);
+    check_bucket_order<FullSampleComparator>(250);
+    check_bucket_order<SampleHeaderComparator>(10000);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sample_sink)
+{
+    std::vector<SampleT<float>*> samps;
+    for (int i = 0; i < 40; i++)
+    {
+        SampleT<float>* samp = getSample<float>(1);
+        samp->setTimeTag(i);
+        samps.push_back(samp);
+    }
+
+    SampleSink sink;
+    BOOST_CHECK(sink.empty());
+    // Past the size of the local array, samples are moved to the heap.
+    for (size_t i = 0; i < samps.size(); i++)
+    {
+        sink.push_back(samps[i]);
+        BOOST_CHECK_EQUAL(sink.size(), i + 1);
+        BOOST_CHECK_EQUAL(sink.back(), samps[i]);
+    }
+    BOOST_CHECK_EQUAL(sink.front(), samps[0]);
+
+    size_t n = 0;
+    for (SampleSink::const_iterator si = sink.begin(); si != sink.end(); ++si)
+    {
+        BOOST_CHECK_EQUAL(*si, samps[n]);
+        BOOST_CHECK_EQUAL(sink[n], samps[n]);
+        n++;
+    }
+    BOOST_CHECK_EQUAL(n, samps.size());
+
+    sink.clear();
+    BOOST_CHECK(sink.empty());
+    sink.push_back(samps[5]);
+    BOOST_CHECK_EQUAL(sink.front(), samps[5]);
+
+    for (size_t i = 0; i < samps.size(); i++)
+        samps[i]->freeReference();
+}
+
+
+/*
+ * A client which records the samples it receives, and the number of
+ * calls.
+ */
+class RecordingClient: public SampleClient
+{
+public:
+    RecordingClient(): samples(), ncalls(0) {}
+
+    bool receive(const Sample* s) throw()
+    {
+        samples.push_back(s);
+        ncalls++;
+        return true;
+    }
+
+    void flush() throw() {}
+
+    std::vector<const Sample*> samples;
+    int ncalls;
+};
+
+
+class BatchClient: public RecordingClient
+{
+public:
+    bool receiveBatch(const Sample* const* samps, size_t nsamps) throw()
+    {
+        samples.insert(samples.end(), samps, samps + nsamps);
+        ncalls++;
+        return true;
+    }
+};
+
+
+BOOST_AUTO_TEST_CASE(test_distribute_batch)
+{
+    SampleSourceSupport source(false);
+    RecordingClient single;
+    BatchClient batch;
+    source.addSampleClient(&single);
+    source.addSampleClient(&batch);
+
+    std::vector<const Sample*> samps;
+    for (int i = 0; i < 10; ++i) {
+        SampleT<float>* samp = getSample<float>(1);
+        samp->setTimeTag(i);
+        samps.push_back(samp);
+        // keep a reference past the distribute
+        samp->holdReference();
+    }
+    source.distribute(&samps[0], samps.size());
+
+    BOOST_CHECK(single.samples == samps);
+    BOOST_CHECK_EQUAL(single.ncalls, 10);
+    BOOST_CHECK(batch.samples == samps);
+    BOOST_CHECK_EQUAL(batch.ncalls, 1);
+
+    // distribute freed one reference of each sample
+    for (auto samp : samps) {
+        BOOST_CHECK_EQUAL(samp->getReferenceCount(), 1);
+        samp->freeReference();
+    }
+}
+
+
+/*
+ * A client which counts the samples it receives after it has been
+ * marked as deleted.
+ */
+class ValidClient: public SampleClient
+{
+public:
+    ValidClient(): valid(true), nreceived(0), ninvalid(0) {}
+
+    bool receive(const Sample*) throw()
+    {
+        nreceived++;
+        if (!valid) ninvalid++;
+        return true;
+    }
+
+    void flush() throw() {}
+
+    std::atomic<bool> valid;
+    std::atomic<int> nreceived;
+    std::atomic<int> ninvalid;
+};
+
+
+class DistributeLoop: public n_u::Thread
+{
+public:
+    DistributeLoop(SampleSourceSupport* source):
+        n_u::Thread("DistributeLoop"), _source(source)
+    {}
+
+    int run() override
+    {
+        while (!isInterrupted()) {
+            SampleT<float>* samp = getSample<float>(1);
+            _source->distribute(samp);
+        }
+        return RUN_OK;
+    }
+
+private:
+    SampleSourceSupport* _source;
+};
+
+
+BOOST_AUTO_TEST_CASE(test_distribute_remove_client)
+{
+    SampleSourceSupport source(false);
+    ValidClient always;
+    source.addSampleClient(&always);
+
+    DistributeLoop loop(&source);
+    loop.start();
+
+    // Once removeSampleClient() returns, a client must not be called
+    // again, so it could be deleted.
+    std::vector<ValidClient*> clients;
+    for (int i = 0; i < 200; ++i) {
+        ValidClient* client = new ValidClient();
+        clients.push_back(client);
+        source.addSampleClient(client);
+        while (client->nreceived == 0 && always.nreceived < 1000000)
+            std::this_thread::yield();
+        source.removeSampleClient(client);
+        client->valid = false;
+    }
+    loop.interrupt();
+    loop.join();
+
+    BOOST_CHECK_EQUAL(source.getClientCount(), 1);
+    for (auto client : clients) {
+        BOOST_CHECK_EQUAL(client->ninvalid, 0);
+        delete client;
+    }
+}
+
+
+/**
+ * A client which removes itself from its source in receive().
+ */
+class SelfRemovingClient: public SampleClient
+{
+public:
+    SelfRemovingClient(SampleSourceSupport* source):
+        _source(source), removed(false)
+    {}
+
+    bool receive(const Sample*) throw()
+    {
+        if (!removed) {
+            _source->removeSampleClient(this);
+            removed = true;
+        }
+        return true;
+    }
+
+    void flush() throw() {}
+
+private:
+    SampleSourceSupport* _source;
+
+public:
+    std::atomic<bool> removed;
+};
+
+
+BOOST_AUTO_TEST_CASE(test_distribute_remove_in_receive)
+{
+    // A client removing itself in receive() must not deadlock with
+    // another thread which is waiting in removeSampleClient() for
+    // that receive() to finish.
+    SampleSourceSupport source(false);
+    ValidClient always;
+    source.addSampleClient(&always);
+
+    DistributeLoop loop(&source);
+    loop.start();
+
+    std::vector<SelfRemovingClient*> selfs;
+    for (int i = 0; i < 200; ++i) {
+        SelfRemovingClient* self = new SelfRemovingClient(&source);
+        selfs.push_back(self);
+        ValidClient* client = new ValidClient();
+        source.addSampleClient(client);
+        source.addSampleClient(self);
+        source.removeSampleClient(client);
+        client->valid = false;
+        BOOST_CHECK_EQUAL(client->ninvalid, 0);
+        int n0 = always.nreceived;
+        while (!self->removed && always.nreceived - n0 < 1000000)
+            std::this_thread::yield();
+        delete client;
+    }
+    loop.interrupt();
+    loop.join();
+
+    BOOST_CHECK_EQUAL(source.getClientCount(), 1);
+    for (auto self : selfs) {
+        BOOST_CHECK(self->removed);
+        delete self;
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE(test_sample_index)
+{
+    std::string path = SampleIndex::indexPath("tsamples_index.dat");
+    BOOST_CHECK_EQUAL(path, "tsamples_index.dat.idx");
+    ::unlink(path.c_str());
+
+    SampleIndex missing;
+    BOOST_CHECK(!missing.read(path));
+    BOOST_CHECK_EQUAL(missing.findOffset(0), -1);
+
+    // 100 samples, one every 100 msec, each 20 bytes, with a block
+    // every second.  The samples of each block are out of time order.
+    dsm_time_t t0 = 1000000000LL * USECS_PER_SEC;
+    {
+        SampleIndexWriter writer(path, USECS_PER_SEC);
+        for (int i = 0; i < 100; ++i) {
+            SampleT<float>* samp = getSample<float>(1);
+            int j = (i % 10 == 1) ? i - 1 : ((i % 10 == 0) ? i + 1 : i);
+            samp->setTimeTag(t0 + j * USECS_PER_MSEC * 100);
+            samp->setId(SET_DSM_ID(0, 1 + i % 3) + 10);
+            writer.addSample(samp, i * 20);
+            samp->freeReference();
+        }
+    }
+
+    SampleIndex index;
+    BOOST_REQUIRE(index.read(path));
+    const std::vector<SampleIndex::Block>& blocks = index.getBlocks();
+    BOOST_REQUIRE_EQUAL(blocks.size(), 10);
+    for (unsigned int i = 0; i < blocks.size(); ++i)
+        BOOST_CHECK_EQUAL(blocks[i].offset, i * 200);
+    // the first block starts with the sample at 100 msec
+    BOOST_CHECK_EQUAL(blocks[0].maxTime, t0 + USECS_PER_MSEC * 900);
+    BOOST_CHECK_EQUAL(blocks[1].maxTime, t0 + USECS_PER_MSEC * 1900);
+
+    BOOST_CHECK_EQUAL(index.findOffset(0), 0);
+    BOOST_CHECK_EQUAL(index.findOffset(t0 + USECS_PER_MSEC * 900), 0);
+    BOOST_CHECK_EQUAL(index.findOffset(t0 + USECS_PER_MSEC * 901), 200);
+    BOOST_CHECK_EQUAL(index.findOffset(t0 + USECS_PER_SEC * 5), 1000);
+    BOOST_CHECK_EQUAL(index.findOffset(t0 + USECS_PER_SEC * 50), 1800);
+
+    ::unlink(path.c_str());
+}
@@ -0,0 +1,553 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+using boost::unit_test_framework::test_suite;
+
+#include <nidas/core/SampleScanner.h>
+#include <nidas/core/DSMSensor.h>
+#include <nidas/core/Sample.h>
+#include <nidas/util/util.h>
+
+#include <algorithm>
+#include <cstring>
+#include <list>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace nidas::core;
+
+namespace n_u = nidas::util;
+
+/*
+ * Compare the splitting of a message stream by MessageStreamScanner
+ * with the character at a time scanning that it did before it
+ * searched for separators with memchr().
+ */
+
+namespace {
+
+/**
+ * MessageStreamScanner with the original, character at a time,
+ * nextSampleSepEOM() and nextSampleSepBOM().
+ */
+class RefScanner: public MessageStreamScanner
+{
+public:
+    RefScanner(int bufsize): MessageStreamScanner(bufsize) {}
+
+    Sample* nextSampleSepEOM(DSMSensor* sensor);
+
+    Sample* nextSampleSepBOM(DSMSensor* sensor);
+};
+
+Sample* RefScanner::nextSampleSepEOM(DSMSensor* sensor)
+{
+    Sample* result = 0;
+
+    if (!_osamp) {
+        // first call, or just sent out last sample
+        // Wait to allocate next sample, and set its timetag when
+        // we have characters.
+        if (_buftail == _bufhead) return 0;
+        _osamp = getSample<char>(_sampleLengthAlloc);
+        _osamp->setId(sensor->getId());
+        dsm_time_t ttag = _tfirstchar + _buftail * getUsecsPerByte();
+
+        if (ttag <= _lastSampleTime) {
+            if (_stepBackwards) {
+                if (!(_stepBackTimeTag++ % 100))
+                    warnBackwardsStepTimeTag(sensor,ttag,_stepBackTimeTag);
+            }
+            else {
+                if (!(_nonIncrTimeTag++ % 100))
+                    warnNonIncrTimeTag(sensor,ttag,
+                        _lastSampleTime + 1, _nonIncrTimeTag);
+                ttag = _lastSampleTime + 1;
+            }
+        }
+        _lastSampleTime = ttag;
+        _osamp->setTimeTag(ttag);
+        _outSampDataPtr = (char*) _osamp->getVoidDataPtr();
+        _outSampLengthAlloc = _osamp->getAllocByteLength();
+        _outSampRead = 0;
+        _separatorCnt = 0;
+    }
+
+    // if getMessageLength() > 0 copy multiple characters
+    int nc = getMessageLength() - _outSampRead;
+    if (nc > 0) {
+        nc = std::min(_bufhead-_buftail,(unsigned)nc);
+        if (nc > 0) {
+            // actually don't need to check for allocated space here
+            // because if getMessageLength() is > 0, then
+            // _outSampLengthAlloc should be big enough, but
+            // we'll do it to be sure.  Could put an
+            // assert here instead.
+            if (_outSampRead + nc > _outSampLengthAlloc &&
+                (result = requestBiggerSample(nc))) return result;
+            ::memcpy(_outSampDataPtr+_outSampRead,_buffer+_buftail,nc);
+            _outSampRead += nc;
+            _buftail += nc;
+        }
+    }
+
+    // extra space needed for null terminator before processing next character
+    int nterm = getNullTerminate() ? 1 : 0;
+
+    // now loop through character by character, until we find the 
+    // separator string.
+    while (_buftail < _bufhead) {
+
+        if (_outSampRead + 1 + nterm > _outSampLengthAlloc &&
+                (result = requestBiggerSample(1 + nterm))) return result;
+
+        char c = _buffer[_buftail++];
+        _outSampDataPtr[_outSampRead++] = c;
+
+        // if the character matches the current character
+        // in the end of message separator string.
+        if (c == _separator[_separatorCnt]) {
+            // character matched
+            if (++_separatorCnt == _separatorLen) {   // sample is ready
+                if (getNullTerminate())
+                    _outSampDataPtr[_outSampRead++] = '\0';
+                _osamp->setDataLength(_outSampRead);
+                addSampleToStats(_outSampRead);
+
+                result = _osamp;
+                _osamp = 0;
+
+                // adjust size of next sample to request, if it needs changing
+                if (_outSampRead > _sampleLengthAlloc) {
+                    _sampleLengthAlloc = std::min(_outSampRead + 16,MAX_MESSAGE_STREAM_SAMPLE_SIZE);
+                    _nsmallSamples = 0;
+                }
+                // check for 100 samples in a row less than _sampleLengthAlloc - 64
+                else if (_sampleLengthAlloc > 64 && _outSampRead < _sampleLengthAlloc - 64) {
+                    if (++_nsmallSamples > 100) {
+                        _sampleLengthAlloc -= 64;
+                        _nsmallSamples = 0;
+                    }
+                }
+                else _nsmallSamples = 0;
+                break;
+            }
+        }
+        else {
+            // no match of current character to EOM string.
+            // check for match at beginning of separator string
+            //
+            // Also handle situation where there are repeated character
+            // sequences in the separator.  For example: a separator
+            // sequence of xxy, and the input is xxxy.  When you get
+            // a failure matching the third character, you shouldn't start
+            // completely over scanning for xxy starting at the third x,
+            // but should scan for xy starting at the third x.
+            // This also happens with a separator of xyxyz and an input of xyxyxyz.
+            // One can never tell what kind of separator sequence someone might think of...
+            if (_separatorCnt > 0) {
+                // initial character repeated
+                if (_separatorCnt > 1 && !memcmp(_separator,_separator+1,_separatorCnt-1) &&
+                    c == _separator[_separatorCnt-1]);  // leave _separatorCnt as is
+                else {
+                    // possible repeated sequence
+                    int nrep = _separatorCnt / 2;   // length of seq
+                    if (!(_separatorCnt % 2) && !memcmp(_separator,_separator+nrep,nrep) &&
+                        c == _separator[_separatorCnt = nrep]) _separatorCnt++;
+                    // start scan over
+                    else if (c == _separator[_separatorCnt = 0]) _separatorCnt++;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+Sample* RefScanner::nextSampleSepBOM(DSMSensor* sensor)
+{
+    Sample* result = 0;
+
+    /*
+     * scanner will be in one of these states:
+     * 1. first call, no chars scanned, _osamp==NULL
+     * 2. last sample exceeded MAX_MESSAGE_STREAM_SAMPLE_SIZE before
+     *    finding the next BOM. That bogus sample was returned, and now
+     *    _osamp==NULL.
+     * 3. last call successfully matched the BOM separator and returned
+     *    the sample previous to the separator.
+     *    In this case _osamp != NULL, _separatorCnt == _separatorLen.
+     *    Now to read the portion after the separator into _osamp. If
+     *    getMessageLength() > 0, memcpy available characters, up to
+     *    the message length, then start scanning for the next BOM.
+     * 4. last call returned 0, meaning we have consumed some
+     *    characters after the last BOM, but haven't found the next BOM.
+     *    In this case, _osamp != NULL and _separatorCnt < _separatorLen.
+     */
+
+    if (!_osamp) {
+        // first call, or last sample exceeded MAX_MESSAGE_STREAM_SAMPLE_SIZE 
+        // Wait to allocate next sample, and set its default timetag when
+        // we have characters.
+        if (_buftail == _bufhead) return 0;
+        _osamp = getSample<char>(_sampleLengthAlloc);
+        _osamp->setId(sensor->getId());
+        _outSampDataPtr = (char*) _osamp->getVoidDataPtr();
+        _outSampLengthAlloc = _osamp->getAllocByteLength();
+        // set default timetag in case we never find a BOM again.
+        dsm_time_t ttag = _tfirstchar + _buftail * getUsecsPerByte();
+
+        if (ttag <= _lastSampleTime) {
+            if (_stepBackwards) {
+                if (!(_stepBackTimeTag++ % 100))
+                    warnBackwardsStepTimeTag(sensor,ttag,_stepBackTimeTag);
+            }
+            else {
+                if (!(_nonIncrTimeTag++ % 100))
+                    warnNonIncrTimeTag(sensor,ttag,
+                        _lastSampleTime + 1, _nonIncrTimeTag);
+                ttag = _lastSampleTime + 1;
+            }
+        }
+        _lastSampleTime = ttag;
+        _osamp->setTimeTag(ttag);
+        _outSampRead = 0;
+        _separatorCnt = 0;
+    }
+
+    if (_separatorCnt == _separatorLen) {
+        // BOM separator has been scanned
+        // Copy up to getMessageLength() number of characters,
+        // or whatever is available in the buffer.
+        // _outSampRead includes the separator. If the buffer
+        // contains less than getMessageLength() number of characters,
+        // copy what is available and return, and then on the next
+        // call to this method, this section will re-entered.
+        int nc = getMessageLength() - (_outSampRead - _separatorCnt);
+        if (nc > 0) {
+            nc = std::min(_bufhead-_buftail,(unsigned)nc);
+            if (nc > 0) {
+                if (_outSampRead + nc > _outSampLengthAlloc &&
+                    (result = requestBiggerSample(nc))) return result;
+                ::memcpy(_outSampDataPtr+_outSampRead,_buffer+_buftail,nc);
+                _outSampRead += nc;
+                _buftail += nc;
+                if (_buftail == _bufhead) return 0;
+            }
+        }
+        // Copied data portion of sample, starting looking for BOM
+        // of next sample.
+        _separatorCnt = 0;
+    }
+
+    // empty space needed in sample before processing next character
+    int space = _separatorLen;
+    if (getNullTerminate()) space++;
+
+    // At this point we are currently scanning
+    // for the message separator at the beginning of the next message.
+    for (;_buftail < _bufhead;) {
+        char c = _buffer[_buftail];
+
+        if (_outSampRead + space > _outSampLengthAlloc &&
+            (result = requestBiggerSample(space))) return result;
+
+        if (c == _separator[_separatorCnt]) {
+            // We now have a character match to the record separator.
+            // increment the separator counter.
+            // if matched entire separator string, previous sample
+            // is ready, ship it.
+
+            // the receipt time of the initial separator character
+            // is the timetag for the sample. Save this time
+            // in case the entire separator is not in this buffer.
+            if (_separatorCnt == 0) _bomtt =
+                _tfirstchar + _buftail * getUsecsPerByte();
+            _buftail++;      // used character
+
+            if (++_separatorCnt == _separatorLen) {
+                // send previous sample
+                if (_outSampRead > 0) {
+                    if (getNullTerminate()) _outSampDataPtr[_outSampRead++] =
+                        '\0';
+                    _osamp->setDataLength(_outSampRead);
+                    addSampleToStats(_outSampRead);
+                    result = _osamp;
+
+                    // adjust size of next sample to request, if it needs changing
+                    if (_outSampRead > _sampleLengthAlloc) {
+                        _sampleLengthAlloc = std::min(_outSampRead + 16,MAX_MESSAGE_STREAM_SAMPLE_SIZE);
+                        _nsmallSamples = 0;
+                    }
+                    // check for 100 samples in a row less than _sampleLengthAlloc - 64
+                    else if (_sampleLengthAlloc > 64 && _outSampRead < _sampleLengthAlloc - 64) {
+                        if (++_nsmallSamples > 100) {
+                            _sampleLengthAlloc -= 64;
+                            _nsmallSamples = 0;
+                        }
+                    }
+                    else _nsmallSamples = 0;
+
+                    _osamp = getSample<char>(_sampleLengthAlloc);
+                    _osamp->setId(sensor->getId());
+                    _outSampDataPtr = (char*) _osamp->getVoidDataPtr();
+                    _outSampLengthAlloc = _osamp->getAllocByteLength();
+                }
+
+                if (_bomtt <= _lastSampleTime) {
+                    if (_stepBackwards) {
+                        if (!(_stepBackTimeTag++ % 100))
+                            warnBackwardsStepTimeTag(sensor, _bomtt, _stepBackTimeTag);
+                    }
+                    else {
+                        if (!(_nonIncrTimeTag++ % 100))
+                            warnNonIncrTimeTag(sensor, _bomtt,
+                                _lastSampleTime + 1, _nonIncrTimeTag);
+                        _bomtt = _lastSampleTime + 1;
+                    }
+                }
+                _lastSampleTime = _bomtt;
+                _osamp->setTimeTag(_bomtt);
+
+                // copy separator to beginning of next sample
+                ::memcpy(_outSampDataPtr,_separator,_separatorCnt);
+                _outSampRead = _separatorCnt;
+                // leave _separatorCnt equal to _separatorLen
+                if (result) return result;
+                // If no previous sample then do a recursive call
+                // (or a goto to the beginning of this function).
+                // It won't be infinitely recursive, even if the sensor
+                // was only sending out BOM strings, because
+                // _outSampRead is now > 0
+                else return nextSampleSepBOM(sensor);
+            }
+        }
+        else {
+            // At this point:
+            // 1. we're looking for the BOM separator, but
+            // 2. the current character fails a match with the
+            //    BOM string
+            //
+            // Perhaps this is a faulty record, in which case
+            // we'll put the unexpected data in the sample anyway so that
+            // the user can see what is going on.
+            // Or it could be simply that the current message length is
+            // greater than getMessageLength() and this is good data.
+            //
+            // _osamp was allocated in one of the following situations.
+            //      1. The very first sample is being scanned. _osamp timetag was set
+            //          to estimated receipt time of first character of current sample.
+            //      2. The previous sample exceeded MAX_MESSAGE_STREAM_SAMPLE_SIZE. That
+            //          sample was sent on, and another sample allocated. We haven't found a
+            //          BOM for this sample, and _osamp timetag was set to estimated
+            //          receipt time of first character in current sample.
+            //      3. We've found a BOM separator. _osamp timetag has been set, _outSampRead will be > 0.
+
+            if (_separatorCnt > 0) {     // previous partial match
+
+                // check for repeated sequence in _separator, e.g. the separator 
+                // is "xxz" and the data is "xxx...". The third 'x' in the data has failed
+                // to match the 'z' in the separator. _separatorCnt will be 2.
+                // Copy the first 'x' to the output sample, check again for a separator match
+                // looking for the second 'x' in the separator.
+                if (_separatorCnt > 1 && !memcmp(_separator,_separator+1,_separatorCnt-1)) {
+                    // initial repeated character
+                    ::memcpy(_outSampDataPtr+_outSampRead,_separator,1);
+                    _outSampRead++;
+                    _separatorCnt--;
+                }
+                else {
+                    int nrep = _separatorCnt / 2;   // length of sequence
+                    if (!(_separatorCnt % 2) && !memcmp(_separator,_separator+nrep,nrep)) {
+                        // initial repeated sequence in _separator: "xyxyz".
+                        // _separatorCnt is 4,6, etc, nrep is at least 2.
+                        ::memcpy(_outSampDataPtr+_outSampRead,_separator,nrep);
+                        _outSampRead += nrep;
+                        _separatorCnt -= nrep;
+                    }
+                    else {
+                        // We have a partial match to separator,
+                        // copy chars to the sample data, start scanning over
+                        ::memcpy(_outSampDataPtr+_outSampRead,_separator,_separatorCnt);
+                        _outSampRead += _separatorCnt;
+                        _separatorCnt = 0;      // start scanning for BOM again
+                    }
+                }
+                // We have copied at least one character from the separator into the 
+                // current sample, so _outSampRead is now > 0.
+                //
+                // Note that _buftail has *not* been incremented, i.e. a character has
+                // not been consumed from the buffer. This won't infinitely loop
+                // because we've reduced _separatorCnt.
+            }
+            else {              // no match to first character in separator
+                _outSampDataPtr[_outSampRead++] = c;
+                _buftail++;      // used character
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Scanner whose buffers are time tagged by a simulated clock, rather
+ * than the system clock, so that the time tags of the samples from
+ * two scanners can be compared.  The clock steps backwards now and
+ * then, and buffers can arrive faster than the baud rate allows.
+ */
+template <typename Scanner>
+class FakeClockScanner: public Scanner
+{
+public:
+    FakeClockScanner(int bufsize, unsigned int seed):
+        Scanner(bufsize), _rng(seed), _clock(1000000000LL * USECS_PER_SEC)
+    {}
+
+    size_t readBuffer(DSMSensor* sensor, bool& exhausted)
+    {
+        size_t rlen = Scanner::readBuffer(sensor, exhausted);
+        if (_rng() % 50 == 0) _clock -= USECS_PER_SEC / 5;
+        else _clock += rlen * this->getUsecsPerByte() / 2 + _rng() % 1000;
+        this->_tfirstchar = _clock - rlen * this->getUsecsPerByte();
+        this->_stepBackwards = _clock < this->_lastBufferTime;
+        this->_lastBufferTime = _clock;
+        return rlen;
+    }
+
+private:
+    std::mt19937 _rng;
+
+    dsm_time_t _clock;
+};
+
+/**
+ * DSMSensor which reads from a string, in reads of random lengths
+ * up to maxRead bytes.
+ */
+class StringSensor: public DSMSensor
+{
+public:
+    StringSensor(const std::string& data, size_t maxRead, unsigned int seed):
+        _data(data), _pos(0), _maxRead(maxRead), _rng(seed)
+    {
+        setDSMId(1);
+        setSensorId(100);
+    }
+
+    IODevice* buildIODevice() { return 0; }
+
+    SampleScanner* buildSampleScanner() { return 0; }
+
+    bool process(const Sample*, std::list<const Sample*>&) { return false; }
+
+    size_t read(void *buf, size_t len)
+    {
+        len = std::min(len, 1 + _rng() % _maxRead);
+        len = std::min(len, _data.length() - _pos);
+        ::memcpy(buf, _data.data() + _pos, len);
+        _pos += len;
+        return len;
+    }
+
+    size_t read(void *buf, size_t len, int)
+    {
+        return read(buf, len);
+    }
+
+    bool atEnd() const { return _pos == _data.length(); }
+
+private:
+    const std::string& _data;
+
+    size_t _pos;
+
+    size_t _maxRead;
+
+    std::mt19937 _rng;
+};
+
+struct Message
+{
+    dsm_time_t tt;
+    std::string data;
+
+    bool operator==(const Message& x) const
+    {
+        return tt == x.tt && data == x.data;
+    }
+};
+
+template <typename Scanner>
+std::vector<Message>
+scanStream(const std::string& data, const std::string& sep, bool eom,
+           int mlen, bool nullTerm, int bufsize, size_t maxRead)
+{
+    StringSensor sensor(data, maxRead, 17);
+    FakeClockScanner<Scanner> scanner(bufsize, 23);
+    scanner.setUsecsPerByte(87);
+    scanner.setMessageParameters(mlen, sep, eom);
+    scanner.setNullTerminate(nullTerm);
+
+    std::vector<Message> msgs;
+    while (!sensor.atEnd()) {
+        bool exhausted;
+        scanner.readBuffer(&sensor, exhausted);
+        while (Sample* samp = scanner.nextSample(&sensor)) {
+            Message msg;
+            msg.tt = samp->getTimeTag();
+            msg.data = std::string((const char*)samp->getConstVoidDataPtr(),
+                                   samp->getDataByteLength());
+            msgs.push_back(msg);
+            samp->freeReference();
+        }
+    }
+    return msgs;
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_message_scanner_reference)
+{
+    // Separators with repeated characters and sequences, which
+    // need backtracking when a match fails part way through.
+    const char* seps[] = { "\r\n", "\n", "xxy", "xyxyz", "aab" };
+    const std::string alpha = "abxyz\r\n012 ";
+    std::mt19937 rng(3);
+
+    size_t nconfigs = 0;
+    for (const char* sep : seps)
+    for (int eom = 0; eom < 2; eom++) {
+        // Random characters of the separators, and the separator
+        // itself, with messages longer than the maximum sample size.
+        std::string data;
+        for (int i = 0; i < 5000; i++) {
+            int r = rng() % 1000;
+            if (r < 30) data += sep;
+            else if (r < 32) data += std::string(rng() % 9000, 'q');
+            else if (r < 40) data += std::string(rng() % 500, 'b');
+            else data += alpha[rng() % alpha.size()];
+        }
+
+        for (int mlen : { 0, 3, 40 })
+        for (int nt = 0; nt < 2; nt++)
+        for (int bufsize : { 16, 100, 8192 })
+        for (size_t maxRead : { (size_t)1, (size_t)7, (size_t)5000 }) {
+            std::vector<Message> ref = scanStream<RefScanner>(
+                data, sep, eom, mlen, nt, bufsize, maxRead);
+            std::vector<Message> cur = scanStream<MessageStreamScanner>(
+                data, sep, eom, mlen, nt, bufsize, maxRead);
+
+            std::ostringstream ost;
+            ost << "sep=\"" << n_u::addBackslashSequences(sep) <<
+                "\" eom=" << eom << " mlen=" << mlen << " nt=" << nt <<
+                " bufsize=" << bufsize << " maxRead=" << maxRead;
+            BOOST_CHECK_MESSAGE(!ref.empty(), ost.str());
+            BOOST_CHECK_MESSAGE(cur.size() == ref.size(), ost.str() <<
+                ": " << cur.size() << " messages, reference " << ref.size());
+            BOOST_CHECK_MESSAGE(cur == ref, ost.str() << ": messages differ");
+            nconfigs++;
+        }
+    }
+    BOOST_CHECK_EQUAL(nconfigs, 5 * 2 * 3 * 2 * 3 * 3);
+}
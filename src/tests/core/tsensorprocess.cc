@@ -0,0 +1,194 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+using boost::unit_test_framework::test_suite;
+
+#include <nidas/core/DSMSensor.h>
+#include <nidas/core/SampleSink.h>
+#include <nidas/core/Sample.h>
+
+#include <list>
+#include <vector>
+
+using namespace nidas::core;
+
+namespace {
+
+/**
+ * The processing done by both test sensors: an output sample
+ * of two values for each input value.
+ */
+template <typename Container>
+void processValues(const Sample* samp, Container& results)
+{
+    for (unsigned int i = 0; i < samp->getDataLength(); i++) {
+        SampleT<float>* outs = getSample<float>(2);
+        outs->setTimeTag(samp->getTimeTag() + i);
+        outs->setId(samp->getId() + 1);
+        outs->getDataPtr()[0] = samp->getDataValue(i) * 2;
+        outs->getDataPtr()[1] = samp->getDataValue(i) + 1;
+        results.push_back(outs);
+    }
+}
+
+class TestSensor: public DSMSensor
+{
+public:
+    IODevice* buildIODevice() { return 0; }
+
+    SampleScanner* buildSampleScanner() { return 0; }
+};
+
+/**
+ * A sensor which only implements process().
+ */
+class ListSensor: public TestSensor
+{
+public:
+    bool process(const Sample* samp, std::list<const Sample*>& results)
+    {
+        processValues(samp, results);
+        return true;
+    }
+};
+
+/**
+ * A sensor which implements processInto(), and process() with
+ * DSMSensor::process().
+ */
+class SinkSensor: public TestSensor
+{
+public:
+    bool process(const Sample* samp, std::list<const Sample*>& results)
+    {
+        return DSMSensor::process(samp, results);
+    }
+
+    bool processInto(const Sample* samp, SampleSink& results)
+    {
+        processValues(samp, results);
+        return true;
+    }
+};
+
+struct Output
+{
+    dsm_time_t tt;
+    dsm_sample_id_t id;
+    std::vector<float> values;
+
+    bool operator==(const Output& x) const
+    {
+        return tt == x.tt && id == x.id && values == x.values;
+    }
+
+    bool operator!=(const Output& x) const
+    {
+        return !(*this == x);
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, const Output& x)
+{
+    os << x.tt << ' ' << x.id << ' ' << x.values.size();
+    return os;
+}
+
+Output toOutput(const Sample* samp)
+{
+    Output out;
+    out.tt = samp->getTimeTag();
+    out.id = samp->getId();
+    for (unsigned int i = 0; i < samp->getDataLength(); i++)
+        out.values.push_back(samp->getDataValue(i));
+    return out;
+}
+
+/**
+ * Collects the samples distributed by a sensor.
+ */
+class OutputClient: public SampleClient
+{
+public:
+    OutputClient(): outputs() {}
+
+    bool receive(const Sample* samp) throw()
+    {
+        outputs.push_back(toOutput(samp));
+        return true;
+    }
+
+    void flush() throw() {}
+
+    std::vector<Output> outputs;
+};
+
+SampleT<float>* makeInput(int nvalues)
+{
+    SampleT<float>* samp = getSample<float>(nvalues);
+    samp->setTimeTag(1000000);
+    samp->setId(SET_DSM_ID(0, 10) + 100);
+    for (int i = 0; i < nvalues; i++)
+        samp->getDataPtr()[i] = i * 0.5;
+    return samp;
+}
+
+/**
+ * Run a sensor through process(), processInto() and receive(),
+ * returning the outputs of each.
+ */
+void runSensor(DSMSensor& sensor, int nvalues,
+    std::vector<Output>& listOut, std::vector<Output>& sinkOut,
+    std::vector<Output>& recvOut)
+{
+    SampleT<float>* samp = makeInput(nvalues);
+
+    std::list<const Sample*> lresults;
+    BOOST_CHECK(sensor.process(samp, lresults));
+    for (auto outs : lresults) {
+        listOut.push_back(toOutput(outs));
+        outs->freeReference();
+    }
+
+    SampleSink sresults;
+    BOOST_CHECK(sensor.processInto(samp, sresults));
+    for (auto outs : sresults) {
+        sinkOut.push_back(toOutput(outs));
+        outs->freeReference();
+    }
+
+    OutputClient client;
+    sensor.addSampleClient(&client);
+    sensor.receive(samp);
+    sensor.removeSampleClient(&client);
+    recvOut = client.outputs;
+
+    samp->freeReference();
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_process_adapter)
+{
+    // More values than fit in the local array of a SampleSink.
+    for (int nvalues : { 0, 1, 5, 20 }) {
+        ListSensor lsensor;
+        std::vector<Output> llist, lsink, lrecv;
+        runSensor(lsensor, nvalues, llist, lsink, lrecv);
+
+        SinkSensor ssensor;
+        std::vector<Output> slist, ssink, srecv;
+        runSensor(ssensor, nvalues, slist, ssink, srecv);
+
+        BOOST_CHECK_EQUAL(llist.size(), (size_t)nvalues);
+        BOOST_CHECK_EQUAL_COLLECTIONS(llist.begin(), llist.end(),
+            lsink.begin(), lsink.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(llist.begin(), llist.end(),
+            lrecv.begin(), lrecv.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(llist.begin(), llist.end(),
+            slist.begin(), slist.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(llist.begin(), llist.end(),
+            ssink.begin(), ssink.end());
+        BOOST_CHECK_EQUAL_COLLECTIONS(llist.begin(), llist.end(),
+            srecv.begin(), srecv.end());
+    }
+}
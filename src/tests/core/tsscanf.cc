@@ -0,0 +1,105 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+using boost::unit_test_framework::test_suite;
+
+#include <nidas/core/CompiledSscanf.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace nidas::core;
+
+
+namespace {
+
+/*
+ * Scan input with a format of up to four %f fields, with the compiled
+ * format and with ::sscanf, and check that the results are identical.
+ */
+void
+check_floats(const char* format, const char* input, int nexpected)
+{
+  CompiledSscanf cs;
+  BOOST_REQUIRE(cs.compile(format));
+
+  float expected[4] = { 0, 0, 0, 0 };
+  int nref = ::sscanf(input, format, &expected[0], &expected[1],
+                      &expected[2], &expected[3]);
+  if (nref < 0) nref = 0;
+
+  float values[4];
+  int n = cs.scan(input, values, cs.getNumberOfFields());
+  BOOST_TEST_MESSAGE("format=\"" << format << "\" input=\"" << input << "\"");
+  BOOST_CHECK_EQUAL(nref, nexpected);
+  BOOST_CHECK_EQUAL(n, nref);
+  for (int i = 0; i < n && i < nref; i++)
+    BOOST_CHECK(::memcmp(&values[i], &expected[i], sizeof(float)) == 0);
+}
+
+}
+
+
+BOOST_AUTO_TEST_CASE(test_compiled_sscanf_floats)
+{
+  // Typical sonic, hygrometer and barometer messages.
+  check_floats("%f%f%f%f", "  0.04  -0.12   0.31  22.85\r\n", 4);
+  check_floats("%f,%f,%f,%f", "1.234,-5.67e-3,+8.,.5", 4);
+  check_floats("$PTB,%f,%f", "$PTB,1013.25,21.3", 2);
+  check_floats("RH= %f %%RH T= %f", "RH= 45.2 %RH T= 18.75", 2);
+  check_floats("%*f%f%*[^,],%f", "1.5 2.5 junk,3.5", 2);
+  check_floats("%5f%3f", "12345678", 2);
+  check_floats("%*s %*s %f", "2026-10-17 12:00:00 3.25", 1);
+
+  // Partial matches.
+  check_floats("%f,%f,%f", "1.0,2.0", 2);
+  check_floats("%f,%f,%f", "1.0;2.0,3.0", 1);
+  check_floats("T=%f", "RH=45", 0);
+  check_floats("%f", "", 0);
+
+  // Values not parsed inline, which are passed to ::sscanf.
+  check_floats("%f %f %f", "nan inf -infinity", 3);
+  check_floats("%f %f", "0x1p3 1e", 2);
+  check_floats("%f %f", "1.00000005960464477539062 16777217", 2);
+  check_floats("%f %f", "3.40282357e38 1e-50", 2);
+  check_floats("%f", "12345678901234567890123", 1);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_compiled_sscanf_integers)
+{
+  CompiledSscanf cs;
+  BOOST_REQUIRE(cs.compile("%d %hd %x %o %u %hu %ld %2c"));
+  BOOST_CHECK_EQUAL(cs.getNumberOfFields(), 8);
+
+  float values[8];
+  BOOST_CHECK_EQUAL(cs.scan("-17 40000 ff -17 123 70000 -5 AB",
+                            values, 8), 8);
+  BOOST_CHECK_EQUAL(values[0], -17.0);
+  BOOST_CHECK_EQUAL(values[1], (float)(short)40000);
+  BOOST_CHECK_EQUAL(values[2], 255.0);
+  BOOST_CHECK_EQUAL(values[3], -15.0);
+  BOOST_CHECK_EQUAL(values[4], 123.0);
+  BOOST_CHECK_EQUAL(values[5], (float)(unsigned short)70000);
+  BOOST_CHECK_EQUAL(values[6], -5.0);
+  BOOST_CHECK_EQUAL(values[7], (float)('A' + ('B' << 8)));
+
+  // nout limits the number of values.
+  BOOST_CHECK_EQUAL(cs.scan("1 2 3 4 5 6 7 AB", values, 3), 3);
+}
+
+
+BOOST_AUTO_TEST_CASE(test_compiled_sscanf_unsupported)
+{
+  CompiledSscanf cs;
+  BOOST_CHECK(!cs.compile("%s"));
+  BOOST_CHECK(!cs.isCompiled());
+  BOOST_CHECK(!cs.compile("%e"));
+  BOOST_CHECK(!cs.compile("%5.2f"));
+  BOOST_CHECK(!cs.compile("%[abc]"));
+  BOOST_CHECK(!cs.compile("%f%"));
+  BOOST_CHECK(cs.compile("%*[^,],%f"));
+  BOOST_CHECK(cs.isCompiled());
+  BOOST_CHECK(cs.compile("%*s %*2s%f"));
+  BOOST_CHECK_EQUAL(cs.getNumberOfFields(), 1);
+}
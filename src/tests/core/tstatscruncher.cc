@@ -0,0 +1,179 @@
+#define BOOST_TEST_DYN_LINK
+#include <boost/test/unit_test.hpp>
+using boost::unit_test_framework::test_suite;
+
+#include <nidas/dynld/StatisticsCruncher.h>
+#include <nidas/dynld/StatisticsProcessor.h>
+#include <nidas/core/SampleSourceSupport.h>
+#include <nidas/core/SampleTag.h>
+#include <nidas/core/Variable.h>
+#include <nidas/core/Site.h>
+#include <nidas/core/Sample.h>
+
+#include <string>
+#include <vector>
+
+using namespace nidas::core;
+using namespace nidas::dynld;
+
+namespace {
+
+/**
+ * Collects the output samples of a cruncher.
+ */
+class OutputClient: public SampleClient
+{
+public:
+    OutputClient(): outputs() {}
+
+    bool receive(const Sample* samp) throw()
+    {
+        std::vector<float> values;
+        for (unsigned int i = 0; i < samp->getDataLength(); i++)
+            values.push_back(samp->getDataValue(i));
+        outputs.push_back(values);
+        return true;
+    }
+
+    void flush() throw() {}
+
+    std::vector<std::vector<float> > outputs;
+};
+
+/**
+ * Add variables with the given names and site to a SampleTag.
+ */
+void addVariables(SampleTag& tag, const std::vector<std::string>& names,
+                  const Site* site)
+{
+    for (const std::string& name : names) {
+        Variable* var = new Variable();
+        var->setName(name);
+        var->setSite(site);
+        tag.addVariable(var);
+    }
+}
+
+/**
+ * Run a cruncher over two one-second periods of 10 Hz samples of u,
+ * v, w and T.  Every fourth sample is short, without T, so its value
+ * of T is NaN.  Return the values of the output samples.
+ */
+std::vector<std::vector<float> >
+crunch(StatisticsCruncher::statisticsType type,
+       const std::vector<std::string>& names, bool higherMoments)
+{
+    Site site;
+    site.setName("test");
+
+    SampleTag intag;
+    intag.setDSMId(1);
+    intag.setSensorId(10);
+    intag.setSampleId(1);
+    intag.setRate(10.0);
+    addVariables(intag, { "u", "v", "w", "T" }, &site);
+
+    SampleSourceSupport source(false);
+    source.addSampleTag(&intag);
+
+    SampleTag stag;
+    stag.setDSMId(1);
+    stag.setSensorId(32768);
+    stag.setSampleId(1);
+    stag.setRate(1.0);
+    addVariables(stag, names, &site);
+
+    StatisticsProcessor proc;
+    StatisticsCruncher cruncher(&proc, &stag, type, "", higherMoments);
+    cruncher.connect(&source);
+
+    OutputClient client;
+    cruncher.addSampleClient(&client);
+
+    const dsm_time_t t0 = 1700000000LL * USECS_PER_SEC;
+    for (int i = 0; i < 20; i++) {
+        SampleT<float>* samp = getSample<float>(4);
+        samp->setId(intag.getId());
+        samp->setTimeTag(t0 + i * USECS_PER_SEC / 10);
+        float* dp = samp->getDataPtr();
+        dp[0] = (i % 7) * 0.25 - 1.0;
+        dp[1] = (i % 5) * 0.5 + 2.0;
+        dp[2] = (i % 3) * 0.125 - 0.125;
+        dp[3] = 20.0 + (i % 6) * 0.75;
+        // The value of T past the end of a short sample is not used.
+        if (i % 4 == 3) samp->setDataLength(3);
+        source.distribute(samp);
+    }
+    cruncher.flush();
+    cruncher.removeSampleClient(&client);
+    cruncher.disconnect(&source);
+    return client.outputs;
+}
+
+/**
+ * Check that the outputs are exactly those of the cruncher before its
+ * cross term sums were computed from gathered inputs.
+ */
+void checkOutputs(const std::vector<std::vector<float> >& outputs,
+                  const std::vector<std::vector<float> >& expected)
+{
+    BOOST_REQUIRE_EQUAL(outputs.size(), expected.size());
+    for (unsigned int i = 0; i < outputs.size(); i++) {
+        BOOST_REQUIRE_EQUAL(outputs[i].size(), expected[i].size());
+        for (unsigned int j = 0; j < outputs[i].size(); j++)
+            BOOST_CHECK_MESSAGE(outputs[i][j] == expected[i][j],
+                "output " << i << ", value " << j << ": " <<
+                outputs[i][j] << " != " << expected[i][j]);
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_cruncher_covariance)
+{
+    checkOutputs(crunch(StatisticsCruncher::STATS_COV,
+                        { "u", "v", "w", "T" }, true), {
+        { -0.333333343f, 2.83333325f, 0.0f, 21.75f, 0.222222224f,
+          -0.027777778f, 0.0f, 0.208333328f, 0.611111104f, 0.0f, 0.166666672f,
+          0.010416667f, 0.0625f, 1.625f, 0.0405092575f, 0.185185179f, 0.0f,
+          0.03125f, 0.0966435149f, 0.597222209f, 0.000162760422f, 4.5234375f,
+          9.0f },
+        { -0.166666672f, 3.25f, 0.0f, 21.5f, 0.243055552f, -0.0416666679f,
+          -0.03125f, -0.34375f, 0.229166672f, 0.010416667f, -0.3125f,
+          0.010416667f, 0.109375f, 2.0625f, -0.0405092575f, 0.0f, 0.0f,
+          1.265625f, 0.120515049f, 0.108072914f, 0.000162760422f, 6.85546875f,
+          6.0f }
+    });
+}
+
+BOOST_AUTO_TEST_CASE(test_cruncher_trivariance)
+{
+    checkOutputs(crunch(StatisticsCruncher::STATS_TRIVAR,
+                        { "u", "v", "w", "T" }, true), {
+        { -0.333333343f, 2.83333325f, 0.0f, 21.75f, 0.222222224f,
+          -0.027777778f, 0.0f, 0.208333328f, 0.611111104f, 0.0f, 0.166666672f,
+          0.010416667f, 0.0625f, 1.625f, 0.0405092575f, -0.0740740746f,
+          -0.00868055597f, -0.152777776f, 0.00925925933f, -0.012152778f,
+          -0.135416672f, 0.0f, 0.0234375f, 0.333333343f, 0.185185179f,
+          -0.013888889f, 0.333333343f, 0.0f, -0.0625f, -0.708333313f, 0.0f,
+          -0.00260416674f, -0.03125f, 0.03125f, 0.0966435149f, 0.597222209f,
+          0.000162760422f, 4.5234375f, 9.0f },
+        { -0.166666672f, 3.25f, 0.0f, 21.5f, 0.243055552f, -0.0416666679f,
+          -0.03125f, -0.34375f, 0.229166672f, 0.010416667f, -0.3125f,
+          0.010416667f, 0.109375f, 2.0625f, -0.0405092575f, 0.0850694478f,
+          0.010416667f, -0.0755208358f, -0.0972222239f, -0.011284722f,
+          0.0651041642f, -0.000868055562f, 0.014322917f, 0.0859375f, 0.0f,
+          0.010416667f, 0.125f, 0.00130208337f, -0.01171875f, -0.46875f, 0.0f,
+          -0.001953125f, 0.01171875f, 1.265625f, 0.120515049f, 0.108072914f,
+          0.000162760422f, 6.85546875f, 6.0f }
+    });
+}
+
+BOOST_AUTO_TEST_CASE(test_cruncher_winddir)
+{
+    checkOutputs(crunch(StatisticsCruncher::STATS_WINDDIR,
+                        { "u", "v" }, false), {
+        { 172.434677f },
+        { 176.933502f }
+    });
+}
@@ -3,6 +3,11 @@
 using boost::unit_test_framework::test_suite;
 
 #include <nidas/core/Variable.h>
+#include <nidas/core/VariableConverter.h>
+#include <nidas/core/ConversionPlan.h>
+#include <nidas/core/Site.h>
+
+#include <cmath>
 
 using namespace nidas::util;
 using namespace nidas::core;
@@ -45,3 +50,144 @@ BOOST_AUTO_TEST_CASE(test_variable_attributes)
     t.removeAttribute("a");
     BOOST_TEST(t.getAttributes() == vector<Parameter>{});
 }
+
+
+namespace {
+
+/**
+ * A Linear subclass with its own convert(), which the ConversionPlan
+ * must call for each value rather than compile as a Linear.
+ */
+class SquareLinear: public Linear
+{
+public:
+    double convert(dsm_time_t t, double val) override
+    {
+        return Linear::convert(t, val) * val;
+    }
+};
+
+class NoConversionsSite: public Site
+{
+public:
+    bool getApplyVariableConversions() const override
+    {
+        return false;
+    }
+};
+
+/**
+ * Convert @p values with Variable::convert() for each Variable, as
+ * DSMSensor::applyConversions() used to do.
+ */
+vector<float>
+convertEach(const vector<Variable*>& vars, dsm_time_t tt,
+            vector<float> values)
+{
+    float* fp = values.data();
+    for (auto var: vars)
+        fp = var->convert(tt, fp);
+    return values;
+}
+
+void
+checkSame(const vector<float>& expected, const vector<float>& results)
+{
+    BOOST_REQUIRE_EQUAL(expected.size(), results.size());
+    for (unsigned int i = 0; i < expected.size(); i++)
+    {
+        BOOST_TEST_INFO("value " << i);
+        if (std::isnan(expected[i]))
+            BOOST_TEST(std::isnan(results[i]));
+        else
+            BOOST_TEST(expected[i] == results[i]);
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_conversion_plan)
+{
+    Variable linear;
+    Linear* lconv = new Linear();
+    lconv->setSlope(0.1);
+    lconv->setIntercept(-3.7);
+    linear.setConverter(lconv);
+    linear.setMissingValue(-9999);
+    linear.setMinValue(-10);
+    linear.setMaxValue(90);
+
+    Variable poly;
+    poly.setLength(70);
+    Polynomial* pconv = new Polynomial();
+    pconv->setCoefficients(vector<float>{ 1.5, -0.25, 3.0e-3, 1.0e-5 });
+    poly.setConverter(pconv);
+    poly.setMissingValue(-99);
+    poly.setMaxValue(1000);
+
+    Variable raw;
+    raw.setLength(3);
+    raw.setMinValue(0);
+
+    Variable square;
+    square.setConverter(new SquareLinear());
+
+    vector<Variable*> vars{ &linear, &poly, &raw, &square };
+    vector<float> values;
+    for (unsigned int i = 0; i < 75; i++)
+        values.push_back(i * 13.7 - 100);
+    values[0] = -9999;      // missing value of linear
+    values[5] = -99;        // missing value of poly
+    values[6] = floatNAN;
+
+    dsm_time_t tt = 0;
+    ConversionPlan plan;
+    vector<float> results(values);
+    BOOST_TEST(plan.apply(vars, tt, results.data(), results.size()) == 75);
+    BOOST_TEST(plan.getNumOperations() == 4);
+    checkSame(convertEach(vars, tt, values), results);
+
+    // Convert into a separate results array.
+    vector<float> copy(values);
+    BOOST_TEST(plan.apply(vars, tt, copy.data(), copy.size(),
+                          results.data()) == 75);
+    checkSame(values, copy);
+    checkSame(convertEach(vars, tt, values), results);
+
+    // Changes to coefficients and limits are seen without recompiling.
+    lconv->setSlope(2.0);
+    poly.setMinValue(1.0);
+    results = values;
+    plan.apply(vars, tt, results.data(), results.size());
+    checkSame(convertEach(vars, tt, values), results);
+
+    // A new converter and length recompile the plan.
+    Polynomial* lpoly = new Polynomial();
+    lpoly->setCoefficients(vector<float>{ 0.5, 2.0 });
+    linear.setConverter(lpoly);
+    raw.setLength(2);
+    values.pop_back();
+    results = values;
+    plan.apply(vars, tt, results.data(), results.size());
+    checkSame(convertEach(vars, tt, values), results);
+
+    // A short sample: only the values present are converted.
+    results = values;
+    BOOST_TEST(plan.apply(vars, tt, results.data(), 40) == 40);
+    vector<float> expected = convertEach(vars, tt, values);
+    std::copy(values.begin() + 40, values.end(), expected.begin() + 40);
+    checkSame(expected, results);
+
+    // Conversions disabled by the site: only missing values are masked.
+    NoConversionsSite site;
+    for (auto var: vars)
+        var->setSite(&site);
+    results = values;
+    plan.apply(vars, tt, results.data(), results.size());
+    checkSame(convertEach(vars, tt, values), results);
+    BOOST_TEST(std::isnan(results[0]));
+    BOOST_TEST(results[1] == values[1]);
+    BOOST_TEST(std::isnan(results[5]));
+    for (auto var: vars)
+        var->setSite(0);
+}
@@ -16,6 +16,7 @@ data_dump="data_dump --precision 4"
 
 compare data_dump_-1,100.txt ${data_dump} -i -1,100 $datfile
 compare data_dump_-1,-1.txt ${data_dump} -i -1,-1 $datfile
+compare data_dump_-1,-1.txt ${data_dump} --mmap -i -1,-1 $datfile
 compare data_dump_1,0x32.txt ${data_dump} -i 1,0x32 $datfile
 compare data_dump_-1,0x32.txt ${data_dump} -i -1,0x32 $datfile
 compare data_dump_-p_-1,101.txt ${data_dump} -p -x $xfile -i -1,101 $datfile
@@ -0,0 +1,113 @@
+#!/bin/bash
+
+# Test the batching writer of data_influxdb against a stub http server:
+# gzip bodies, batches queued by age, the reader waiting for a full
+# queue, and an http error stopping the writes.
+
+tinfluxwriter=${TINFLUXWRITER:-./tinfluxwriter}
+
+tmpdir=$(mktemp -d /tmp/influx_test_XXXXXX)
+server_pid=
+
+stop_server() {
+    [ -n "$server_pid" ] && kill $server_pid 2>/dev/null
+    wait $server_pid 2>/dev/null
+    server_pid=
+}
+
+trap '{ stop_server; rm -rf $tmpdir; }' EXIT
+
+errs=0
+
+fail() {
+    echo "FAIL: $*"
+    errs=$((errs + 1))
+}
+
+# Start the stub server with delay $1 and fail-after $2, logging the
+# posts to $tmpdir/server.log, and set url.
+start_server() {
+    # don't read the port of the last server
+    rm -f $tmpdir/server.log
+    port=
+    python3 ./stub_server.py $1 $2 > $tmpdir/server.log &
+    server_pid=$!
+    for (( i = 0; i < 50; i++ )); do
+        port=$(head -n 1 $tmpdir/server.log 2>/dev/null)
+        [ -n "$port" ] && break
+        sleep 0.1
+    done
+    [ -n "$port" ] || { echo "stub server did not start"; exit 1; }
+    url="http://127.0.0.1:$port/write?db=test&precision=u"
+}
+
+# Run tinfluxwriter with the arguments after the url, and set
+# result to its output.
+run_writer() {
+    result=$($tinfluxwriter $url "$@")
+    echo "tinfluxwriter $*: $result"
+}
+
+# Value of the field $1 in the output of tinfluxwriter.
+field() {
+    echo "$result" | sed -n "s/.*\b$1=\([0-9]*\).*/\1/p" | head -n 1
+}
+
+server_posts() {
+    grep -c "^post" $tmpdir/server.log
+}
+
+server_lines() {
+    awk -F'[= ]' '/^post/{n += $3} END{print n + 0}' $tmpdir/server.log
+}
+
+# gzip and plain bodies, 10 full batches
+for gzip in yes no; do
+    start_server 0 0
+    run_writer $gzip 1000 100 5 4 2 0
+    stop_server
+    [ "$(field ok)" = 1 ] || fail "gzip=$gzip: write failed"
+    [ "$(field lines)" = 1000 ] || fail "gzip=$gzip: lines posted"
+    [ "$(server_posts)" = 10 ] || fail "gzip=$gzip: server posts"
+    [ "$(server_lines)" = 1000 ] || fail "gzip=$gzip: server lines"
+    gz=$([ $gzip = yes ] && echo 1 || echo 0)
+    grep "^post" $tmpdir/server.log | grep -q -v "gzip=$gz" &&
+        fail "gzip=$gzip: body encoding"
+done
+
+# Lines added more slowly than the maximum age are posted in batches
+# queued by age, before the batch is full.
+start_server 0 0
+run_writer yes 20 1000 0.1 4 2 30
+stop_server
+[ "$(field ok)" = 1 ] || fail "age: write failed"
+[ "$(field lines)" = 20 ] || fail "age: lines posted"
+[ "$(field aged)" -ge 2 ] || fail "age: no batches queued by age"
+[ "$(server_lines)" = 20 ] || fail "age: server lines"
+
+# A slow server fills the queue, and the reader waits for it,
+# without losing lines.
+start_server 0.1 0
+run_writer yes 200 10 5 1 1 0
+stop_server
+[ "$(field ok)" = 1 ] || fail "queue: write failed"
+[ "$(field lines)" = 200 ] || fail "queue: lines posted"
+[ "$(field stalls)" -gt 0 ] || fail "queue: reader did not wait"
+[ "$(server_lines)" = 200 ] || fail "queue: server lines"
+
+# An http error stops the writes, and is reported.
+start_server 0 2
+run_writer yes 1000 10 5 1 1 0
+stop_server
+[ "$(field ok)" = 0 ] || fail "error: write did not fail"
+[ "$(field lines)" = 20 ] || fail "error: lines posted"
+echo "$result" | grep -q "field type conflict" ||
+    fail "error: json error message not reported"
+[ "$(server_posts)" = 3 ] || fail "error: writes continued after the error"
+
+if [ $errs -eq 0 ]; then
+    echo "data_influxdb writer tests OK"
+    exit 0
+fi
+echo "data_influxdb writer tests: $errs failures"
+exit 1
@@ -0,0 +1,58 @@
+#!/usr/bin/env python3
+"""
+A stub of the influx database write endpoint.  Prints the port it
+listens on, then a line for each post: the number of lines, and whether
+the body was gzip compressed.
+
+Usage: stub_server.py <delay-secs> <fail-after>
+
+Each response is delayed by <delay-secs>.  If <fail-after> is greater
+than 0, the posts after the first <fail-after> get an http 400 error
+with a json error message, like a field type conflict of influxdb.
+"""
+
+import gzip
+import http.server
+import sys
+import threading
+import time
+
+delay = float(sys.argv[1])
+fail_after = int(sys.argv[2])
+lock = threading.Lock()
+nposts = 0
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    protocol_version = "HTTP/1.1"
+
+    def do_POST(self):
+        global nposts
+        body = self.rfile.read(int(self.headers['Content-Length']))
+        gzipped = self.headers.get('Content-Encoding') == 'gzip'
+        if gzipped:
+            body = gzip.decompress(body)
+        with lock:
+            nposts += 1
+            fail = fail_after > 0 and nposts > fail_after
+            print("post lines=%d gzip=%d" % (body.count(b'\n'), gzipped),
+                  flush=True)
+        time.sleep(delay)
+        if fail:
+            msg = b'{"error":"partial write: field type conflict"}'
+            self.send_response(400)
+            self.send_header('Content-Type', 'application/json')
+            self.send_header('Content-Length', str(len(msg)))
+            self.end_headers()
+            self.wfile.write(msg)
+        else:
+            self.send_response(204)
+            self.end_headers()
+
+    def log_message(self, *args):
+        pass
+
+
+server = http.server.ThreadingHTTPServer(('127.0.0.1', 0), Handler)
+print(server.server_address[1], flush=True)
+server.serve_forever()
@@ -0,0 +1,59 @@
+/*
+ * Post measurement lines with the InfluxWriter of data_influxdb to the
+ * stub server of run_test.sh, and print the result and statistics of
+ * the writer.
+ */
+
+#include <nidas/apps/InfluxWriter.h>
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+int main(int argc, char** argv)
+{
+    if (argc != 9)
+    {
+        cerr << "Usage: " << argv[0] << " url {yes|no} nlines maxlines "
+             << "maxage maxqueue maxrequests pausemsecs" << endl;
+        return 1;
+    }
+    curl_global_init(CURL_GLOBAL_ALL);
+
+    int nlines = atoi(argv[3]);
+    int pause = atoi(argv[8]);
+
+    bool ok = true;
+    {
+        InfluxWriter writer;
+        writer.setURL(argv[1]);
+        writer.setGzip(string(argv[2]) == "yes");
+        writer.setMaxLines(atoi(argv[4]));
+        writer.setMaxAge(atof(argv[5]));
+        writer.setMaxQueue(atoi(argv[6]));
+        writer.setMaxRequests(atoi(argv[7]));
+
+        for (int i = 0; i < nlines && ok; i++)
+        {
+            ok = writer.add("meas,site=test value=" + to_string(i) + " " +
+                            to_string(1700000000000000LL + i) + "\n");
+            if (pause > 0)
+                std::this_thread::sleep_for(
+                    std::chrono::milliseconds(pause));
+        }
+        ok = writer.flush() && ok;
+        writer.stop();
+
+        InfluxWriterStats stats = writer.getStats();
+        cout << "ok=" << ok
+             << " batches=" << stats.batches
+             << " lines=" << stats.lines
+             << " aged=" << stats.agedBatches
+             << " stalls=" << stats.stalls << endl;
+        if (!ok)
+            cout << "errors=" << writer.getErrors() << endl;
+    }
+    curl_global_cleanup();
+    return 0;
+}
@@ -70,6 +70,10 @@ echo The merges should match the inputs...
 run_diff dsm12.dat outputs/dsm12.out.dat
 run_diff dsm13.dat outputs/dsm13.out.dat
 
+echo A parallel merge should match the serial merge...
+run_merge --parallel -i dsm12.dat -i dsm13.dat -o outputs/dsm-both-parallel.dat || exit 1
+compare_dat_then_stats outputs/dsm-both.dat outputs/dsm-both-parallel.dat
+
 echo M2HATS excerpts: all t2 samples should also be in the network stream...
 run_merge -i isfs_20230731_0401.dat.bz2 -i t2_20230731_0401.dat.bz2 -o outputs/merged_20230731_0401.dat.bz2 || exit 1
 data_stats t2_20230731_0401.dat.bz2 > outputs/t2_baseline.stats.txt
@@ -82,6 +86,10 @@ data_stats isfs_20230731_0401.dat.bz2 > outputs/m2hats_baseline.stats.txt
 data_stats outputs/merged_20230731_0401.dat.bz2 > outputs/m2hats_merged.stats.txt
 run_diff outputs/m2hats_baseline.stats.txt outputs/m2hats_merged.stats.txt
 
+echo ...and the parallel merge of the compressed streams should match
+run_merge --parallel -i isfs_20230731_0401.dat.bz2 -i t2_20230731_0401.dat.bz2 -o outputs/merged_20230731_0401_parallel.dat.bz2 || exit 1
+compare_dat_then_stats outputs/merged_20230731_0401.dat.bz2 outputs/merged_20230731_0401_parallel.dat.bz2
+
 echo Merging the same file multiple times should produce the same file...
 testout=isfs_20230731_0401_null_merge
 # disable verbose logs about duplicates
@@ -0,0 +1,58 @@
+#!/bin/bash
+
+# Check that statsproc computes the same statistics, in time order,
+# whether the crunchers run on the input thread or on a pool of threads.
+# The input is the sonic test archive, with 20 Hz CSAT3 and ATIK samples,
+# and config/stats.xml computes 1 second statistics of them.
+
+source ../nidas_tests.sh
+check_executable statsproc
+check_executable data_dump
+
+data_file=../sonic/data/centnet_20120601_000000.dat.bz2
+
+mkdir -p outputs
+rm -rf outputs/*
+
+run_statsproc() # nthreads
+{
+    export STATSPROC_OUTPUT=$PWD/outputs/threads$1
+    mkdir -p $STATSPROC_OUTPUT
+    echo "statsproc --threads $1"
+    if ! statsproc --log info -x config/stats.xml -p 1 --threads $1 \
+        $data_file > outputs/threads$1.log 2>&1; then
+        cat outputs/threads$1.log
+        failed "statsproc --threads $1"
+    fi
+    data_dump --precision 6 -i -1,-1 $STATSPROC_OUTPUT/stats.dat \
+        > outputs/threads$1.txt 2> outputs/threads$1.txt.stderr ||
+        failed "data_dump of statsproc --threads $1 output"
+}
+
+# The timetags of the dumped samples, without the header line.
+timetags() # dumpfile
+{
+    tail -n +2 "$1" | cut -c1-24
+}
+
+run_statsproc 0
+run_statsproc 4
+
+nsamps=`tail -n +2 outputs/threads0.txt | wc -l`
+echo "$nsamps statistics samples"
+[ $nsamps -ge 30 ] || failed "too few statistics samples: $nsamps"
+
+for n in 0 4; do
+    timetags outputs/threads$n.txt | sort -c ||
+        failed "statsproc --threads $n output is not in time order"
+done
+
+# The output sorter only orders samples by time, so statistics with the
+# same timetag from different threads can be written in any order.
+# Compare the sorted lines.
+sort outputs/threads0.txt > outputs/threads0.sorted.txt
+sort outputs/threads4.txt > outputs/threads4.sorted.txt
+run_diff outputs/threads0.sorted.txt outputs/threads4.sorted.txt
+
+echo "statsproc tests succeeded"
+exit 0
@@ -26,29 +26,8 @@ check_tcp_port() {
     echo "false"
 }
 
-export SYNC_REC_PORT_TCP=`find_tcp_port`
-echo "Using port=$SYNC_REC_PORT_TCP"
-
 # To look at the latitude data
 # data_dump -i 4,4072 -p data/dsm_20060908_200303.ads
- 
-echo "running sync_server in the background"
-valgrind --leak-check=full --suppressions=suppressions.txt --gen-suppressions=all \
-    sync_server -p $SYNC_REC_PORT_TCP \
-    --log enable,level=verbose,function=SyncRecordSource::receive \
-    --logfields level,message \
-    --logparam trace_samples=4,4072 --log enable,level=info \
-    data/dsm_20060908_200303.ads > sync_server.log 2>&1 &
-
-echo "waiting for port $SYNC_REC_PORT_TCP to open, then run sync_dump"
-
-for (( i=0; i<20; i++)); do
-    `check_tcp_port $SYNC_REC_PORT_TCP` && break
-    sleep 1
-done
-
-valgrind --leak-check=full --gen-suppressions=all sync_dump LAT_G sock:localhost:$SYNC_REC_PORT_TCP 2>&1 | \
-    tee sync_dump.log
 
 tmp1=$(mktemp /tmp/sync_rec_test_XXXXXX_expect.dat)
 tmp2=$(mktemp /tmp/sync_rec_test_XXXXXX_actual.dat)
@@ -64,24 +43,63 @@ cat << EOD > $tmp1
 2006 09 08 20:03:08.000 nan
 EOD
 
-grep -E "^2006 09" sync_dump.log > $tmp2
-
 dataok=true
-if ! diff $tmp1 $tmp2; then
-    echo "sync_dump data not as expected, files=/tmp/sync_rec_test*.dat"
-    cp $tmp1 /tmp/sync_rec_test_expect.dat
-    cp $tmp2 /tmp/sync_rec_test_actual.dat
-    dataok=false
-else
-    echo "sync_dump data looks good"
-fi
+dump_errs=0
+server_errs=0
+
+# Run sync_server with the options in $1, and sync_dump with the
+# options in $2, logging to sync_server$3.log and sync_dump$3.log.
+run_case() {
+    local server_opts=$1
+    local dump_opts=$2
+    local suffix=$3
+
+    export SYNC_REC_PORT_TCP=`find_tcp_port`
+    echo "Using port=$SYNC_REC_PORT_TCP"
+
+    echo "running sync_server $server_opts in the background"
+    valgrind --leak-check=full --suppressions=suppressions.txt --gen-suppressions=all \
+        sync_server -p $SYNC_REC_PORT_TCP $server_opts \
+        --log enable,level=verbose,function=SyncRecordSource::receive \
+        --logfields level,message \
+        --logparam trace_samples=4,4072 --log enable,level=info \
+        data/dsm_20060908_200303.ads > sync_server$suffix.log 2>&1 &
+
+    echo "waiting for port $SYNC_REC_PORT_TCP to open, then run sync_dump $dump_opts"
+
+    for (( i=0; i<20; i++)); do
+        `check_tcp_port $SYNC_REC_PORT_TCP` && break
+        sleep 1
+    done
+
+    valgrind --leak-check=full --gen-suppressions=all sync_dump $dump_opts LAT_G sock:localhost:$SYNC_REC_PORT_TCP 2>&1 | \
+        tee sync_dump$suffix.log
+
+    grep -E "^2006 09" sync_dump$suffix.log > $tmp2
+
+    if ! diff $tmp1 $tmp2; then
+        echo "sync_dump $dump_opts data not as expected, files=/tmp/sync_rec_test*.dat"
+        cp $tmp1 /tmp/sync_rec_test_expect.dat
+        cp $tmp2 /tmp/sync_rec_test${suffix}_actual.dat
+        dataok=false
+    else
+        echo "sync_dump $dump_opts data looks good"
+    fi
+
+    local errs=`valgrind_errors sync_dump$suffix.log`
+    echo "$errs errors reported by valgrind in sync_dump$suffix.log"
+    dump_errs=$(( dump_errs + errs ))
+
+    sleep 5
+    errs=`valgrind_errors sync_server$suffix.log`
+    echo "$errs errors reported by valgrind in sync_server$suffix.log"
+    server_errs=$(( server_errs + errs ))
+}
 
-dump_errs=`valgrind_errors sync_dump.log`
-echo "$dump_errs errors reported by valgrind in sync_dump.log"
+run_case "" "" ""
 
-sleep 5
-server_errs=`valgrind_errors sync_server.log`
-echo "$server_errs errors reported by valgrind in sync_server.log"
+# The same variable, subscribed to as binary columns.
+run_case --subscribe -c _columns
 
 if $dataok && [ $dump_errs -eq 0 -a $server_errs -eq 0 ]; then
     exit 0
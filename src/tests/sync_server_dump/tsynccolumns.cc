@@ -0,0 +1,219 @@
+#define BOOST_TEST_DYN_LINK
+#define BOOST_AUTO_TEST_MAIN
+#include <boost/test/unit_test.hpp>
+using boost::unit_test_framework::test_suite;
+
+#include <nidas/dynld/raf/SyncRecordColumns.h>
+#include <nidas/dynld/raf/SyncRecordSource.h>
+#include <nidas/core/Sample.h>
+#include <nidas/util/EndianConverter.h>
+#include <nidas/util/ParseException.h>
+
+#include <cmath>
+#include <vector>
+
+using namespace nidas::core;
+using namespace nidas::dynld::raf;
+
+namespace n_u = nidas::util;
+
+namespace {
+
+/**
+ * A sync record of 100 values, with three columns selected from it.
+ * The first two are adjacent in the sync record.
+ */
+void addColumns(SyncRecordColumns& cols)
+{
+    cols.addColumn("LAT_G", 11, 1, 10, 1.0);
+    cols.addColumn("PSX", 13, 10, 12, 10.0);
+    cols.addColumn("CONCD", 51, 30, 40, 1.0);
+}
+
+std::vector<double> makeRecord(size_t len)
+{
+    std::vector<double> rec(len);
+    for (size_t i = 0; i < len; i++)
+        rec[i] = i * 1.25 + 0.1;
+    return rec;
+}
+
+void checkRoundTrip(bool float32, size_t reclen)
+{
+    SyncRecordColumns cols;
+    cols.setFloat32(float32);
+    addColumns(cols);
+    BOOST_CHECK_EQUAL(cols.getNumValues(), 1 + 1 + 1 + 10 + 1 + 30);
+    BOOST_CHECK_EQUAL(cols.getBlockLength(),
+                      cols.getNumValues() * (float32 ? 4 : 8));
+
+    std::vector<double> rec = makeRecord(reclen);
+    std::vector<char> block(cols.getBlockLength());
+    cols.encodeRecord(&rec[0], rec.size(), &block[0]);
+
+    // The reader only has the header.
+    std::string head = cols.encodeHeader();
+    SyncRecordColumns rcols;
+    rcols.decodeHeader(head.c_str(), head.length());
+    BOOST_CHECK_EQUAL(rcols.getFloat32(), float32);
+    BOOST_CHECK_EQUAL(rcols.getNumValues(), cols.getNumValues());
+    BOOST_REQUIRE_EQUAL(rcols.getColumns().size(), cols.getColumns().size());
+
+    std::vector<double> values(rcols.getNumValues());
+    rcols.decodeRecord(&block[0], &values[0]);
+
+    for (unsigned int i = 0; i < cols.getColumns().size(); i++) {
+        const SyncRecordColumns::Column& col = cols.getColumns()[i];
+        const SyncRecordColumns::Column* rcol = rcols.getColumn(col.name);
+        BOOST_REQUIRE(rcol);
+        BOOST_CHECK_EQUAL(rcol->offset, col.offset);
+        BOOST_CHECK_EQUAL(rcol->lagOffset, col.lagOffset);
+        BOOST_CHECK_EQUAL(rcol->length, col.length);
+        BOOST_CHECK_EQUAL(rcol->rate, col.rate);
+
+        for (unsigned int j = 0; j <= col.length; j++) {
+            // the lag, then the values
+            unsigned int src = j == 0 ? col.srcLagOffset :
+                col.srcOffset + j - 1;
+            double val = values[rcol->lagOffset + j];
+            if (src >= reclen)
+                BOOST_CHECK(std::isnan(val));
+            else if (float32)
+                BOOST_CHECK_EQUAL(val, (double)(float)rec[src]);
+            else
+                BOOST_CHECK_EQUAL(val, rec[src]);
+        }
+    }
+}
+
+}
+
+BOOST_AUTO_TEST_CASE(test_columns_round_trip)
+{
+    checkRoundTrip(false, 100);
+    checkRoundTrip(true, 100);
+    // A short sync record: the end of CONCD is missing.
+    checkRoundTrip(false, 70);
+    checkRoundTrip(true, 70);
+}
+
+BOOST_AUTO_TEST_CASE(test_columns_bad_header)
+{
+    SyncRecordColumns cols;
+    addColumns(cols);
+    std::string head = cols.encodeHeader();
+
+    SyncRecordColumns rcols;
+    BOOST_CHECK_THROW(rcols.decodeHeader(head.c_str(), head.length() - 1),
+                      n_u::ParseException);
+    BOOST_CHECK_THROW(rcols.decodeHeader(head.c_str(), 10),
+                      n_u::ParseException);
+
+    // A column whose offset + length wraps around to within the block.
+    const n_u::EndianConverter* cvtr =
+        n_u::EndianConverter::getConverter(
+            n_u::EndianConverter::getHostEndianness(),
+            n_u::EndianConverter::EC_LITTLE_ENDIAN);
+    std::string bad = head;
+    // magic, version, value size, number of values, number of columns
+    size_t coloff = 4 + 4 * sizeof(uint32_t);
+    cvtr->uint32Copy(0xfffffff0, &bad[coloff]);
+    cvtr->uint32Copy(0x20, &bad[coloff + sizeof(uint32_t)]);
+    BOOST_CHECK_THROW(rcols.decodeHeader(bad.c_str(), bad.length()),
+                      n_u::ParseException);
+
+    rcols.decodeHeader(head.c_str(), head.length());
+    BOOST_CHECK_EQUAL(rcols.getColumns().size(), 3);
+}
+
+BOOST_AUTO_TEST_CASE(test_columns_subscription)
+{
+    std::vector<std::string> names;
+    names.push_back("LAT_G");
+    names.push_back("PSX");
+    std::string line = SyncRecordColumns::formatSubscription(names, true);
+    BOOST_CHECK_EQUAL(line, "columns float32 LAT_G PSX\n");
+
+    std::vector<std::string> pnames;
+    bool float32 = false;
+    SyncRecordColumns::parseSubscription(line, pnames, float32);
+    BOOST_CHECK(float32);
+    BOOST_CHECK(pnames == names);
+
+    BOOST_CHECK_THROW(
+        SyncRecordColumns::parseSubscription("rows float32 A\n",
+                                             pnames, float32),
+        n_u::ParseException);
+    BOOST_CHECK_THROW(
+        SyncRecordColumns::parseSubscription("columns float16 A\n",
+                                             pnames, float32),
+        n_u::ParseException);
+}
+
+namespace {
+
+/**
+ * Client which keeps the blocks it receives, and whose result
+ * of receive() can be set.
+ */
+class BlockClient: public SampleClient
+{
+public:
+    BlockClient(): blocks(), result(true) {}
+
+    ~BlockClient()
+    {
+        for (unsigned int i = 0; i < blocks.size(); i++)
+            blocks[i]->freeReference();
+    }
+
+    bool receive(const Sample* samp) throw()
+    {
+        samp->holdReference();
+        blocks.push_back(samp);
+        return result;
+    }
+
+    void flush() throw() {}
+
+    std::vector<const Sample*> blocks;
+
+    bool result;
+};
+
+}
+
+BOOST_AUTO_TEST_CASE(test_columns_filter)
+{
+    SyncRecordColumns cols;
+    addColumns(cols);
+
+    std::vector<double> rec = makeRecord(100);
+    SampleT<double>* samp = getSample<double>(rec.size());
+    samp->setTimeTag(1000000);
+    samp->setId(SYNC_RECORD_ID);
+    std::copy(rec.begin(), rec.end(), samp->getDataPtr());
+
+    BlockClient client;
+    SyncRecordColumnsFilter filter(cols, &client);
+    BOOST_CHECK(filter.receive(samp));
+    BOOST_REQUIRE_EQUAL(client.blocks.size(), 1);
+    const Sample* block = client.blocks[0];
+    BOOST_CHECK_EQUAL(block->getId(), SYNC_RECORD_COLUMNS_ID);
+    BOOST_CHECK_EQUAL(block->getTimeTag(), samp->getTimeTag());
+    BOOST_REQUIRE_EQUAL(block->getDataByteLength(), cols.getBlockLength());
+
+    std::vector<double> values(cols.getNumValues());
+    cols.decodeRecord(block->getConstVoidDataPtr(), &values[0]);
+    const SyncRecordColumns::Column* col = cols.getColumn("PSX");
+    BOOST_REQUIRE(col);
+    BOOST_CHECK_EQUAL(values[col->lagOffset], rec[col->srcLagOffset]);
+    BOOST_CHECK_EQUAL(values[col->offset + 9], rec[col->srcOffset + 9]);
+
+    // A failure of the client is passed back.
+    client.result = false;
+    BOOST_CHECK(!filter.receive(samp));
+    BOOST_CHECK_EQUAL(client.blocks.size(), 2);
+
+    samp->freeReference();
+}
@@ -36,6 +36,7 @@ using boost::unit_test_framework::test_suite;
 #include "nidas/core/UnixIOChannel.h"
 #include "nidas/util/Logger.h"
 #include <nidas/core/SampleInputHeader.h>
+#include <nidas/core/Sample.h>
 #include <sstream>
 #include <errno.h>
 
@@ -47,6 +48,8 @@ static std::ostringstream oss;
 using nidas::core::IOStream;
 using nidas::core::UnixIOChannel;
 using nidas::core::SampleInputHeader;
+using nidas::core::Sample;
+using nidas::core::getSample;
 
 class DummyChannel : public nidas::core::UnixIOChannel
 {
@@ -84,6 +87,27 @@ public:
     return len;
   }
 
+  virtual size_t
+  write(const struct iovec* iov, int iovcnt) override
+  {
+    size_t len = 0;
+    for (int i = 0; i < iovcnt; ++i)
+      len += iov[i].iov_len;
+    if (_partial)
+      len = len / 2;
+    _buffer = (char*)realloc(_buffer, _buflen + len);
+    size_t l = len;
+    for (int i = 0; i < iovcnt && l > 0; ++i)
+    {
+      size_t n = std::min(l, iov[i].iov_len);
+      memcpy(_buffer+_buflen, iov[i].iov_base, n);
+      _buflen += n;
+      l -= n;
+    }
+    ++_nwrites;
+    return len;
+  }
+
   virtual size_t read(void* buf, size_t len) override
   {
     if (_buflen > 0)
@@ -275,6 +299,60 @@ BOOST_AUTO_TEST_CASE(test_steady_writes)
 }
 
 
+BOOST_AUTO_TEST_CASE(test_gather_writes)
+{
+  DummyChannel channel("null");
+  IOStream iostream(channel, 4096);
+  iostream.setGatherMinLength(1024);
+
+  // A large sample, whose data is gathered, between small headers,
+  // which are copied.
+  const size_t nfloat = 1000;
+  Sample* samp = getSample<float>(nfloat);
+  float* fp = (float*)samp->getVoidDataPtr();
+  for (size_t i = 0; i < nfloat; ++i)
+    fp[i] = (float)i;
+  BOOST_CHECK_EQUAL(samp->getReferenceCount(), 1);
+
+  const char hdr1[] = "header1";
+  const char hdr2[] = "header2";
+  struct iovec iov[2];
+  iov[0].iov_base = const_cast<char*>(hdr1);
+  iov[0].iov_len = sizeof(hdr1);
+  iov[1].iov_base = samp->getVoidDataPtr();
+  iov[1].iov_len = samp->getDataByteLength();
+
+  size_t tlen = sizeof(hdr1) + 4*nfloat;
+  BOOST_CHECK_EQUAL(iostream.write(iov, 2, false, samp), tlen);
+  BOOST_CHECK_EQUAL(channel._nwrites, 0);
+  BOOST_CHECK_EQUAL(samp->getReferenceCount(), 2);
+  BOOST_CHECK_EQUAL(iostream.write(hdr2, sizeof(hdr2), false), sizeof(hdr2));
+  BOOST_CHECK_EQUAL(iostream.getNumCopiedBytes(), sizeof(hdr1) + sizeof(hdr2));
+  BOOST_CHECK_EQUAL(iostream.getNumGatheredBytes(), 4*nfloat);
+
+  // Partial writes, then the rest on another flush, with the sample
+  // released once all of its data is written.
+  channel._partial = true;
+  iostream.flush();
+  channel._partial = false;
+  iostream.flush();
+  BOOST_CHECK_EQUAL(samp->getReferenceCount(), 1);
+  BOOST_CHECK_EQUAL(channel._buflen, tlen + sizeof(hdr2));
+  BOOST_CHECK(memcmp(channel._buffer, hdr1, sizeof(hdr1)) == 0);
+  BOOST_CHECK(memcmp(channel._buffer + sizeof(hdr1), fp, 4*nfloat) == 0);
+  BOOST_CHECK(memcmp(channel._buffer + tlen, hdr2, sizeof(hdr2)) == 0);
+  BOOST_CHECK_EQUAL(iostream.getNumOutputBytes(), tlen + sizeof(hdr2));
+
+  // A gathered write to an empty list with flush goes out in one write.
+  channel.clear();
+  BOOST_CHECK_EQUAL(iostream.write(iov, 2, true, samp), tlen);
+  BOOST_CHECK_EQUAL(channel._nwrites, 1);
+  BOOST_CHECK_EQUAL(channel._buflen, tlen);
+  BOOST_CHECK_EQUAL(samp->getReferenceCount(), 1);
+  samp->freeReference();
+}
+
+
 const char* _header =
 R"(NIDAS (ncar.ucar.edu)
 archive version: 1